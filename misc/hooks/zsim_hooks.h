@@ -18,6 +18,56 @@
 #define ZSIM_MAGIC_OP_HEARTBEAT         (1028)
 #define ZSIM_MAGIC_OP_WORK_BEGIN        (1029) //ubik
 #define ZSIM_MAGIC_OP_WORK_END          (1030) //ubik
+#define ZSIM_MAGIC_OP_REGISTER_CSR      (1034)
+#define ZSIM_MAGIC_OP_PIM_GATHER        (1035)
+#define ZSIM_MAGIC_OP_ACCEL_GEMM        (1036)
+#define ZSIM_MAGIC_OP_ACCEL_WAIT        (1037)
+
+//Describes a CSR graph to the CSR-aware prefetcher; must match CSRGraphDesc in prefetcher.h
+struct ZsimCsrGraph {
+    uint64_t offsets;       //address of the (numVertices+1)-entry offsets array
+    uint64_t neighbors;     //address of the numEdges-entry neighbors array
+    uint64_t features;      //address of the feature table, 0 if none
+    uint64_t numVertices;
+    uint64_t numEdges;
+    uint32_t offsetBytes;   //4 or 8
+    uint32_t neighborBytes; //4 or 8
+    uint32_t featureBytes;  //bytes per feature row
+    uint32_t pad;
+};
+
+//Near-memory gather-reduce of numLines lines into one; must match PIMGatherDesc in zsim.cpp
+enum ZsimPimOp {
+    ZSIM_PIM_SUM_F32 = 0,
+    ZSIM_PIM_MAX_F32 = 1,
+    ZSIM_PIM_SUM_I32 = 2,
+};
+
+struct ZsimPimGather {
+    uint64_t srcs;      //address of an array of numLines source addresses, each a line-aligned line
+    uint64_t dst;       //address of the line-sized result
+    uint32_t numLines;
+    uint32_t op;        //ZsimPimOp
+};
+
+//GEMM on the accelerator, C (+)= A*B with row-major matrices; must match AccelGemmDesc in zsim.cpp
+enum ZsimAccelType {
+    ZSIM_ACCEL_F32 = 0,
+    ZSIM_ACCEL_I32 = 1,
+};
+
+#define ZSIM_ACCEL_ACCUMULATE (1 << 0) //C += A*B instead of C = A*B
+
+struct ZsimAccelGemm {
+    uint64_t a, b, c;       //addresses of A (m x k), B (k x n) and C (m x n)
+    uint32_t m, n, k;
+    uint32_t lda, ldb, ldc; //row strides, in elements
+    uint32_t type;          //ZsimAccelType
+    uint32_t flags;         //ZSIM_ACCEL_*
+    uint64_t id;            //set by launch
+    uint32_t done;          //set by wait
+    uint32_t pad;
+};
 
 #ifdef __x86_64__
 #define HOOKS_STR  "HOOKS"
@@ -26,11 +76,21 @@ static inline void zsim_magic_op(uint64_t op) {
     __asm__ __volatile__("xchg %%rcx, %%rcx;" : : "c"(op));
     COMPILER_BARRIER();
 }
+
+static inline void zsim_magic_op_arg(uint64_t op, uint64_t arg) {
+    COMPILER_BARRIER();
+    __asm__ __volatile__("xchg %%rcx, %%rcx;" : : "c"(op), "d"(arg));
+    COMPILER_BARRIER();
+}
 #else
 #define HOOKS_STR  "NOP-HOOKS"
 static inline void zsim_magic_op(uint64_t op) {
     //NOP
 }
+
+static inline void zsim_magic_op_arg(uint64_t op, uint64_t arg) {
+    //NOP
+}
 #endif
 
 static inline void zsim_roi_begin() {
@@ -50,6 +110,27 @@ static inline void zsim_heartbeat() {
 static inline void zsim_work_begin() { zsim_magic_op(ZSIM_MAGIC_OP_WORK_BEGIN); }
 static inline void zsim_work_end() { zsim_magic_op(ZSIM_MAGIC_OP_WORK_END); }
 
+static inline void zsim_register_csr(const ZsimCsrGraph* graph) {
+    zsim_magic_op_arg(ZSIM_MAGIC_OP_REGISTER_CSR, (uint64_t)graph);
+}
+
+//Gathers and reduces the lines in memory-side PIM units; sources should not be dirty in the caches
+static inline void zsim_pim_gather(const ZsimPimGather* gather) {
+    zsim_magic_op_arg(ZSIM_MAGIC_OP_PIM_GATHER, (uint64_t)gather);
+}
+
+//Launches a GEMM on the accelerator. C is written when this returns, but the
+//accelerator's timing only completes in zsim_accel_wait()
+static inline void zsim_accel_gemm(ZsimAccelGemm* gemm) {
+    zsim_magic_op_arg(ZSIM_MAGIC_OP_ACCEL_GEMM, (uint64_t)gemm);
+}
+
+static inline void zsim_accel_wait(ZsimAccelGemm* gemm) {
+    do {
+        zsim_magic_op_arg(ZSIM_MAGIC_OP_ACCEL_WAIT, (uint64_t)gemm);
+    } while (!*(volatile uint32_t*)&gemm->done);
+}
+
 // nfp 2023-6-20
 enum class FlashGNNCallType {
     LOAD_EDGE_LIST,
@@ -18,6 +18,9 @@ unsigned int Device_Parameter_Set::Data_Cache_DRAM_Data_Busrt_Size = 4;//The num
 sim_time_type Device_Parameter_Set::Data_Cache_DRAM_tRCD = 13;//tRCD parameter to access DRAM in the data cache, the unit is nano-seconds
 sim_time_type Device_Parameter_Set::Data_Cache_DRAM_tCL = 13;//tCL parameter to access DRAM in the data cache, the unit is nano-seconds
 sim_time_type Device_Parameter_Set::Data_Cache_DRAM_tRP = 13;//tRP parameter to access DRAM in the data cache, the unit is nano-seconds
+SSD_Components::Data_Cache_Prefetching_Mode Device_Parameter_Set::Data_Cache_Prefetching_Mode = SSD_Components::Data_Cache_Prefetching_Mode::NONE;//Readahead into the data cache, only used by the ADVANCED caching mechanism
+unsigned int Device_Parameter_Set::Data_Cache_Prefetch_Degree = 8;//The number of pages that the prefetcher runs ahead of the demand reads
+unsigned int Device_Parameter_Set::Data_Cache_Prefetch_Stream_Table_Size = 16;//The number of concurrently tracked sequential streams
 SSD_Components::Flash_Address_Mapping_Type Device_Parameter_Set::Address_Mapping = SSD_Components::Flash_Address_Mapping_Type::PAGE_LEVEL;
 bool Device_Parameter_Set::Ideal_Mapping_Table = false;//If mapping is ideal, then all the mapping entries are found in the DRAM and there is no need to read mapping entries from flash
 unsigned int Device_Parameter_Set::CMT_Capacity = 2 * 1024 * 1024;//Size of SRAM/DRAM space that is used to cache address mapping table in bytes
@@ -147,6 +150,30 @@ void Device_Parameter_Set::XML_serialize(Utils::XmlWriter& xmlwriter)
 	val = std::to_string(Data_Cache_DRAM_tRP);
 	xmlwriter.Write_attribute_string(attr, val);
 
+	attr = "Data_Cache_Prefetching_Mode";
+	switch (Data_Cache_Prefetching_Mode) {
+		case SSD_Components::Data_Cache_Prefetching_Mode::NONE:
+			val = "NONE";
+			break;
+		case SSD_Components::Data_Cache_Prefetching_Mode::SEQUENTIAL:
+			val = "SEQUENTIAL";
+			break;
+		case SSD_Components::Data_Cache_Prefetching_Mode::GRAPH_GUIDED:
+			val = "GRAPH_GUIDED";
+			break;
+		default:
+			break;
+	}
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Data_Cache_Prefetch_Degree";
+	val = std::to_string(Data_Cache_Prefetch_Degree);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Data_Cache_Prefetch_Stream_Table_Size";
+	val = std::to_string(Data_Cache_Prefetch_Stream_Table_Size);
+	xmlwriter.Write_attribute_string(attr, val);
+
 	attr = "Address_Mapping";
 	switch (Address_Mapping) {
 		case SSD_Components::Flash_Address_Mapping_Type::PAGE_LEVEL:
@@ -451,6 +478,24 @@ void Device_Parameter_Set::XML_deserialize(rapidxml::xml_node<> *node)
 			} else if (strcmp(param->name(), "Data_Cache_DRAM_tRP") == 0) {
 				std::string val = param->value();
 				Data_Cache_DRAM_tRP = std::stoul(val);
+			} else if (strcmp(param->name(), "Data_Cache_Prefetching_Mode") == 0) {
+				std::string val = param->value();
+				std::transform(val.begin(), val.end(), val.begin(), ::toupper);
+				if (strcmp(val.c_str(), "NONE") == 0) {
+					Data_Cache_Prefetching_Mode = SSD_Components::Data_Cache_Prefetching_Mode::NONE;
+				} else if (strcmp(val.c_str(), "SEQUENTIAL") == 0) {
+					Data_Cache_Prefetching_Mode = SSD_Components::Data_Cache_Prefetching_Mode::SEQUENTIAL;
+				} else if (strcmp(val.c_str(), "GRAPH_GUIDED") == 0) {
+					Data_Cache_Prefetching_Mode = SSD_Components::Data_Cache_Prefetching_Mode::GRAPH_GUIDED;
+				} else {
+					PRINT_ERROR("Unknown data cache prefetching mode specified in the SSD configuration file")
+				}
+			} else if (strcmp(param->name(), "Data_Cache_Prefetch_Degree") == 0) {
+				std::string val = param->value();
+				Data_Cache_Prefetch_Degree = std::stoul(val);
+			} else if (strcmp(param->name(), "Data_Cache_Prefetch_Stream_Table_Size") == 0) {
+				std::string val = param->value();
+				Data_Cache_Prefetch_Stream_Table_Size = std::stoul(val);
 			} else if (strcmp(param->name(), "Address_Mapping") == 0) {
 				std::string val = param->value();
 				std::transform(val.begin(), val.end(), val.begin(), ::toupper);
@@ -5,6 +5,7 @@
 #include "../ssd/Host_Interface_Defs.h"
 #include "../ssd/Host_Interface_Base.h"
 #include "../ssd/Data_Cache_Manager_Base.h"
+#include "../ssd/Data_Cache_Prefetcher.h"
 #include "../ssd/Address_Mapping_Unit_Base.h"
 #include "../ssd/TSU_Base.h"
 #include "../ssd/ONFI_Channel_Base.h"
@@ -31,6 +32,9 @@ public:
 	static sim_time_type Data_Cache_DRAM_tRCD;//tRCD parameter to access DRAM in the data cache, the unit is nano-seconds
 	static sim_time_type Data_Cache_DRAM_tCL;//tCL parameter to access DRAM in the data cache, the unit is nano-seconds
 	static sim_time_type Data_Cache_DRAM_tRP;//tRP parameter to access DRAM in the data cache, the unit is nano-seconds
+	static SSD_Components::Data_Cache_Prefetching_Mode Data_Cache_Prefetching_Mode;//Readahead into the data cache, only used by the ADVANCED caching mechanism
+	static unsigned int Data_Cache_Prefetch_Degree;//The number of pages that the prefetcher runs ahead of the demand reads
+	static unsigned int Data_Cache_Prefetch_Stream_Table_Size;//The number of concurrently tracked sequential streams
 	static SSD_Components::Flash_Address_Mapping_Type Address_Mapping;
 	static bool Ideal_Mapping_Table;//If mapping is ideal, then all the mapping entries are found in the DRAM and there is no need to read mapping entries from flash
 	static unsigned int CMT_Capacity;//Size of SRAM/DRAM space that is used to cache address mapping table, the unit is bytes
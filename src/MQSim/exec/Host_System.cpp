@@ -5,6 +5,8 @@
 #include "../host/PCIe_Root_Complex.h"
 #include "../host/IO_Flow_Synthetic.h"
 #include "../host/IO_Flow_Trace_Based.h"
+#include "../host/IO_Flow_GNN_Sampling.h"
+#include "../ssd/Data_Cache_Manager_Flash_Advanced.h"
 #include "../utils/StringTools.h"
 #include "../utils/Logical_Address_Partitioning_Unit.h"
 
@@ -74,6 +76,18 @@ Host_System::Host_System(Host_Parameter_Set* parameters, bool preconditioning_re
 				this->IO_flows.push_back(io_flow);
 				break;
 			}
+			case Flow_Type::GNN_SAMPLING: {
+				IO_Flow_Parameter_Set_GNN_Sampling* flow_param = (IO_Flow_Parameter_Set_GNN_Sampling*)parameters->IO_Flow_Definitions[flow_id];
+				io_flow = new Host_Components::IO_Flow_GNN_Sampling(this->ID() + ".IO_Flow.GNN.No_" + std::to_string(flow_id), flow_id,
+					Utils::Logical_Address_Partitioning_Unit::Start_lha_available_to_flow(flow_id), Utils::Logical_Address_Partitioning_Unit::End_lha_available_to_flow(flow_id),
+					FLOW_ID_TO_Q_ID(flow_id), nvme_sq_size, nvme_cq_size, flow_param->Priority_Class,
+					flow_param->Graph_Path, flow_param->Graph_Block_Size, flow_param->Batch_Size, flow_param->Fanouts, flow_param->Feature_Size,
+					flow_param->Generator_Type, (flow_param->Request_Rate == 0 ? 0 : NanoSecondCoeff / flow_param->Request_Rate), flow_param->Average_No_of_Reqs_in_Queue,
+					flow_param->Seed, flow_param->Stop_Time, flow_param->Initial_Occupancy_Percentage / double(100.0), flow_param->Total_Requests_To_Generate, ssd_host_interface->GetType(), this->PCIe_root_complex, this->SATA_hba,
+					parameters->Enable_ResponseTime_Logging, parameters->ResponseTime_Logging_Period_Length, parameters->Input_file_path + ".IO_Flow.No_" + std::to_string(flow_id) + ".log");
+				this->IO_flows.push_back(io_flow);
+				break;
+			}
 			default:
 				throw "The specified IO flow type is not supported.\n";
 		}
@@ -104,6 +118,23 @@ void Host_System::Attach_ssd_device(SSD_Device* ssd_device)
 	ssd_device->Attach_to_host(this->PCIe_switch);
 	this->PCIe_switch->Attach_ssd_device(ssd_device->Host_interface);
 	this->ssd_device = ssd_device;
+
+	//Graph-guided prefetching needs the on-flash graph layout, which only the GNN sampling flows know
+	SSD_Components::Data_Cache_Manager_Flash_Advanced* dcm = dynamic_cast<SSD_Components::Data_Cache_Manager_Flash_Advanced*>(ssd_device->Cache_manager);
+	SSD_Components::Data_Cache_Prefetcher_Graph_Guided* prefetcher = dcm == NULL ? NULL : dynamic_cast<SSD_Components::Data_Cache_Prefetcher_Graph_Guided*>(dcm->Get_prefetcher());
+	if (prefetcher != NULL) {
+		std::vector<Host_Components::IO_Flow_GNN_Sampling*> gnn_flows;//Indexed by stream id, which is the flow id
+		for (auto &flow : IO_flows) {
+			gnn_flows.push_back(dynamic_cast<Host_Components::IO_Flow_GNN_Sampling*>(flow));
+		}
+		unsigned int sectors_per_page = ssd_device->Get_no_of_LHAs_in_an_NVM_write_unit();
+		prefetcher->Set_neighbor_page_resolver([gnn_flows, sectors_per_page](const stream_id_type stream_id, const LPA_type lpa, std::vector<LPA_type>& pages) {
+			if (stream_id >= gnn_flows.size() || gnn_flows[stream_id] == NULL) {
+				return false;
+			}
+			return gnn_flows[stream_id]->Resolve_feature_pages(lpa, sectors_per_page, pages);
+		});
+	}
 }
 
 const std::vector<Host_Components::IO_Flow_Base*> Host_System::Get_io_flows()
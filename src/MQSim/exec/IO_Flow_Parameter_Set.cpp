@@ -472,4 +472,129 @@ void IO_Flow_Parameter_Set_Trace_Based::XML_deserialize(rapidxml::xml_node<> *no
 	} catch (...) {
 		PRINT_ERROR("Error in IO_Flow_Parameter_Set_Trace_Based!")
 	}
-}
\ No newline at end of file
+}
+
+void IO_Flow_Parameter_Set_GNN_Sampling::XML_serialize(Utils::XmlWriter& xmlwriter)
+{
+	std::string tmp = "IO_Flow_Parameter_Set_GNN_Sampling";
+	xmlwriter.Write_open_tag(tmp);
+	IO_Flow_Parameter_Set::XML_serialize(xmlwriter);
+
+	std::string attr = "Graph_Path";
+	std::string val = Graph_Path;
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Graph_Block_Size";
+	val = std::to_string(Graph_Block_Size);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Batch_Size";
+	val = std::to_string(Batch_Size);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Fanouts";
+	val = "";
+	for (std::size_t i = 0; i < Fanouts.size(); i++) {
+		if (i > 0) {
+			val += ",";
+		}
+		val += std::to_string(Fanouts[i]);
+	}
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Feature_Size";
+	val = std::to_string(Feature_Size);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Generator_Type";
+	switch (Generator_Type) {
+		case Utils::Request_Generator_Type::BANDWIDTH:
+			val = "BANDWIDTH";
+			break;
+		case Utils::Request_Generator_Type::QUEUE_DEPTH:
+			val = "QUEUE_DEPTH";
+			break;
+	}
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Average_No_of_Reqs_in_Queue";
+	val = std::to_string(Average_No_of_Reqs_in_Queue);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Request_Rate";
+	val = std::to_string(Request_Rate);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Seed";
+	val = std::to_string(Seed);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Stop_Time";
+	val = std::to_string(Stop_Time);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	attr = "Total_Requests_To_Generate";
+	val = std::to_string(Total_Requests_To_Generate);
+	xmlwriter.Write_attribute_string(attr, val);
+
+	xmlwriter.Write_close_tag();
+}
+
+void IO_Flow_Parameter_Set_GNN_Sampling::XML_deserialize(rapidxml::xml_node<> *node)
+{
+	IO_Flow_Parameter_Set::XML_deserialize(node);
+
+	try {
+		for (auto param = node->first_node(); param; param = param->next_sibling()) {
+			if (strcmp(param->name(), "Graph_Path") == 0) {
+				Graph_Path = param->value();
+			} else if (strcmp(param->name(), "Graph_Block_Size") == 0) {
+				std::string val = param->value();
+				Graph_Block_Size = std::stoi(val);
+			} else if (strcmp(param->name(), "Batch_Size") == 0) {
+				std::string val = param->value();
+				Batch_Size = std::stoi(val);
+			} else if (strcmp(param->name(), "Fanouts") == 0) {
+				Fanouts.clear();
+				char tmp[1000], *tmp2;
+				strncpy(tmp, param->value(), 1000);
+				tmp[999] = '\0';
+				tmp2 = strtok(tmp, ",");
+				while (tmp2 != NULL) {
+					Fanouts.push_back(std::stoi(std::string(tmp2)));
+					tmp2 = strtok(NULL, ",");
+				}
+			} else if (strcmp(param->name(), "Feature_Size") == 0) {
+				std::string val = param->value();
+				Feature_Size = std::stoi(val);
+			} else if (strcmp(param->name(), "Generator_Type") == 0) {
+				std::string val = param->value();
+				std::transform(val.begin(), val.end(), val.begin(), ::toupper);
+				if (strcmp(val.c_str(), "BANDWIDTH") == 0) {
+					Generator_Type = Utils::Request_Generator_Type::BANDWIDTH;
+				} else if (strcmp(val.c_str(), "QUEUE_DEPTH") == 0) {
+					Generator_Type = Utils::Request_Generator_Type::QUEUE_DEPTH;
+				} else {
+					PRINT_ERROR("Unknown GNN sampling generator type specified in the input file")
+				}
+			} else if (strcmp(param->name(), "Average_No_of_Reqs_in_Queue") == 0) {
+				std::string val = param->value();
+				Average_No_of_Reqs_in_Queue = std::stoi(val);
+			} else if (strcmp(param->name(), "Request_Rate") == 0) {
+				std::string val = param->value();
+				Request_Rate = std::stoi(val);
+			} else if (strcmp(param->name(), "Seed") == 0) {
+				std::string val = param->value();
+				Seed = std::stoi(val);
+			} else if (strcmp(param->name(), "Stop_Time") == 0) {
+				std::string val = param->value();
+				Stop_Time = std::stoll(val);
+			} else if (strcmp(param->name(), "Total_Requests_To_Generate") == 0) {
+				std::string val = param->value();
+				Total_Requests_To_Generate = std::stoi(val);
+			}
+		}
+	} catch (...) {
+		PRINT_ERROR("Error in IO_Flow_Parameter_Set_GNN_Sampling!")
+	}
+}
@@ -6,11 +6,12 @@
 #include "../ssd/Host_Interface_Defs.h"
 #include "../host/IO_Flow_Synthetic.h"
 #include "../host/IO_Flow_Trace_Based.h"
+#include "../host/IO_Flow_GNN_Sampling.h"
 #include "../utils/Workload_Statistics.h"
 #include "../utils/DistributionTypes.h"
 #include "Parameter_Set_Base.h"
 
-enum class Flow_Type { SYNTHETIC, TRACE };
+enum class Flow_Type { SYNTHETIC, TRACE, GNN_SAMPLING };
 class IO_Flow_Parameter_Set : public Parameter_Set_Base
 {
 public:
@@ -67,4 +68,25 @@ public:
 	void XML_deserialize(rapidxml::xml_node<> *node);
 };
 
+class IO_Flow_Parameter_Set_GNN_Sampling : public IO_Flow_Parameter_Set
+{
+public:
+	IO_Flow_Parameter_Set_GNN_Sampling() { this->Type = Flow_Type::GNN_SAMPLING; }
+	std::string Graph_Path;//The graph directory, in the format read by GraphUtil::Graph::import
+	unsigned int Graph_Block_Size;//The size of the edge-list blocks in bytes
+	unsigned int Batch_Size;//Number of target vertices per mini-batch
+	std::vector<unsigned int> Fanouts;//Number of sampled neighbors per vertex for each layer, e.g., 25,10
+	unsigned int Feature_Size;//Size of the feature vector of a vertex in bytes
+	Utils::Request_Generator_Type Generator_Type;//QUEUE_DEPTH: closed-loop, BANDWIDTH: open-loop at Request_Rate
+	unsigned int Average_No_of_Reqs_in_Queue;
+	unsigned int Request_Rate;//Requests per second in the BANDWIDTH mode
+	int Seed;
+
+	sim_time_type Stop_Time;//Defines when to stop generating I/O requests
+	unsigned int Total_Requests_To_Generate;//If Stop_Time is equal to zero, then requst generator considers Total_Requests_To_Generate to decide when to stop generating I/O requests
+
+	void XML_serialize(Utils::XmlWriter& xmlwriter);
+	void XML_deserialize(rapidxml::xml_node<> *node);
+};
+
 #endif // !IO_FLOW_PARAMETER_SET_H
@@ -19,7 +19,7 @@
 
 SSD_Device *SSD_Device::my_instance; //Used in static functions
 
-SSD_Device::SSD_Device(Device_Parameter_Set *parameters, std::vector<IO_Flow_Parameter_Set *> *io_flows) : MQSimEngine::Sim_Object("SSDDevice")
+SSD_Device::SSD_Device(Device_Parameter_Set *parameters, std::vector<IO_Flow_Parameter_Set *> *io_flows) : MQSimEngine::Sim_Object("SSDDevice"), functional_mode(false), functional_read_pages(0), functional_write_pages(0)
 {
 	SSD_Device *device = this;
 	my_instance = device; //used for static functions
@@ -336,7 +336,8 @@ SSD_Device::SSD_Device(Device_Parameter_Set *parameters, std::vector<IO_Flow_Par
 																		parameters->Data_Cache_Capacity, parameters->Data_Cache_DRAM_Row_Size, parameters->Data_Cache_DRAM_Data_Rate,
 																		parameters->Data_Cache_DRAM_Data_Busrt_Size, parameters->Data_Cache_DRAM_tRCD, parameters->Data_Cache_DRAM_tCL, parameters->Data_Cache_DRAM_tRP,
 																		caching_modes, parameters->Data_Cache_Sharing_Mode, (unsigned int)io_flows->size(),
-																		parameters->Flash_Parameters.Page_Capacity / SECTOR_SIZE_IN_BYTE, parameters->Flash_Channel_Count * parameters->Chip_No_Per_Channel * parameters->Flash_Parameters.Die_No_Per_Chip * parameters->Flash_Parameters.Plane_No_Per_Die * parameters->Flash_Parameters.Page_Capacity / SECTOR_SIZE_IN_BYTE);
+																		parameters->Flash_Parameters.Page_Capacity / SECTOR_SIZE_IN_BYTE, parameters->Flash_Channel_Count * parameters->Chip_No_Per_Channel * parameters->Flash_Parameters.Die_No_Per_Chip * parameters->Flash_Parameters.Plane_No_Per_Die * parameters->Flash_Parameters.Page_Capacity / SECTOR_SIZE_IN_BYTE,
+																		parameters->Data_Cache_Prefetching_Mode, parameters->Data_Cache_Prefetch_Degree, parameters->Data_Cache_Prefetch_Stream_Table_Size);
 
 			break;
 		default:
@@ -435,6 +436,7 @@ void SSD_Device::Report_results_in_XML(std::string name_prefix, Utils::XmlWriter
 	{
 		((SSD_Components::FTL *)this->Firmware)->Report_results_in_XML(ID(), xmlwriter);
 		((SSD_Components::FTL *)this->Firmware)->TSU->Report_results_in_XML(ID(), xmlwriter);
+		this->Cache_manager->Report_results_in_XML(ID(), xmlwriter);
 
 		for (unsigned int channel_cntr = 0; channel_cntr < Channel_count; channel_cntr++)
 		{
@@ -461,3 +463,105 @@ page_status_type SSD_Device::Find_NVM_subunit_access_bitmap(LHA_type lha)
 {
 	return my_instance->Firmware->Find_NVM_subunit_access_bitmap(lha);
 }
+
+void SSD_Device::Enter_functional_mode()
+{
+	if (Memory_Type != NVM::NVM_Type::FLASH) {
+		PRINT_ERROR("Functional mode is only supported for flash based SSDs!")
+	}
+	if (functional_mode) {
+		return;
+	}
+	functional_mode = true;
+	functional_read_pages = 0;
+	functional_write_pages = 0;
+	((SSD_Components::FTL *)Firmware)->GC_and_WL_Unit->Set_functional_mode(true);
+}
+
+void SSD_Device::Exit_functional_mode()
+{
+	if (!functional_mode) {
+		return;
+	}
+	functional_mode = false;
+	((SSD_Components::FTL *)Firmware)->GC_and_WL_Unit->Set_functional_mode(false);
+	PRINT_MESSAGE("Leaving SSD functional mode after " << functional_read_pages << " page reads and " << functional_write_pages << " page writes");
+}
+
+void SSD_Device::Functional_access(stream_id_type stream_id, LHA_type start_lha, unsigned int size_in_sectors, bool is_write)
+{
+	if (!functional_mode) {
+		PRINT_ERROR("Functional access issued while the SSD is not in functional mode!")
+	}
+
+	unsigned int sectors_per_page = Get_no_of_LHAs_in_an_NVM_write_unit();
+	LPA_type logical_pages_count = ((SSD_Components::FTL *)Firmware)->Address_Mapping_Unit->Get_logical_pages_count(stream_id);
+	LHA_type lha = start_lha;
+	unsigned int handled_sectors_count = 0;
+	while (handled_sectors_count < size_in_sectors)
+	{
+		unsigned int transaction_size = sectors_per_page - (unsigned int)(lha % sectors_per_page);
+		if (handled_sectors_count + transaction_size >= size_in_sectors)
+		{
+			transaction_size = size_in_sectors - handled_sectors_count;
+		}
+		LPA_type lpa = (lha / sectors_per_page) % logical_pages_count;
+		page_status_type temp = ~(0xffffffffffffffff << (int)transaction_size);
+		page_status_type access_status_bitmap = temp << (int)(lha % sectors_per_page);
+
+		Cache_manager->Functional_access(stream_id, lpa, access_status_bitmap, is_write);
+		if (is_write)
+		{
+			functional_write_pages++;
+		}
+		else
+		{
+			functional_read_pages++;
+		}
+
+		lha += transaction_size;
+		handled_sectors_count += transaction_size;
+	}
+}
+
+void SSD_Device::Save_checkpoint(Utils::CheckpointWriter& writer)
+{
+	if (!Simulator->is_event_tree_empty()) {
+		PRINT_ERROR("Cannot checkpoint the SSD while simulation events are pending!")
+	}
+
+	writer.Write_section("SSD_Device");
+	writer.Write(Device_Parameter_Set::Flash_Channel_Count);
+	writer.Write(Device_Parameter_Set::Chip_No_Per_Channel);
+	writer.Write(Device_Parameter_Set::Flash_Parameters.Die_No_Per_Chip);
+	writer.Write(Device_Parameter_Set::Flash_Parameters.Plane_No_Per_Die);
+	writer.Write(Device_Parameter_Set::Flash_Parameters.Block_No_Per_Plane);
+	writer.Write(Device_Parameter_Set::Flash_Parameters.Page_No_Per_Block);
+	writer.Write(Get_no_of_LHAs_in_an_NVM_write_unit());
+	writer.Write(Simulator->Time());
+
+	((SSD_Components::FTL *)Firmware)->Save_checkpoint(writer);
+	Cache_manager->Save_checkpoint(writer);
+}
+
+void SSD_Device::Load_checkpoint(Utils::CheckpointReader& reader)
+{
+	if (!Simulator->is_event_tree_empty()) {
+		PRINT_ERROR("Cannot restore an SSD checkpoint while simulation events are pending!")
+	}
+
+	reader.Read_section("SSD_Device");
+	if (reader.Read<unsigned int>() != Device_Parameter_Set::Flash_Channel_Count
+		|| reader.Read<unsigned int>() != Device_Parameter_Set::Chip_No_Per_Channel
+		|| reader.Read<unsigned int>() != Device_Parameter_Set::Flash_Parameters.Die_No_Per_Chip
+		|| reader.Read<unsigned int>() != Device_Parameter_Set::Flash_Parameters.Plane_No_Per_Die
+		|| reader.Read<unsigned int>() != Device_Parameter_Set::Flash_Parameters.Block_No_Per_Plane
+		|| reader.Read<unsigned int>() != Device_Parameter_Set::Flash_Parameters.Page_No_Per_Block
+		|| reader.Read<unsigned int>() != Get_no_of_LHAs_in_an_NVM_write_unit()) {
+		PRINT_ERROR("The SSD geometry in the checkpoint does not match the current configuration!")
+	}
+	Simulator->set_sim_time(reader.Read<sim_time_type>());
+
+	((SSD_Components::FTL *)Firmware)->Load_checkpoint(reader);
+	Cache_manager->Load_checkpoint(reader);
+}
@@ -18,6 +18,7 @@
 #include "Device_Parameter_Set.h"
 #include "IO_Flow_Parameter_Set.h"
 #include "../utils/Workload_Statistics.h"
+#include "../utils/Checkpoint.h"
 
 /*********************************************************************************************************
 * An SSD device has the following components:
@@ -49,11 +50,23 @@ public:
 	static LPA_type Convert_host_logical_address_to_device_address(LHA_type lha);
 	static page_status_type Find_NVM_subunit_access_bitmap(LHA_type lha);
 
+	//Functional mode: accesses update the FTL mapping, CMT, block and cache state without simulating timing, e.g., while the host simulator fast-forwards
+	void Enter_functional_mode();
+	void Exit_functional_mode();
+	bool Is_in_functional_mode() { return functional_mode; }
+	void Functional_access(stream_id_type stream_id, LHA_type start_lha, unsigned int size_in_sectors, bool is_write);//start_lha is relative to the logical address range of the stream
+
+	//Checkpointing: stores the simulation time, FTL and cache state so that a warmed-up SSD can be reused across runs. Only allowed when no event is pending.
+	void Save_checkpoint(Utils::CheckpointWriter& writer);
+	void Load_checkpoint(Utils::CheckpointReader& reader);
+
 	unsigned int Channel_count;
 	unsigned int Chip_no_per_channel;
 
 private:
 	static SSD_Device * my_instance;//Used in static functions
+	bool functional_mode;
+	unsigned long long functional_read_pages, functional_write_pages;
 };
 
 #endif //!SSD_DEVICE_H
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include "../sim/Engine.h"
+#include "IO_Flow_GNN_Sampling.h"
+
+namespace Host_Components
+{
+	IO_Flow_GNN_Sampling::IO_Flow_GNN_Sampling(const sim_object_id_type &name, uint16_t flow_id, LHA_type start_lsa_on_device, LHA_type end_lsa_on_device, uint16_t io_queue_id,
+		uint16_t nvme_submission_queue_size, uint16_t nvme_completion_queue_size, IO_Flow_Priority_Class::Priority priority_class,
+		std::string graph_path, unsigned int graph_block_size, unsigned int batch_size, const std::vector<unsigned int>& fanouts, unsigned int feature_size,
+		Utils::Request_Generator_Type generator_type, sim_time_type Average_inter_arrival_time_nano_sec, unsigned int average_number_of_enqueued_requests,
+		int seed, sim_time_type stop_time, double initial_occupancy_ratio, unsigned int total_req_count, HostInterface_Types SSD_device_type, PCIe_Root_Complex *pcie_root_complex, SATA_HBA *sata_hba,
+		bool enabled_logging, sim_time_type logging_period, std::string logging_file_path)
+		: IO_Flow_Base(name, flow_id, start_lsa_on_device, end_lsa_on_device, io_queue_id, nvme_submission_queue_size, nvme_completion_queue_size, priority_class, stop_time, initial_occupancy_ratio, total_req_count, SSD_device_type, pcie_root_complex, sata_hba, enabled_logging, logging_period, logging_file_path),
+		batch_size(batch_size), fanouts(fanouts), generator_type(generator_type), random_time_interval_generator(NULL), random_time_interval_generator_seed(0), Average_inter_arrival_time_nano_sec(Average_inter_arrival_time_nano_sec),
+		average_number_of_enqueued_requests(average_number_of_enqueued_requests)
+	{
+		if (this->start_lsa_on_device > this->end_lsa_on_device) {
+			throw std::logic_error("Problem in IO Flow GNN Sampling, the start LBA address is greater than the end LBA address");
+		}
+		if (batch_size == 0 || graph_block_size == 0 || feature_size == 0) {
+			PRINT_ERROR("The batch size, graph block size and feature size of GNN sampling workload " << name << " should be larger than zero")
+		}
+
+		graph.import(graph_path, graph_block_size);
+		if (graph.get_global_metadata().nverts == 0) {
+			PRINT_ERROR("The graph of GNN sampling workload " << name << " has no vertices")
+		}
+		block_size_in_sectors = (graph_block_size - 1) / SECTOR_SIZE_IN_BYTE + 1;
+		feature_size_in_sectors = (feature_size - 1) / SECTOR_SIZE_IN_BYTE + 1;
+		feature_table_start_offset = (LHA_type)graph.get_global_metadata().nblocks * block_size_in_sectors;
+		layout_size_in_sectors = feature_table_start_offset + (LHA_type)graph.get_global_metadata().nverts * feature_size_in_sectors;
+
+		random_vertex_generator_seed = seed++;
+		random_vertex_generator = new Utils::RandomGenerator(random_vertex_generator_seed);
+		if (generator_type == Utils::Request_Generator_Type::BANDWIDTH) {
+			random_time_interval_generator_seed = seed++;
+			random_time_interval_generator = new Utils::RandomGenerator(random_time_interval_generator_seed);
+		}
+	}
+
+	IO_Flow_GNN_Sampling::~IO_Flow_GNN_Sampling()
+	{
+		delete random_vertex_generator;
+		delete random_time_interval_generator;
+	}
+
+	void IO_Flow_GNN_Sampling::add_read(LHA_type offset, unsigned int lba_count)
+	{
+		//A graph that is larger than the address range of the flow is folded into it
+		LHA_type range = end_lsa_on_device - start_lsa_on_device + 1;
+		if (lba_count > range) {
+			lba_count = (unsigned int)range;
+		}
+		offset %= range;
+		if (offset + lba_count > range) {
+			offset = range - lba_count;
+		}
+		Sampling_Read read;
+		read.Start_LBA = start_lsa_on_device + offset;
+		read.LBA_count = lba_count;
+		pending_reads.push_back(read);
+	}
+
+	void IO_Flow_GNN_Sampling::generate_next_batch()
+	{
+		const GraphUtil::Graph::GlobalMetadata& metadata = graph.get_global_metadata();
+		std::vector<GraphUtil::vid_t> frontier;
+		std::set<GraphUtil::vid_t> sampled_vertices;
+		for (unsigned int i = 0; i < batch_size; i++) {
+			GraphUtil::vid_t vid = (GraphUtil::vid_t)random_vertex_generator->Uniform_ulong(0, metadata.nverts - 1);
+			frontier.push_back(vid);
+			sampled_vertices.insert(vid);
+		}
+
+		for (auto fanout : fanouts) {
+			//Edge-list blocks are deduplicated within a layer and read in address order
+			std::set<GraphUtil::bid_t> blocks_to_read;
+			std::vector<GraphUtil::vid_t> next_frontier;
+			next_frontier.reserve(frontier.size() * fanout);
+			for (auto vid : frontier) {
+				if (graph.is_dvert(vid)) {
+					//The adjacency list of a dense vertex spans several blocks, only the ones holding the sampled edges are read
+					const GraphUtil::Graph::DenseVertex::Metadata& dvert = graph.get_dvert_metadata(vid);
+					for (unsigned int i = 0; i < std::min(fanout, (unsigned int)dvert.nblocks); i++) {
+						blocks_to_read.insert(dvert.blo + random_vertex_generator->Uniform_uint(0, dvert.nblocks - 1));
+					}
+				} else {
+					blocks_to_read.insert(graph.binary_search_block(vid));
+				}
+				for (unsigned int i = 0; i < fanout; i++) {
+					GraphUtil::vid_t neighbor = (GraphUtil::vid_t)random_vertex_generator->Uniform_ulong(0, metadata.nverts - 1);
+					next_frontier.push_back(neighbor);
+					sampled_vertices.insert(neighbor);
+				}
+			}
+			for (auto bid : blocks_to_read) {
+				unsigned int bytes = graph.get_block_metadata(bid).bytes;
+				unsigned int lba_count = bytes == 0 ? 1 : std::min((bytes - 1) / SECTOR_SIZE_IN_BYTE + 1, block_size_in_sectors);
+				add_read((LHA_type)bid * block_size_in_sectors, lba_count);
+			}
+			frontier.swap(next_frontier);
+		}
+
+		for (auto vid : sampled_vertices) {
+			add_read(feature_table_start_offset + (LHA_type)vid * feature_size_in_sectors, feature_size_in_sectors);
+		}
+	}
+
+	Host_IO_Request* IO_Flow_GNN_Sampling::Generate_next_request()
+	{
+		if (stop_time > 0) {
+			if (Simulator->Time() > stop_time) {
+				return NULL;
+			}
+		} else if (STAT_generated_request_count >= total_requests_to_be_generated) {
+			return NULL;
+		}
+
+		if (pending_reads.size() == 0) {
+			generate_next_batch();
+		}
+		Sampling_Read read = pending_reads.front();
+		pending_reads.pop_front();
+
+		Host_IO_Request* request = new Host_IO_Request;
+		request->Type = Host_IO_Request_Type::READ;
+		request->Start_LBA = read.Start_LBA;
+		request->LBA_count = read.LBA_count;
+		STAT_generated_read_request_count++;
+		STAT_generated_request_count++;
+		request->Arrival_time = Simulator->Time();
+		DEBUG("* Host: GNN sampling request generated - LBA:" << request->Start_LBA << ", Size_in_sectors:" << request->LBA_count << "")
+
+		return request;
+	}
+
+	void IO_Flow_GNN_Sampling::NVMe_consume_io_request(Completion_Queue_Entry* io_request)
+	{
+		IO_Flow_Base::NVMe_consume_io_request(io_request);
+		IO_Flow_Base::NVMe_update_and_submit_completion_queue_tail();
+		if (generator_type == Utils::Request_Generator_Type::QUEUE_DEPTH) {
+			Host_IO_Request* request = Generate_next_request();
+			if (request != NULL) {
+				Submit_io_request(request);
+			}
+		}
+	}
+
+	void IO_Flow_GNN_Sampling::SATA_consume_io_request(Host_IO_Request* io_request)
+	{
+		IO_Flow_Base::SATA_consume_io_request(io_request);
+		if (generator_type == Utils::Request_Generator_Type::QUEUE_DEPTH) {
+			Host_IO_Request* request = Generate_next_request();
+			if (request != NULL) {
+				Submit_io_request(request);
+			}
+		}
+	}
+
+	void IO_Flow_GNN_Sampling::Start_simulation()
+	{
+		IO_Flow_Base::Start_simulation();
+
+		if (generator_type == Utils::Request_Generator_Type::BANDWIDTH) {
+			Simulator->Register_sim_event((sim_time_type)random_time_interval_generator->Exponential((double)Average_inter_arrival_time_nano_sec), this, 0, 0);
+		} else {
+			Simulator->Register_sim_event((sim_time_type)1, this, 0, 0);
+		}
+	}
+
+	void IO_Flow_GNN_Sampling::Validate_simulation_config()
+	{
+		if (layout_size_in_sectors > end_lsa_on_device - start_lsa_on_device + 1) {
+			PRINT_MESSAGE("The graph of GNN sampling workload " << ID() << " does not fit in its logical address range and is folded into it")
+		}
+	}
+
+	void IO_Flow_GNN_Sampling::Execute_simulator_event(MQSimEngine::Sim_Event* event)
+	{
+		if (generator_type == Utils::Request_Generator_Type::BANDWIDTH) {
+			Host_IO_Request* req = Generate_next_request();
+			if (req != NULL) {
+				Submit_io_request(req);
+				Simulator->Register_sim_event(Simulator->Time() + (sim_time_type)random_time_interval_generator->Exponential((double)Average_inter_arrival_time_nano_sec), this, 0, 0);
+			}
+		} else {
+			for (unsigned int i = 0; i < average_number_of_enqueued_requests; i++) {
+				Host_IO_Request* req = Generate_next_request();
+				if (req == NULL) {
+					break;
+				}
+				Submit_io_request(req);
+			}
+		}
+	}
+
+	bool IO_Flow_GNN_Sampling::Resolve_feature_pages(const LPA_type lpa, const unsigned int sectors_per_page, std::vector<LPA_type>& pages)
+	{
+		//Device pages are numbered from the start of the flow's address range, see the segmentation in the host interface
+		LHA_type offset = (LHA_type)lpa * sectors_per_page;
+		if (offset >= feature_table_start_offset) {
+			return false;
+		}
+
+		const GraphUtil::Graph::GlobalMetadata& metadata = graph.get_global_metadata();
+		GraphUtil::bid_t first_block = (GraphUtil::bid_t)(offset / block_size_in_sectors);
+		GraphUtil::bid_t last_block = (GraphUtil::bid_t)std::min((offset + sectors_per_page - 1) / block_size_in_sectors, (LHA_type)metadata.nblocks - 1);
+		for (GraphUtil::bid_t bid = first_block; bid <= last_block; bid++) {
+			//The features of consecutive vertices are contiguous, so each block resolves to one run of pages
+			const GraphUtil::Graph::Block::Metadata& block = graph.get_block_metadata(bid);
+			GraphUtil::vid_t vup = block.vup > block.vlo ? block.vup : block.vlo + 1;
+			LPA_type first_page = (LPA_type)((feature_table_start_offset + (LHA_type)block.vlo * feature_size_in_sectors) / sectors_per_page);
+			LPA_type last_page = (LPA_type)((feature_table_start_offset + (LHA_type)vup * feature_size_in_sectors - 1) / sectors_per_page);
+			for (LPA_type page = first_page; page <= last_page; page++) {
+				if (pages.size() == 0 || page > pages.back()) {
+					pages.push_back(page);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void IO_Flow_GNN_Sampling::Get_statistics(Utils::Workload_Statistics& stats, LPA_type(*Convert_host_logical_address_to_device_address)(LHA_type lha),
+		page_status_type(*Find_NVM_subunit_access_bitmap)(LHA_type lha))
+	{
+		//Preconditioning sees the flow as a read-only synthetic workload that uniformly accesses the graph layout
+		LHA_type range = end_lsa_on_device - start_lsa_on_device + 1;
+		stats.Type = Utils::Workload_Type::SYNTHETIC;
+		stats.generator_type = generator_type;
+		stats.Stream_id = io_queue_id - 1;
+		stats.Initial_occupancy_ratio = initial_occupancy_ratio;
+		stats.Working_set_ratio = layout_size_in_sectors >= range ? 1.0 : (double)layout_size_in_sectors / (double)range;
+		stats.Read_ratio = 1.0;
+		stats.random_request_type_generator_seed = random_vertex_generator_seed;
+		stats.Address_distribution_type = Utils::Address_Distribution_Type::RANDOM_UNIFORM;
+		stats.Ratio_of_hot_addresses_to_whole_working_set = 0;
+		stats.Ratio_of_traffic_accessing_hot_region = 0;
+		stats.random_address_generator_seed = random_vertex_generator_seed;
+		stats.random_hot_address_generator_seed = random_vertex_generator_seed;
+		stats.random_hot_cold_generator_seed = random_vertex_generator_seed;
+		stats.generate_aligned_addresses = false;
+		stats.alignment_value = 1;
+		stats.Request_size_distribution_type = Utils::Request_Size_Distribution_Type::FIXED;
+		stats.Average_request_size_sector = feature_size_in_sectors;
+		stats.STDEV_reuqest_size = 0;
+		stats.random_request_size_generator_seed = random_vertex_generator_seed;
+		stats.Request_queue_depth = average_number_of_enqueued_requests;
+		stats.random_time_interval_generator_seed = random_time_interval_generator_seed;
+		stats.Average_inter_arrival_time_nano_sec = Average_inter_arrival_time_nano_sec;
+		stats.Min_LHA = start_lsa_on_device;
+		stats.Max_LHA = start_lsa_on_device + std::min(layout_size_in_sectors, range) - 1;
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef IO_FLOW_GNN_SAMPLING_H
+#define IO_FLOW_GNN_SAMPLING_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include "IO_Flow_Base.h"
+#include "../utils/RandomGenerator.h"
+#include "../utils/DistributionTypes.h"
+#include "../wrapper/graph.hh"
+
+namespace Host_Components
+{
+/* Generates the storage traffic of mini-batch neighbor sampling for GNN training. The graph is laid out in the
+* logical address space of the flow as the edge-list blocks of GraphUtil::Graph (one Graph_Block_Size slot per
+* block) followed by the vertex feature table (Feature_Size bytes per vertex). For each mini-batch, Batch_Size
+* target vertices are picked, then every layer reads the edge-list blocks of the current frontier and samples
+* Fanout neighbors per frontier vertex, and finally the features of all sampled vertices are read. Only block
+* metadata is available on the host side, so neighbor IDs are drawn uniformly over all vertices.*/
+class IO_Flow_GNN_Sampling : public IO_Flow_Base
+{
+public:
+	IO_Flow_GNN_Sampling(const sim_object_id_type &name, uint16_t flow_id, LHA_type start_lsa_on_device, LHA_type end_lsa_on_device, uint16_t io_queue_id,
+						 uint16_t nvme_submission_queue_size, uint16_t nvme_completion_queue_size, IO_Flow_Priority_Class::Priority priority_class,
+						 std::string graph_path, unsigned int graph_block_size, unsigned int batch_size, const std::vector<unsigned int>& fanouts, unsigned int feature_size,
+						 Utils::Request_Generator_Type generator_type, sim_time_type Average_inter_arrival_time_nano_sec, unsigned int average_number_of_enqueued_requests,
+						 int seed, sim_time_type stop_time, double initial_occupancy_ratio, unsigned int total_req_count, HostInterface_Types SSD_device_type, PCIe_Root_Complex *pcie_root_complex, SATA_HBA *sata_hba,
+						 bool enabled_logging, sim_time_type logging_period, std::string logging_file_path);
+	~IO_Flow_GNN_Sampling();
+	Host_IO_Request *Generate_next_request();
+	void NVMe_consume_io_request(Completion_Queue_Entry *);
+	void SATA_consume_io_request(Host_IO_Request *);
+	void Start_simulation();
+	void Validate_simulation_config();
+	void Execute_simulator_event(MQSimEngine::Sim_Event *);
+	void Get_statistics(Utils::Workload_Statistics &stats, LPA_type (*Convert_host_logical_address_to_device_address)(LHA_type lha),
+						page_status_type (*Find_NVM_subunit_access_bitmap)(LHA_type lha));
+	//Neighbor page resolver of graph-guided prefetching: maps a device page of an edge-list block to the pages holding the features of its vertices
+	bool Resolve_feature_pages(const LPA_type lpa, const unsigned int sectors_per_page, std::vector<LPA_type>& pages);
+
+private:
+	struct Sampling_Read
+	{
+		LHA_type Start_LBA;
+		unsigned int LBA_count;
+	};
+
+	GraphUtil::Graph graph;
+	unsigned int batch_size;
+	std::vector<unsigned int> fanouts;
+	unsigned int block_size_in_sectors;
+	unsigned int feature_size_in_sectors;
+	LHA_type feature_table_start_offset;//Offset of the feature table from start_lsa_on_device
+	LHA_type layout_size_in_sectors;
+	std::deque<Sampling_Read> pending_reads;//Reads of the current mini-batch that are not submitted yet
+	Utils::RandomGenerator *random_vertex_generator;
+	int random_vertex_generator_seed;
+	Utils::Request_Generator_Type generator_type;
+	Utils::RandomGenerator *random_time_interval_generator;
+	int random_time_interval_generator_seed;
+	sim_time_type Average_inter_arrival_time_nano_sec;
+	unsigned int average_number_of_enqueued_requests;
+
+	void generate_next_batch();
+	void add_read(LHA_type offset, unsigned int lba_count);
+};
+} // namespace Host_Components
+
+#endif // !IO_FLOW_GNN_SAMPLING_H
@@ -4,6 +4,7 @@
 #include "../sim/Sim_Object.h"
 #include "../nvm_chip/flash_memory/Physical_Page_Address.h"
 #include "../nvm_chip/flash_memory/FlashTypes.h"
+#include "../utils/Checkpoint.h"
 #include "SSD_Defs.h"
 #include "NVM_Transaction_Flash.h"
 #include "NVM_PHY_ONFI_NVDDR2.h"
@@ -47,10 +48,18 @@ namespace SSD_Components
 		virtual int Bring_to_CMT_for_preconditioning(stream_id_type stream_id, LPA_type lpa) = 0;//Used for warming up the cached mapping table during preconditioning
 		virtual void Store_mapping_table_on_flash_at_start() = 0; //It should only be invoked at the begenning of the simulation to store mapping table entries on the flash space
 
+		//Functional (timing-free) execution, used to warm up the mapping and block state while the host is fast-forwarding
+		virtual void Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write) = 0;
+
+		//Checkpointing of the mapping state, only allowed while no transaction is in flight
+		virtual void Save_checkpoint(Utils::CheckpointWriter& writer) = 0;
+		virtual void Load_checkpoint(Utils::CheckpointReader& reader) = 0;
+
 		
 		virtual unsigned int Get_cmt_capacity() = 0;//Returns the maximum number of entries that could be stored in the cached mapping table
 		virtual unsigned int Get_current_cmt_occupancy_for_stream(stream_id_type stream_id) = 0;
 		virtual LPA_type Get_logical_pages_count(stream_id_type stream_id) = 0; //Returns the number of logical pages allocated to an I/O stream
+		virtual bool Is_lpa_mapped(const stream_id_type stream_id, const LPA_type lpa) = 0; //False if the LPA was never written, reading it would allocate a new mapping
 		unsigned int Get_no_of_input_streams() { return no_of_input_streams; }
 		bool Is_ideal_mapping_table(); //Checks if ideal mapping table is enabled in which all address translations entries are always in CMT (i.e., CMT is infinite in size) and thus all adddress translation requests are always successful
 
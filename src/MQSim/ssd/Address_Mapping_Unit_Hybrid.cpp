@@ -17,6 +17,9 @@ namespace SSD_Components
 
 	void Address_Mapping_Unit_Hybrid::Allocate_address_for_preconditioning(const stream_id_type stream_id, std::map<LPA_type, page_status_type>& lpa_list, std::vector<double>& steady_state_distribution) {}
 	int Address_Mapping_Unit_Hybrid::Bring_to_CMT_for_preconditioning(stream_id_type stream_id, LPA_type lpa) { return 0; }
+	void Address_Mapping_Unit_Hybrid::Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write) {}
+	void Address_Mapping_Unit_Hybrid::Save_checkpoint(Utils::CheckpointWriter& writer) {}
+	void Address_Mapping_Unit_Hybrid::Load_checkpoint(Utils::CheckpointReader& reader) {}
 	unsigned int Address_Mapping_Unit_Hybrid::Get_cmt_capacity() { return 0; }
 	unsigned int Address_Mapping_Unit_Hybrid::Get_current_cmt_occupancy_for_stream(stream_id_type stream_id) { return 0; }
 	void Address_Mapping_Unit_Hybrid::Translate_lpa_to_ppa_and_dispatch(const std::list<NVM_Transaction*>& transaction_list) {}
@@ -37,6 +40,11 @@ namespace SSD_Components
 		return 0;
 	}
 
+	bool Address_Mapping_Unit_Hybrid::Is_lpa_mapped(const stream_id_type stream_id, const LPA_type lpa)
+	{
+		return false;
+	}
+
 	void Address_Mapping_Unit_Hybrid::Convert_ppa_to_address(const PPA_type ppa, NVM::FlashMemory::Physical_Page_Address& address) {}
 	PPA_type Address_Mapping_Unit_Hybrid::Convert_address_to_ppa(const NVM::FlashMemory::Physical_Page_Address& pageAddress) { return 0; }
 	void Address_Mapping_Unit_Hybrid::Store_mapping_table_on_flash_at_start() {}
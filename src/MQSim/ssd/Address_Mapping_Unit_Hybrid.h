@@ -20,6 +20,9 @@ namespace SSD_Components
 
 		void Allocate_address_for_preconditioning(const stream_id_type stream_id, std::map<LPA_type, page_status_type>& lpa_list, std::vector<double>& steady_state_distribution);
 		int Bring_to_CMT_for_preconditioning(stream_id_type stream_id, LPA_type lpa);
+		void Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write);
+		void Save_checkpoint(Utils::CheckpointWriter& writer);
+		void Load_checkpoint(Utils::CheckpointReader& reader);
 		unsigned int Get_cmt_capacity();
 		unsigned int Get_current_cmt_occupancy_for_stream(stream_id_type stream_id);
 		void Translate_lpa_to_ppa_and_dispatch(const std::list<NVM_Transaction*>& transactionList);
@@ -29,6 +32,7 @@ namespace SSD_Components
 
 		void Store_mapping_table_on_flash_at_start();
 		LPA_type Get_logical_pages_count(stream_id_type stream_id);
+		bool Is_lpa_mapped(const stream_id_type stream_id, const LPA_type lpa);
 		NVM::FlashMemory::Physical_Page_Address Convert_ppa_to_address(const PPA_type ppa);
 		void Convert_ppa_to_address(const PPA_type ppn, NVM::FlashMemory::Physical_Page_Address& address);
 		PPA_type Convert_address_to_ppa(const NVM::FlashMemory::Physical_Page_Address& pageAddress);
@@ -164,6 +164,48 @@ namespace SSD_Components
 	}
 
 
+	void Cached_Mapping_Table::Save_checkpoint(Utils::CheckpointWriter& writer)
+	{
+		//Entries are stored from the most to the least recently used one, so that the LRU order survives a restore
+		writer.Write((uint64_t)lruList.size());
+		for (auto &entry : lruList) {
+			if (entry.second->Status != CMTEntryStatus::VALID) {
+				PRINT_ERROR("Cannot checkpoint the CMT while a mapping entry is being read from flash!")
+			}
+			writer.Write(entry.first);
+			writer.Write(entry.second->PPA);
+			writer.Write(entry.second->WrittenStateBitmap);
+			writer.Write(entry.second->Dirty);
+			writer.Write(entry.second->Stream_id);
+		}
+	}
+
+	void Cached_Mapping_Table::Load_checkpoint(Utils::CheckpointReader& reader)
+	{
+		for (auto &entry : lruList) {
+			delete entry.second;
+		}
+		lruList.clear();
+		addressMap.clear();
+
+		uint64_t entry_count = reader.Read<uint64_t>();
+		if (entry_count > capacity) {
+			PRINT_ERROR("The CMT stored in the checkpoint does not fit in the configured CMT capacity!")
+		}
+		for (uint64_t i = 0; i < entry_count; i++) {
+			LPA_type key = reader.Read<LPA_type>();
+			CMTSlotType* cmtEnt = new CMTSlotType();
+			reader.Read(cmtEnt->PPA);
+			reader.Read(cmtEnt->WrittenStateBitmap);
+			reader.Read(cmtEnt->Dirty);
+			reader.Read(cmtEnt->Stream_id);
+			cmtEnt->Status = CMTEntryStatus::VALID;
+			lruList.push_back(std::pair<LPA_type, CMTSlotType*>(key, cmtEnt));
+			cmtEnt->listPtr = std::prev(lruList.end());
+			addressMap[key] = cmtEnt;
+		}
+	}
+
 	AddressMappingDomain::AddressMappingDomain(unsigned int cmt_capacity, unsigned int cmt_entry_size, unsigned int no_of_translation_entries_per_page,
 		Cached_Mapping_Table* CMT,
 		Flash_Plane_Allocation_Scheme_Type PlaneAllocationScheme,
@@ -467,6 +509,120 @@ namespace SSD_Components
 		return domains[stream_id]->No_of_inserted_entries_in_preconditioning;
 	}
 
+	void Address_Mapping_Unit_Page_Level::Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write)
+	{
+		AddressMappingDomain* domain = domains[stream_id];
+		if (lpa >= domain->Total_logical_pages_no) {
+			PRINT_ERROR("Out of range LPA specified for functional access! LPA shoud be smaller than " << domain->Total_logical_pages_no << ", but it is " << lpa)
+		}
+
+		functional_bring_to_cmt(stream_id, lpa);
+
+		if (!is_write) {
+			//Reading a never written page creates its mapping entry, exactly as in translate_lpa_to_ppa
+			if (domain->Get_ppa(ideal_mapping_table, stream_id, lpa) == NO_PPA) {
+				NVM::FlashMemory::Physical_Page_Address address;
+				online_create_entry_for_reads(lpa, stream_id, address, sectors_bitmap);
+				block_manager->Program_transaction_serviced(address);
+				flash_controller->Change_flash_page_status_for_preconditioning(address, lpa);
+			}
+			return;
+		}
+
+		//The transaction is only used as an argument carrier for the allocation functions, it is never submitted to the TSU
+		NVM_Transaction_Flash_WR transaction(Transaction_Source_Type::USERIO, stream_id, count_sector_no_from_status_bitmap(sectors_bitmap) * SECTOR_SIZE_IN_BYTE,
+			lpa, NULL, IO_Flow_Priority_Class::UNDEFINED, 0, sectors_bitmap, CurrentTimeStamp);
+		allocate_plane_for_user_write(&transaction);
+		allocate_page_in_plane_for_user_write(&transaction, false);
+		if (transaction.RelatedRead != NULL) {
+			block_manager->Read_transaction_serviced(transaction.RelatedRead->Address);
+			delete transaction.RelatedRead;
+			transaction.RelatedRead = NULL;
+		}
+		block_manager->Program_transaction_serviced(transaction.Address);
+		flash_controller->Change_flash_page_status_for_preconditioning(transaction.Address, lpa);
+	}
+
+	void Address_Mapping_Unit_Page_Level::functional_bring_to_cmt(const stream_id_type stream_id, const LPA_type lpa)
+	{
+		AddressMappingDomain* domain = domains[stream_id];
+		if (ideal_mapping_table || domain->CMT->Exists(stream_id, lpa)) {
+			return;
+		}
+		if (domain->CMT->Is_slot_reserved_for_lpn_and_waiting(stream_id, lpa)) {
+			PRINT_ERROR("Functional access to an LPA whose mapping read is still in flight! Functional mode should only be entered when the SSD is idle.")
+		}
+
+		if (!domain->CMT->Check_free_slot_availability()) {
+			LPA_type evicted_lpa;
+			CMTSlotType evicted_item = domain->CMT->Evict_one_slot(evicted_lpa);
+			if (evicted_item.Dirty) {
+				//No translation page is programmed in functional mode, GMT is updated in place
+				domain->GlobalMappingTable[evicted_lpa].PPA = evicted_item.PPA;
+				domain->GlobalMappingTable[evicted_lpa].WrittenStateBitmap = evicted_item.WrittenStateBitmap;
+				domain->GlobalMappingTable[evicted_lpa].TimeStamp = CurrentTimeStamp;
+			}
+		}
+		domain->CMT->Reserve_slot_for_lpn(stream_id, lpa);
+		domain->CMT->Insert_new_mapping_info(stream_id, lpa,
+			domain->GlobalMappingTable[lpa].PPA, domain->GlobalMappingTable[lpa].WrittenStateBitmap);
+	}
+
+	void Address_Mapping_Unit_Page_Level::Save_checkpoint(Utils::CheckpointWriter& writer)
+	{
+		writer.Write_section("AddressMappingUnit");
+		writer.Write((uint32_t)no_of_input_streams);
+		for (unsigned int stream_id = 0; stream_id < no_of_input_streams; stream_id++) {
+			AddressMappingDomain* domain = domains[stream_id];
+			if (domain->Waiting_unmapped_read_transactions.size() > 0 || domain->Waiting_unmapped_program_transactions.size() > 0
+				|| domain->ArrivingMappingEntries.size() > 0 || domain->DepartingMappingEntries.size() > 0
+				|| domain->Locked_LPAs.size() > 0 || domain->Locked_MVPNs.size() > 0) {
+				PRINT_ERROR("Cannot checkpoint the address mapping unit while transactions of stream " << stream_id << " are in flight!")
+			}
+			writer.Write(domain->Total_logical_pages_no);
+			writer.Write(domain->Total_translation_pages_no);
+			writer.Write(domain->No_of_inserted_entries_in_preconditioning);
+			writer.Write_array(domain->GlobalMappingTable, domain->Total_logical_pages_no);
+			writer.Write_array(domain->GlobalTranslationDirectory, domain->Total_translation_pages_no + 1);
+
+			//A shared CMT is referenced by all domains, so it is only stored once with the first domain
+			bool shared_cmt = stream_id > 0 && domain->CMT == domains[0]->CMT;
+			writer.Write(shared_cmt);
+			if (!shared_cmt) {
+				domain->CMT->Save_checkpoint(writer);
+			}
+		}
+		writer.Write(mapping_table_stored_on_flash);
+	}
+
+	void Address_Mapping_Unit_Page_Level::Load_checkpoint(Utils::CheckpointReader& reader)
+	{
+		reader.Read_section("AddressMappingUnit");
+		if (reader.Read<uint32_t>() != no_of_input_streams) {
+			PRINT_ERROR("The number of I/O streams in the SSD checkpoint does not match the current configuration!")
+		}
+		for (unsigned int stream_id = 0; stream_id < no_of_input_streams; stream_id++) {
+			AddressMappingDomain* domain = domains[stream_id];
+			LPA_type total_logical_pages_no = reader.Read<LPA_type>();
+			MVPN_type total_translation_pages_no = reader.Read<MVPN_type>();
+			if (total_logical_pages_no != domain->Total_logical_pages_no || total_translation_pages_no != domain->Total_translation_pages_no) {
+				PRINT_ERROR("The logical address space of stream " << stream_id << " in the SSD checkpoint does not match the current configuration!")
+			}
+			reader.Read(domain->No_of_inserted_entries_in_preconditioning);
+			reader.Read_array(domain->GlobalMappingTable, domain->Total_logical_pages_no);
+			reader.Read_array(domain->GlobalTranslationDirectory, domain->Total_translation_pages_no + 1);
+
+			bool shared_cmt = reader.Read<bool>();
+			if (shared_cmt != (stream_id > 0 && domain->CMT == domains[0]->CMT)) {
+				PRINT_ERROR("The CMT sharing mode in the SSD checkpoint does not match the current configuration!")
+			}
+			if (!shared_cmt) {
+				domain->CMT->Load_checkpoint(reader);
+			}
+		}
+		reader.Read(mapping_table_stored_on_flash);
+	}
+
 	unsigned int Address_Mapping_Unit_Page_Level::Get_cmt_capacity()
 	{
 		return cmt_capacity;
@@ -1422,6 +1578,14 @@ namespace SSD_Components
 	{
 		return this->domains[stream_id]->Total_logical_pages_no;
 	}
+
+	bool Address_Mapping_Unit_Page_Level::Is_lpa_mapped(const stream_id_type stream_id, const LPA_type lpa)
+	{
+		PPA_type ppa;
+		page_status_type page_state;
+		Get_data_mapping_info_for_gc(stream_id, lpa, ppa, page_state);
+		return ppa != NO_PPA;
+	}
 	
 	inline NVM::FlashMemory::Physical_Page_Address Address_Mapping_Unit_Page_Level::Convert_ppa_to_address(const PPA_type ppa)
 	{
@@ -59,6 +59,8 @@ namespace SSD_Components
 		
 		bool Is_dirty(const stream_id_type streamID, const LPA_type lpa);
 		void Make_clean(const stream_id_type streamID, const LPA_type lpa);
+		void Save_checkpoint(Utils::CheckpointWriter& writer);
+		void Load_checkpoint(Utils::CheckpointReader& reader);
 	private:
 		std::unordered_map<LPA_type, CMTSlotType*> addressMap;
 		std::list<std::pair<LPA_type, CMTSlotType*>> lruList;
@@ -148,6 +150,9 @@ namespace SSD_Components
 
 		void Allocate_address_for_preconditioning(const stream_id_type stream_id, std::map<LPA_type, page_status_type>& lpa_list, std::vector<double>& steady_state_distribution);
 		int Bring_to_CMT_for_preconditioning(stream_id_type stream_id, LPA_type lpa);
+		void Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write);
+		void Save_checkpoint(Utils::CheckpointWriter& writer);
+		void Load_checkpoint(Utils::CheckpointReader& reader);
 		unsigned int Get_cmt_capacity();
 		unsigned int Get_current_cmt_occupancy_for_stream(stream_id_type stream_id);
 		void Translate_lpa_to_ppa_and_dispatch(const std::list<NVM_Transaction*>& transactionList);
@@ -157,6 +162,7 @@ namespace SSD_Components
 
 		void Store_mapping_table_on_flash_at_start();
 		LPA_type Get_logical_pages_count(stream_id_type stream_id);
+		bool Is_lpa_mapped(const stream_id_type stream_id, const LPA_type lpa);
 		NVM::FlashMemory::Physical_Page_Address Convert_ppa_to_address(const PPA_type ppa);
 		void Convert_ppa_to_address(const PPA_type ppn, NVM::FlashMemory::Physical_Page_Address& address);
 		PPA_type Convert_address_to_ppa(const NVM::FlashMemory::Physical_Page_Address& pageAddress);
@@ -192,6 +198,7 @@ namespace SSD_Components
 
 		bool query_cmt(NVM_Transaction_Flash* transaction);
 		PPA_type online_create_entry_for_reads(LPA_type lpa, const stream_id_type stream_id, NVM::FlashMemory::Physical_Page_Address& read_address, uint64_t read_sectors_bitmap);
+		void functional_bring_to_cmt(const stream_id_type stream_id, const LPA_type lpa);
 		void mange_unsuccessful_translation(NVM_Transaction_Flash* transaction);
 		void manage_user_transaction_facing_barrier(NVM_Transaction_Flash* transaction);
 		void manage_mapping_transaction_facing_barrier(stream_id_type stream_id, MVPN_type mvpn, bool read);
@@ -1,124 +1,171 @@
 #include "Data_Cache_Flash.h"
 #include <assert.h>
+#include <stdexcept>
 
 
 namespace SSD_Components
 {
-	Data_Cache_Flash::Data_Cache_Flash(unsigned int capacity_in_pages) : capacity_in_pages(capacity_in_pages) {}
-	bool Data_Cache_Flash::Exists(const stream_id_type stream_id, const LPA_type lpn)
+	Data_Cache_Flash::Data_Cache_Flash(unsigned int capacity_in_pages) : capacity_in_pages(capacity_in_pages), clock_hand(0)
 	{
-		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
-		auto it = slots.find(key);
-		if (it == slots.end()) {
-			return false;
+		slot_array.resize(capacity_in_pages);
+		slot_keys.resize(capacity_in_pages, 0);
+		free_slots.reserve(capacity_in_pages);
+		for (unsigned int i = 0; i < capacity_in_pages; i++) {
+			slot_array[i].Status = Cache_Slot_Status::EMPTY;
+			slot_array[i].Referenced = false;
+			slot_array[i].Prefetched = false;
+			free_slots.push_back(capacity_in_pages - i - 1);
 		}
+		slot_index.reserve(capacity_in_pages);
+	}
 
-		return true;
+	bool Data_Cache_Flash::Exists(const stream_id_type stream_id, const LPA_type lpn)
+	{
+		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
+		return slot_index.find(key) != slot_index.end();
 	}
 
 	Data_Cache_Flash::~Data_Cache_Flash()
 	{
-		for (auto &slot : slots) {
-			delete slot.second;
+	}
+
+	unsigned int Data_Cache_Flash::allocate_slot(const LPA_type key)
+	{
+		if (free_slots.size() == 0) {
+			throw std::logic_error("Data cache overfull!");
 		}
+		unsigned int slot_id = free_slots.back();
+		free_slots.pop_back();
+		slot_keys[slot_id] = key;
+		slot_index[key] = slot_id;
+
+		return slot_id;
+	}
+
+	void Data_Cache_Flash::release_slot(const unsigned int slot_id)
+	{
+		slot_index.erase(slot_keys[slot_id]);
+		slot_array[slot_id].Status = Cache_Slot_Status::EMPTY;
+		slot_array[slot_id].Referenced = false;
+		slot_array[slot_id].Prefetched = false;
+		free_slots.push_back(slot_id);
 	}
 
 	Data_Cache_Slot_Type Data_Cache_Flash::Get_slot(const stream_id_type stream_id, const LPA_type lpn)
 	{
 		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
-		auto it = slots.find(key);
-		assert(it != slots.end());
-		if (lru_list.begin()->first != key) {
-			lru_list.splice(lru_list.begin(), lru_list, it->second->lru_list_ptr);
+		auto it = slot_index.find(key);
+		assert(it != slot_index.end());
+		slot_array[it->second].Referenced = true;
+		slot_array[it->second].Prefetched = false;//Callers that count useful prefetches check Touch_prefetched_slot first
+
+		return slot_array[it->second];
+	}
+
+	bool Data_Cache_Flash::Touch_prefetched_slot(const stream_id_type stream_id, const LPA_type lpn)
+	{
+		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
+		auto it = slot_index.find(key);
+		if (it == slot_index.end() || !slot_array[it->second].Prefetched) {
+			return false;
 		}
+		slot_array[it->second].Prefetched = false;
 
-		return *(it->second);
+		return true;
 	}
 
 	bool Data_Cache_Flash::Check_free_slot_availability()
 	{
-		return slots.size() < capacity_in_pages;
+		return slot_index.size() < capacity_in_pages;
 	}
 
 	bool Data_Cache_Flash::Check_free_slot_availability(unsigned int no_of_slots)
 	{
-		return slots.size() + no_of_slots <= capacity_in_pages;
+		return slot_index.size() + no_of_slots <= capacity_in_pages;
 	}
 
 	bool Data_Cache_Flash::Empty()
 	{
-		return slots.size() == 0;
+		return slot_index.size() == 0;
 	}
 
 	bool Data_Cache_Flash::Full()
 	{
-		return slots.size() == capacity_in_pages;
+		return slot_index.size() == capacity_in_pages;
 	}
 
 	Data_Cache_Slot_Type Data_Cache_Flash::Evict_one_dirty_slot()
 	{
-		assert(slots.size() > 0);
-		auto itr = lru_list.rbegin();
-		while (itr != lru_list.rend()) {
-			if ((*itr).second->Status == Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK) {
-				break;
+		assert(slot_index.size() > 0);
+		//Two full sweeps are enough to find an unreferenced dirty slot, if there is any
+		for (unsigned int step = 0; step < 2 * capacity_in_pages; step++) {
+			Data_Cache_Slot_Type& slot = slot_array[clock_hand];
+			unsigned int slot_id = clock_hand;
+			clock_hand = (clock_hand + 1) % capacity_in_pages;
+			if (slot.Status != Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK) {
+				continue;
 			}
-			itr++;
-		}
-
-		Data_Cache_Slot_Type evicted_item = *lru_list.back().second;
-		if (itr == lru_list.rend()) {
-			evicted_item.Status = Cache_Slot_Status::EMPTY;
+			if (slot.Referenced) {
+				slot.Referenced = false;
+				continue;
+			}
+			Data_Cache_Slot_Type evicted_item = slot;
+			release_slot(slot_id);
 			return evicted_item;
 		}
 
-		slots.erase(lru_list.back().first);
-		delete lru_list.back().second;
-		lru_list.pop_back();
-		
+		Data_Cache_Slot_Type evicted_item;
+		evicted_item.Status = Cache_Slot_Status::EMPTY;
+		evicted_item.Referenced = false;
+		evicted_item.Prefetched = false;
 		return evicted_item;
 	}
 
-	Data_Cache_Slot_Type Data_Cache_Flash::Evict_one_slot_lru()
+	Data_Cache_Slot_Type Data_Cache_Flash::Evict_one_slot()
 	{
-		assert(slots.size() > 0);
-		slots.erase(lru_list.back().first);
-		Data_Cache_Slot_Type evicted_item = *lru_list.back().second;
-		delete lru_list.back().second;
-		lru_list.pop_back();
-
-		return evicted_item;
+		assert(slot_index.size() > 0);
+		while (true) {
+			Data_Cache_Slot_Type& slot = slot_array[clock_hand];
+			unsigned int slot_id = clock_hand;
+			clock_hand = (clock_hand + 1) % capacity_in_pages;
+			if (slot.Status == Cache_Slot_Status::EMPTY) {
+				continue;
+			}
+			if (slot.Referenced) {
+				slot.Referenced = false;
+				continue;
+			}
+			Data_Cache_Slot_Type evicted_item = slot;
+			release_slot(slot_id);
+			return evicted_item;
+		}
 	}
 
 	void Data_Cache_Flash::Change_slot_status_to_writeback(const stream_id_type stream_id, const LPA_type lpn)
 	{
 		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
-		auto it = slots.find(key);
-		assert(it != slots.end());
-		it->second->Status = Cache_Slot_Status::DIRTY_FLASH_WRITEBACK;
+		auto it = slot_index.find(key);
+		assert(it != slot_index.end());
+		slot_array[it->second].Status = Cache_Slot_Status::DIRTY_FLASH_WRITEBACK;
 	}
 
 	void Data_Cache_Flash::Insert_read_data(const stream_id_type stream_id, const LPA_type lpn, const data_cache_content_type content,
-		const data_timestamp_type timestamp, const page_status_type state_bitmap_of_read_sectors)
+		const data_timestamp_type timestamp, const page_status_type state_bitmap_of_read_sectors, const bool prefetched)
 	{
 		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
 		
-		if (slots.find(key) != slots.end()) {
+		if (slot_index.find(key) != slot_index.end()) {
 			throw std::logic_error("Duplicate lpn insertion into data cache!");
 		}
-		if (slots.size() >= capacity_in_pages) {
-			throw std::logic_error("Data cache overfull!");
-		}
 
-		Data_Cache_Slot_Type* cache_slot = new Data_Cache_Slot_Type();
-		cache_slot->LPA = lpn;
-		cache_slot->State_bitmap_of_existing_sectors = state_bitmap_of_read_sectors;
-		cache_slot->Content = content;
-		cache_slot->Timestamp = timestamp;
-		cache_slot->Status = Cache_Slot_Status::CLEAN;
-		lru_list.push_front(std::pair<LPA_type, Data_Cache_Slot_Type*>(key, cache_slot));
-		cache_slot->lru_list_ptr = lru_list.begin();
-		slots[key] = cache_slot;
+		Data_Cache_Slot_Type& cache_slot = slot_array[allocate_slot(key)];
+		cache_slot.LPA = lpn;
+		cache_slot.State_bitmap_of_existing_sectors = state_bitmap_of_read_sectors;
+		cache_slot.Content = content;
+		cache_slot.Timestamp = timestamp;
+		cache_slot.Status = Cache_Slot_Status::CLEAN;
+		cache_slot.Referenced = !prefetched;//A prefetched page has to prove its usefulness before the hand passes over it
+		cache_slot.Prefetched = prefetched;
 	}
 
 	void Data_Cache_Flash::Insert_write_data(const stream_id_type stream_id, const LPA_type lpn, const data_cache_content_type content,
@@ -126,49 +173,99 @@ namespace SSD_Components
 	{
 		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
 		
-		if (slots.find(key) != slots.end()) {
+		if (slot_index.find(key) != slot_index.end()) {
 			throw std::logic_error("Duplicate lpn insertion into data cache!!");
 		}
-		
-		if (slots.size() >= capacity_in_pages) {
-			throw std::logic_error("Data cache overfull!");
-		}
 
-		Data_Cache_Slot_Type* cache_slot = new Data_Cache_Slot_Type();
-		cache_slot->LPA = lpn;
-		cache_slot->State_bitmap_of_existing_sectors = state_bitmap_of_write_sectors;
-		cache_slot->Content = content;
-		cache_slot->Timestamp = timestamp;
-		cache_slot->Status = Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK;
-		lru_list.push_front(std::pair<LPA_type, Data_Cache_Slot_Type*>(key, cache_slot));
-		cache_slot->lru_list_ptr = lru_list.begin();
-		slots[key] = cache_slot;
+		Data_Cache_Slot_Type& cache_slot = slot_array[allocate_slot(key)];
+		cache_slot.LPA = lpn;
+		cache_slot.State_bitmap_of_existing_sectors = state_bitmap_of_write_sectors;
+		cache_slot.Content = content;
+		cache_slot.Timestamp = timestamp;
+		cache_slot.Status = Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK;
+		cache_slot.Referenced = true;
+		cache_slot.Prefetched = false;
 	}
 
 	void Data_Cache_Flash::Update_data(const stream_id_type stream_id, const LPA_type lpn, const data_cache_content_type content,
 		const data_timestamp_type timestamp, const page_status_type state_bitmap_of_write_sectors)
 	{
 		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
-		auto it = slots.find(key);
-		assert(it != slots.end());
-
-		it->second->LPA = lpn;
-		it->second->State_bitmap_of_existing_sectors = state_bitmap_of_write_sectors;
-		it->second->Content = content;
-		it->second->Timestamp = timestamp;
-		it->second->Status = Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK;
-		if (lru_list.begin()->first != key) {
-			lru_list.splice(lru_list.begin(), lru_list, it->second->lru_list_ptr);
-		}
+		auto it = slot_index.find(key);
+		assert(it != slot_index.end());
+
+		Data_Cache_Slot_Type& cache_slot = slot_array[it->second];
+		cache_slot.LPA = lpn;
+		cache_slot.State_bitmap_of_existing_sectors = state_bitmap_of_write_sectors;
+		cache_slot.Content = content;
+		cache_slot.Timestamp = timestamp;
+		cache_slot.Status = Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK;
+		cache_slot.Referenced = true;
+		cache_slot.Prefetched = false;
 	}
 
 	void Data_Cache_Flash::Remove_slot(const stream_id_type stream_id, const LPA_type lpn)
 	{
 		LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpn);
-		auto it = slots.find(key);
-		assert(it != slots.end());
-		lru_list.erase(it->second->lru_list_ptr);
-		delete it->second;
-		slots.erase(it);
+		auto it = slot_index.find(key);
+		assert(it != slot_index.end());
+		release_slot(it->second);
+	}
+
+	void Data_Cache_Flash::Save_checkpoint(Utils::CheckpointWriter& writer)
+	{
+		writer.Write(capacity_in_pages);
+		writer.Write(clock_hand);
+		for (unsigned int slot_id = 0; slot_id < capacity_in_pages; slot_id++) {
+			Data_Cache_Slot_Type& slot = slot_array[slot_id];
+			if (slot.Status == Cache_Slot_Status::DIRTY_FLASH_WRITEBACK) {
+				PRINT_ERROR("Cannot checkpoint the data cache while a write-back to flash is in flight!")
+			}
+			writer.Write(slot.Status);
+			if (slot.Status == Cache_Slot_Status::EMPTY) {
+				continue;
+			}
+			writer.Write(slot_keys[slot_id]);
+			writer.Write(slot.LPA);
+			writer.Write(slot.State_bitmap_of_existing_sectors);
+			writer.Write(slot.Content);
+			writer.Write(slot.Timestamp);
+			writer.Write(slot.Referenced);
+			writer.Write(slot.Prefetched);
+		}
+	}
+
+	void Data_Cache_Flash::Load_checkpoint(Utils::CheckpointReader& reader)
+	{
+		if (reader.Read<unsigned int>() != capacity_in_pages) {
+			PRINT_ERROR("The data cache capacity in the SSD checkpoint does not match the current configuration!")
+		}
+		reader.Read(clock_hand);
+		slot_index.clear();
+		free_slots.clear();
+		for (unsigned int slot_id = 0; slot_id < capacity_in_pages; slot_id++) {
+			Data_Cache_Slot_Type& slot = slot_array[slot_id];
+			reader.Read(slot.Status);
+			slot.Referenced = false;
+			slot.Prefetched = false;
+			if (slot.Status == Cache_Slot_Status::EMPTY) {
+				continue;
+			}
+			reader.Read(slot_keys[slot_id]);
+			reader.Read(slot.LPA);
+			reader.Read(slot.State_bitmap_of_existing_sectors);
+			reader.Read(slot.Content);
+			reader.Read(slot.Timestamp);
+			reader.Read(slot.Referenced);
+			reader.Read(slot.Prefetched);
+			slot_index[slot_keys[slot_id]] = slot_id;
+		}
+
+		//Keep the same allocation order as a freshly constructed cache, lowest slot first
+		for (unsigned int slot_id = capacity_in_pages; slot_id > 0; slot_id--) {
+			if (slot_array[slot_id - 1].Status == Cache_Slot_Status::EMPTY) {
+				free_slots.push_back(slot_id - 1);
+			}
+		}
 	}
 }
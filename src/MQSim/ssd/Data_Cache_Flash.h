@@ -1,7 +1,7 @@
 #ifndef DATA_CACHE_FLASH_H
 #define DATA_CACHE_FLASH_H
 
-#include <list>
+#include <vector>
 #include <queue>
 #include <unordered_map>
 #include "../nvm_chip/flash_memory/FlashTypes.h"
@@ -19,7 +19,8 @@ namespace SSD_Components
 		data_cache_content_type Content;
 		data_timestamp_type Timestamp;
 		Cache_Slot_Status Status;
-		std::list<std::pair<LPA_type, Data_Cache_Slot_Type*>>::iterator lru_list_ptr;//used for fast implementation of LRU
+		bool Referenced;//CLOCK reference bit, set on every access and cleared when the clock hand passes over the slot
+		bool Prefetched;//The slot was filled by the prefetcher and has not been touched by a demand access yet
 	};
 
 	enum class Data_Cache_Simulation_Event_Type {
@@ -37,6 +38,10 @@ namespace SSD_Components
 		stream_id_type Stream_id;
 	};
 
+	/* The cache slots live in one flat array that is allocated at construction time. Replacement
+	* is CLOCK (second chance): the hand sweeps the array, clears reference bits and evicts the
+	* first slot that has not been referenced since the last sweep. The hash index only maps
+	* unique keys to slot positions, so no per-access allocation or list splicing is needed.*/
 	class Data_Cache_Flash
 	{
 	public:
@@ -49,16 +54,25 @@ namespace SSD_Components
 		bool Full();
 		Data_Cache_Slot_Type Get_slot(const stream_id_type stream_id, const LPA_type lpn);
 		Data_Cache_Slot_Type Evict_one_dirty_slot();
-		Data_Cache_Slot_Type Evict_one_slot_lru();
+		Data_Cache_Slot_Type Evict_one_slot();
+		bool Touch_prefetched_slot(const stream_id_type stream_id, const LPA_type lpn);//Clears the prefetched flag of a slot, returns true if the flag was set
 		void Change_slot_status_to_writeback(const stream_id_type stream_id, const LPA_type lpn);
 		void Remove_slot(const stream_id_type stream_id, const LPA_type lpn);
-		void Insert_read_data(const stream_id_type stream_id, const LPA_type lpn, const data_cache_content_type content, const data_timestamp_type timestamp, const page_status_type state_bitmap_of_read_sectors);
+		void Insert_read_data(const stream_id_type stream_id, const LPA_type lpn, const data_cache_content_type content, const data_timestamp_type timestamp, const page_status_type state_bitmap_of_read_sectors, const bool prefetched = false);
 		void Insert_write_data(const stream_id_type stream_id, const LPA_type lpn, const data_cache_content_type content, const data_timestamp_type timestamp, const page_status_type state_bitmap_of_write_sectors);
 		void Update_data(const stream_id_type stream_id, const LPA_type lpn, const data_cache_content_type content, const data_timestamp_type timestamp, const page_status_type state_bitmap_of_write_sectors);
+		void Save_checkpoint(Utils::CheckpointWriter& writer);
+		void Load_checkpoint(Utils::CheckpointReader& reader);
 	private:
-		std::unordered_map<LPA_type, Data_Cache_Slot_Type*> slots;
-		std::list<std::pair<LPA_type, Data_Cache_Slot_Type*>> lru_list;
+		std::vector<Data_Cache_Slot_Type> slot_array;
+		std::vector<LPA_type> slot_keys;//The unique key stored in each slot, used to clean up the index upon eviction
+		std::vector<unsigned int> free_slots;
+		std::unordered_map<LPA_type, unsigned int> slot_index;
 		unsigned int capacity_in_pages;
+		unsigned int clock_hand;
+
+		unsigned int allocate_slot(const LPA_type key);
+		void release_slot(const unsigned int slot_id);
 	};
 }
 
@@ -33,6 +33,21 @@ namespace SSD_Components
 	
 	void Data_Cache_Manager_Base::Validate_simulation_config() {}
 
+	void Data_Cache_Manager_Base::Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter) {}
+
+	void Data_Cache_Manager_Base::Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write)
+	{
+		static_cast<FTL*>(nvm_firmware)->Address_Mapping_Unit->Functional_access(stream_id, lpa, sectors_bitmap, is_write);
+	}
+
+	void Data_Cache_Manager_Base::Save_checkpoint(Utils::CheckpointWriter& writer)
+	{
+	}
+
+	void Data_Cache_Manager_Base::Load_checkpoint(Utils::CheckpointReader& reader)
+	{
+	}
+
 	void Data_Cache_Manager_Base::Connect_to_user_request_serviced_signal(UserRequestServicedSignalHanderType function)
 	{
 		connected_user_request_serviced_signal_handlers.push_back(function);
@@ -8,6 +8,8 @@
 #include "NVM_Firmware.h"
 #include "NVM_PHY_ONFI.h"
 #include "../utils/Workload_Statistics.h"
+#include "../utils/XMLWriter.h"
+#include "../utils/Checkpoint.h"
 
 namespace SSD_Components
 {
@@ -37,6 +39,10 @@ namespace SSD_Components
 		void Connect_to_user_memory_transaction_serviced_signal(MemoryTransactionServicedSignalHanderType);
 		void Set_host_interface(Host_Interface_Base* host_interface);
 		virtual void Do_warmup(std::vector<Utils::Workload_Statistics*> workload_stats) = 0;
+		virtual void Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter);
+		virtual void Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write);//Updates cache contents and FTL state without simulating any timing
+		virtual void Save_checkpoint(Utils::CheckpointWriter& writer);//The default cache manager keeps no state that outlives a request
+		virtual void Load_checkpoint(Utils::CheckpointReader& reader);
 	protected:
 		static Data_Cache_Manager_Base* _my_instance;
 		Host_Interface_Base* host_interface;
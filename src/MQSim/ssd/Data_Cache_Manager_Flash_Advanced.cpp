@@ -11,10 +11,11 @@ namespace SSD_Components
 		unsigned int total_capacity_in_bytes,
 		unsigned int dram_row_size, unsigned int dram_data_rate, unsigned int dram_busrt_size, sim_time_type dram_tRCD, sim_time_type dram_tCL, sim_time_type dram_tRP,
 		Caching_Mode* caching_mode_per_input_stream, Cache_Sharing_Mode sharing_mode,unsigned int stream_count,
-		unsigned int sector_no_per_page, unsigned int back_pressure_buffer_max_depth)
+		unsigned int sector_no_per_page, unsigned int back_pressure_buffer_max_depth,
+		Data_Cache_Prefetching_Mode prefetching_mode, unsigned int prefetch_degree, unsigned int prefetch_stream_table_size)
 		: Data_Cache_Manager_Base(id, host_interface, firmware, dram_row_size, dram_data_rate, dram_busrt_size, dram_tRCD, dram_tCL, dram_tRP, caching_mode_per_input_stream, sharing_mode, stream_count),
 		flash_controller(flash_controller), capacity_in_bytes(total_capacity_in_bytes), sector_no_per_page(sector_no_per_page),	memory_channel_is_busy(false),
-		dram_execution_list_turn(0), back_pressure_buffer_max_depth(back_pressure_buffer_max_depth)
+		dram_execution_list_turn(0), back_pressure_buffer_max_depth(back_pressure_buffer_max_depth), prefetcher(NULL)
 	{
 		capacity_in_pages = capacity_in_bytes / (SECTOR_SIZE_IN_BYTE * sector_no_per_page);
 		switch (sharing_mode)
@@ -51,6 +52,19 @@ namespace SSD_Components
 		}
 
 		bloom_filter = new std::set<LPA_type>[stream_count];
+
+		switch (prefetching_mode)
+		{
+			case Data_Cache_Prefetching_Mode::SEQUENTIAL:
+				prefetcher = new Data_Cache_Prefetcher_Sequential(prefetch_degree, prefetch_stream_table_size);
+				break;
+			case Data_Cache_Prefetching_Mode::GRAPH_GUIDED:
+				//Each edge-list page may reference many feature pages, allow a wider burst than sequential readahead
+				prefetcher = new Data_Cache_Prefetcher_Graph_Guided(prefetch_degree, prefetch_stream_table_size, prefetch_degree * 4);
+				break;
+			default:
+				break;
+		}
 	}
 	
 	Data_Cache_Manager_Flash_Advanced::~Data_Cache_Manager_Flash_Advanced()
@@ -89,6 +103,7 @@ namespace SSD_Components
 		delete[] dram_execution_queue;
 		delete[] waiting_user_requests_queue_for_dram_free_slot;
 		delete[] bloom_filter;
+		delete prefetcher;
 	}
 
 	void Data_Cache_Manager_Flash_Advanced::Setup_triggers()
@@ -204,9 +219,24 @@ namespace SSD_Components
 				case Caching_Mode::READ_CACHE:
 				case Caching_Mode::WRITE_READ_CACHE:
 				{
+					//Prefetched pages are only kept in DRAM if read data is cached for this stream
+					bool prefetching_enabled = prefetcher != NULL && caching_mode_per_input_stream[user_request->Stream_id] != Caching_Mode::WRITE_CACHE;
+					std::vector<LPA_type> demand_read_pages;
 					std::list<NVM_Transaction*>::iterator it = user_request->Transaction_list.begin();
 					while (it != user_request->Transaction_list.end()) {
 						NVM_Transaction_Flash_RD* tr = (NVM_Transaction_Flash_RD*)(*it);
+						if (prefetching_enabled) {
+							demand_read_pages.push_back(tr->LPA);
+							if (per_stream_cache[tr->Stream_id]->Touch_prefetched_slot(tr->Stream_id, tr->LPA)) {
+								prefetcher->Record_useful_prefetch();
+							} else if (!per_stream_cache[tr->Stream_id]->Exists(tr->Stream_id, tr->LPA)) {
+								if (in_flight_prefetches.find(LPN_TO_UNIQUE_KEY(tr->Stream_id, tr->LPA)) != in_flight_prefetches.end()) {
+									prefetcher->Record_late_prefetch();
+								} else {
+									prefetcher->Record_demand_miss();
+								}
+							}
+						}
 						if (per_stream_cache[tr->Stream_id]->Exists(tr->Stream_id, tr->LPA)) {
 							page_status_type available_sectors_bitmap = per_stream_cache[tr->Stream_id]->Get_slot(tr->Stream_id, tr->LPA).State_bitmap_of_existing_sectors & tr->read_sectors_bitmap;
 							if (available_sectors_bitmap == tr->read_sectors_bitmap) {
@@ -236,6 +266,9 @@ namespace SSD_Components
 					if (user_request->Transaction_list.size() > 0) {
 						static_cast<FTL*>(nvm_firmware)->Address_Mapping_Unit->Translate_lpa_to_ppa_and_dispatch(user_request->Transaction_list);
 					}
+					if (prefetching_enabled) {
+						issue_prefetches(user_request->Stream_id, demand_read_pages);
+					}
 
 					return;
 				}
@@ -299,7 +332,10 @@ namespace SSD_Components
 				per_stream_cache[tr->Stream_id]->Update_data(tr->Stream_id, tr->LPA, content, timestamp, tr->write_sectors_bitmap | slot.State_bitmap_of_existing_sectors);
 			} else {//the logical address is not in the cache
 				if (!per_stream_cache[tr->Stream_id]->Check_free_slot_availability()) {
-					Data_Cache_Slot_Type evicted_slot = per_stream_cache[tr->Stream_id]->Evict_one_slot_lru();
+					Data_Cache_Slot_Type evicted_slot = per_stream_cache[tr->Stream_id]->Evict_one_slot();
+					if (evicted_slot.Prefetched) {
+						prefetcher->Record_unused_prefetch();
+					}
 					if (evicted_slot.Status == Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK) {
 						evicted_cache_slots->push_back(new NVM_Transaction_Flash_WR(Transaction_Source_Type::CACHE,
 							tr->Stream_id, count_sector_no_from_status_bitmap(evicted_slot.State_bitmap_of_existing_sectors) * SECTOR_SIZE_IN_BYTE,
@@ -375,6 +411,12 @@ namespace SSD_Components
 				return;
 			}
 
+			//The only reads that the cache issues on its own are prefetches
+			if (transaction->Source == Transaction_Source_Type::CACHE) {
+				((Data_Cache_Manager_Flash_Advanced*)_my_instance)->finish_prefetch((NVM_Transaction_Flash_RD*)transaction);
+				return;
+			}
+
 			switch (Data_Cache_Manager_Flash_Advanced::caching_mode_per_input_stream[transaction->Stream_id])
 			{
 				case Caching_Mode::TURNED_OFF:
@@ -401,27 +443,7 @@ namespace SSD_Components
 						((Data_Cache_Manager_Flash_Advanced*)_my_instance)->per_stream_cache[transaction->Stream_id]->Update_data(transaction->Stream_id, transaction->LPA, content,
 							timestamp, ((NVM_Transaction_Flash_RD*)transaction)->read_sectors_bitmap | slot.State_bitmap_of_existing_sectors);
 					} else  {
-						if (!((Data_Cache_Manager_Flash_Advanced*)_my_instance)->per_stream_cache[transaction->Stream_id]->Check_free_slot_availability()) {
-							std::list<NVM_Transaction*>* evicted_cache_slots = new std::list<NVM_Transaction*>;
-							Data_Cache_Slot_Type evicted_slot = ((Data_Cache_Manager_Flash_Advanced*)_my_instance)->per_stream_cache[transaction->Stream_id]->Evict_one_slot_lru();
-							if (evicted_slot.Status == Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK) {
-								Memory_Transfer_Info* transfer_info = new Memory_Transfer_Info;
-								transfer_info->Size_in_bytes = count_sector_no_from_status_bitmap(evicted_slot.State_bitmap_of_existing_sectors) * SECTOR_SIZE_IN_BYTE;
-								evicted_cache_slots->push_back(new NVM_Transaction_Flash_WR(Transaction_Source_Type::USERIO,
-									transaction->Stream_id, transfer_info->Size_in_bytes, evicted_slot.LPA, NULL, IO_Flow_Priority_Class::UNDEFINED, evicted_slot.Content,
-									evicted_slot.State_bitmap_of_existing_sectors, evicted_slot.Timestamp));
-								transfer_info->Related_request = evicted_cache_slots;
-								transfer_info->next_event_type = Data_Cache_Simulation_Event_Type::MEMORY_READ_FOR_CACHE_EVICTION_FINISHED;
-								transfer_info->Stream_id = transaction->Stream_id;
-								unsigned int cache_eviction_read_size_in_sectors = count_sector_no_from_status_bitmap(evicted_slot.State_bitmap_of_existing_sectors);
-								int sharing_id = transaction->Stream_id;
-								if (((Data_Cache_Manager_Flash_Advanced*)_my_instance)->shared_dram_request_queue) {
-									sharing_id = 0;
-								}
-								((Data_Cache_Manager_Flash_Advanced*)_my_instance)->back_pressure_buffer_depth[sharing_id] += cache_eviction_read_size_in_sectors;
-								((Data_Cache_Manager_Flash_Advanced*)_my_instance)->service_dram_access_request(transfer_info);
-							}
-						}
+						((Data_Cache_Manager_Flash_Advanced*)_my_instance)->make_room_for_read_data(transaction->Stream_id);
 						((Data_Cache_Manager_Flash_Advanced*)_my_instance)->per_stream_cache[transaction->Stream_id]->Insert_read_data(transaction->Stream_id, transaction->LPA,
 							((NVM_Transaction_Flash_RD*)transaction)->Content, ((NVM_Transaction_Flash_RD*)transaction)->DataTimeStamp, ((NVM_Transaction_Flash_RD*)transaction)->read_sectors_bitmap);
 
@@ -518,6 +540,170 @@ namespace SSD_Components
 		}
 	}
 
+	void Data_Cache_Manager_Flash_Advanced::make_room_for_read_data(const stream_id_type stream_id)
+	{
+		if (per_stream_cache[stream_id]->Check_free_slot_availability()) {
+			return;
+		}
+
+		Data_Cache_Slot_Type evicted_slot = per_stream_cache[stream_id]->Evict_one_slot();
+		if (evicted_slot.Prefetched) {
+			prefetcher->Record_unused_prefetch();
+		}
+		if (evicted_slot.Status == Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK) {
+			std::list<NVM_Transaction*>* evicted_cache_slots = new std::list<NVM_Transaction*>;
+			Memory_Transfer_Info* transfer_info = new Memory_Transfer_Info;
+			transfer_info->Size_in_bytes = count_sector_no_from_status_bitmap(evicted_slot.State_bitmap_of_existing_sectors) * SECTOR_SIZE_IN_BYTE;
+			evicted_cache_slots->push_back(new NVM_Transaction_Flash_WR(Transaction_Source_Type::USERIO,
+				stream_id, transfer_info->Size_in_bytes, evicted_slot.LPA, NULL, IO_Flow_Priority_Class::UNDEFINED, evicted_slot.Content,
+				evicted_slot.State_bitmap_of_existing_sectors, evicted_slot.Timestamp));
+			transfer_info->Related_request = evicted_cache_slots;
+			transfer_info->next_event_type = Data_Cache_Simulation_Event_Type::MEMORY_READ_FOR_CACHE_EVICTION_FINISHED;
+			transfer_info->Stream_id = stream_id;
+			unsigned int cache_eviction_read_size_in_sectors = count_sector_no_from_status_bitmap(evicted_slot.State_bitmap_of_existing_sectors);
+			int sharing_id = stream_id;
+			if (shared_dram_request_queue) {
+				sharing_id = 0;
+			}
+			back_pressure_buffer_depth[sharing_id] += cache_eviction_read_size_in_sectors;
+			service_dram_access_request(transfer_info);
+		}
+	}
+
+	void Data_Cache_Manager_Flash_Advanced::issue_prefetches(const stream_id_type stream_id, const std::vector<LPA_type>& demand_read_pages)
+	{
+		prefetch_candidates.clear();
+		for (auto lpa : demand_read_pages) {
+			prefetcher->Observe_demand_read(stream_id, lpa, prefetch_candidates);
+		}
+		if (prefetch_candidates.size() == 0) {
+			return;
+		}
+
+		Address_Mapping_Unit_Base* amu = static_cast<FTL*>(nvm_firmware)->Address_Mapping_Unit;
+		LPA_type logical_pages_count = amu->Get_logical_pages_count(stream_id);
+		page_status_type full_page_bitmap = sector_no_per_page >= 64 ? ~((page_status_type)0) : ((((page_status_type)1) << sector_no_per_page) - 1);
+		std::list<NVM_Transaction*> prefetch_transactions;
+		for (auto lpa : prefetch_candidates) {
+			LPA_type key = LPN_TO_UNIQUE_KEY(stream_id, lpa);
+			//Never-written pages are skipped, reading them would allocate flash pages and mappings just for readahead
+			if (lpa >= logical_pages_count || !amu->Is_lpa_mapped(stream_id, lpa) || per_stream_cache[stream_id]->Exists(stream_id, lpa)
+				|| in_flight_prefetches.find(key) != in_flight_prefetches.end()) {
+				continue;
+			}
+			in_flight_prefetches.insert(key);
+			prefetcher->Record_issued_prefetch();
+			prefetch_transactions.push_back(new NVM_Transaction_Flash_RD(Transaction_Source_Type::CACHE, stream_id,
+				sector_no_per_page * SECTOR_SIZE_IN_BYTE, lpa, NO_PPA, NULL, IO_Flow_Priority_Class::UNDEFINED, 0, full_page_bitmap, CurrentTimeStamp));
+		}
+		if (prefetch_transactions.size() > 0) {
+			amu->Translate_lpa_to_ppa_and_dispatch(prefetch_transactions);
+		}
+	}
+
+	void Data_Cache_Manager_Flash_Advanced::finish_prefetch(NVM_Transaction_Flash_RD* transaction)
+	{
+		in_flight_prefetches.erase(LPN_TO_UNIQUE_KEY(transaction->Stream_id, transaction->LPA));
+
+		//A demand read may have brought the page in while the prefetch was in flight
+		if (per_stream_cache[transaction->Stream_id]->Exists(transaction->Stream_id, transaction->LPA)) {
+			return;
+		}
+
+		make_room_for_read_data(transaction->Stream_id);
+		per_stream_cache[transaction->Stream_id]->Insert_read_data(transaction->Stream_id, transaction->LPA,
+			transaction->Content, transaction->DataTimeStamp, transaction->read_sectors_bitmap, true);
+
+		Memory_Transfer_Info* transfer_info = new Memory_Transfer_Info;
+		transfer_info->Size_in_bytes = count_sector_no_from_status_bitmap(transaction->read_sectors_bitmap) * SECTOR_SIZE_IN_BYTE;
+		transfer_info->Related_request = NULL;
+		transfer_info->next_event_type = Data_Cache_Simulation_Event_Type::MEMORY_WRITE_FOR_CACHE_FINISHED;
+		transfer_info->Stream_id = transaction->Stream_id;
+		service_dram_access_request(transfer_info);
+	}
+
+	void Data_Cache_Manager_Flash_Advanced::Save_checkpoint(Utils::CheckpointWriter& writer)
+	{
+		writer.Write_section("DataCache");
+		if (in_flight_prefetches.size() > 0) {
+			PRINT_ERROR("Cannot checkpoint the data cache while prefetch reads are in flight!")
+		}
+		writer.Write((uint32_t)stream_count);
+		for (unsigned int i = 0; i < stream_count; i++) {
+			//In the SHARED mode all streams point to the same cache, so it is only stored once
+			if (i > 0 && per_stream_cache[i] == per_stream_cache[0]) {
+				break;
+			}
+			per_stream_cache[i]->Save_checkpoint(writer);
+		}
+	}
+
+	void Data_Cache_Manager_Flash_Advanced::Load_checkpoint(Utils::CheckpointReader& reader)
+	{
+		reader.Read_section("DataCache");
+		if (reader.Read<uint32_t>() != stream_count) {
+			PRINT_ERROR("The number of I/O streams in the SSD checkpoint does not match the current configuration!")
+		}
+		for (unsigned int i = 0; i < stream_count; i++) {
+			if (i > 0 && per_stream_cache[i] == per_stream_cache[0]) {
+				break;
+			}
+			per_stream_cache[i]->Load_checkpoint(reader);
+		}
+	}
+
+	void Data_Cache_Manager_Flash_Advanced::Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter)
+	{
+		if (prefetcher != NULL) {
+			prefetcher->Report_results_in_XML(name_prefix + ".DataCache", xmlwriter);
+		}
+	}
+
+	void Data_Cache_Manager_Flash_Advanced::Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write)
+	{
+		Address_Mapping_Unit_Base* amu = static_cast<FTL*>(nvm_firmware)->Address_Mapping_Unit;
+		Data_Cache_Flash* cache = per_stream_cache[stream_id];
+		Caching_Mode caching_mode = caching_mode_per_input_stream[stream_id];
+
+		if (is_write) {
+			if (caching_mode != Caching_Mode::WRITE_CACHE && caching_mode != Caching_Mode::WRITE_READ_CACHE) {
+				amu->Functional_access(stream_id, lpa, sectors_bitmap, true);
+				return;
+			}
+			if (cache->Exists(stream_id, lpa)) {
+				Data_Cache_Slot_Type slot = cache->Get_slot(stream_id, lpa);
+				cache->Update_data(stream_id, lpa, slot.Content, CurrentTimeStamp, sectors_bitmap | slot.State_bitmap_of_existing_sectors);
+			} else {
+				functional_make_room(stream_id);
+				cache->Insert_write_data(stream_id, lpa, 0, CurrentTimeStamp, sectors_bitmap);
+			}
+			return;
+		}
+
+		if (caching_mode != Caching_Mode::TURNED_OFF && cache->Exists(stream_id, lpa)) {
+			cache->Touch_prefetched_slot(stream_id, lpa);
+			if ((cache->Get_slot(stream_id, lpa).State_bitmap_of_existing_sectors & sectors_bitmap) == sectors_bitmap) {
+				return;
+			}
+		}
+		amu->Functional_access(stream_id, lpa, sectors_bitmap, false);
+		if ((caching_mode == Caching_Mode::READ_CACHE || caching_mode == Caching_Mode::WRITE_READ_CACHE) && !cache->Exists(stream_id, lpa)) {
+			functional_make_room(stream_id);
+			cache->Insert_read_data(stream_id, lpa, 0, CurrentTimeStamp, sectors_bitmap);
+		}
+	}
+
+	void Data_Cache_Manager_Flash_Advanced::functional_make_room(const stream_id_type stream_id)
+	{
+		if (per_stream_cache[stream_id]->Check_free_slot_availability()) {
+			return;
+		}
+		Data_Cache_Slot_Type evicted_slot = per_stream_cache[stream_id]->Evict_one_slot();
+		if (evicted_slot.Status == Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK) {
+			static_cast<FTL*>(nvm_firmware)->Address_Mapping_Unit->Functional_access(stream_id, evicted_slot.LPA, evicted_slot.State_bitmap_of_existing_sectors, true);
+		}
+	}
+
 	void Data_Cache_Manager_Flash_Advanced::service_dram_access_request(Memory_Transfer_Info* request_info)
 	{
 		if (memory_channel_is_busy) {
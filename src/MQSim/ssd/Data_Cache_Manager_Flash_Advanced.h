@@ -4,11 +4,14 @@
 #include <list>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include "../nvm_chip/flash_memory/FlashTypes.h"
 #include "SSD_Defs.h"
 #include "Data_Cache_Manager_Base.h"
 #include "Data_Cache_Flash.h"
+#include "Data_Cache_Prefetcher.h"
 #include "NVM_Transaction_Flash.h"
+#include "NVM_Transaction_Flash_RD.h"
 
 namespace SSD_Components
 {
@@ -33,11 +36,17 @@ namespace SSD_Components
 			unsigned int total_capacity_in_bytes,
 			unsigned int dram_row_size, unsigned int dram_data_rate, unsigned int dram_busrt_size, sim_time_type dram_tRCD, sim_time_type dram_tCL, sim_time_type dram_tRP,
 			Caching_Mode* caching_mode_per_input_stream, Cache_Sharing_Mode sharing_mode, 
-			unsigned int stream_count, unsigned int sector_no_per_page, unsigned int back_pressure_buffer_max_depth);
+			unsigned int stream_count, unsigned int sector_no_per_page, unsigned int back_pressure_buffer_max_depth,
+			Data_Cache_Prefetching_Mode prefetching_mode = Data_Cache_Prefetching_Mode::NONE, unsigned int prefetch_degree = 0, unsigned int prefetch_stream_table_size = 0);
 		~Data_Cache_Manager_Flash_Advanced();
 		void Execute_simulator_event(MQSimEngine::Sim_Event* ev);
 		void Setup_triggers();
 		void Do_warmup(std::vector<Utils::Workload_Statistics*> workload_stats);
+		void Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter);
+		void Functional_access(const stream_id_type stream_id, const LPA_type lpa, const page_status_type sectors_bitmap, const bool is_write);
+		void Save_checkpoint(Utils::CheckpointWriter& writer);
+		void Load_checkpoint(Utils::CheckpointReader& reader);
+		Data_Cache_Prefetcher_Base* Get_prefetcher() { return prefetcher; }//NULL if prefetching is turned off
 	private:
 		NVM_PHY_ONFI * flash_controller;
 		unsigned int capacity_in_bytes, capacity_in_pages;
@@ -57,6 +66,15 @@ namespace SSD_Components
 		sim_time_type bloom_filter_reset_step = 1000000000;
 		sim_time_type next_bloom_filter_reset_milestone = 0;
 
+		//Readahead into the DRAM cache, only active for the streams whose caching mode keeps read data in DRAM
+		Data_Cache_Prefetcher_Base* prefetcher;
+		std::unordered_set<LPA_type> in_flight_prefetches;//Unique keys of the pages whose prefetch read is not finished yet
+		std::vector<LPA_type> prefetch_candidates;
+		void issue_prefetches(const stream_id_type stream_id, const std::vector<LPA_type>& demand_read_pages);
+		void finish_prefetch(NVM_Transaction_Flash_RD* transaction);
+		void make_room_for_read_data(const stream_id_type stream_id);
+		void functional_make_room(const stream_id_type stream_id);
+
 		static void handle_transaction_serviced_signal_from_PHY(NVM_Transaction_Flash* transaction);
 		void service_dram_access_request(Memory_Transfer_Info* request_info);
 	};
@@ -147,7 +147,7 @@ namespace SSD_Components
 				data_cache->Update_data(tr->Stream_id, tr->LPA, content, timestamp, tr->write_sectors_bitmap | slot.State_bitmap_of_existing_sectors);
 			} else { //the logical address is not in the cache
 				if (!data_cache->Check_free_slot_availability()) {
-					Data_Cache_Slot_Type evicted_slot = data_cache->Evict_one_slot_lru();
+					Data_Cache_Slot_Type evicted_slot = data_cache->Evict_one_slot();
 					if (evicted_slot.Status == Cache_Slot_Status::DIRTY_NO_FLASH_WRITEBACK) {
 						evicted_cache_slots->push_back(new NVM_Transaction_Flash_WR(Transaction_Source_Type::CACHE,
 							tr->Stream_id, count_sector_no_from_status_bitmap(evicted_slot.State_bitmap_of_existing_sectors) * SECTOR_SIZE_IN_BYTE,
@@ -0,0 +1,144 @@
+#include "Data_Cache_Prefetcher.h"
+
+namespace SSD_Components
+{
+	Data_Cache_Prefetcher_Base::Data_Cache_Prefetcher_Base(unsigned int prefetch_degree) : prefetch_degree(prefetch_degree),
+		STAT_issued_prefetches(0), STAT_useful_prefetches(0), STAT_late_prefetches(0), STAT_unused_prefetches(0), STAT_demand_misses(0)
+	{
+	}
+
+	Data_Cache_Prefetcher_Base::~Data_Cache_Prefetcher_Base()
+	{
+	}
+
+	double Data_Cache_Prefetcher_Base::Get_accuracy() const
+	{
+		if (STAT_issued_prefetches == 0) {
+			return 0;
+		}
+
+		//A late prefetch fetched the right page, it just did not arrive in time
+		return double(STAT_useful_prefetches + STAT_late_prefetches) / double(STAT_issued_prefetches);
+	}
+
+	double Data_Cache_Prefetcher_Base::Get_coverage() const
+	{
+		unsigned long total_demand_misses_without_prefetching = STAT_useful_prefetches + STAT_late_prefetches + STAT_demand_misses;
+		if (total_demand_misses_without_prefetching == 0) {
+			return 0;
+		}
+
+		return double(STAT_useful_prefetches) / double(total_demand_misses_without_prefetching);
+	}
+
+	void Data_Cache_Prefetcher_Base::Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter)
+	{
+		std::string tmp = name_prefix + ".Prefetcher";
+		xmlwriter.Write_start_element_tag(tmp);
+
+		std::string attr = "Issued_Prefetches";
+		std::string val = std::to_string(STAT_issued_prefetches);
+		xmlwriter.Write_attribute_string_inline(attr, val);
+
+		attr = "Useful_Prefetches";
+		val = std::to_string(STAT_useful_prefetches);
+		xmlwriter.Write_attribute_string_inline(attr, val);
+
+		attr = "Late_Prefetches";
+		val = std::to_string(STAT_late_prefetches);
+		xmlwriter.Write_attribute_string_inline(attr, val);
+
+		attr = "Unused_Evicted_Prefetches";
+		val = std::to_string(STAT_unused_prefetches);
+		xmlwriter.Write_attribute_string_inline(attr, val);
+
+		attr = "Demand_Misses";
+		val = std::to_string(STAT_demand_misses);
+		xmlwriter.Write_attribute_string_inline(attr, val);
+
+		attr = "Accuracy";
+		val = std::to_string(Get_accuracy());
+		xmlwriter.Write_attribute_string_inline(attr, val);
+
+		attr = "Coverage";
+		val = std::to_string(Get_coverage());
+		xmlwriter.Write_attribute_string_inline(attr, val);
+
+		xmlwriter.Write_end_element_tag();
+	}
+
+	Data_Cache_Prefetcher_Sequential::Data_Cache_Prefetcher_Sequential(unsigned int prefetch_degree, unsigned int stream_table_size, unsigned int trigger_threshold)
+		: Data_Cache_Prefetcher_Base(prefetch_degree), trigger_threshold(trigger_threshold), access_counter(0)
+	{
+		Stream_Table_Entry empty_entry = { false, 0, 0, 0, 0, 0 };
+		stream_table.resize(stream_table_size == 0 ? 1 : stream_table_size, empty_entry);
+	}
+
+	void Data_Cache_Prefetcher_Sequential::Observe_demand_read(const stream_id_type stream_id, const LPA_type lpa, std::vector<LPA_type>& prefetch_list)
+	{
+		access_counter++;
+		Stream_Table_Entry* victim = &stream_table[0];
+		for (auto &entry : stream_table) {
+			if (entry.Valid && entry.Stream_id == stream_id) {
+				if (lpa == entry.Last_lpa) {//Re-read of the same page, neither a new stream nor a continuation
+					entry.Last_use = access_counter;
+					return;
+				}
+				//The read continues the stream if it falls right after the last page or inside the readahead window
+				LPA_type window_end = entry.Prefetched_up_to > entry.Last_lpa ? entry.Prefetched_up_to : entry.Last_lpa + 1;
+				if (lpa > entry.Last_lpa && lpa <= window_end) {
+					if (entry.Confidence < trigger_threshold) {
+						entry.Confidence++;
+					}
+					entry.Last_lpa = lpa;
+					entry.Last_use = access_counter;
+					if (entry.Confidence >= trigger_threshold) {
+						LPA_type first = entry.Prefetched_up_to > lpa ? entry.Prefetched_up_to + 1 : lpa + 1;
+						for (LPA_type page = first; page <= lpa + prefetch_degree; page++) {
+							prefetch_list.push_back(page);
+						}
+						if (lpa + prefetch_degree > entry.Prefetched_up_to) {
+							entry.Prefetched_up_to = lpa + prefetch_degree;
+						}
+					}
+					return;
+				}
+			}
+			if (!entry.Valid || (victim->Valid && entry.Last_use < victim->Last_use)) {
+				victim = &entry;
+			}
+		}
+
+		//No stream matches, start tracking a new one
+		victim->Valid = true;
+		victim->Stream_id = stream_id;
+		victim->Last_lpa = lpa;
+		victim->Prefetched_up_to = lpa;
+		victim->Confidence = 0;
+		victim->Last_use = access_counter;
+	}
+
+	Data_Cache_Prefetcher_Graph_Guided::Data_Cache_Prefetcher_Graph_Guided(unsigned int prefetch_degree, unsigned int stream_table_size, unsigned int max_neighbor_pages)
+		: Data_Cache_Prefetcher_Base(prefetch_degree), sequential_prefetcher(prefetch_degree, stream_table_size),
+		neighbor_page_resolver(nullptr), max_neighbor_pages(max_neighbor_pages)
+	{
+	}
+
+	void Data_Cache_Prefetcher_Graph_Guided::Observe_demand_read(const stream_id_type stream_id, const LPA_type lpa, std::vector<LPA_type>& prefetch_list)
+	{
+		resolved_pages.clear();
+		if (neighbor_page_resolver && neighbor_page_resolver(stream_id, lpa, resolved_pages)) {
+			unsigned int count = 0;
+			for (auto page : resolved_pages) {
+				if (count == max_neighbor_pages) {
+					break;
+				}
+				prefetch_list.push_back(page);
+				count++;
+			}
+			return;
+		}
+
+		sequential_prefetcher.Observe_demand_read(stream_id, lpa, prefetch_list);
+	}
+}
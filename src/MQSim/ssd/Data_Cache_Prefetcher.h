@@ -0,0 +1,85 @@
+#ifndef DATA_CACHE_PREFETCHER_H
+#define DATA_CACHE_PREFETCHER_H
+
+#include <vector>
+#include <functional>
+#include "SSD_Defs.h"
+#include "../sim/Sim_Defs.h"
+#include "../utils/XMLWriter.h"
+
+namespace SSD_Components
+{
+	enum class Data_Cache_Prefetching_Mode { NONE, SEQUENTIAL, GRAPH_GUIDED };
+
+	/* A prefetcher observes the stream of demand page reads that arrive at the data cache manager and
+	* proposes logical pages that should be brought into the DRAM cache ahead of time. It does not issue
+	* any flash transaction itself; the cache manager filters out resident and in-flight pages, issues
+	* the reads and reports back how each prefetched page was used, so accuracy and coverage are measured
+	* at one place independent of the detection scheme.*/
+	class Data_Cache_Prefetcher_Base
+	{
+	public:
+		Data_Cache_Prefetcher_Base(unsigned int prefetch_degree);
+		virtual ~Data_Cache_Prefetcher_Base();
+		//Called once per demand page read (both hits and misses), appends the prefetch candidates to prefetch_list
+		virtual void Observe_demand_read(const stream_id_type stream_id, const LPA_type lpa, std::vector<LPA_type>& prefetch_list) = 0;
+
+		void Record_issued_prefetch() { STAT_issued_prefetches++; }
+		void Record_useful_prefetch() { STAT_useful_prefetches++; }//A demand read hit a page that was brought in by the prefetcher
+		void Record_late_prefetch() { STAT_late_prefetches++; }//A demand read missed on a page whose prefetch was still in flight
+		void Record_unused_prefetch() { STAT_unused_prefetches++; }//A prefetched page was evicted before any demand access
+		void Record_demand_miss() { STAT_demand_misses++; }
+		double Get_accuracy() const;
+		double Get_coverage() const;
+		void Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter);
+	protected:
+		unsigned int prefetch_degree;//The maximum number of pages proposed per demand read
+		unsigned long STAT_issued_prefetches, STAT_useful_prefetches, STAT_late_prefetches, STAT_unused_prefetches, STAT_demand_misses;
+	};
+
+	/* Stream-based readahead. A small fully-associative table tracks the most recent page of each
+	* detected stream. A read that continues a tracked stream raises its confidence; once the
+	* confidence reaches the trigger threshold, the prefetcher keeps the stream prefetch_degree pages
+	* ahead of the demand reads.*/
+	class Data_Cache_Prefetcher_Sequential : public Data_Cache_Prefetcher_Base
+	{
+	public:
+		Data_Cache_Prefetcher_Sequential(unsigned int prefetch_degree, unsigned int stream_table_size, unsigned int trigger_threshold = 2);
+		void Observe_demand_read(const stream_id_type stream_id, const LPA_type lpa, std::vector<LPA_type>& prefetch_list);
+	private:
+		struct Stream_Table_Entry
+		{
+			bool Valid;
+			stream_id_type Stream_id;
+			LPA_type Last_lpa;
+			LPA_type Prefetched_up_to;//The last page for which a prefetch has already been proposed
+			unsigned int Confidence;
+			unsigned long Last_use;
+		};
+		std::vector<Stream_Table_Entry> stream_table;
+		unsigned int trigger_threshold;
+		unsigned long access_counter;
+	};
+
+	/* Graph-guided prefetching. The host side knows the on-flash layout of the graph, so it registers a
+	* resolver that maps a page of an edge-list block to the pages that hold the features of the
+	* vertices referenced from it. Reads of such pages trigger prefetches of the resolved feature pages;
+	* every other read falls back to sequential stream detection.*/
+	class Data_Cache_Prefetcher_Graph_Guided : public Data_Cache_Prefetcher_Base
+	{
+	public:
+		//Returns false if the page is not part of an edge-list block
+		typedef std::function<bool(const stream_id_type, const LPA_type, std::vector<LPA_type>&)> Neighbor_page_resolver_type;
+
+		Data_Cache_Prefetcher_Graph_Guided(unsigned int prefetch_degree, unsigned int stream_table_size, unsigned int max_neighbor_pages);
+		void Set_neighbor_page_resolver(Neighbor_page_resolver_type resolver) { neighbor_page_resolver = resolver; }
+		void Observe_demand_read(const stream_id_type stream_id, const LPA_type lpa, std::vector<LPA_type>& prefetch_list);
+	private:
+		Data_Cache_Prefetcher_Sequential sequential_prefetcher;
+		Neighbor_page_resolver_type neighbor_page_resolver;
+		unsigned int max_neighbor_pages;//The maximum number of feature pages proposed per edge-list page
+		std::vector<LPA_type> resolved_pages;
+	};
+}
+
+#endif // !DATA_CACHE_PREFETCHER_H
@@ -762,6 +762,53 @@ namespace SSD_Components
 		}
 	}
 	
+	void FTL::Save_checkpoint(Utils::CheckpointWriter& writer)
+	{
+		Address_Mapping_Unit->Save_checkpoint(writer);
+		BlockManager->Save_checkpoint(writer);
+
+		//The LPA stored in the metadata area of each written page is needed by GC to relocate valid pages
+		writer.Write_section("PageMetadata");
+		NVM::FlashMemory::Physical_Page_Address address;
+		for (address.ChannelID = 0; address.ChannelID < channel_no; address.ChannelID++) {
+			for (address.ChipID = 0; address.ChipID < chip_no_per_channel; address.ChipID++) {
+				for (address.DieID = 0; address.DieID < die_no_per_chip; address.DieID++) {
+					for (address.PlaneID = 0; address.PlaneID < plane_no_per_die; address.PlaneID++) {
+						PlaneBookKeepingType* plane_record = BlockManager->Get_plane_bookkeeping_entry(address);
+						for (address.BlockID = 0; address.BlockID < block_no_per_plane; address.BlockID++) {
+							for (address.PageID = 0; address.PageID < plane_record->Blocks[address.BlockID].Current_page_write_index; address.PageID++) {
+								writer.Write(PHY->Get_metadata(address.ChannelID, address.ChipID, address.DieID, address.PlaneID, address.BlockID, address.PageID));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void FTL::Load_checkpoint(Utils::CheckpointReader& reader)
+	{
+		Address_Mapping_Unit->Load_checkpoint(reader);
+		BlockManager->Load_checkpoint(reader);
+
+		reader.Read_section("PageMetadata");
+		NVM::FlashMemory::Physical_Page_Address address;
+		for (address.ChannelID = 0; address.ChannelID < channel_no; address.ChannelID++) {
+			for (address.ChipID = 0; address.ChipID < chip_no_per_channel; address.ChipID++) {
+				for (address.DieID = 0; address.DieID < die_no_per_chip; address.DieID++) {
+					for (address.PlaneID = 0; address.PlaneID < plane_no_per_die; address.PlaneID++) {
+						PlaneBookKeepingType* plane_record = BlockManager->Get_plane_bookkeeping_entry(address);
+						for (address.BlockID = 0; address.BlockID < block_no_per_plane; address.BlockID++) {
+							for (address.PageID = 0; address.PageID < plane_record->Blocks[address.BlockID].Current_page_write_index; address.PageID++) {
+								PHY->Change_flash_page_status_for_preconditioning(address, reader.Read<LPA_type>());
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
 	void FTL::Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter)
 	{
 		std::string tmp = name_prefix + ".FTL";
@@ -40,6 +40,8 @@ namespace SSD_Components
 		TSU_Base * TSU;
 		NVM_PHY_ONFI* PHY;
 		void Report_results_in_XML(std::string name_prefix, Utils::XmlWriter& xmlwriter);
+		void Save_checkpoint(Utils::CheckpointWriter& writer);//Stores the mapping tables, block bookkeeping, and page metadata
+		void Load_checkpoint(Utils::CheckpointReader& reader);
 	private:
 		Utils::RandomGenerator random_generator;
 		unsigned int channel_no, chip_no_per_channel, die_no_per_chip, plane_no_per_die;
@@ -28,6 +28,7 @@ namespace SSD_Components
 
 		//The current write frontier block is written to the end
 		if(plane_record->Data_wf[stream_id]->Current_page_write_index == pages_no_per_block) {
+			plane_record->Add_to_victim_index(plane_record->Data_wf[stream_id]);
 			//Assign a new write frontier block
 			plane_record->Data_wf[stream_id] = plane_record->Get_a_free_block(stream_id, false);
 			gc_and_wl_unit->Check_gc_required(plane_record->Get_free_block_pool_size(), page_address);
@@ -47,6 +48,7 @@ namespace SSD_Components
 		
 		//The current write frontier block is written to the end
 		if (plane_record->GC_wf[stream_id]->Current_page_write_index == pages_no_per_block) {
+			plane_record->Add_to_victim_index(plane_record->GC_wf[stream_id]);
 			//Assign a new write frontier block
 			plane_record->GC_wf[stream_id] = plane_record->Get_a_free_block(stream_id, false);
 			gc_and_wl_unit->Check_gc_required(plane_record->Get_free_block_pool_size(), page_address);
@@ -85,6 +87,7 @@ namespace SSD_Components
 		}
 
 		//Update the write frontier
+		plane_record->Add_to_victim_index(plane_record->Data_wf[stream_id]);
 		plane_record->Data_wf[stream_id] = plane_record->Get_a_free_block(stream_id, false);
 	}
 
@@ -99,6 +102,7 @@ namespace SSD_Components
 
 		//The current write frontier block for translation pages is written to the end
 		if (plane_record->Translation_wf[streamID]->Current_page_write_index == pages_no_per_block) {
+			plane_record->Add_to_victim_index(plane_record->Translation_wf[streamID]);
 			//Assign a new write frontier block
 			plane_record->Translation_wf[streamID] = plane_record->Get_a_free_block(streamID, true);
 			if (!is_for_gc) {
@@ -118,6 +122,7 @@ namespace SSD_Components
 		}
 		plane_record->Blocks[page_address.BlockID].Invalid_page_count++;
 		plane_record->Blocks[page_address.BlockID].Invalid_page_bitmap[page_address.PageID / 64] |= ((uint64_t)0x1) << (page_address.PageID % 64);
+		plane_record->Update_victim_index(&plane_record->Blocks[page_address.BlockID]);
 	}
 
 	inline void Flash_Block_Manager::Invalidate_page_in_block_for_preconditioning(const stream_id_type stream_id, const NVM::FlashMemory::Physical_Page_Address& page_address)
@@ -129,6 +134,7 @@ namespace SSD_Components
 		}
 		plane_record->Blocks[page_address.BlockID].Invalid_page_count++;
 		plane_record->Blocks[page_address.BlockID].Invalid_page_bitmap[page_address.PageID / 64] |= ((uint64_t)0x1) << (page_address.PageID % 64);
+		plane_record->Update_victim_index(&plane_record->Blocks[page_address.BlockID]);
 	}
 
 	void Flash_Block_Manager::Add_erased_block_to_pool(const NVM::FlashMemory::Physical_Page_Address& block_address)
@@ -139,6 +145,7 @@ namespace SSD_Components
 		plane_record->Invalid_pages_count -= block->Invalid_page_count;
 
 		Stats::Block_erase_histogram[block_address.ChannelID][block_address.ChipID][block_address.DieID][block_address.PlaneID][block->Erase_count]--;
+		plane_record->Remove_from_victim_index(block->BlockID);
 		block->Erase();
 		Stats::Block_erase_histogram[block_address.ChannelID][block_address.ChipID][block_address.DieID][block_address.PlaneID][block->Erase_count]++;
 		plane_record->Add_to_free_block_pool(block, gc_and_wl_unit->Use_dynamic_wearleveling());
@@ -1,4 +1,5 @@
 #include "Flash_Block_Manager.h"
+#include "Stats.h"
 
 
 namespace SSD_Components
@@ -25,7 +26,7 @@ namespace SSD_Components
 						plane_manager[channelID][chipID][dieID][planeID].Free_pages_count = block_no_per_plane * pages_no_per_block;
 						plane_manager[channelID][chipID][dieID][planeID].Valid_pages_count = 0;
 						plane_manager[channelID][chipID][dieID][planeID].Invalid_pages_count = 0;
-						plane_manager[channelID][chipID][dieID][planeID].Ongoing_erase_operations.clear();
+						plane_manager[channelID][chipID][dieID][planeID].Initialize_victim_index(block_no_per_plane, pages_no_per_block);
 						plane_manager[channelID][chipID][dieID][planeID].Blocks = new Block_Pool_Slot_Type[block_no_per_plane];
 						
 						//Initialize block pool for plane
@@ -143,6 +144,80 @@ namespace SSD_Components
 		}
 	}
 
+	void PlaneBookKeepingType::Initialize_victim_index(unsigned int block_no_per_plane, unsigned int pages_no_per_block)
+	{
+		Erase_ongoing.assign(block_no_per_plane, 0);
+		Ongoing_erase_count = 0;
+		Victim_bucket_head.assign(pages_no_per_block + 1, NO_VICTIM_BLOCK);
+		Victim_next.assign(block_no_per_plane, NO_VICTIM_BLOCK);
+		Victim_prev.assign(block_no_per_plane, NO_VICTIM_BLOCK);
+		Victim_bucket.assign(block_no_per_plane, NO_VICTIM_BLOCK);
+		Max_victim_bucket = 0;
+	}
+
+	void PlaneBookKeepingType::Add_to_victim_index(const Block_Pool_Slot_Type* block)
+	{
+		flash_block_ID_type block_id = block->BlockID;
+		if (Victim_bucket[block_id] != NO_VICTIM_BLOCK) {
+			PRINT_ERROR("Inconsistent status in the GC victim index: block " << block_id << " is inserted twice!")
+		}
+		unsigned int bucket = block->Invalid_page_count;
+		Victim_bucket[block_id] = bucket;
+		Victim_prev[block_id] = NO_VICTIM_BLOCK;
+		Victim_next[block_id] = Victim_bucket_head[bucket];
+		if (Victim_bucket_head[bucket] != NO_VICTIM_BLOCK) {
+			Victim_prev[Victim_bucket_head[bucket]] = block_id;
+		}
+		Victim_bucket_head[bucket] = block_id;
+		if (bucket > Max_victim_bucket) {
+			Max_victim_bucket = bucket;
+		}
+	}
+
+	void PlaneBookKeepingType::Remove_from_victim_index(const flash_block_ID_type block_id)
+	{
+		unsigned int bucket = Victim_bucket[block_id];
+		if (bucket == NO_VICTIM_BLOCK) {
+			return;
+		}
+		if (Victim_prev[block_id] != NO_VICTIM_BLOCK) {
+			Victim_next[Victim_prev[block_id]] = Victim_next[block_id];
+		} else {
+			Victim_bucket_head[bucket] = Victim_next[block_id];
+		}
+		if (Victim_next[block_id] != NO_VICTIM_BLOCK) {
+			Victim_prev[Victim_next[block_id]] = Victim_prev[block_id];
+		}
+		Victim_next[block_id] = NO_VICTIM_BLOCK;
+		Victim_prev[block_id] = NO_VICTIM_BLOCK;
+		Victim_bucket[block_id] = NO_VICTIM_BLOCK;
+	}
+
+	void PlaneBookKeepingType::Update_victim_index(const Block_Pool_Slot_Type* block)
+	{
+		if (Victim_bucket[block->BlockID] == NO_VICTIM_BLOCK || Victim_bucket[block->BlockID] == block->Invalid_page_count) {
+			return;
+		}
+		Remove_from_victim_index(block->BlockID);
+		Add_to_victim_index(block);
+	}
+
+	void PlaneBookKeepingType::Erase_started(const flash_block_ID_type block_id)
+	{
+		if (Erase_ongoing[block_id] == 0) {
+			Erase_ongoing[block_id] = 1;
+			Ongoing_erase_count++;
+		}
+	}
+
+	void PlaneBookKeepingType::Erase_finished(const flash_block_ID_type block_id)
+	{
+		if (Erase_ongoing[block_id] != 0) {
+			Erase_ongoing[block_id] = 0;
+			Ongoing_erase_count--;
+		}
+	}
+
 	unsigned int Flash_Block_Manager_Base::Get_min_max_erase_difference(const NVM::FlashMemory::Physical_Page_Address& plane_address)
 	{
 		unsigned int min_erased_block = 0;
@@ -241,4 +316,130 @@ namespace SSD_Components
 		}
 		return false;
 	}
+
+	void Flash_Block_Manager_Base::Save_checkpoint(Utils::CheckpointWriter& writer)
+	{
+		writer.Write_section("BlockManager");
+		for (unsigned int channel_id = 0; channel_id < channel_count; channel_id++) {
+			for (unsigned int chip_id = 0; chip_id < chip_no_per_channel; chip_id++) {
+				for (unsigned int die_id = 0; die_id < die_no_per_chip; die_id++) {
+					for (unsigned int plane_id = 0; plane_id < plane_no_per_die; plane_id++) {
+						PlaneBookKeepingType* plane_record = &plane_manager[channel_id][chip_id][die_id][plane_id];
+						if (plane_record->Get_ongoing_erase_count() > 0) {
+							PRINT_ERROR("Cannot checkpoint the block manager while an erase operation is in flight!")
+						}
+						writer.Write(plane_record->Free_pages_count);
+						writer.Write(plane_record->Valid_pages_count);
+						writer.Write(plane_record->Invalid_pages_count);
+						for (unsigned int block_id = 0; block_id < block_no_per_plane; block_id++) {
+							Block_Pool_Slot_Type* block = &plane_record->Blocks[block_id];
+							if (block->Ongoing_user_read_count != 0 || block->Ongoing_user_program_count != 0 || block->Has_ongoing_gc_wl) {
+								PRINT_ERROR("Cannot checkpoint the block manager while a flash operation is in flight!")
+							}
+							writer.Write(block->Current_page_write_index);
+							writer.Write(block->Invalid_page_count);
+							writer.Write(block->Erase_count);
+							writer.Write(block->Stream_id);
+							writer.Write(block->Holds_mapping_data);
+							writer.Write(block->Hot_block);
+							writer.Write_array(block->Invalid_page_bitmap, Block_Pool_Slot_Type::Page_vector_size);
+						}
+
+						//Pointers are stored as block IDs and resolved again on restore
+						writer.Write((uint64_t)plane_record->Free_block_pool.size());
+						for (auto &entry : plane_record->Free_block_pool) {
+							writer.Write(entry.first);
+							writer.Write(entry.second->BlockID);
+						}
+						for (unsigned int stream_id = 0; stream_id < total_concurrent_streams_no; stream_id++) {
+							writer.Write(plane_record->Data_wf[stream_id]->BlockID);
+							writer.Write(plane_record->GC_wf[stream_id]->BlockID);
+							writer.Write(plane_record->Translation_wf[stream_id]->BlockID);
+						}
+						std::queue<flash_block_ID_type> history = plane_record->Block_usage_history;
+						writer.Write((uint64_t)history.size());
+						while (!history.empty()) {
+							writer.Write(history.front());
+							history.pop();
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void Flash_Block_Manager_Base::Load_checkpoint(Utils::CheckpointReader& reader)
+	{
+		reader.Read_section("BlockManager");
+		for (unsigned int channel_id = 0; channel_id < channel_count; channel_id++) {
+			for (unsigned int chip_id = 0; chip_id < chip_no_per_channel; chip_id++) {
+				for (unsigned int die_id = 0; die_id < die_no_per_chip; die_id++) {
+					for (unsigned int plane_id = 0; plane_id < plane_no_per_die; plane_id++) {
+						PlaneBookKeepingType* plane_record = &plane_manager[channel_id][chip_id][die_id][plane_id];
+						reader.Read(plane_record->Free_pages_count);
+						reader.Read(plane_record->Valid_pages_count);
+						reader.Read(plane_record->Invalid_pages_count);
+						for (unsigned int block_id = 0; block_id < block_no_per_plane; block_id++) {
+							Block_Pool_Slot_Type* block = &plane_record->Blocks[block_id];
+							reader.Read(block->Current_page_write_index);
+							reader.Read(block->Invalid_page_count);
+							reader.Read(block->Erase_count);
+							reader.Read(block->Stream_id);
+							reader.Read(block->Holds_mapping_data);
+							reader.Read(block->Hot_block);
+							reader.Read_array(block->Invalid_page_bitmap, Block_Pool_Slot_Type::Page_vector_size);
+							block->Current_status = Block_Service_Status::IDLE;
+							block->Has_ongoing_gc_wl = false;
+							block->Erase_transaction = NULL;
+							block->Ongoing_user_read_count = 0;
+							block->Ongoing_user_program_count = 0;
+						}
+
+						plane_record->Free_block_pool.clear();
+						uint64_t pool_size = reader.Read<uint64_t>();
+						for (uint64_t i = 0; i < pool_size; i++) {
+							unsigned int key = reader.Read<unsigned int>();
+							flash_block_ID_type block_id = reader.Read<flash_block_ID_type>();
+							plane_record->Free_block_pool.insert(std::pair<unsigned int, Block_Pool_Slot_Type*>(key, &plane_record->Blocks[block_id]));
+						}
+						for (unsigned int stream_id = 0; stream_id < total_concurrent_streams_no; stream_id++) {
+							plane_record->Data_wf[stream_id] = &plane_record->Blocks[reader.Read<flash_block_ID_type>()];
+							plane_record->GC_wf[stream_id] = &plane_record->Blocks[reader.Read<flash_block_ID_type>()];
+							plane_record->Translation_wf[stream_id] = &plane_record->Blocks[reader.Read<flash_block_ID_type>()];
+						}
+						plane_record->Block_usage_history = std::queue<flash_block_ID_type>();
+						uint64_t history_size = reader.Read<uint64_t>();
+						for (uint64_t i = 0; i < history_size; i++) {
+							plane_record->Block_usage_history.push(reader.Read<flash_block_ID_type>());
+						}
+
+						//The victim index is derived state, so it is rebuilt instead of being stored in the checkpoint
+						plane_record->Initialize_victim_index(block_no_per_plane, pages_no_per_block);
+						for (unsigned int block_id = 0; block_id < block_no_per_plane; block_id++) {
+							if (plane_record->Blocks[block_id].Current_page_write_index == pages_no_per_block) {
+								plane_record->Add_to_victim_index(&plane_record->Blocks[block_id]);
+							}
+						}
+
+						//So is the erase histogram; bucket 0 starts from the same count as in Stats::Init_stats and every erase moves one block up
+						unsigned int* erase_histogram = Stats::Block_erase_histogram[channel_id][chip_id][die_id][plane_id];
+						for (unsigned int i = 0; i < max_allowed_block_erase_count; i++) {
+							erase_histogram[i] = 0;
+						}
+						erase_histogram[0] = block_no_per_plane * pages_no_per_block;
+						for (unsigned int block_id = 0; block_id < block_no_per_plane; block_id++) {
+							unsigned int erase_count = plane_record->Blocks[block_id].Erase_count;
+							if (erase_count >= max_allowed_block_erase_count) {
+								PRINT_ERROR("The erase count of a block in the SSD checkpoint exceeds the maximum allowed block erase count!")
+							}
+							if (erase_count > 0) {
+								erase_histogram[0]--;
+								erase_histogram[erase_count]++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
 }
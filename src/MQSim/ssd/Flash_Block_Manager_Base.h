@@ -5,14 +5,18 @@
 #include <cstdint>
 #include <queue>
 #include <set>
+#include <map>
+#include <vector>
 #include "../nvm_chip/flash_memory/FlashTypes.h"
 #include "../nvm_chip/flash_memory/Physical_Page_Address.h"
 #include "GC_and_WL_Unit_Base.h"
 #include "../nvm_chip/flash_memory/FlashTypes.h"
+#include "../utils/Checkpoint.h"
 
 namespace SSD_Components
 {
 #define All_VALID_PAGE 0x0000000000000000ULL
+#define NO_VICTIM_BLOCK 0xffffffff
 	class GC_and_WL_Unit_Base;
 	/*
 	* Block_Service_Status is used to impelement a state machine for each physical block in order to
@@ -58,11 +62,31 @@ namespace SSD_Components
 		Block_Pool_Slot_Type** Data_wf, ** GC_wf; //The write frontier blocks for data and GC pages. MQSim adopts Double Write Frontier approach for user and GC writes which is shown very advantages in: B. Van Houdt, "On the necessity of hot and cold data identification to reduce the write amplification in flash - based SSDs", Perf. Eval., 2014
 		Block_Pool_Slot_Type** Translation_wf; //The write frontier blocks for translation GC pages
 		std::queue<flash_block_ID_type> Block_usage_history;//A fifo queue that keeps track of flash blocks based on their usage history
-		std::set<flash_block_ID_type> Ongoing_erase_operations;
+
+		/* The per-block state that GC victim selection scans is kept in flat arrays indexed by block ID (struct-of-arrays).
+		* Fully written blocks are linked into buckets by their invalid page count, so GREEDY takes the head of the highest
+		* non-empty bucket instead of walking all blocks of the plane. Blocks leave the index when they are erased.*/
+		std::vector<uint8_t> Erase_ongoing;
+		unsigned int Ongoing_erase_count;
+		std::vector<flash_block_ID_type> Victim_bucket_head;//One bucket per possible invalid page count, 0..pages_no_per_block
+		std::vector<flash_block_ID_type> Victim_next, Victim_prev;
+		std::vector<flash_page_ID_type> Victim_bucket;//The bucket of each block, NO_VICTIM_BLOCK if the block is not fully written
+		unsigned int Max_victim_bucket;//An upper bound of the highest non-empty bucket, lowered lazily during victim search
+
 		Block_Pool_Slot_Type* Get_a_free_block(stream_id_type stream_id, bool for_mapping_data);
 		unsigned int Get_free_block_pool_size();
 		void Check_bookkeeping_correctness(const NVM::FlashMemory::Physical_Page_Address& plane_address);
 		void Add_to_free_block_pool(Block_Pool_Slot_Type* block, bool consider_dynamic_wl);
+		void Initialize_victim_index(unsigned int block_no_per_plane, unsigned int pages_no_per_block);
+		void Add_to_victim_index(const Block_Pool_Slot_Type* block);//Called once the block is written to the end
+		void Remove_from_victim_index(const flash_block_ID_type block_id);
+		void Update_victim_index(const Block_Pool_Slot_Type* block);//Called when the invalid page count of the block changes
+		flash_block_ID_type Get_victim_bucket_head(const unsigned int invalid_page_count) { return Victim_bucket_head[invalid_page_count]; }
+		flash_block_ID_type Get_next_in_victim_bucket(const flash_block_ID_type block_id) { return Victim_next[block_id]; }
+		bool Has_ongoing_erase(const flash_block_ID_type block_id) const { return Erase_ongoing[block_id] != 0; }
+		unsigned int Get_ongoing_erase_count() const { return Ongoing_erase_count; }
+		void Erase_started(const flash_block_ID_type block_id);
+		void Erase_finished(const flash_block_ID_type block_id);
 	};
 
 	class Flash_Block_Manager_Base
@@ -96,6 +120,8 @@ namespace SSD_Components
 		void Program_transaction_serviced(const NVM::FlashMemory::Physical_Page_Address& page_address);//Updates the block bookkeeping record
 		bool Is_having_ongoing_program(const NVM::FlashMemory::Physical_Page_Address& block_address);//Cheks if block has any ongoing program request
 		bool Is_page_valid(Block_Pool_Slot_Type* block, flash_page_ID_type page_id);//Make the page invalid in the block bookkeeping record
+		void Save_checkpoint(Utils::CheckpointWriter& writer);//Stores the block bookkeeping records, only allowed while no flash operation is in flight
+		void Load_checkpoint(Utils::CheckpointReader& reader);
 	protected:
 		PlaneBookKeepingType ****plane_manager;//Keeps track of plane block usage information
 		GC_and_WL_Unit_Base *gc_and_wl_unit;
@@ -58,6 +58,8 @@ namespace SSD_Components
 		bool Use_dynamic_wearleveling();
 		bool Use_static_wearleveling();
 		bool Stop_servicing_writes(const NVM::FlashMemory::Physical_Page_Address& plane_address);
+		void Set_functional_mode(bool enabled) { functional_mode = enabled; }//In functional mode, GC relocates pages and erases blocks in place without generating flash transactions
+		bool Is_in_functional_mode() { return functional_mode; }
 	protected:
 		static GC_and_WL_Unit_Base * _my_instance;
 		Address_Mapping_Unit_Base* address_mapping_unit;
@@ -65,6 +67,7 @@ namespace SSD_Components
 		TSU_Base* tsu;
 		NVM_PHY_ONFI* flash_controller;
 		bool force_gc;
+		bool functional_mode;
 		GC_Block_Selection_Policy_Type block_selection_policy;
 		double gc_threshold;//As the ratio of free pages to the total number of physical pages
 		bool use_copyback;
@@ -46,24 +46,30 @@ namespace SSD_Components
 			flash_block_ID_type gc_candidate_block_id = block_manager->Get_coldest_block_id(plane_address);
 			PlaneBookKeepingType* pbke = block_manager->Get_plane_bookkeeping_entry(plane_address);
 
-			if (pbke->Ongoing_erase_operations.size() >= max_ongoing_gc_reqs_per_plane) {
+			if (pbke->Get_ongoing_erase_count() >= max_ongoing_gc_reqs_per_plane) {
 				return;
 			}
 
 			switch (block_selection_policy) {
 				case SSD_Components::GC_Block_Selection_Policy_Type::GREEDY://Find the set of blocks with maximum number of invalid pages and no free pages
 				{
-					gc_candidate_block_id = 0;
-					if (pbke->Ongoing_erase_operations.find(0) != pbke->Ongoing_erase_operations.end()) {
-						gc_candidate_block_id++;
-					}
-					for (flash_block_ID_type block_id = 1; block_id < block_no_per_plane; block_id++) {
-						if (pbke->Blocks[block_id].Invalid_page_count > pbke->Blocks[gc_candidate_block_id].Invalid_page_count
-							&& pbke->Blocks[block_id].Current_page_write_index == pages_no_per_block
-							&& is_safe_gc_wl_candidate(pbke, block_id)) {
-							gc_candidate_block_id = block_id;
+					//Walk the invalid-count buckets downwards, usually the head of the highest bucket is taken right away
+					gc_candidate_block_id = NO_VICTIM_BLOCK;
+					for (unsigned int bucket = pbke->Max_victim_bucket; bucket > 0 && gc_candidate_block_id == NO_VICTIM_BLOCK; bucket--) {
+						flash_block_ID_type block_id = pbke->Get_victim_bucket_head(bucket);
+						if (block_id == NO_VICTIM_BLOCK && bucket == pbke->Max_victim_bucket) {
+							pbke->Max_victim_bucket--;
+						}
+						for (; block_id != NO_VICTIM_BLOCK; block_id = pbke->Get_next_in_victim_bucket(block_id)) {
+							if (!pbke->Has_ongoing_erase(block_id) && is_safe_gc_wl_candidate(pbke, block_id)) {
+								gc_candidate_block_id = block_id;
+								break;
+							}
 						}
 					}
+					if (gc_candidate_block_id == NO_VICTIM_BLOCK) {
+						return;
+					}
 					break;
 				}
 				case SSD_Components::GC_Block_Selection_Policy_Type::RGA:
@@ -71,7 +77,7 @@ namespace SSD_Components
 					std::set<flash_block_ID_type> random_set;
 					while (random_set.size() < rga_set_size) {
 						flash_block_ID_type block_id = random_generator.Uniform_uint(0, block_no_per_plane - 1);
-						if (pbke->Ongoing_erase_operations.find(block_id) == pbke->Ongoing_erase_operations.end()
+						if (!pbke->Has_ongoing_erase(block_id)
 							&& is_safe_gc_wl_candidate(pbke, block_id)) {
 							random_set.insert(block_id);
 							}
@@ -131,7 +137,7 @@ namespace SSD_Components
 			}
 
 			//This should never happen, but we check it here for safty
-			if (pbke->Ongoing_erase_operations.find(gc_candidate_block_id) != pbke->Ongoing_erase_operations.end()) {
+			if (pbke->Has_ongoing_erase(gc_candidate_block_id)) {
 				return;
 			}
 			
@@ -143,10 +149,15 @@ namespace SSD_Components
 			if (block->Current_page_write_index == 0 || block->Invalid_page_count == 0) {
 				return;
 			}
+
+			if (functional_mode) {
+				run_functional_gc(gc_candidate_address);
+				return;
+			}
 			
 			//Run the state machine to protect against race condition
 			block_manager->GC_WL_started(gc_candidate_address);
-			pbke->Ongoing_erase_operations.insert(gc_candidate_block_id);
+			pbke->Erase_started(gc_candidate_block_id);
 			address_mapping_unit->Set_barrier_for_accessing_physical_block(gc_candidate_address);//Lock the block, so no user request can intervene while the GC is progressing
 			
 			//If there are ongoing requests targeting the candidate block, the gc execution should be postponed
@@ -189,4 +200,41 @@ namespace SSD_Components
 			}
 		}
 	}
+
+	void GC_and_WL_Unit_Page_Level::run_functional_gc(const NVM::FlashMemory::Physical_Page_Address& gc_candidate_address)
+	{
+		PlaneBookKeepingType* pbke = block_manager->Get_plane_bookkeeping_entry(gc_candidate_address);
+		Block_Pool_Slot_Type* block = &pbke->Blocks[gc_candidate_address.BlockID];
+		Stats::Total_gc_executions++;
+		pbke->Erase_started(gc_candidate_address.BlockID);
+
+		NVM::FlashMemory::Physical_Page_Address page_address(gc_candidate_address);
+		for (flash_page_ID_type pageID = 0; pageID < block->Current_page_write_index; pageID++) {
+			if (!block_manager->Is_page_valid(block, pageID)) {
+				continue;
+			}
+			Stats::Total_page_movements_for_gc++;
+			page_address.PageID = pageID;
+			LPA_type lpa = flash_controller->Get_metadata(page_address.ChannelID, page_address.ChipID, page_address.DieID, page_address.PlaneID, page_address.BlockID, page_address.PageID);
+
+			page_status_type page_status_bitmap = FULL_PROGRAMMED_PAGE;
+			if (!block->Holds_mapping_data) {
+				//Bring the mapping entry into CMT first, so that the relocation below does not need a mapping read/writeback from flash
+				PPA_type ppa;
+				address_mapping_unit->Functional_access(block->Stream_id, lpa, FULL_PROGRAMMED_PAGE, false);
+				address_mapping_unit->Get_data_mapping_info_for_gc(block->Stream_id, lpa, ppa, page_status_bitmap);
+				if (ppa != address_mapping_unit->Convert_address_to_ppa(page_address)) {
+					PRINT_ERROR("Inconsistency found when moving a page for functional GC!")
+				}
+			}
+
+			NVM_Transaction_Flash_WR gc_write(Transaction_Source_Type::GC_WL, block->Stream_id, sector_no_per_page * SECTOR_SIZE_IN_BYTE,
+				lpa, NO_PPA, page_address, NULL, 0, NULL, page_status_bitmap, INVALID_TIME_STAMP);
+			address_mapping_unit->Allocate_new_page_for_gc(&gc_write, block->Holds_mapping_data);
+			flash_controller->Change_flash_page_status_for_preconditioning(gc_write.Address, lpa);
+		}
+
+		pbke->Erase_finished(gc_candidate_address.BlockID);
+		block_manager->Add_erased_block_to_pool(gc_candidate_address);
+	}
 }
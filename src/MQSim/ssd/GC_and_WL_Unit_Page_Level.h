@@ -28,6 +28,7 @@ namespace SSD_Components
 		void Check_gc_required(const unsigned int free_block_pool_size, const NVM::FlashMemory::Physical_Page_Address& plane_address);
 	private:
 		NVM_PHY_ONFI * flash_controller;
+		void run_functional_gc(const NVM::FlashMemory::Physical_Page_Address& gc_candidate_address);
 	};
 }
 #endif // !GC_AND_WL_UNIT_PAGE_LEVEL_H
@@ -7,6 +7,22 @@ namespace SSD_Components {
 	/*hack: using this style to emulate event/delegate*/
 	NVM_PHY_ONFI_NVDDR2* NVM_PHY_ONFI_NVDDR2::_my_instance;
 
+	/*Transactions generated inside the SSD (e.g., GC, mapping and cache prefetch reads) have no
+	* related user request, so the channel callbacks are only invoked when one exists.*/
+	inline void notify_channel_busy(NVM_Transaction_Flash* transaction)
+	{
+		if (transaction->UserIORequest != NULL && transaction->UserIORequest->channel_busy_callback) {
+			transaction->UserIORequest->channel_busy_callback();
+		}
+	}
+
+	inline void notify_channel_idle(NVM_Transaction_Flash* transaction)
+	{
+		if (transaction->UserIORequest != NULL && transaction->UserIORequest->channel_idle_callback) {
+			transaction->UserIORequest->channel_idle_callback();
+		}
+	}
+
 	NVM_PHY_ONFI_NVDDR2::NVM_PHY_ONFI_NVDDR2(const sim_object_id_type& id, ONFI_Channel_NVDDR2** channels,
 		unsigned int ChannelCount, unsigned int chip_no_per_channel, unsigned int DieNoPerChip, unsigned int PlaneNoPerDie)
 		: NVM_PHY_ONFI(id, ChannelCount, chip_no_per_channel, DieNoPerChip, PlaneNoPerDie), channels(channels)
@@ -136,7 +152,7 @@ namespace SSD_Components {
 		ChipBookKeepingEntry* chipBKE = &bookKeepingTable[transaction_list.front()->Address.ChannelID][transaction_list.front()->Address.ChipID];
 		DieBookKeepingEntry* dieBKE = &chipBKE->Die_book_keeping_records[transaction_list.front()->Address.DieID];
 
-		bool local = transaction_list.front()->UserIORequest->local;
+		bool local = transaction_list.front()->UserIORequest != NULL && transaction_list.front()->UserIORequest->local;
 
 		/*If this is not a die-interleaved command execution, and the channel is already busy,
 		* then something illegarl is happening*/
@@ -319,7 +335,7 @@ namespace SSD_Components {
 		}
 
 		target_channel->SetStatus(BusChannelStatus::BUSY, targetChip);
-		transaction_list.front()->UserIORequest->channel_busy_callback();
+		notify_channel_busy(transaction_list.front());
 	}
 
 	void NVM_PHY_ONFI_NVDDR2::Change_memory_status_preconditioning(const NVM::NVM_Memory_Address* address, const void* status_info)
@@ -361,7 +377,7 @@ namespace SSD_Components {
 				} else {
 					chipBKE->Status = ChipStatus::READING;
 					targetChannel->SetStatus(BusChannelStatus::IDLE, targetChip);
-					dieBKE->ActiveTransactions.front()->UserIORequest->channel_idle_callback();
+					notify_channel_idle(dieBKE->ActiveTransactions.front());
 				}
 				break;
 			case NVDDR2_SimEventType::ERASE_SETUP_COMPLETED:
@@ -378,7 +394,7 @@ namespace SSD_Components {
 				} else {
 					chipBKE->Status = ChipStatus::ERASING;
 					targetChannel->SetStatus(BusChannelStatus::IDLE, targetChip);
-					dieBKE->ActiveTransactions.front()->UserIORequest->channel_idle_callback();
+					notify_channel_idle(dieBKE->ActiveTransactions.front());
 				}
 				break;
 			case NVDDR2_SimEventType::PROGRAM_CMD_ADDR_DATA_TRANSFERRED:
@@ -397,7 +413,7 @@ namespace SSD_Components {
 				} else {
 					chipBKE->Status = ChipStatus::WRITING;
 					targetChannel->SetStatus(BusChannelStatus::IDLE, targetChip);
-					dieBKE->ActiveTransactions.front()->UserIORequest->channel_idle_callback();
+					notify_channel_idle(dieBKE->ActiveTransactions.front());
 				}
 				break;
 			case NVDDR2_SimEventType::READ_DATA_TRANSFERRED:
@@ -407,7 +423,7 @@ namespace SSD_Components {
 	#if 0
 				if (tr->ExecutionMode != ExecutionModeType::COPYBACK)
 	#endif
-				dieBKE->ActiveTransactions.front()->UserIORequest->channel_idle_callback();
+				notify_channel_idle(dieBKE->ActiveTransactions.front());
 
 				broadcastTransactionServicedSignal(dieBKE->ActiveTransfer);
 
@@ -469,7 +485,7 @@ namespace SSD_Components {
 
 			WaitingCopybackWrites[channel_id].pop_front();
 			channels[channel_id]->SetStatus(BusChannelStatus::BUSY, targetChip);
-			waitingBKE->ActiveTransactions.front()->UserIORequest->channel_busy_callback();
+			notify_channel_busy(waitingBKE->ActiveTransactions.front());
 
 			return;
 		} else if (WaitingMappingRead_TX[channel_id].size() > 0) {
@@ -580,7 +596,7 @@ namespace SSD_Components {
 					_my_instance, dieBKE, (int)NVDDR2_SimEventType::PROGRAM_COPYBACK_CMD_ADDR_TRANSFERRED);
 				chipBKE->OngoingDieCMDTransfers.push(dieBKE);
 				_my_instance->channels[chip->ChannelID]->SetStatus(BusChannelStatus::BUSY, chip);
-				dieBKE->ActiveTransactions.front()->UserIORequest->channel_busy_callback();
+				notify_channel_busy(dieBKE->ActiveTransactions.front());
 
 				dieBKE->Expected_finish_time = Simulator->Time() + _my_instance->channels[chip->ChannelID]->ProgramCommandTime[dieBKE->ActiveTransactions.size()]
 					+ chip->Get_command_execution_latency(dieBKE->ActiveCommand->CommandCode, dieBKE->ActiveCommand->Address[0].PageID);
@@ -658,7 +674,7 @@ namespace SSD_Components {
 
 		tr->STAT_transfer_time += NVDDR2DataOutTransferTime(tr->Data_and_metadata_size_in_byte, channels[tr->Address.ChannelID]);
 		channels[tr->Address.ChannelID]->SetStatus(BusChannelStatus::BUSY, channels[tr->Address.ChannelID]->Chips[tr->Address.ChipID]);
-		tr->UserIORequest->channel_busy_callback();
+		notify_channel_busy(tr);
 	}
 
 	void NVM_PHY_ONFI_NVDDR2::perform_interleaved_cmd_data_transfer(NVM::FlashMemory::Flash_Chip* chip, DieBookKeepingEntry* bookKeepingEntry)
@@ -698,7 +714,7 @@ namespace SSD_Components {
 				PRINT_ERROR("NVMController_NVDDR2: Uknown flash transaction type!")
 		}
 		target_channel->SetStatus(BusChannelStatus::BUSY, chip);
-		bookKeepingEntry->ActiveTransactions.front()->UserIORequest->channel_busy_callback();
+		notify_channel_busy(bookKeepingEntry->ActiveTransactions.front());
 	}
 
 	inline void NVM_PHY_ONFI_NVDDR2::send_resume_command_to_chip(NVM::FlashMemory::Flash_Chip* chip, ChipBookKeepingEntry* chipBKE)
@@ -204,7 +204,8 @@ namespace SSD_Components
 		{
 			flash_channel_ID_type channel_id = (*it)->Address.ChannelID;
 			flash_chip_ID_type chip_id = (*it)->Address.ChipID;
-			unsigned int priority_class = ((int)(*it)->UserIORequest->Priority_class) - 1;
+			//Prefetches and cache evictions have no user request, they are scheduled in the lowest priority class
+			unsigned int priority_class = (*it)->UserIORequest == NULL ? no_of_priority_classes - 1 : ((int)(*it)->UserIORequest->Priority_class) - 1;
 			stream_id_type stream_id = (*it)->Stream_id;
 			switch ((*it)->Type)
 			{
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include "Checkpoint.h"
+#include "../sim/Sim_Defs.h"
+
+namespace Utils
+{
+	bool CheckpointWriter::Open(const std::string file_path)
+	{
+		outFilePath = file_path;
+		outFile.open(file_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		return outFile.is_open();
+	}
+
+	void CheckpointWriter::Close()
+	{
+		//Buffered data is only written out here, so a full disk may show up on close only
+		outFile.close();
+		check_stream();
+	}
+
+	void CheckpointWriter::Write_section(const std::string name)
+	{
+		uint32_t length = (uint32_t)name.size();
+		Write(length);
+		outFile.write(name.c_str(), length);
+		check_stream();
+	}
+
+	void CheckpointWriter::check_stream()
+	{
+		if (!outFile) {
+			//Do not leave a truncated checkpoint behind for a later run to restore
+			outFile.close();
+			std::remove(outFilePath.c_str());
+			PRINT_ERROR("Could not write the SSD checkpoint file " << outFilePath << "!")
+		}
+	}
+
+	bool CheckpointReader::Open(const std::string file_path)
+	{
+		inFile.open(file_path.c_str(), std::ios::in | std::ios::binary);
+		return inFile.is_open();
+	}
+
+	void CheckpointReader::Close()
+	{
+		inFile.close();
+	}
+
+	void CheckpointReader::Read_section(const std::string name)
+	{
+		uint32_t length = Read<uint32_t>();
+		std::string section(length, '\0');
+		if (length > 0) {
+			inFile.read(&section[0], length);
+			check_stream();
+		}
+		if (section != name) {
+			PRINT_ERROR("Unexpected section in the SSD checkpoint! Expected " << name << ", but found " << section)
+		}
+	}
+
+	void CheckpointReader::check_stream()
+	{
+		if (!inFile) {
+			PRINT_ERROR("The SSD checkpoint file is truncated or unreadable!")
+		}
+	}
+}
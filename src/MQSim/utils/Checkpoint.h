@@ -0,0 +1,65 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Utils
+{
+	/*
+	* Binary streams used to save and restore the state of the SSD model. Values are stored in host
+	* byte order, so a checkpoint can only be restored on the same architecture and with the same
+	* device configuration that created it. Each component brackets its data with a named section,
+	* which lets the reader detect configuration mismatches and truncated files early.
+	*/
+	class CheckpointWriter {
+	public:
+		bool Open(const std::string file_path);
+		void Close();//Stops the simulation if the file could not be completely written
+		void Write_section(const std::string name);
+		template<typename T> void Write(const T& value)
+		{
+			outFile.write(reinterpret_cast<const char*>(&value), sizeof(T));
+			check_stream();
+		}
+		template<typename T> void Write_array(const T* values, const uint64_t count)
+		{
+			outFile.write(reinterpret_cast<const char*>(values), sizeof(T) * count);
+			check_stream();
+		}
+	private:
+		std::ofstream outFile;
+		std::string outFilePath;
+		void check_stream();
+	};
+
+	class CheckpointReader {
+	public:
+		bool Open(const std::string file_path);
+		void Close();
+		void Read_section(const std::string name);//Stops the simulation if the next section in the file is not name
+		template<typename T> void Read(T& value)
+		{
+			inFile.read(reinterpret_cast<char*>(&value), sizeof(T));
+			check_stream();
+		}
+		template<typename T> T Read()
+		{
+			T value;
+			Read(value);
+			return value;
+		}
+		template<typename T> void Read_array(T* values, const uint64_t count)
+		{
+			inFile.read(reinterpret_cast<char*>(values), sizeof(T) * count);
+			check_stream();
+		}
+	private:
+		std::ifstream inFile;
+		void check_stream();
+	};
+}
+
+#endif // !CHECKPOINT_H
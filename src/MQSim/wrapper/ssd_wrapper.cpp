@@ -43,11 +43,18 @@ void MQSimWrapper::load_workload_config(const std::string& workload_file) {
   rapidxml::xml_node<> *mqsim_io_scenarios = doc.first_node("MQSim_IO_Scenarios");
   assert(mqsim_io_scenarios);
   auto xml_io_scenario = mqsim_io_scenarios->first_node("IO_Scenario");
-  auto flow_def = xml_io_scenario->first_node();
-  assert(!strcmp(flow_def->name(), "IO_Flow_Parameter_Set_Trace_Based"));
-  auto flow = new IO_Flow_Parameter_Set_Trace_Based;
-  flow->XML_deserialize(flow_def);
-  _exec_params->Host_Configuration.IO_Flow_Definitions.push_back(flow);
+  for(auto flow_def = xml_io_scenario->first_node(); flow_def; flow_def = flow_def->next_sibling()) {
+    IO_Flow_Parameter_Set* flow = nullptr;
+    if(!strcmp(flow_def->name(), "IO_Flow_Parameter_Set_Trace_Based")) {
+      flow = new IO_Flow_Parameter_Set_Trace_Based;
+    } else if(!strcmp(flow_def->name(), "IO_Flow_Parameter_Set_GNN_Sampling")) {
+      // drives the SSD standalone with mini-batch sampling traffic
+      flow = new IO_Flow_Parameter_Set_GNN_Sampling;
+    }
+    assert(flow);
+    flow->XML_deserialize(flow_def);
+    _exec_params->Host_Configuration.IO_Flow_Definitions.push_back(flow);
+  }
   delete []temp_string;
   fs.close();
 }
@@ -148,12 +155,7 @@ void MQSimWrapper::handle_req_flash(const SSDRequest& req) {
       }
 
 
-      trans->Address.ChannelID = addr.channel;
-      trans->Address.ChipID = addr.chip;
-      trans->Address.DieID = addr.die;
-      trans->Address.PlaneID = addr.plane;
-      trans->Address.BlockID = addr.block + ((addr.page + pagecnt) / get_num_pages_per_block());
-      trans->Address.PageID = (addr.page + pagecnt) % get_num_pages_per_block();
+      trans->Address = get_page_address(addr, pagecnt);
 
       trans->Physical_address_determined = true;
 
@@ -203,6 +205,41 @@ void MQSimWrapper::handle_req_channel(const SSDRequest& req) {
   }
 }
 
+NVM::FlashMemory::Physical_Page_Address MQSimWrapper::get_page_address(const FlashAddress& addr, uint32_t pagecnt) const {
+  NVM::FlashMemory::Physical_Page_Address ppa;
+  ppa.ChannelID = addr.channel;
+  ppa.ChipID = addr.chip;
+  ppa.DieID = addr.die;
+  ppa.PlaneID = addr.plane;
+  ppa.BlockID = addr.block + ((addr.page + pagecnt) / get_num_pages_per_block());
+  ppa.PageID = (addr.page + pagecnt) % get_num_pages_per_block();
+  return ppa;
+}
+
+void MQSimWrapper::complete_functional(const SSDRequest& req) {
+  if(req.type == SSDRequestType::WRITE_LOCAL || req.type == SSDRequestType::WRITE) {
+    // program the same physical pages as handle_req_flash, with the same (unused) LPA its transactions carry;
+    // reads leave no state behind, and PULL/PUSH only move data over the channel
+    LPA_type lpa = 0;
+    for(uint32_t pagecnt = 0; pagecnt < (req.bytes - 1) / get_page_capacity() + 1; ++pagecnt) {
+      for(const auto& addr : req.addrs) {
+        auto ppa = get_page_address(addr, pagecnt);
+        _ssd->PHY->Change_memory_status_preconditioning(&ppa, &lpa);
+      }
+    }
+  }
+  _functional_completions.push(req.callback);
+  // callbacks may issue new requests, so drain iteratively instead of recursing
+  if(_draining_functional_completions) return;
+  _draining_functional_completions = true;
+  while(!_functional_completions.empty()) {
+    auto callback = _functional_completions.front();
+    _functional_completions.pop();
+    callback();
+  }
+  _draining_functional_completions = false;
+}
+
 void MQSimWrapper::handle_req(const SSDRequest& req) {
   for(const auto& addr : req.addrs) {
     if(!check_addr(addr)) {
@@ -212,6 +249,8 @@ void MQSimWrapper::handle_req(const SSDRequest& req) {
   }
   if(req.bytes == 0) {
     req.callback();
+  } else if(_functional_mode) {
+    complete_functional(req);
   } else {
     switch(req.type) {
       case SSDRequestType::READ_LOCAL:
@@ -237,7 +276,7 @@ MQSimWrapper::MQSimWrapper(const GraphUtil::Graph* graph)
       _exec_params->SSD_Device_Configuration.Flash_Channel_Width
       * _exec_params->SSD_Device_Configuration.Channel_Transfer_Rate
       * 1024.0 / 1000.0 * 1024.0 / 1000.0 / 1000.0),
-    _output_path(".") {
+    _output_path("."), _functional_mode(false), _draining_functional_completions(false) {
   Simulator->Reset();
 
   load_ssd_config("configs/ssd/config_4096_333.xml");
@@ -308,6 +347,60 @@ void MQSimWrapper::tick() {
   _last_cycle = _cycle;
 }
 
+void MQSimWrapper::enter_functional_mode() {
+  if(_functional_mode) return;
+  _functional_mode = true;
+  _ssd->Enter_functional_mode();
+}
+
+void MQSimWrapper::exit_functional_mode() {
+  if(!_functional_mode) return;
+  assert(_functional_completions.empty());
+  _functional_mode = false;
+  _ssd->Exit_functional_mode();
+}
+
+void MQSimWrapper::save_checkpoint(const std::string& path) {
+  assert(_cycle == _last_cycle);
+  for(auto& chan : _channels) assert(!chan.busy && chan.reqs.empty());
+  assert(_functional_completions.empty());
+  Utils::CheckpointWriter writer;
+  if(!writer.Open(path)) {
+    PRINT_ERROR("Cannot open the SSD checkpoint file " << path << " for writing!")
+  }
+  writer.Write_section("MQSimWrapper");
+  writer.Write(_cycle);
+  writer.Write(_clock_ns);
+  writer.Write((uint64_t)_channels.size());
+  for(auto& chan : _channels) {
+    writer.Write(chan.board_to_chip_bytes);
+    writer.Write(chan.chip_to_board_bytes);
+  }
+  _ssd->Save_checkpoint(writer);
+  writer.Close();
+}
+
+void MQSimWrapper::load_checkpoint(const std::string& path) {
+  for(auto& chan : _channels) assert(!chan.busy && chan.reqs.empty());
+  Utils::CheckpointReader reader;
+  if(!reader.Open(path)) {
+    PRINT_ERROR("Cannot open the SSD checkpoint file " << path << "!")
+  }
+  reader.Read_section("MQSimWrapper");
+  reader.Read(_cycle);
+  _last_cycle = _cycle;
+  reader.Read(_clock_ns);
+  if(reader.Read<uint64_t>() != _channels.size()) {
+    PRINT_ERROR("The number of flash channels in the SSD checkpoint does not match the current configuration!")
+  }
+  for(auto& chan : _channels) {
+    reader.Read(chan.board_to_chip_bytes);
+    reader.Read(chan.chip_to_board_bytes);
+  }
+  _ssd->Load_checkpoint(reader);
+  reader.Close();
+}
+
 bool MQSimWrapper::is_event_tree_empty() const {
   for(auto& chan : _channels) if(!chan.reqs.empty()) return false;
   return Simulator->is_event_tree_empty();
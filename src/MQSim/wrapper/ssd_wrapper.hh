@@ -120,6 +120,16 @@ private:
 
   std::string _output_path;
 
+  // functional mode: requests complete instantly while the host fast-forwards; flash writes still leave the
+  // programmed pages behind, the only flash state the timing path (which bypasses the FTL and cache) depends on
+  bool _functional_mode;
+  bool _draining_functional_completions;
+  std::queue<std::function<void(void)>> _functional_completions;
+
+  void complete_functional(const SSDRequest& req);
+  // pagecnt-th page of a (possibly multi-page) request starting at addr
+  NVM::FlashMemory::Physical_Page_Address get_page_address(const FlashAddress& addr, uint32_t pagecnt) const;
+
   void load_ssd_config(const std::string& config_file);
   void load_workload_config(const std::string& workload_file);
 
@@ -139,6 +149,14 @@ public:
 
   void tick() override;
 
+  void enter_functional_mode();
+  void exit_functional_mode();
+  bool in_functional_mode() const { return _functional_mode; }
+
+  // checkpointing: only allowed when no request is in flight; stats are not part of a checkpoint
+  void save_checkpoint(const std::string& path);
+  void load_checkpoint(const std::string& path);
+
   uint32_t get_num_channels() const override { return _exec_params->SSD_Device_Configuration.Flash_Channel_Count; }
   uint32_t get_num_chips_per_channel() const override { return _exec_params->SSD_Device_Configuration.Chip_No_Per_Channel; }
   uint32_t get_num_dies_per_chip() const override { return _exec_params->SSD_Device_Configuration.Flash_Parameters.Die_No_Per_Chip; }
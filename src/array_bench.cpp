@@ -0,0 +1,124 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmark for cache array lookups: fills SetAssocArray and ZArray
+ * instances of several associativities and reports lookups per second (half
+ * the probed lines were inserted, though random replacement evicts some).
+ * Build with -march=native to use the AVX2 lookup path.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "cache_arrays.h"
+#include "galloc.h"
+#include "hash.h"
+#include "log.h"
+#include "mtrand.h"
+#include "repl_policies.h"
+
+// Random replacement that does not need a coherence controller
+class BenchReplPolicy : public ReplPolicy {
+    private:
+        MTRand rnd;
+
+    public:
+        BenchReplPolicy() : rnd(0xB3A7) {}
+
+        void update(uint32_t id, const MemReq* req) {}
+        void replaced(uint32_t id) {}
+
+        template <typename C> inline uint32_t rank(const MemReq* req, C cands) {
+            uint32_t n = 0;
+            for (auto ci = cands.begin(); ci != cands.end(); ci.inc()) n++;
+            uint32_t pick = rnd.randInt(n - 1);
+            for (auto ci = cands.begin(); ci != cands.end(); ci.inc()) {
+                if (!pick--) return *ci;
+            }
+            panic("Empty candidate list");
+        }
+
+        DECL_RANK_BINDINGS;
+};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static void bench(const char* type, uint32_t numLines, uint32_t ways, uint32_t cands, uint64_t lookups) {
+    uint32_t setBits = ilog2(numLines/ways);
+    ReplPolicy* rp = new BenchReplPolicy();
+    CacheArray* array;
+    if (cands) array = new ZArray(numLines, ways, cands, rp, new H3HashFamily(ways, setBits, 0xCAC7EAFFA1));
+    else array = new SetAssocArray(numLines, ways, rp, new IdHashFamily());
+
+    // Fill with lines 1..numLines, then look up 1..2*numLines (lines are never 0)
+    MESIState state = I;
+    MemReq req = {0, GETS, 0, &state, 0, nullptr, I, 0, 0};
+    for (Address line = 1; line <= numLines; line++) {
+        req.lineAddr = line;
+        Address wbLineAddr;
+        uint32_t id = array->preinsert(line, &req, &wbLineAddr);
+        array->postinsert(line, &req, id);
+    }
+
+    std::vector<Address> addrs(1 << 16);
+    MTRand rnd(0x5EED);
+    for (Address& a : addrs) a = 1 + rnd.randInt(2*numLines - 1);
+
+    uint64_t hits = 0;
+    double start = now();
+    for (uint64_t i = 0; i < lookups; i++) {
+        req.lineAddr = addrs[i & (addrs.size() - 1)];
+        hits += (array->lookup(req.lineAddr, &req, true) >= 0);
+    }
+    double secs = now() - start;
+    info("%-8s %7d lines %3d ways %3d cands: %8.2f Mlookups/s (%.1f%% hits)", type, numLines, ways, cands,
+            lookups/secs/1e6, 100.0*hits/lookups);
+}
+
+int main(int argc, char* argv[]) {
+    InitLog("[B] ");
+    uint64_t lookups = (argc > 1)? strtoull(argv[1], nullptr, 0) : 20*1000*1000;
+    gm_init(256 << 20);
+    info("Array lookup microbenchmark, %ld lookups per config, %s tag matching", lookups,
+#if defined(__AVX2__)
+            "AVX2"
+#elif defined(__SSE2__)
+            "SSE2"
+#else
+            "scalar"
+#endif
+            );
+
+    const uint32_t lines = 32768;  // 2MB of 64-byte lines
+    for (uint32_t ways : {4, 8, 16, 32}) bench("SetAssoc", lines, ways, 0, lookups);
+    for (uint32_t ways : {4, 8}) {
+        for (uint32_t cands : {16, 52}) bench("Z", lines, ways, cands, lookups);
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bbl_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core.h"
+#include "decoder.h"
+#include "galloc.h"
+#include "log.h"
+#include "zsim.h"
+
+#define BBL_CACHE_MAGIC 0x3143424c424d535aUL  // "ZSMBLBC1"
+#define BBL_CACHE_VERSION 1  // bump whenever the decoder's output changes
+
+struct BblCacheHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t uopBytes;
+    uint32_t vectorUarch;
+    uint32_t pad;
+    uint64_t imageHash;
+    uint64_t entries;
+};
+
+static uint64_t fnv1a(const void* data, size_t bytes, uint64_t h = 0xcbf29ce484222325UL) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < bytes; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3UL;
+    }
+    return h;
+}
+
+static inline uint64_t entryKey(uint64_t offset, uint32_t bytes) {
+    return offset ^ (((uint64_t)bytes) << 48);  // the same address may start blocks of different lengths
+}
+
+BblCache::BblCache(const char* _dir) : dir(_dir), hits(0), misses(0) {
+    if (mkdir(_dir, 0777) != 0 && errno != EEXIST) panic("Could not create BBL cache directory %s: %s", _dir, strerror(errno));
+}
+
+BblCache::ImageCache* BblCache::getImageCache(IMG img) {
+    uint32_t id = IMG_Id(img);
+    auto it = images.find(id);
+    if (it != images.end()) return it->second;
+
+    ImageCache* ic = nullptr;
+    std::string path = IMG_Name(img);
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        ic = new ImageCache();
+        uint64_t ident[2] = {(uint64_t)st.st_size, (uint64_t)st.st_mtime};
+        ic->imageHash = fnv1a(ident, sizeof(ident), fnv1a(path.c_str(), path.size()));
+        char name[32];
+        snprintf(name, sizeof(name), "/%016lx.bblc", ic->imageHash);
+        ic->file = dir + name;
+        ic->map = nullptr;
+        ic->mapBytes = 0;
+        ic->validEntries = 0;
+        ic->validBytes = 0;
+        load(ic);
+    }
+    images[id] = ic;  // images without a backing file are never cached
+    return ic;
+}
+
+void BblCache::load(ImageCache* ic) {
+    int fd = open(ic->file.c_str(), O_RDONLY);
+    if (fd < 0) return;  // first run with this image
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BblCacheHeader)) {
+        close(fd);
+        return;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        warn("Could not mmap BBL cache file %s: %s", ic->file.c_str(), strerror(errno));
+        return;
+    }
+
+    const BblCacheHeader* hdr = static_cast<const BblCacheHeader*>(map);
+    if (hdr->magic != BBL_CACHE_MAGIC || hdr->version != BBL_CACHE_VERSION || hdr->uopBytes != sizeof(DynUop) ||
+            hdr->vectorUarch != zinfo->vectorUarch || hdr->imageHash != ic->imageHash) {
+        // Stale file from another simulator build or config, will be overwritten if we add entries
+        munmap(map, st.st_size);
+        return;
+    }
+
+    const char* cur = static_cast<const char*>(map) + sizeof(BblCacheHeader);
+    const char* end = static_cast<const char*>(map) + st.st_size;
+    uint64_t i;
+    for (i = 0; i < hdr->entries; i++) {
+        const Entry* e = reinterpret_cast<const Entry*>(cur);
+        if (cur + sizeof(Entry) > end || cur + sizeof(Entry) + e->uops*sizeof(DynUop) > end) {
+            warn("Truncated BBL cache file %s, using %ld/%ld entries", ic->file.c_str(), i, hdr->entries);
+            break;
+        }
+        ic->entries[entryKey(e->offset, e->bytes)] = e;  // later entries supersede earlier ones
+        cur += sizeof(Entry) + e->uops*sizeof(DynUop);
+    }
+    ic->map = map;
+    ic->mapBytes = st.st_size;
+    ic->validEntries = i;
+    ic->validBytes = cur - (static_cast<const char*>(map) + sizeof(BblCacheHeader));
+}
+
+BblInfo* BblCache::decodeBbl(BBL bbl) {
+    ADDRINT addr = BBL_Address(bbl);
+    uint32_t instrs = BBL_NumIns(bbl);
+    uint32_t bytes = BBL_Size(bbl);
+
+    IMG img = IMG_FindByAddress(addr);
+    ImageCache* ic = IMG_Valid(img)? getImageCache(img) : nullptr;
+    if (!ic) return Decoder::decodeBbl(bbl, true);
+
+    std::vector<uint8_t> code(bytes);
+    if (PIN_SafeCopy(&code[0], (const VOID*)addr, bytes) != bytes) return Decoder::decodeBbl(bbl, true);
+    uint64_t codeHash = fnv1a(&code[0], bytes);
+    uint64_t offset = addr - IMG_LowAddress(img);
+    uint64_t key = entryKey(offset, bytes);
+
+    auto it = ic->entries.find(key);
+    if (it != ic->entries.end()) {
+        const Entry* e = it->second;
+        if (e->offset == offset && e->bytes == bytes && e->instrs == instrs && e->codeHash == codeHash) {
+            hits++;
+            uint32_t objBytes = offsetof(BblInfo, oooBbl) + DynBbl::bytes(e->uops);
+            BblInfo* bblInfo = static_cast<BblInfo*>(gm_malloc(objBytes));
+            bblInfo->instrs = instrs;
+            bblInfo->bytes = bytes;
+            DynBbl& dynBbl = bblInfo->oooBbl[0];
+            dynBbl.addr = addr;
+            dynBbl.uops = e->uops;
+            dynBbl.approxInstrs = e->approxInstrs;
+            memcpy(dynBbl.uop, e + 1, e->uops*sizeof(DynUop));
+            return bblInfo;
+        }
+    }
+
+    misses++;
+    BblInfo* bblInfo = Decoder::decodeBbl(bbl, true);
+    const DynBbl& dynBbl = bblInfo->oooBbl[0];
+    Entry* e = static_cast<Entry*>(malloc(sizeof(Entry) + dynBbl.uops*sizeof(DynUop)));
+    e->offset = offset;
+    e->codeHash = codeHash;
+    e->instrs = instrs;
+    e->bytes = bytes;
+    e->uops = dynBbl.uops;
+    e->approxInstrs = dynBbl.approxInstrs;
+    memcpy(e + 1, dynBbl.uop, dynBbl.uops*sizeof(DynUop));
+    ic->entries[key] = e;
+    ic->newEntries.push_back(e);
+    return bblInfo;
+}
+
+void BblCache::write(ImageCache* ic) {
+    // Keep only the validated prefix of the old file, a truncated trailing entry would misalign the new ones
+    const char* oldData = ic->map? static_cast<const char*>(ic->map) + sizeof(BblCacheHeader) : nullptr;
+    size_t oldBytes = ic->validBytes;
+    uint64_t oldEntries = ic->validEntries;
+
+    std::string tmpFile = ic->file + ".tmp." + std::to_string(getpid());
+    FILE* f = fopen(tmpFile.c_str(), "w");
+    if (!f) {
+        warn("Could not write BBL cache file %s: %s", tmpFile.c_str(), strerror(errno));
+        return;
+    }
+
+    BblCacheHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = BBL_CACHE_MAGIC;
+    hdr.version = BBL_CACHE_VERSION;
+    hdr.uopBytes = sizeof(DynUop);
+    hdr.vectorUarch = zinfo->vectorUarch;
+    hdr.imageHash = ic->imageHash;
+    hdr.entries = oldEntries + ic->newEntries.size();
+
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    if (oldBytes) ok = ok && fwrite(oldData, oldBytes, 1, f) == 1;
+    for (Entry* e : ic->newEntries) ok = ok && fwrite(e, sizeof(Entry) + e->uops*sizeof(DynUop), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(tmpFile.c_str(), ic->file.c_str()) != 0) {
+        warn("Could not write BBL cache file %s: %s", ic->file.c_str(), strerror(errno));
+        unlink(tmpFile.c_str());
+    }
+}
+
+void BblCache::flush() {
+    uint64_t written = 0;
+    for (auto& it : images) {
+        ImageCache* ic = it.second;
+        if (!ic || ic->newEntries.empty()) continue;
+        write(ic);
+        written += ic->newEntries.size();
+    }
+    info("BBL cache: %ld hits, %ld misses, %ld new entries written to %s", hits, misses, written, dir.c_str());
+}
@@ -0,0 +1,89 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BBL_CACHE_H_
+#define BBL_CACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "pin.H"
+
+struct BblInfo;
+
+/* On-disk cache of OOO-decoded basic blocks, so that runs of the same binaries skip most of the decoding work.
+ *
+ * Blocks are stored in one file per image, named after a hash of the image's path, size and mtime. Entries are
+ * keyed by the block's offset in the image and validated against a hash of its code bytes; code outside of images
+ * (JIT'd code, the vDSO) is always decoded. Files are mmap'd the first time one of their blocks is instrumented,
+ * and files with new entries are rewritten on exit through a rename, so concurrent runs never see partial files
+ * (at worst, they drop each other's new entries).
+ *
+ * The cache is process-local and must only be used from instrumentation routines, which Pin serializes.
+ */
+class BblCache {
+    private:
+        struct Entry {
+            uint64_t offset;
+            uint64_t codeHash;
+            uint32_t instrs;
+            uint32_t bytes;
+            uint32_t uops;
+            uint32_t approxInstrs;
+            // followed by DynUop[uops]
+        };
+
+        struct ImageCache {
+            std::string file;
+            uint64_t imageHash;
+            void* map;
+            size_t mapBytes;
+            uint64_t validEntries;  // entries of the mapped file that passed validation...
+            size_t validBytes;      // ...and the bytes they span after the header; only this prefix is kept on rewrite
+            std::unordered_map<uint64_t, const Entry*> entries;
+            std::vector<Entry*> newEntries;
+        };
+
+        std::string dir;
+        std::unordered_map<uint32_t, ImageCache*> images;  // indexed by IMG_Id
+        uint64_t hits, misses;
+
+    public:
+        explicit BblCache(const char* _dir);
+
+        // Returns the same BblInfo that Decoder::decodeBbl(bbl, true) would
+        BblInfo* decodeBbl(BBL bbl);
+
+        // Writes back the files of images with new entries
+        void flush();
+
+    private:
+        ImageCache* getImageCache(IMG img);
+        void load(ImageCache* ic);
+        void write(ImageCache* ic);
+};
+
+#endif  // BBL_CACHE_H_
@@ -0,0 +1,184 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "branch_predictor.h"
+#include <math.h>
+#include "bithacks.h"
+#include "log.h"
+
+#define TAGE_U_RESET_PERIOD (1 << 18)  // branches between useful-counter decays
+
+TAGEBranchPredictor::TAGEBranchPredictor(uint32_t _numTables, uint32_t _tableBits, uint32_t _baseBits, uint32_t _tagBits, uint32_t minHist, uint32_t maxHist)
+    : numTables(_numTables), tableBits(_tableBits), baseBits(_baseBits), tagBits(_tagBits)
+{
+    if (numTables < 1 || numTables > 32) panic("TAGE: need 1-32 tagged tables, %d given", numTables);
+    if (tableBits < 1 || tableBits > 24 || baseBits < 1 || baseBits > 24) panic("TAGE: table sizes must be 2^1 to 2^24 entries");
+    if (tagBits < 2 || tagBits > 16) panic("TAGE: tags must be 2-16 bits, %d given", tagBits);
+    if (minHist < 1 || maxHist < minHist) panic("TAGE: invalid history lengths [%d, %d]", minHist, maxHist);
+
+    base = gm_calloc<uint8_t>(1 << baseBits);
+    for (uint32_t i = 0; i < (1u << baseBits); i++) base[i] = 1;  // weak non-taken
+    tables = gm_calloc<TaggedEntry>(numTables << tableBits);
+
+    // Geometric history lengths
+    histLengths = gm_calloc<uint32_t>(numTables);
+    idxHist = gm_calloc<FoldedHistory>(numTables);
+    tagHist[0] = gm_calloc<FoldedHistory>(numTables);
+    tagHist[1] = gm_calloc<FoldedHistory>(numTables);
+    for (uint32_t i = 0; i < numTables; i++) {
+        double ratio = (numTables > 1)? ((double)i)/(numTables - 1) : 0.0;
+        histLengths[i] = (uint32_t)(minHist*pow(((double)maxHist)/minHist, ratio) + 0.5);
+        idxHist[i].init(histLengths[i], tableBits);
+        tagHist[0][i].init(histLengths[i], tagBits);
+        tagHist[1][i].init(histLengths[i], tagBits - 1);
+    }
+
+    uint32_t ghistSize = 1 << (ilog2(maxHist) + 1);  // > maxHist
+    ghist = gm_calloc<uint8_t>(ghistSize);
+    ghistMask = ghistSize - 1;
+    ghistPos = 0;
+    pathHist = 0;
+
+    useAltOnNewAlloc = 0;
+    randState = 0xdeadbeef;
+    branchCount = 0;
+    uDecayPos = 0;
+
+    idx = gm_calloc<uint32_t>(numTables);
+    tags = gm_calloc<uint16_t>(numTables);
+}
+
+void TAGEBranchPredictor::initStats(AggregateStat* parentStat) {
+    AggregateStat* bpStat = new AggregateStat();
+    bpStat->init("tage", "TAGE branch predictor stats");
+    profProvider.init("provider", "Predictions by provider (0: base, i: tagged table i-1)", numTables + 1);
+    profAllocs.init("allocs", "Tagged entries allocated on mispredicts");
+    bpStat->append(&profProvider);
+    bpStat->append(&profAllocs);
+    parentStat->append(bpStat);
+}
+
+bool TAGEBranchPredictor::predict(Address branchPc, bool taken) {
+    uint32_t pcHash = (uint32_t)(branchPc ^ (branchPc >> 16));
+    uint32_t tableMask = (1 << tableBits) - 1;
+    uint32_t tagMask = (1 << tagBits) - 1;
+
+    // Compute indices and tags, find the provider (longest hit) and alternate (next-longest hit)
+    int32_t provider = -1;
+    int32_t alt = -1;
+    for (uint32_t i = 0; i < numTables; i++) {
+        uint32_t shift = (tableBits > i)? (tableBits - i) : (i - tableBits + 1);
+        uint32_t path = pathHist & ((1 << MIN(histLengths[i], 16u)) - 1);
+        idx[i] = (pcHash ^ (pcHash >> shift) ^ idxHist[i].comp ^ path ^ (path >> tableBits)) & tableMask;
+        tags[i] = (pcHash ^ tagHist[0][i].comp ^ (tagHist[1][i].comp << 1)) & tagMask;
+    }
+    for (int32_t i = numTables - 1; i >= 0; i--) {
+        if (entry(i).tag == tags[i]) {
+            if (provider == -1) {
+                provider = i;
+            } else {
+                alt = i;
+                break;
+            }
+        }
+    }
+
+    uint32_t baseIdx = pcHash & ((1 << baseBits) - 1);
+    bool basePred = base[baseIdx] > 1;
+    bool altPred = (alt >= 0)? (entry(alt).ctr >= 0) : basePred;
+    bool pred;
+    if (provider >= 0) {
+        TaggedEntry& e = entry(provider);
+        bool providerPred = e.ctr >= 0;
+        bool newAlloc = (e.ctr == 0 || e.ctr == -1) && e.u == 0;
+        pred = (newAlloc && useAltOnNewAlloc >= 0)? altPred : providerPred;
+        profProvider.inc(provider + 1);
+
+        // Update
+        if (newAlloc && providerPred != altPred) {
+            if (altPred == taken) useAltOnNewAlloc = MIN(useAltOnNewAlloc + 1, 7);
+            else useAltOnNewAlloc = MAX(useAltOnNewAlloc - 1, -8);
+        }
+        if (pred != taken) allocate(provider, taken);
+        if (providerPred != altPred) {
+            if (providerPred == taken) e.u = MIN(e.u + 1, 3);
+            else if (e.u) e.u--;
+        }
+        e.ctr = taken? MIN(e.ctr + 1, 3) : MAX(e.ctr - 1, -4);
+    } else {
+        pred = basePred;
+        profProvider.inc(0);
+        if (pred != taken) allocate(provider, taken);
+        base[baseIdx] = taken? MIN(base[baseIdx] + 1, 3) : MAX(base[baseIdx] - 1, 0);
+    }
+
+    // Periodically decay useful counters so stale entries can be replaced. Each branch decays its share of the
+    // entries, so every entry is halved once per period without a full-table sweep on a single prediction
+    uint64_t phase = ++branchCount % TAGE_U_RESET_PERIOD;
+    uint32_t decayEnd = phase? (uint32_t)(phase*(numTables << tableBits)/TAGE_U_RESET_PERIOD) : (numTables << tableBits);
+    while (uDecayPos < decayEnd) tables[uDecayPos++].u >>= 1;
+    if (!phase) uDecayPos = 0;
+
+    updateHistory(branchPc, taken);
+    return (taken == pred);
+}
+
+void TAGEBranchPredictor::allocate(int32_t provider, bool taken) {
+    uint32_t start = provider + 1;
+    if (start >= numTables) return;
+
+    // Randomly skip the first candidate to spread allocations across tables
+    randState ^= randState << 13;
+    randState ^= randState >> 17;
+    randState ^= randState << 5;
+    if ((randState & 1) && start + 1 < numTables) start++;
+
+    for (uint32_t i = start; i < numTables; i++) {
+        TaggedEntry& e = entry(i);
+        if (e.u == 0) {
+            e.tag = tags[i];
+            e.ctr = taken? 0 : -1;
+            profAllocs.inc();
+            return;
+        }
+    }
+
+    // No free entry, age the candidates instead
+    for (uint32_t i = provider + 1; i < numTables; i++) {
+        TaggedEntry& e = entry(i);
+        if (e.u) e.u--;
+    }
+}
+
+void TAGEBranchPredictor::updateHistory(Address branchPc, bool taken) {
+    ghistPos--;
+    ghist[ghistPos & ghistMask] = taken? 1 : 0;
+    pathHist = ((pathHist << 1) ^ (uint32_t)(branchPc & 1)) & 0xffff;
+    for (uint32_t i = 0; i < numTables; i++) {
+        idxHist[i].update(ghist, ghistPos, ghistMask);
+        tagHist[0][i].update(ghist, ghistPos, ghistMask);
+        tagHist[1][i].update(ghist, ghistPos, ghistMask);
+    }
+}
@@ -0,0 +1,243 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BRANCH_PREDICTOR_H_
+#define BRANCH_PREDICTOR_H_
+
+#include <stdint.h>
+#include "galloc.h"
+#include "memory_hierarchy.h"
+#include "stats.h"
+
+/* Branch predictor interface used by OOOCore. predict() is called once per
+ * conditional branch (at most once per BBL), so a virtual call is cheap
+ * compared to the rest of bbl().
+ */
+class BranchPredictor : public GlobAlloc {
+    public:
+        virtual ~BranchPredictor() {}
+
+        // Predicts and updates; returns false if mispredicted
+        virtual bool predict(Address branchPc, bool taken) = 0;
+
+        virtual void initStats(AggregateStat* parentStat) {}
+};
+
+/* 2-level branch predictor:
+ *  - L1: Branch history shift registers (bshr): 2^NB entries, HB bits of history/entry, indexed by XOR'd PC
+ *  - L2: Pattern history table (pht): 2^LB entries, 2-bit sat counters, indexed by XOR'd bshr contents
+ *  NOTE: Assumes LB is in [NB, HB] range for XORing (e.g., HB = 18 and NB = 10, LB = 13 is OK)
+ */
+template<uint32_t NB, uint32_t HB, uint32_t LB>
+class BranchPredictorPAg : public BranchPredictor {
+    private:
+        uint32_t bhsr[1 << NB];
+        uint8_t pht[1 << LB];
+
+    public:
+        BranchPredictorPAg() {
+            uint32_t numBhsrs = 1 << NB;
+            uint32_t phtSize = 1 << LB;
+
+            for (uint32_t i = 0; i < numBhsrs; i++) {
+                bhsr[i] = 0;
+            }
+            for (uint32_t i = 0; i < phtSize; i++) {
+                pht[i] = 1;  // weak non-taken
+            }
+
+            static_assert(LB <= HB, "Too many PHT entries");
+            static_assert(LB >= NB, "Too few PHT entries (you'll need more XOR'ing)");
+        }
+
+        // Predicts and updates; returns false if mispredicted
+        bool predict(Address branchPc, bool taken) {
+            uint32_t bhsrMask = (1 << NB) - 1;
+            uint32_t histMask = (1 << HB) - 1;
+            uint32_t phtMask  = (1 << LB) - 1;
+
+            // Predict
+            // uint32_t bhsrIdx = ((uint32_t)( branchPc ^ (branchPc >> NB) ^ (branchPc >> 2*NB) )) & bhsrMask;
+            uint32_t bhsrIdx = ((uint32_t)( branchPc >> 1)) & bhsrMask;
+            uint32_t phtIdx = bhsr[bhsrIdx];
+
+            // Shift-XOR-mask to fit in PHT
+            phtIdx ^= (phtIdx & ~phtMask) >> (HB - LB); // take the [HB-1, LB] bits of bshr, XOR with [LB-1, ...] bits
+            phtIdx &= phtMask;
+
+            // If uncommented, behaves like a global history predictor
+            // bhsrIdx = 0;
+            // phtIdx = (bhsr[bhsrIdx] ^ ((uint32_t)branchPc)) & phtMask;
+
+            bool pred = pht[phtIdx] > 1;
+
+            // info("BP Pred: 0x%lx bshr[%d]=%x taken=%d pht=%d pred=%d", branchPc, bhsrIdx, phtIdx, taken, pht[phtIdx], pred);
+
+            // Update
+            pht[phtIdx] = taken? (pred? 3 : (pht[phtIdx]+1)) : (pred? (pht[phtIdx]-1) : 0); //2-bit saturating counter
+            bhsr[bhsrIdx] = ((bhsr[bhsrIdx] << 1) & histMask ) | (taken? 1: 0); //we apply phtMask here, dependence is further away
+
+            // info("BP Update: newPht=%d newBshr=%x", pht[phtIdx], bhsr[bhsrIdx]);
+            return (taken == pred);
+        }
+};
+
+/* TAGE predictor (Seznec and Michaud, JILP 2006): a bimodal base predictor
+ * plus tagged tables indexed with geometrically increasing global history
+ * lengths. The longest-history hit provides the prediction. On a mispredict,
+ * an entry is allocated in a longer-history table. All sizes are set at
+ * construction, so they can come from the config.
+ */
+class TAGEBranchPredictor : public BranchPredictor {
+    private:
+        struct TaggedEntry {
+            int8_t ctr;  // 3-bit signed counter, predicts taken if >= 0
+            uint8_t u;  // 2-bit useful counter
+            uint16_t tag;
+        };
+
+        // Global history folded (XOR'd) into compLen bits, updated incrementally
+        struct FoldedHistory {
+            uint32_t comp;
+            uint32_t compLen;
+            uint32_t origLen;
+            uint32_t outPoint;
+
+            void init(uint32_t _origLen, uint32_t _compLen) {
+                comp = 0;
+                origLen = _origLen;
+                compLen = _compLen;
+                outPoint = origLen % compLen;
+            }
+
+            inline void update(const uint8_t* hist, uint32_t pos, uint32_t histMask) {
+                comp = (comp << 1) ^ hist[pos & histMask];
+                comp ^= hist[(pos + origLen) & histMask] << outPoint;
+                comp ^= comp >> compLen;
+                comp &= (1 << compLen) - 1;
+            }
+        };
+
+        const uint32_t numTables;
+        const uint32_t tableBits;
+        const uint32_t baseBits;
+        const uint32_t tagBits;
+
+        uint8_t* base;  // 2-bit bimodal counters
+        TaggedEntry* tables;  // numTables x 2^tableBits, shortest history first
+        uint32_t* histLengths;
+        FoldedHistory* idxHist;
+        FoldedHistory* tagHist[2];
+
+        uint8_t* ghist;  // circular, newest bit at ghistPos
+        uint32_t ghistMask;
+        uint32_t ghistPos;
+        uint32_t pathHist;
+
+        int32_t useAltOnNewAlloc;  // 4-bit signed, use the alternate prediction on newly allocated entries if >= 0
+        uint32_t randState;
+        uint64_t branchCount;
+        uint32_t uDecayPos;  // next tagged entry whose useful counter decays
+
+        // Per-prediction scratch space
+        uint32_t* idx;
+        uint16_t* tags;
+
+        VectorCounter profProvider;  // 0 is the base predictor, i is tagged table i-1
+        Counter profAllocs;
+
+    public:
+        TAGEBranchPredictor(uint32_t _numTables, uint32_t _tableBits, uint32_t _baseBits, uint32_t _tagBits, uint32_t minHist, uint32_t maxHist);
+
+        bool predict(Address branchPc, bool taken);
+
+        void initStats(AggregateStat* parentStat);
+
+    private:
+        inline TaggedEntry& entry(uint32_t table) {return tables[(table << tableBits) + idx[table]];}
+        void allocate(int32_t provider, bool taken);
+        void updateHistory(Address branchPc, bool taken);
+};
+
+/* Per-branch mispredict profile. Branches are tracked in a small
+ * direct-mapped table. A mispredicting branch steals a slot once it has
+ * conflicted with the current owner more times than the owner has
+ * mispredicted, so the table converges to the most-mispredicted branches.
+ */
+class BranchProfiler {
+    private:
+        struct Entry {
+            Address pc;
+            uint64_t execs;
+            uint64_t mispreds;
+            uint64_t conflicts;
+        };
+
+        Entry* entries;
+        uint32_t numEntries;
+
+    public:
+        BranchProfiler() : entries(nullptr), numEntries(0) {}
+
+        void init(uint32_t _numEntries) {
+            numEntries = _numEntries;
+            if (numEntries) entries = gm_calloc<Entry>(numEntries);
+        }
+
+        inline void record(Address pc, bool mispred) {
+            if (!numEntries) return;
+            Entry& e = entries[(pc ^ (pc >> 7)) % numEntries];
+            if (e.pc == pc) {
+                e.execs++;
+                if (mispred) e.mispreds++;
+            } else if (mispred && ++e.conflicts > e.mispreds) {
+                e.pc = pc;
+                e.execs = 1;
+                e.mispreds = 1;
+                e.conflicts = 0;
+            }
+        }
+
+        void initStats(AggregateStat* parentStat) {
+            if (!numEntries) return;
+            AggregateStat* profStat = new AggregateStat();
+            profStat->init("branchProfile", "Most-mispredicted branches");
+            auto pcs = [this](uint32_t i) { return entries[i].pc; };
+            auto execs = [this](uint32_t i) { return entries[i].execs; };
+            auto mispreds = [this](uint32_t i) { return entries[i].mispreds; };
+            auto pcsStat = makeLambdaVectorStat(pcs, numEntries);
+            pcsStat->init("pc", "Branch PCs (0 if unused)");
+            auto execsStat = makeLambdaVectorStat(execs, numEntries);
+            execsStat->init("execs", "Executions since the branch was tracked");
+            auto mispredsStat = makeLambdaVectorStat(mispreds, numEntries);
+            mispredsStat->init("mispreds", "Mispredictions since the branch was tracked");
+            profStat->append(pcsStat);
+            profStat->append(execsStat);
+            profStat->append(mispredsStat);
+            parentStat->append(profStat);
+        }
+};
+
+#endif  // BRANCH_PREDICTOR_H_
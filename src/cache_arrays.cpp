@@ -24,13 +24,47 @@
  */
 
 #include "cache_arrays.h"
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "hash.h"
 #include "repl_policies.h"
 
+/* Tag matching. Returns the index of tag in tags[0..n), or -1. Tags are 64-bit,
+ * so AVX2 compares 4 per instruction. Plain SSE2 (every x86-64 build, including
+ * -march=core2) has no 64-bit compare, so we compare 32-bit halves and AND them.
+ * The vector paths only differ from the scalar loop in speed.
+ */
+static inline int32_t matchTag(const Address* tags, uint32_t n, Address tag) {
+    uint32_t i = 0;
+#if defined(__AVX2__)
+    __m256i key = _mm256_set1_epi64x(tag);
+    for (; i + 4 <= n; i += 4) {
+        __m256i cmp = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)&tags[i]), key);
+        uint32_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+#elif defined(__SSE2__)
+    __m128i key = _mm_set1_epi64x(tag);
+    for (; i + 2 <= n; i += 2) {
+        __m128i cmp = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&tags[i]), key);
+        cmp = _mm_and_si128(cmp, _mm_shuffle_epi32(cmp, _MM_SHUFFLE(2, 3, 0, 1)));
+        uint32_t mask = _mm_movemask_pd(_mm_castsi128_pd(cmp));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < n; i++) {
+        if (tags[i] == tag) return i;
+    }
+    return -1;
+}
+
 /* Set-associative array implementation */
 
 SetAssocArray::SetAssocArray(uint32_t _numLines, uint32_t _assoc, ReplPolicy* _rp, HashFamily* _hf) : rp(_rp), hf(_hf), numLines(_numLines), assoc(_assoc)  {
-    array = gm_calloc<Address>(numLines);
+    //Sets are contiguous; align them so that vector loads rarely straddle lines
+    array = gm_memalign<Address>(CACHE_LINE_BYTES, numLines);
+    for (uint32_t i = 0; i < numLines; i++) array[i] = 0;
     numSets = numLines/assoc;
     setMask = numSets - 1;
     assert_msg(isPow2(numSets), "must have a power of 2 # sets, but you specified %d", numSets);
@@ -39,13 +73,11 @@ SetAssocArray::SetAssocArray(uint32_t _numLines, uint32_t _assoc, ReplPolicy* _r
 int32_t SetAssocArray::lookup(const Address lineAddr, const MemReq* req, bool updateReplacement) {
     uint32_t set = hf->hash(0, lineAddr) & setMask;
     uint32_t first = set*assoc;
-    for (uint32_t id = first; id < first + assoc; id++) {
-        if (array[id] ==  lineAddr) {
-            if (updateReplacement) rp->update(id, req);
-            return id;
-        }
-    }
-    return -1;
+    int32_t way = matchTag(&array[first], assoc, lineAddr);
+    if (way < 0) return -1;
+    uint32_t id = first + way;
+    if (updateReplacement) rp->update(id, req);
+    return id;
 }
 
 uint32_t SetAssocArray::preinsert(const Address lineAddr, const MemReq* req, Address* wbLineAddr) { //TODO: Give out valid bit of wb cand?
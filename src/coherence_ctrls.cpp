@@ -25,7 +25,9 @@
 
 #include "coherence_ctrls.h"
 #include "cache.h"
+#include "mesh_network.h"
 #include "network.h"
+#include "zsim.h"
 
 /* Do a simple XOR block hash on address to determine its bank. Hacky for now,
  * should probably have a class that deals with this with a real hash function
@@ -50,6 +52,39 @@ void MESIBottomCC::init(const g_vector<MemObject*>& _parents, Network* network,
         parents[p] = _parents[p];
         parentRTTs[p] = (network)? network->getRTT(name, parents[p]->getName()) : 0;
     }
+
+    mesh = dynamic_cast<MeshNetwork*>(network);
+    int32_t selfNode = mesh? mesh->getNode(name) : -1;
+    if (selfNode == -1) {
+        mesh = nullptr;
+    } else {
+        assert_msg(mesh->getTile(selfNode, 0) == mesh->getTile(selfNode, 1), "%s must sit on a single tile", name);
+        selfTile = mesh->getTile(selfNode, 0);
+        parentNodes.resize(parents.size());
+        for (uint32_t p = 0; p < parents.size(); p++) parentNodes[p] = mesh->getNode(parents[p]->getName());
+    }
+}
+
+uint32_t MESIBottomCC::accessParent(uint32_t parentId, MemReq& req, bool reqData, bool respData, uint32_t* netLat) {
+    uint64_t cycle = req.cycle;
+    if (!mesh || parentNodes[parentId] == -1) {
+        *netLat = parentRTTs[parentId];
+        return parents[parentId]->access(req) - cycle;
+    }
+
+    uint32_t reqBytes = reqData? zinfo->lineSize : mesh->getCtrlBytes();
+    uint32_t respBytes = respData? zinfo->lineSize : mesh->getCtrlBytes();
+    uint32_t dstTile = mesh->getTile(parentNodes[parentId], req.lineAddr);
+    uint32_t reqLat = mesh->getLatency(selfTile, dstTile, reqBytes);
+    uint32_t respLat = mesh->getLatency(dstTile, selfTile, respBytes);
+
+    req.cycle = cycle + reqLat;
+    uint64_t parentRespCycle = parents[parentId]->access(req);
+    req.cycle = cycle;
+
+    mesh->recordTraversals(zinfo->eventRecorders[req.srcId], selfTile, dstTile, reqBytes, respBytes, cycle, parentRespCycle + respLat);
+    *netLat = reqLat + respLat;
+    return parentRespCycle - cycle - reqLat;
 }
 
 
@@ -68,13 +103,17 @@ uint64_t MESIBottomCC::processEviction(Address wbLineAddr, uint32_t lineId, bool
         case E:
             {
                 MemReq req = {wbLineAddr, PUTS, selfId, state, cycle, &ccLock, *state, srcId, 0 /*no flags*/};
-                respCycle = parents[getParentId(wbLineAddr)]->access(req);
+                uint32_t netLat;
+                respCycle = cycle + accessParent(getParentId(wbLineAddr), req, false, false, &netLat);
+                if (mesh) respCycle += netLat;  // fixed-delay networks do not delay writebacks
             }
             break;
         case M:
             {
                 MemReq req = {wbLineAddr, PUTX, selfId, state, cycle, &ccLock, *state, srcId, 0 /*no flags*/};
-                respCycle = parents[getParentId(wbLineAddr)]->access(req);
+                uint32_t netLat;
+                respCycle = cycle + accessParent(getParentId(wbLineAddr), req, true, false, &netLat);
+                if (mesh) respCycle += netLat;
             }
             break;
 
@@ -105,8 +144,8 @@ uint64_t MESIBottomCC::processAccess(Address lineAddr, uint32_t lineId, AccessTy
             if (*state == I) {
                 uint32_t parentId = getParentId(lineAddr);
                 MemReq req = {lineAddr, GETS, selfId, state, cycle, &ccLock, *state, srcId, flags};
-                uint32_t nextLevelLat = parents[parentId]->access(req) - cycle;
-                uint32_t netLat = parentRTTs[parentId];
+                uint32_t netLat;
+                uint32_t nextLevelLat = accessParent(parentId, req, false, true, &netLat);
                 profGETNextLevelLat.inc(nextLevelLat);
                 profGETNetLat.inc(netLat);
                 respCycle += nextLevelLat + netLat;
@@ -123,8 +162,8 @@ uint64_t MESIBottomCC::processAccess(Address lineAddr, uint32_t lineId, AccessTy
                 else profGETXMissSM.inc();
                 uint32_t parentId = getParentId(lineAddr);
                 MemReq req = {lineAddr, GETX, selfId, state, cycle, &ccLock, *state, srcId, flags};
-                uint32_t nextLevelLat = parents[parentId]->access(req) - cycle;
-                uint32_t netLat = parentRTTs[parentId];
+                uint32_t netLat;
+                uint32_t nextLevelLat = accessParent(parentId, req, false, true, &netLat);
                 profGETNextLevelLat.inc(nextLevelLat);
                 profGETNetLat.inc(netLat);
                 respCycle += nextLevelLat + netLat;
@@ -225,7 +264,7 @@ uint64_t MESITopCC::sendInvalidates(Address lineAddr, uint32_t lineId, InvType t
         uint32_t sentInvs = 0;
         for (uint32_t c = 0; c < numChildren; c++) {
             if (e->sharers[c]) {
-                InvReq req = {lineAddr, type, reqWriteback, cycle, srcId};
+                InvReq req = {lineAddr, type, reqWriteback, cycle, srcId, false};
                 uint64_t respCycle = children[c]->invalidate(req);
                 respCycle += childrenRTTs[c];
                 maxCycle = MAX(respCycle, maxCycle);
@@ -74,6 +74,7 @@ class CC : public GlobAlloc {
  */
 
 class Cache;
+class MeshNetwork;
 class Network;
 
 /* NOTE: To avoid virtual function overheads, there is no BottomCC interface, since we only have a MESI controller for now */
@@ -83,6 +84,9 @@ class MESIBottomCC : public GlobAlloc {
         MESIState* array;
         g_vector<MemObject*> parents;
         g_vector<uint32_t> parentRTTs;
+        MeshNetwork* mesh;  // if set, requests to parents in parentNodes (-1 if not on it) use it
+        uint32_t selfTile;
+        g_vector<int32_t> parentNodes;
         uint32_t numLines;
         uint32_t selfId;
 
@@ -101,7 +105,7 @@ class MESIBottomCC : public GlobAlloc {
         PAD();
 
     public:
-        MESIBottomCC(uint32_t _numLines, uint32_t _selfId, bool _nonInclusiveHack) : numLines(_numLines), selfId(_selfId), nonInclusiveHack(_nonInclusiveHack) {
+        MESIBottomCC(uint32_t _numLines, uint32_t _selfId, bool _nonInclusiveHack) : mesh(nullptr), selfTile(0), numLines(_numLines), selfId(_selfId), nonInclusiveHack(_nonInclusiveHack) {
             array = gm_calloc<MESIState>(numLines);
             for (uint32_t i = 0; i < numLines; i++) {
                 array[i] = I;
@@ -171,6 +175,12 @@ class MESIBottomCC : public GlobAlloc {
 
     private:
         uint32_t getParentId(Address lineAddr);
+
+        /* Sends req to a parent, returns its latency there, and sets netLat to the round-trip network latency.
+         * Over a MeshNetwork, this is the zero-load latency of the request and response (each a control message
+         * or a line), and both traverse the mesh in the weave phase.
+         */
+        uint32_t accessParent(uint32_t parentId, MemReq& req, bool reqData, bool respData, uint32_t* netLat);
 };
 
 
@@ -395,6 +405,10 @@ class MESICC : public CC {
         }
 
         uint64_t processInv(const InvReq& req, int32_t lineId, uint64_t startCycle) {
+            if (req.imprecise && (lineId == -1 || !bcc->isValid(lineId))) { //imprecise invalidate of a line we don't have (maybe a stale I tag), just ack it
+                bcc->unlock();
+                return startCycle;
+            }
             uint64_t respCycle = tcc->processInval(req.lineAddr, lineId, req.type, req.writeback, startCycle, req.srcId); //send invalidates or downgrades to children
             bcc->processInval(req.lineAddr, lineId, req.type, req.writeback); //adjust our own state
 
@@ -485,6 +499,10 @@ class MESITerminalCC : public CC {
         }
 
         uint64_t processInv(const InvReq& req, int32_t lineId, uint64_t startCycle) {
+            if (req.imprecise && (lineId == -1 || !bcc->isValid(lineId))) { //imprecise invalidate of a line we don't have (maybe a stale I tag), just ack it
+                bcc->unlock();
+                return startCycle;
+            }
             bcc->processInval(req.lineAddr, lineId, req.type, req.writeback); //adjust our own state
             bcc->unlock();
             return startCycle; //no extra delay in terminal caches
@@ -41,6 +41,9 @@
 #define POST_MORTEM 0
 //#define POST_MORTEM 1
 
+//With work stealing, max events simulated on a domain before its thread picks a domain again
+#define STEAL_QUANTUM 64
+
 bool ContentionSim::CompareEvents::operator()(TimingEvent* lhs, TimingEvent* rhs) const {
     return lhs->cycle > rhs->cycle;
 }
@@ -58,9 +61,11 @@ void ContentionSim::SimThreadTrampoline(void* arg) {
     csim->simThreadLoop(thid);
 }
 
-ContentionSim::ContentionSim(uint32_t _numDomains, uint32_t _numSimThreads) {
+ContentionSim::ContentionSim(uint32_t _numDomains, uint32_t _numSimThreads, bool _stealing) {
     numDomains = _numDomains;
     numSimThreads = _numSimThreads;
+    stealing = _stealing;
+    domainsLeft = 0;
     threadsDone = 0;
     limit = 0;
     lastLimit = 0;
@@ -70,18 +75,21 @@ ContentionSim::ContentionSim(uint32_t _numDomains, uint32_t _numSimThreads) {
     simThreads = gm_calloc<SimThreadData>(numSimThreads);
 
     for (uint32_t i = 0; i < numDomains; i++) {
-        new (&domains[i].pq) PrioQueue<TimingEvent, PQ_BLOCKS>();
+        new (&domains[i].pq) TimingWheel<TimingEvent, PQ_BLOCKS>();
         domains[i].curCycle = 0;
         futex_init(&domains[i].pqLock);
+        spin_init(&domains[i].runLock);
     }
 
-    if ((numDomains % numSimThreads) != 0) panic("numDomains(%d) must be a multiple of numSimThreads(%d) for now", numDomains, numSimThreads);
+    //With work stealing, threads get uneven numbers of home domains just fine
+    if (!stealing && (numDomains % numSimThreads) != 0) panic("numDomains(%d) must be a multiple of numSimThreads(%d) for now", numDomains, numSimThreads);
 
     for (uint32_t i = 0; i < numSimThreads; i++) {
         futex_init(&simThreads[i].wakeLock);
         futex_lock(&simThreads[i].wakeLock); //starts locked, so first actual call to lock blocks
         simThreads[i].firstDomain = i*numDomains/numSimThreads;
         simThreads[i].supDomain = (i+1)*numDomains/numSimThreads;
+        simThreads[i].stalledCursor = simThreads[i].firstDomain;
     }
 
     futex_init(&waitLock);
@@ -140,6 +148,24 @@ void ContentionSim::initStats(AggregateStat* parentStat) {
         domStat->append(&domains[i].profTime);
         objStat->append(domStat);
     }
+    if (stealing) {
+        for (uint32_t i = 0; i < numSimThreads; i++) {
+            std::stringstream ss;
+            ss << "thread-" << i;
+            AggregateStat* thStat = new AggregateStat();
+            thStat->init(gm_strdup(ss.str().c_str()), "Contention simulation thread stats");
+            new (&simThreads[i].profBusy) ClockStat();
+            new (&simThreads[i].profIdle) ClockStat();
+            new (&simThreads[i].profSteals) Counter();
+            simThreads[i].profBusy.init("busy", "Time simulating domains");
+            simThreads[i].profIdle.init("idle", "Time looking for or waiting on domains to simulate");
+            simThreads[i].profSteals.init("steals", "Quanta simulated on other threads' domains");
+            thStat->append(&simThreads[i].profBusy);
+            thStat->append(&simThreads[i].profIdle);
+            thStat->append(&simThreads[i].profSteals);
+            objStat->append(thStat);
+        }
+    }
     parentStat->append(objStat);
 }
 
@@ -157,6 +183,11 @@ void ContentionSim::simulatePhase(uint64_t limit) {
         if (ocore) ocore->cSimStart();
     }
 
+    if (stealing) {
+        for (uint32_t i = 0; i < numDomains; i++) domains[i].finished = false;
+        domainsLeft = numDomains;
+    }
+
     inCSim = true;
     __sync_synchronize();
 
@@ -190,7 +221,6 @@ void ContentionSim::enqueue(TimingEvent* ev, uint64_t cycle) {
     assert_msg(cycle < lastLimit+10*zinfo->phaseLength+1000000, "Queued event too far into the future, cycle %ld lastLimit %ld", cycle, lastLimit);
 
     assert_msg(cycle >= domains[ev->domain].curCycle, "Queued event goes back in time, cycle %ld curCycle %ld", cycle, domains[ev->domain].curCycle);
-    ev->privCycle = cycle;
     assert(ev->numParents == 0);
     assert(ev->domain != -1);
     assert(ev->domain < (int32_t)numDomains);
@@ -209,7 +239,6 @@ void ContentionSim::enqueueSynced(TimingEvent* ev, uint64_t cycle) {
     assert_msg(cycle >= lastLimit, "Enqueued (synced) event before last limit! cycle %ld min %ld", cycle, lastLimit);
     //Hacky, but helpful to chase events scheduled too far ahead due to bugs (e.g., cycle -1). We should probably formalize this a bit more
     assert_msg(cycle < lastLimit+10*zinfo->phaseLength+10000, "Queued  (synced) event too far into the future, cycle %ld lastLimit %ld", cycle, lastLimit);
-    ev->privCycle = cycle;
     assert(ev->numParents == 0);
     domains[ev->domain].pq.enqueue(ev, cycle);
 
@@ -276,7 +305,8 @@ void ContentionSim::simThreadLoop(uint32_t thid) {
         }
 
         //info("%d --- phase start", domain);
-        simulatePhaseThread(thid);
+        if (stealing) simulatePhaseThreadStealing(thid);
+        else simulatePhaseThread(thid);
         //info("%d --- phase end", domain);
 
         uint32_t val = __sync_add_and_fetch(&threadsDone, 1);
@@ -295,7 +325,7 @@ void ContentionSim::simulatePhaseThread(uint32_t thid) {
     if (thDomains == 1) {
         DomainData& domain = domains[simThreads[thid].firstDomain];
         domain.profTime.start();
-        PrioQueue<TimingEvent, PQ_BLOCKS>& pq = domain.pq;
+        TimingWheel<TimingEvent, PQ_BLOCKS>& pq = domain.pq;
         while (pq.size() && pq.firstCycle() < limit) {
             uint64_t domCycle = domain.curCycle;
             uint64_t cycle;
@@ -363,7 +393,7 @@ void ContentionSim::simulatePhaseThread(uint32_t thid) {
             while (domPq.size()) {
                 DomainData* domain = domPq.top();
                 domPq.pop();
-                PrioQueue<TimingEvent, PQ_BLOCKS>& pq = domain->pq;
+                TimingWheel<TimingEvent, PQ_BLOCKS>& pq = domain->pq;
                 if (!pq.size() || pq.firstCycle() > limit) {
                     numFinished++;
                     domain->curCycle = limit;
@@ -384,7 +414,7 @@ void ContentionSim::simulatePhaseThread(uint32_t thid) {
             while (stalledQueue.size()) {
                 DomainData* domain = stalledQueue.back();
                 stalledQueue.pop_back();
-                PrioQueue<TimingEvent, PQ_BLOCKS>& pq = domain->pq;
+                TimingWheel<TimingEvent, PQ_BLOCKS>& pq = domain->pq;
                 if (!pq.size() || pq.firstCycle() > limit) {
                     numFinished++;
                     domain->curCycle = limit;
@@ -410,6 +440,93 @@ void ContentionSim::simulatePhaseThread(uint32_t thid) {
     __sync_synchronize();
 }
 
+/* Work-stealing weave phase. Domains are the units of work: events of a domain only enqueue events on the same
+ * domain, and crossing events poll their source domain's curCycle, so any thread can simulate any domain as long
+ * as only one does at a time (runLock). Threads repeatedly pick the least-advanced runnable domain, preferring their
+ * home domains on ties, and simulate it for a quantum. Domains stalled on a crossing (prio != 0) are only picked,
+ * round-robin, when no other domain is runnable, which gives their source domains a chance to catch up.
+ */
+void ContentionSim::simulatePhaseThreadStealing(uint32_t thid) {
+    SimThreadData& st = simThreads[thid];
+    st.profIdle.start();
+    while (domainsLeft) {
+        int32_t d = stealDomain(thid);
+        if (d == -1) {
+            _mm_pause();
+            continue;
+        }
+        st.profIdle.end();
+        st.profBusy.start();
+        if ((uint32_t)d < st.firstDomain || (uint32_t)d >= st.supDomain) st.profSteals.inc();
+        runDomainQuantum(domains[d]);
+        st.profBusy.end();
+        st.profIdle.start();
+    }
+    st.profIdle.end();
+    __sync_synchronize();
+}
+
+// Returns a locked, unfinished domain, or -1 if none is available
+int32_t ContentionSim::stealDomain(uint32_t thid) {
+    SimThreadData& st = simThreads[thid];
+
+    // NOTE: These reads of other threads' domains are racy; they only pick the candidate, which we then lock
+    int32_t best = -1;
+    uint64_t bestCycle = (uint64_t)-1;
+    for (uint32_t i = 0; i < numDomains; i++) {
+        DomainData& dom = domains[i];
+        if (dom.finished || dom.runLock || dom.prio) continue;
+        uint64_t c = dom.curCycle;
+        bool home = i >= st.firstDomain && i < st.supDomain;
+        if (c < bestCycle || (c == bestCycle && home)) {
+            best = i;
+            bestCycle = c;
+        }
+    }
+    if (best != -1 && spin_trylock(&domains[best].runLock) == 0) {
+        if (!domains[best].finished) return best;
+        spin_unlock(&domains[best].runLock);
+    }
+
+    // Nothing runnable, pick a stalled domain
+    for (uint32_t j = 0; j < numDomains; j++) {
+        uint32_t i = (st.stalledCursor + j) % numDomains;
+        DomainData& dom = domains[i];
+        if (dom.finished || dom.runLock || spin_trylock(&dom.runLock) != 0) continue;
+        if (dom.finished) {
+            spin_unlock(&dom.runLock);
+            continue;
+        }
+        st.stalledCursor = i + 1;
+        return i;
+    }
+    return -1;
+}
+
+// Simulates a domain (which must be locked) for up to STEAL_QUANTUM events, then unlocks it
+void ContentionSim::runDomainQuantum(DomainData& domain) {
+    domain.profTime.start();
+    TimingWheel<TimingEvent, PQ_BLOCKS>& pq = domain.pq;
+    for (uint32_t n = 0; n < STEAL_QUANTUM && pq.size() && pq.firstCycle() < limit; n++) {
+        uint64_t cycle;
+        TimingEvent* te = pq.dequeue(cycle);
+        assert(cycle >= domain.curCycle);
+        if (cycle != domain.curCycle) domain.curCycle = cycle;
+        te->run(cycle);
+        uint64_t newCycle = pq.size()? pq.firstCycle() : limit;
+        assert(newCycle >= cycle);
+        if (newCycle != domain.curCycle) domain.curCycle = newCycle;
+        if (domain.prio) break; //stalled on a crossing, let other domains catch up
+    }
+    if (!pq.size() || pq.firstCycle() >= limit) {
+        domain.curCycle = limit;
+        domain.finished = true;
+        __sync_fetch_and_sub(&domainsLeft, 1);
+    }
+    domain.profTime.end();
+    spin_unlock(&domain.runLock);
+}
+
 void ContentionSim::finish() {
     assert(!terminate);
     terminate = true;
@@ -35,9 +35,9 @@
 #include "galloc.h"
 #include "memory_hierarchy.h"
 #include "pad.h"
-#include "prio_queue.h"
 #include "profile_stats.h"
 #include "stats.h"
+#include "timing_wheel.h"
 
 //Set to 1 to produce stats of how many event crossings are generated and run. Useful for debugging, but adds overhead.
 #define PROFILE_CROSSINGS 0
@@ -63,7 +63,7 @@ class ContentionSim : public GlobAlloc {
         CrossingEventInfo* lastCrossing; //indexed by [srcId*doms*doms + srcDom*doms + dstDom]
 
         struct DomainData : public GlobAlloc {
-            PrioQueue<TimingEvent, PQ_BLOCKS> pq;
+            TimingWheel<TimingEvent, PQ_BLOCKS> pq;
 
             PAD();
 
@@ -74,6 +74,9 @@ class ContentionSim : public GlobAlloc {
             uint32_t prio;
             uint64_t queuePrio;
 
+            lock_t runLock; //with work stealing, held by the thread simulating the domain
+            volatile bool finished; //with work stealing, no events left before the limit
+
             PAD();
 
             ClockStat profTime;
@@ -95,6 +98,11 @@ class ContentionSim : public GlobAlloc {
             uint32_t supDomain; //supreme, ie first not included
 
             std::vector<std::pair<uint64_t, TimingEvent*> > logVec;
+
+            //Work stealing; [firstDomain, supDomain) are the home domains, preferred on ties
+            uint32_t stalledCursor;
+            ClockStat profBusy, profIdle;
+            Counter profSteals;
         };
 
         //RO
@@ -106,6 +114,7 @@ class ContentionSim : public GlobAlloc {
         uint32_t numDomains;
         uint32_t numSimThreads;
         bool skipContention;
+        bool stealing;
 
         PAD();
 
@@ -120,13 +129,15 @@ class ContentionSim : public GlobAlloc {
 
         volatile bool inCSim; //true when inside contention simulation
 
+        volatile uint32_t domainsLeft; //with work stealing, domains not finished in this phase
+
         PAD();
 
         //lock_t testLock;
         lock_t postMortemLock;
 
     public:
-        ContentionSim(uint32_t _numDomains, uint32_t _numSimThreads);
+        ContentionSim(uint32_t _numDomains, uint32_t _numSimThreads, bool _stealing);
 
         void initStats(AggregateStat* parentStat);
 
@@ -162,6 +173,9 @@ class ContentionSim : public GlobAlloc {
     private:
         void simThreadLoop(uint32_t thid);
         void simulatePhaseThread(uint32_t thid);
+        void simulatePhaseThreadStealing(uint32_t thid);
+        int32_t stealDomain(uint32_t thid);
+        void runDomainQuantum(DomainData& domain);
 
         static void SimThreadTrampoline(void* arg);
 };
@@ -77,6 +77,10 @@ class Core : public GlobAlloc {
         virtual uint64_t getPhaseCycles() const = 0; // used by RDTSC faking --- we need to know how far along we are in the phase, but not the total number of phases
         virtual uint64_t getCycles() const = 0;
 
+        // Blocking offloads (e.g., PIM ops) start at the core's current cycle and stall it until they finish
+        virtual uint64_t getCurCycle() const = 0;
+        virtual void stallUntil(uint64_t cycle) = 0;
+
         virtual void initStats(AggregateStat* parentStat) = 0;
         virtual void contextSwitch(int32_t gid) = 0; //gid == -1 means descheduled, otherwise this is the new gid
 
@@ -153,7 +153,7 @@ class SchedEvent : public TimingEvent, public GlobAlloc {
 DDRMemory::DDRMemory(uint32_t _lineSize, uint32_t _colSize, uint32_t _ranksPerChannel, uint32_t _banksPerRank,
         uint32_t _sysFreqMHz, const char* tech, const char* addrMapping, uint32_t _controllerSysLatency,
         uint32_t _queueDepth, uint32_t _rowHitLimit, bool _deferredWrites, bool _closedPage,
-        uint32_t _domain, g_string& _name)
+        uint32_t _bankGroups, const char* _refreshMode, uint32_t _domain, g_string& _name)
     : lineSize(_lineSize), ranksPerChannel(_ranksPerChannel), banksPerRank(_banksPerRank),
       controllerSysLatency(_controllerSysLatency), queueDepth(_queueDepth), rowHitLimit(_rowHitLimit),
       deferredWrites(_deferredWrites), closedPage(_closedPage), domain(_domain), name(_name)
@@ -177,7 +177,25 @@ DDRMemory::DDRMemory(uint32_t _lineSize, uint32_t _colSize, uint32_t _ranksPerCh
     info("%s: domain %d, %d ranks/ch %d banks/rank, tech %s, boundLat %d rd / %d wr",
             name.c_str(), domain, ranksPerChannel, banksPerRank, tech, minRdLatency, minWrLatency);
 
+    bankGroups = _bankGroups? _bankGroups : techBankGroups;
+    if (!isPow2(bankGroups) || !isPow2(banksPerRank) || banksPerRank < bankGroups) {
+        panic("%s: need power-of-2 banksPerRank (%d) >= bankGroups (%d)", name.c_str(), banksPerRank, bankGroups);
+    }
+
+    std::string refStr(_refreshMode);
+    if (refStr == "AllBank") refreshMode = REFRESH_ALLBANK;
+    else if (refStr == "PerBank") refreshMode = REFRESH_PERBANK;
+    else if (refStr == "SameBank") refreshMode = REFRESH_SAMEBANK;
+    else panic("%s: Invalid refresh mode %s (AllBank, PerBank or SameBank)", name.c_str(), _refreshMode);
+    if (refreshMode == REFRESH_SAMEBANK && bankGroups == 1) panic("%s: SameBank refresh needs bank groups", name.c_str());
+    refreshIdx = 0;
+
+    info("%s: %d bank groups, %s refresh every %d mem cycles", name.c_str(), bankGroups, _refreshMode, tREFI/refreshUnits());
+
     minRespCycle = tCL + tBL + 1; // We subtract tCL + tBL from this on some checks; this avoids overflows
+    lastCmdCycle = 0;
+    lastCmdWasWrite = false;
+    lastCmdRank = lastCmdGroup = 0;
 
     banks.resize(ranksPerChannel);
     for (uint32_t i = 0; i < ranksPerChannel; i++) banks[i].resize(banksPerRank);
@@ -185,6 +203,10 @@ DDRMemory::DDRMemory(uint32_t _lineSize, uint32_t _colSize, uint32_t _ranksPerCh
     rankActWindows.resize(ranksPerChannel);
     for (uint32_t i = 0; i < ranksPerChannel; i++) rankActWindows[i].init(4);  // we only model FAW; for TAW (other technologies) change this to 2
 
+    rankLastActCycles.resize(ranksPerChannel, 0);
+    bankGroupState.resize(ranksPerChannel);
+    for (uint32_t i = 0; i < ranksPerChannel; i++) bankGroupState[i].resize(bankGroups, BankGroup{0, 0});
+
     // We get line addresses, and for a 64-byte line, there are _colSize/(JEDEC_BUS_WIDTH/8) lines/page
     uint32_t colBits = ilog2(_colSize/(JEDEC_BUS_WIDTH/8)*64/lineSize);
     uint32_t bankBits = ilog2(banksPerRank);
@@ -218,7 +240,7 @@ DDRMemory::DDRMemory(uint32_t _lineSize, uint32_t _colSize, uint32_t _ranksPerCh
             ilog2(rankMask << rankShift), rankShift, ilog2(bankMask << bankShift), bankShift);
 
     // Weave phase events
-    new RefreshEvent(this, memToSysCycle(tREFI), domain);
+    new RefreshEvent(this, memToSysCycle(tREFI/refreshUnits()), domain);
 
     nextSchedCycle = -1ul;
     nextSchedEvent = nullptr;
@@ -235,6 +257,9 @@ void DDRMemory::initStats(AggregateStat* parentStat) {
     profReadHits.init("rdhits", "Read row hits"); memStats->append(&profReadHits);
     profWriteHits.init("wrhits", "Write row hits"); memStats->append(&profWriteHits);
     latencyHist.init("mlh", "latency histogram for memory requests", NUMBINS); memStats->append(&latencyHist);
+    profWakeups.init("wakeups", "Scheduler wakeups"); memStats->append(&profWakeups);
+    profIdleWakeups.init("idleWakeups", "Scheduler wakeups that found no command to issue"); memStats->append(&profIdleWakeups);
+    profSkippedWakeups.init("skippedWakeups", "Scheduler wakeups avoided by rescheduling to the next issuable cycle"); memStats->append(&profSkippedWakeups);
     parentStat->append(memStats);
 }
 
@@ -300,6 +325,8 @@ void DDRMemory::enqueue(DDRMemoryAccEvent* ev, uint64_t sysCycle) {
     // Create request
     Request ovfReq;
     bool overflow = rdQueue.full() || wrQueue.full();
+    bool wasEmpty = rdQueue.empty() && wrQueue.empty();
+    bool wasWriteQueue = useWriteQueue();
     bool useWrQueue = deferredWrites && ev->isWrite();
     Request* req = overflow? &ovfReq : useWrQueue? wrQueue.alloc() : rdQueue.alloc();
 
@@ -318,10 +345,13 @@ void DDRMemory::enqueue(DDRMemoryAccEvent* ev, uint64_t sysCycle) {
     } else {
         queue(req, memCycle);
 
-        // If needed, schedule an event to handle this new request
-        if (!req->prev /* first in bank */) {
+        // If needed, schedule an event to handle this new request. If it made
+        // trySchedule switch between read and write queues, the skipped-to
+        // cycle no longer holds, so wake up as soon as the bus frees up.
+        bool switchedQueue = !wasEmpty && wasWriteQueue != useWriteQueue();
+        if (!req->prev /* first in bank */ || switchedQueue) {
             uint64_t minSchedCycle = std::max(memCycle, minRespCycle - tCL - tBL);
-            if (nextSchedCycle > minSchedCycle) minSchedCycle = std::max(minSchedCycle, findMinCmdCycle(*req));
+            if (nextSchedCycle > minSchedCycle && !switchedQueue) minSchedCycle = std::max(minSchedCycle, findMinCmdCycle(*req));
             if (nextSchedCycle > minSchedCycle) {
                 if (nextSchedEvent) nextSchedEvent->annul();
                 if (eventFreelist) {
@@ -429,8 +459,11 @@ uint64_t DDRMemory::tick(uint64_t sysCycle) {
 
     uint64_t minSchedCycle = trySchedule(memCycle, sysCycle);
     assert(minSchedCycle >= memCycle);
+    profWakeups.inc();
     if (!rdQueue.full() && !wrQueue.full() && !overflowQueue.empty()) {
         Request& ovfReq = overflowQueue.front();
+        bool wasEmpty = rdQueue.empty() && wrQueue.empty();
+        bool wasWriteQueue = useWriteQueue();
         bool useWrQueue = deferredWrites && ovfReq.write;
         Request* req = useWrQueue? wrQueue.alloc() : rdQueue.alloc();
         *req = ovfReq;
@@ -438,10 +471,12 @@ uint64_t DDRMemory::tick(uint64_t sysCycle) {
 
         queue(req, memCycle);
 
-        // This request may be schedulable before trySchedule's minSchedCycle
-        if (!req->prev /*first in bank queue*/) {
+        // This request may be schedulable before trySchedule's minSchedCycle,
+        // or may have switched the queue trySchedule picks (see enqueue())
+        bool switchedQueue = !wasEmpty && wasWriteQueue != useWriteQueue();
+        if (!req->prev /*first in bank queue*/ || switchedQueue) {
             uint64_t minQueuedSchedCycle = std::max(memCycle, minRespCycle - tCL - tBL);
-            if (minSchedCycle > minQueuedSchedCycle) minSchedCycle = std::max(minQueuedSchedCycle, findMinCmdCycle(*req));
+            if (minSchedCycle > minQueuedSchedCycle && !switchedQueue) minSchedCycle = std::max(minQueuedSchedCycle, findMinCmdCycle(*req));
             if (minSchedCycle > minQueuedSchedCycle) {
                 DEBUG("Overflowed request lowered minSchedCycle %ld -> %ld (memCycle %ld)", minSchedCycle, minQueuedSchedCycle, memCycle);
                 minSchedCycle = minQueuedSchedCycle;
@@ -467,9 +502,23 @@ void DDRMemory::recycleEvent(SchedEvent* ev) {
     eventFreelist = ev;
 }
 
+uint64_t DDRMemory::findMinActCycle(const Request& r, uint64_t preCycle) const {
+    const BankGroup& group = bankGroupState[r.loc.rank][groupOf(r.loc.bank)];
+    uint64_t actCycle = std::max(r.arrivalCycle, preCycle + tRP);
+    actCycle = std::max(actCycle, std::max(rankLastActCycles[r.loc.rank] + tRRD, group.lastActCycle + tRRD_L));
+    actCycle = std::max(actCycle, rankActWindows[r.loc.rank].minActCycle() + tFAW);
+    return actCycle;
+}
+
+/* NOTE: Including tCCD_L here is what makes FR-FCFS bank-group aware: right
+ * after a column command, requests to other groups become ready tCCD_L-tCCD_S
+ * cycles before those to the same group, so trySchedule interleaves groups.
+ */
 uint64_t DDRMemory::findMinCmdCycle(const Request& r) const {
     const Bank& bank = banks[r.loc.rank][r.loc.bank];
+    const BankGroup& group = bankGroupState[r.loc.rank][groupOf(r.loc.bank)];
     uint64_t minCmdCycle = std::max(r.arrivalCycle, bank.lastCmdCycle + 1);
+    minCmdCycle = std::max(minCmdCycle, group.lastCmdCycle + tCCD_L);
     if (r.loc.row == bank.openRow && bank.open) {
         // Row buffer hit
     } else {
@@ -481,13 +530,33 @@ uint64_t DDRMemory::findMinCmdCycle(const Request& r) const {
             assert(r.loc.row != bank.openRow);
             preCycle = std::max(r.arrivalCycle, bank.minPreCycle);
         }
-        uint64_t actCycle = std::max(r.arrivalCycle, std::max(preCycle + tRP, bank.lastActCycle + tRRD));
-        actCycle = std::max(actCycle, rankActWindows[r.loc.rank].minActCycle() + tFAW);
-        minCmdCycle = actCycle + tRCD;
+        minCmdCycle = std::max(minCmdCycle, findMinActCycle(r, preCycle) + tRCD);
     }
     return minCmdCycle;
 }
 
+bool DDRMemory::useWriteQueue() const {
+    // Writes have priority if the write queue is getting full...
+    bool prioWrites = (wrQueue.size() > (3*queueDepth/4)) || (lastCmdWasWrite && wrQueue.size() > queueDepth/4);
+    return rdQueue.empty() || prioWrites;
+}
+
+/* Earliest cycle at which trySchedule may issue a command, given the current
+ * queue contents: the data bus must be free and some bank queue head must
+ * meet its bank, bank group, rank and refresh constraints. Waking up earlier
+ * is useless, so we reschedule straight to this cycle. Enqueues that could
+ * lower it reschedule on their own.
+ */
+uint64_t DDRMemory::findNextSchedCycle() const {
+    if (rdQueue.empty() && wrQueue.empty()) return -1ul;
+    const RequestQueue<Request>& queue = useWriteQueue()? wrQueue : rdQueue;
+    uint64_t minCmdCycle = -1ul;
+    for (RequestQueue<Request>::iterator ir = queue.begin(); ir != queue.end(); ir.inc()) {
+        if (!(*ir)->prev) minCmdCycle = std::min(minCmdCycle, findMinCmdCycle(**ir));
+    }
+    return std::max(minCmdCycle, minRespCycle - tCL);
+}
+
 uint64_t DDRMemory::trySchedule(uint64_t curCycle, uint64_t sysCycle) {
     /* Implement FR-FCFS scheduling to maximize bus utilization
      *
@@ -504,11 +573,12 @@ uint64_t DDRMemory::trySchedule(uint64_t curCycle, uint64_t sysCycle) {
      */
 
     if (rdQueue.empty() && wrQueue.empty()) return -1ul;
-    if (curCycle + tCL < minRespCycle) return minRespCycle - tCL;  // too far ahead
+    if (curCycle + tCL < minRespCycle) {  // too far ahead
+        profIdleWakeups.inc();
+        return findNextSchedCycle();
+    }
 
-    // Writes have priority if the write queue is getting full...
-    bool prioWrites = (wrQueue.size() > (3*queueDepth/4)) || (lastCmdWasWrite && wrQueue.size() > queueDepth/4);
-    bool isWriteQueue = rdQueue.empty() || prioWrites;
+    bool isWriteQueue = useWriteQueue();
 
     RequestQueue<Request>& queue = isWriteQueue? wrQueue : rdQueue;
     assert(!queue.empty());
@@ -539,17 +609,24 @@ uint64_t DDRMemory::trySchedule(uint64_t curCycle, uint64_t sysCycle) {
          * refreshes trigger these.
          */
         DEBUG("%ld : First req ready at %ld", curCycle, minSchedCycle);
+        profIdleWakeups.inc();
         return minSchedCycle;  // no requests are ready to issue yet
     }
 
     DEBUG("%ld : Found ready request 0x%lx %s %ld (%ld / %ld)", curCycle, r->addr, r->write? "W" : "R", r->arrivalCycle, rdQueue.size(), wrQueue.size());
 
     Bank& bank = banks[r->loc.rank][r->loc.bank];
+    uint32_t groupIdx = groupOf(r->loc.bank);
+    BankGroup& group = bankGroupState[r->loc.rank][groupIdx];
 
     // Compute the minimum cycle at which the read or write command can be issued,
     // without column access or data bus constraints
     uint64_t minCmdCycle = std::max(curCycle, minRespCycle - tCL);
-    if (lastCmdWasWrite && !r->write) minCmdCycle = std::max(minCmdCycle, minRespCycle + tWTR);
+    if (lastCmdWasWrite && !r->write) {
+        bool sameGroup = (lastCmdRank == r->loc.rank) && (lastCmdGroup == groupIdx);
+        minCmdCycle = std::max(minCmdCycle, minRespCycle + (sameGroup? tWTR_L : tWTR));
+    }
+    minCmdCycle = std::max(minCmdCycle, std::max(lastCmdCycle + tCCD_S, group.lastCmdCycle + tCCD_L));
     bool rowHit = false;
     if (r->loc.row == bank.openRow && bank.open) {
         // Row buffer hit
@@ -565,8 +642,7 @@ uint64_t DDRMemory::trySchedule(uint64_t curCycle, uint64_t sysCycle) {
             preCycle = std::max(r->arrivalCycle, bank.minPreCycle);
         }
 
-        uint64_t actCycle = std::max(r->arrivalCycle, std::max(preCycle + tRP, bank.lastActCycle + tRRD));
-        actCycle = std::max(actCycle, rankActWindows[r->loc.rank].minActCycle() + tFAW);
+        uint64_t actCycle = findMinActCycle(*r, preCycle);
 
         // Record ACT
         bank.open = true;
@@ -574,6 +650,8 @@ uint64_t DDRMemory::trySchedule(uint64_t curCycle, uint64_t sysCycle) {
         if (preIssued) bank.minPreCycle = preCycle + tRAS;
         rankActWindows[r->loc.rank].addActivation(actCycle);
         bank.lastActCycle = actCycle;
+        rankLastActCycles[r->loc.rank] = std::max(rankLastActCycles[r->loc.rank], actCycle);
+        group.lastActCycle = std::max(group.lastActCycle, actCycle);
 
         minCmdCycle = std::max(minCmdCycle, actCycle + tRCD);
     }
@@ -581,7 +659,11 @@ uint64_t DDRMemory::trySchedule(uint64_t curCycle, uint64_t sysCycle) {
     // Figure out data bus constraints, find actual time at which command is issued
     uint64_t cmdCycle = std::max(minCmdCycle, minRespCycle - tCL);
     minRespCycle = cmdCycle + tCL + tBL;
+    lastCmdCycle = cmdCycle;
     lastCmdWasWrite = r->write;
+    lastCmdRank = r->loc.rank;
+    lastCmdGroup = groupIdx;
+    group.lastCmdCycle = cmdCycle;
 
     // Record PRE
     // if closed-page, close (auto-precharge) if no more row buffer hits
@@ -628,29 +710,57 @@ uint64_t DDRMemory::trySchedule(uint64_t curCycle, uint64_t sysCycle) {
     queue.remove(ir);
     (isWriteQueue? bank.wrReqs : bank.rdReqs).pop_front();
 
-    return (rdQueue.empty() && wrQueue.empty())? -1ul : minRespCycle - tCL;
+    // Skip the wakeup at the next free bus cycle if no command could issue then
+    uint64_t nextCycle = findNextSchedCycle();
+    if (nextCycle != -1ul && nextCycle > minRespCycle - tCL) profSkippedWakeups.inc();
+    return nextCycle;
+}
+
+uint32_t DDRMemory::refreshUnits() const {
+    switch (refreshMode) {
+        case REFRESH_ALLBANK: return 1;
+        case REFRESH_PERBANK: return banksPerRank;
+        case REFRESH_SAMEBANK: return banksPerRank/bankGroups;
+        default: panic("!?");
+    }
+}
+
+bool DDRMemory::isRefreshed(uint32_t bank) const {
+    switch (refreshMode) {
+        case REFRESH_ALLBANK: return true;
+        case REFRESH_PERBANK: return bank == refreshIdx;
+        case REFRESH_SAMEBANK: return bank/bankGroups == refreshIdx;  // same bank in every group
+        default: panic("!?");
+    }
 }
 
+/* Each refresh event covers 1/refreshUnits() of the banks, so under PerBank
+ * and SameBank refresh the remaining banks keep serving requests.
+ */
 void DDRMemory::refresh(uint64_t sysCycle) {
     uint64_t memCycle = sysToMemCycle(sysCycle);
     uint64_t minRefreshCycle = memCycle;
     for (auto& rankBanks : banks) {
-        for (auto& bank : rankBanks) {
-            minRefreshCycle = std::max(minRefreshCycle, std::max(bank.minPreCycle, bank.lastCmdCycle));
+        for (uint32_t b = 0; b < banksPerRank; b++) {
+            if (!isRefreshed(b)) continue;
+            minRefreshCycle = std::max(minRefreshCycle, std::max(rankBanks[b].minPreCycle, rankBanks[b].lastCmdCycle));
         }
     }
     assert(minRefreshCycle >= memCycle);
 
-    uint64_t refreshDoneCycle = minRefreshCycle + tRFC;
-    assert(tRFC >= tRP);
+    uint32_t refCycles = (refreshMode == REFRESH_ALLBANK)? tRFC : tRFCpb;
+    uint64_t refreshDoneCycle = minRefreshCycle + refCycles;
+    assert(refCycles >= tRP);
     for (auto& rankBanks : banks) {
-        for (auto& bank : rankBanks) {
+        for (uint32_t b = 0; b < banksPerRank; b++) {
+            if (!isRefreshed(b)) continue;
             // Close and force the ACT to happen at least at tRFC
             // PRE <-tRP-> ACT, so discount tRP
-            bank.minPreCycle = refreshDoneCycle - tRP;
-            bank.open = false;
+            rankBanks[b].minPreCycle = refreshDoneCycle - tRP;
+            rankBanks[b].open = false;
         }
     }
+    refreshIdx = (refreshIdx + 1) % refreshUnits();
 
     DEBUG("Refresh %ld start %ld done %ld", memCycle, minRefreshCycle, refreshDoneCycle);
 }
@@ -662,10 +772,99 @@ void DDRMemory::initTech(const char* techName) {
     std::string tech(techName);
     double tCK;
 
-    // tBL's below are for 64-byte lines; we adjust as needed
+    // Bank-group and per-bank refresh timings default to their plain counterparts below
+    techBankGroups = 1;
+    tRRD_L = tCCD_S = tCCD_L = tWTR_L = tRFCpb = 0;
+
+    // tBL's and tCCD's below are for 64-byte lines; we adjust as needed
 
     // Please keep this orderly; go from faster to slower technologies
-    if (tech == "DDR3-1333-CL10") {
+    if (tech == "DDR5-4800-CL40") {
+        // JEDEC DDR5-4800B, 16Gb x8 (8 bank groups x 4 banks). This is one
+        // 32-bit sub-channel (see techSubChannels), so a 64B line is a BL16 burst
+        tCK = 0.416;
+        techBankGroups = 8;
+        tBL = 8;
+        tCL = 40;
+        tRCD = 39;
+        tRTP = 18;
+        tRP = 39;
+        tRRD = 8;
+        tRRD_L = 12;
+        tRAS = 77;
+        tFAW = 32;
+        tWTR = 6;
+        tWTR_L = 18;
+        tWR = 72;
+        tCCD_S = 8;
+        tCCD_L = 12;
+        tRFC = 708;    // tRFC1, 295ns
+        tRFCpb = 312;  // tRFCsb, 130ns
+        tREFI = 9375;  // 3.9us
+    } else if (tech == "DDR4-3200-CL22") {
+        // JEDEC DDR4-3200AA, 8Gb x8 (4 bank groups x 4 banks)
+        tCK = 0.625;
+        techBankGroups = 4;
+        tBL = 4;
+        tCL = 22;
+        tRCD = 22;
+        tRTP = 12;
+        tRP = 22;
+        tRRD = 4;
+        tRRD_L = 8;
+        tRAS = 52;
+        tFAW = 34;
+        tWTR = 4;
+        tWTR_L = 12;
+        tWR = 24;
+        tCCD_S = 4;
+        tCCD_L = 8;
+        tRFC = 560;
+        tREFI = 12480;
+    } else if (tech == "DDR4-2400-CL17") {
+        // JEDEC DDR4-2400R, 8Gb x8 (4 bank groups x 4 banks)
+        tCK = 0.833;
+        techBankGroups = 4;
+        tBL = 4;
+        tCL = 17;
+        tRCD = 17;
+        tRTP = 9;
+        tRP = 17;
+        tRRD = 4;
+        tRRD_L = 6;
+        tRAS = 39;
+        tFAW = 26;
+        tWTR = 3;
+        tWTR_L = 9;
+        tWR = 18;
+        tCCD_S = 4;
+        tCCD_L = 6;
+        tRFC = 420;
+        tREFI = 9360;
+    } else if (tech == "HBM2-2000") {
+        // HBM2 at 2Gbps/pin, 8Gb stack (4 bank groups x 4 banks), one 64-bit
+        // pseudo-channel (see techSubChannels). A 64B line is two BL4 bursts to
+        // the same bank, so tCCD's are twice the per-burst values
+        tCK = 1.0;
+        techBankGroups = 4;
+        tBL = 4;
+        tCL = 14;
+        tRCD = 14;
+        tRTP = 5;
+        tRP = 14;
+        tRRD = 4;
+        tRRD_L = 6;
+        tRAS = 33;
+        tFAW = 16;
+        tWTR = 3;
+        tWTR_L = 8;
+        tWR = 16;
+        tCCD_S = 4;
+        tCCD_L = 8;
+        tRFC = 350;
+        tRFCpb = 160;
+        tREFI = 3900;
+    } else if (tech == "DDR3-1333-CL10") {
         // from DRAMSim2/ini/DDR3_micron_16M_8B_x4_sg15.ini (Micron)
         tCK = 1.5;  // ns; all other in mem cycles
         tBL = 4;
@@ -719,16 +918,44 @@ void DDRMemory::initTech(const char* techName) {
     assert(tCK > 0.0);
     assert(tBL && tCL && tRCD && tRTP && tRP && tRRD && tRAS && tFAW && tWTR && tWR && tRFC && tREFI);
 
+    if (!tCCD_S) tCCD_S = tBL;
+    if (!tCCD_L) tCCD_L = tCCD_S;
+    if (!tRRD_L) tRRD_L = tRRD;
+    if (!tWTR_L) tWTR_L = tWTR;
+    if (!tRFCpb) tRFCpb = tRFC;
+
     if (isPow2(lineSize) && lineSize >= 64) {
         tBL = lineSize*tBL/64;
+        tCCD_S = lineSize*tCCD_S/64;
+        tCCD_L = lineSize*tCCD_L/64;
     } else if (lineSize == 32) {
         tBL = tBL/2;
+        tCCD_S = tCCD_S/2;
+        tCCD_L = tCCD_L/2;
     } else {
         // If we wanted shorter lines, we'd have to start really caring about contention in the command bus;
         // even 32 bytes is pushing it, 32B probably calls for coalescing buffers
         panic("Unsupported line size %d", lineSize);
     }
 
-    memFreqKHz = (uint64_t)(1e9/tCK/1e3);
+    /* Scheduling works on system cycles, so we need memFreq < sysFreq/2. For
+     * fast devices, do as real controllers do (e.g., DDR4/DDR5 Gear 2) and
+     * run at a fraction of the DRAM clock, rounding timings up.
+     */
+    uint32_t gear = 1;
+    while ((uint64_t)(1e9/(tCK*gear)/1e3) >= sysFreqKHz/2) gear *= 2;
+    if (gear > 1) {
+        uint32_t* params[] = {&tBL, &tCL, &tRCD, &tRTP, &tRP, &tRRD, &tRRD_L, &tCCD_S, &tCCD_L,
+            &tRAS, &tFAW, &tWTR, &tWTR_L, &tWR, &tRFC, &tRFCpb, &tREFI};
+        for (uint32_t* t : params) *t = (*t + gear - 1)/gear;
+        info("%s: controller runs at 1/%d of the %s clock", name.c_str(), gear, techName);
+    }
+
+    memFreqKHz = (uint64_t)(1e9/(tCK*gear)/1e3);
+}
+
+uint32_t DDRMemory::techSubChannels(const char* techName) {
+    std::string tech(techName);
+    return (tech.find("DDR5-") == 0 || tech.find("HBM2-") == 0)? 2 : 1;
 }
 
@@ -165,7 +165,7 @@ class DDRMemory : public MemObject {
 
             // Timing constraints
             uint64_t minPreCycle;   // if !open, time of last PRE; if open, min cycle PRE can be issued
-            uint64_t lastActCycle;  // cycle of last ACT command
+            uint64_t lastActCycle;  // cycle of last ACT command, used for tRAS
             uint64_t lastCmdCycle;  // RD/WR command, used for refreshes only
 
             uint64_t curRowHits;    // row hits on the currently opened row
@@ -174,6 +174,19 @@ class DDRMemory : public MemObject {
             InList<Request> wrReqs;
         };
 
+        // Banks in the same group share I/O gating, so back-to-back ACTs and
+        // column commands to one group pay the _L timings instead of the _S ones
+        struct BankGroup {
+            uint64_t lastActCycle;  // latest ACT to any bank in the group
+            uint64_t lastCmdCycle;  // latest RD/WR to any bank in the group
+        };
+
+        enum RefreshMode {
+            REFRESH_ALLBANK,   // REFab: every bank in every rank, blocks for tRFC
+            REFRESH_PERBANK,   // REFpb (HBM, LPDDR): one bank at a time, blocks it for tRFCpb
+            REFRESH_SAMEBANK,  // REFsb (DDR5): the same bank in every group, blocks them for tRFCpb
+        };
+
         // Global timing constraints
         /* We wake up at minSchedCycle, issue one or more requests, and
          * reschedule ourselves at the new minSchedCycle if any requests remain
@@ -183,10 +196,13 @@ class DDRMemory : public MemObject {
         // Minimum cycle at which the next response may arrive
         // Equivalent to first cycle that the data bus can be used
         uint64_t minRespCycle;
+        uint64_t lastCmdCycle;  // last RD/WR on this channel, for tCCD_S
         bool lastCmdWasWrite;
+        uint32_t lastCmdRank, lastCmdGroup;  // for tWTR_L
 
         static const uint32_t JEDEC_BUS_WIDTH = 64;
         const uint32_t lineSize, ranksPerChannel, banksPerRank;
+        uint32_t bankGroups;  // per rank; bank b is in group b % bankGroups
         const uint32_t controllerSysLatency;  // in sysCycles
         const uint32_t queueDepth;
         const uint32_t rowHitLimit; // row hits not prioritized in FR-FCFS beyond this point
@@ -201,13 +217,22 @@ class DDRMemory : public MemObject {
         uint32_t tRCD;   // ACT to CAS
         uint32_t tRTP;   // RD to PRE
         uint32_t tRP;    // PRE to ACT
-        uint32_t tRRD;   // ACT to ACT
+        uint32_t tRRD;   // ACT to ACT, different bank groups (tRRD_S)
+        uint32_t tRRD_L; // ACT to ACT, same bank group
+        uint32_t tCCD_S; // RD/WR to RD/WR, different bank groups
+        uint32_t tCCD_L; // RD/WR to RD/WR, same bank group
         uint32_t tRAS;   // ACT to PRE
         uint32_t tFAW;   // No more than 4 ACTs per rank in this window
-        uint32_t tWTR;   // end of WR burst to RD command
+        uint32_t tWTR;   // end of WR burst to RD command, different bank groups (tWTR_S)
+        uint32_t tWTR_L; // end of WR burst to RD command, same bank group
         uint32_t tWR;    // end of WR burst to PRE
         uint32_t tRFC;   // Refresh to ACT (refresh leaves rows closed)
-        uint32_t tREFI;  // Refresh interval
+        uint32_t tRFCpb; // Per-bank or same-bank refresh to ACT
+        uint32_t tREFI;  // Refresh interval (each bank is refreshed once per tREFI in every mode)
+        uint32_t techBankGroups;  // bank groups of the device, used unless overridden
+
+        RefreshMode refreshMode;
+        uint32_t refreshIdx;  // bank (per-bank) or bank-within-group (same-bank) refreshed next
 
         // Address mapping information
         uint32_t colShift, colMask;
@@ -224,6 +249,8 @@ class DDRMemory : public MemObject {
 
         g_vector< g_vector<Bank> > banks; // indexed by rank, bank
         g_vector<ActWindow> rankActWindows;
+        g_vector<uint64_t> rankLastActCycles;
+        g_vector< g_vector<BankGroup> > bankGroupState;  // indexed by rank, group
 
         // Event scheduling
         SchedEvent* nextSchedEvent;
@@ -238,6 +265,7 @@ class DDRMemory : public MemObject {
         Counter profTotalRdLat, profTotalWrLat;
         Counter profReadHits, profWriteHits;  // row buffer hits
         VectorCounter latencyHist;
+        Counter profWakeups, profIdleWakeups, profSkippedWakeups;  // scheduler event efficiency
         static const uint32_t BINSIZE = 10, NUMBINS = 100;
         PAD();
 
@@ -261,7 +289,12 @@ class DDRMemory : public MemObject {
         DDRMemory(uint32_t _lineSize, uint32_t _colSize, uint32_t _ranksPerChannel, uint32_t _banksPerRank,
             uint32_t _sysFreqMHz, const char* tech, const char* addrMapping, uint32_t _controllerSysLatency,
             uint32_t _queueDepth, uint32_t _rowHitLimit, bool _deferredWrites, bool _closedPage,
-            uint32_t _domain, g_string& _name);
+            uint32_t _bankGroups, const char* _refreshMode, uint32_t _domain, g_string& _name);
+
+        // Independent channels per DIMM/stack channel: 2 for DDR5 (32-bit
+        // sub-channels) and HBM2 (pseudo-channels), 1 otherwise. Each one is
+        // simulated by its own DDRMemory.
+        static uint32_t techSubChannels(const char* tech);
 
         void initStats(AggregateStat* parentStat);
         const char* getName() {return name.c_str();}
@@ -283,7 +316,13 @@ class DDRMemory : public MemObject {
         void queue(Request* req, uint64_t memCycle);
 
         inline uint64_t trySchedule(uint64_t curCycle, uint64_t sysCycle);
+        bool useWriteQueue() const;
+        uint64_t findNextSchedCycle() const;
         uint64_t findMinCmdCycle(const Request& r) const;
+        uint64_t findMinActCycle(const Request& r, uint64_t preCycle) const;
+        inline uint32_t groupOf(uint32_t bank) const { return bank % bankGroups; }
+        bool isRefreshed(uint32_t bank) const;
+        uint32_t refreshUnits() const;
 
         void initTech(const char* tech);
 };
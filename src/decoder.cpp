@@ -34,6 +34,7 @@
 #include "core.h"
 #include "locks.h"
 #include "log.h"
+#include "zsim.h"
 
 extern "C" {
 #include "xed-interface.h"
@@ -53,6 +54,31 @@ extern "C" {
 
 #define PORTS_015 (PORT_0 | PORT_1 | PORT_5)
 
+/* Vector execution models, one per OOO core preset (see ooo_core.h). Vector
+ * ops are classified by iclass name; each class has a latency and port mask.
+ * Ops wider than the datapath are split into several exec uops (e.g., 256-bit
+ * ops on Nehalem, 512-bit ops on Skylake and Zen 2). The port masks use the
+ * 6-port layout above, so vector pipes are mapped onto ports 0, 1 and 5.
+ */
+enum VecOpClass {VEC_ALU, VEC_SHUFFLE, VEC_FP_ADD, VEC_FP_MUL, VEC_FMA, VEC_INT_MUL, VEC_CONVERT, VEC_DIV, VEC_EXEC_CLASSES,
+                 VEC_MOVE = VEC_EXEC_CLASSES, VEC_MASK_MOVE};
+
+struct VectorUarch {
+    const char* preset;
+    uint32_t datapathBytes;
+    uint16_t lat[VEC_EXEC_CLASSES];
+    uint8_t ports[VEC_EXEC_CLASSES];
+    uint8_t divExtraSlots;  // dividers are not fully pipelined
+};
+
+static const VectorUarch vectorUarchs[] = {
+    // Per class: ALU, SHUFFLE, FP_ADD, FP_MUL, FMA, INT_MUL, CONVERT, DIV
+    {"nehalem", 16, {1, 1, 3, 5, 8, 5, 4, 14}, {PORTS_015, PORT_5, PORT_1, PORT_0, PORT_0, PORT_0, PORT_1, PORT_0}, 13},  // no FMA, modeled as mul+add
+    {"skylake", 32, {1, 1, 4, 4, 4, 5, 4, 11}, {PORTS_015, PORT_5, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0}, 4},
+    {"zen",     32, {1, 1, 3, 3, 5, 4, 4, 10}, {PORTS_015, PORT_1 | PORT_5, PORT_1 | PORT_5, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0, PORT_1 | PORT_5, PORT_5}, 3},
+    {"wide",    64, {1, 1, 3, 4, 4, 5, 4, 11}, {PORTS_015, PORT_5, PORT_1 | PORT_5, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0 | PORT_1, PORT_0}, 4},
+};
+
 void DynUop::clear() {
     memset(this, 0, sizeof(DynUop));  // NOTE: This may break if DynUop becomes non-POD
 }
@@ -499,6 +525,170 @@ void Decoder::dropStackRegister(Instr& instr) {
 }
 
 
+uint32_t Decoder::findVectorUarch(const char* preset) {
+    for (uint32_t i = 0; i < sizeof(vectorUarchs)/sizeof(VectorUarch); i++) {
+        if (strcmp(vectorUarchs[i].preset, preset) == 0) return i;
+    }
+    panic("No vector execution model for OOO core preset %s", preset);
+}
+
+static inline bool startsWith(const char* str, const char* prefix) {
+    return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+static VecOpClass classifyVectorOp(const char* iclass) {
+    static const char* fpAddPrefixes[] = {"VADD", "VSUB", "VHADD", "VHSUB", "VMIN", "VMAX", "VCMP", "VROUND", "VRNDSCALE",
+        "VSCALEF", "VGETEXP", "VGETMANT", "VRANGE", "VREDUCE", nullptr};
+    static const char* shufflePrefixes[] = {"VPERM", "VSHUF", "VPSHUF", "VUNPCK", "VPUNPCK", "VINSERT", "VEXTRACT", "VPALIGNR",
+        "VALIGN", "VBROADCAST", "VPBROADCAST", "VPACK", "VEXPAND", "VPEXPAND", "VCOMPRESS", "VPCOMPRESS", "VPSLLDQ", "VPSRLDQ",
+        "VPINSR", "VPEXTR", "VPMOV", nullptr};
+
+    if (strstr(iclass, "FMADD") || strstr(iclass, "FMSUB") || strstr(iclass, "FNMADD") || strstr(iclass, "FNMSUB")) return VEC_FMA;
+    if (startsWith(iclass, "VMASKMOV") || startsWith(iclass, "VPMASKMOV")) return VEC_MASK_MOVE;
+    if (strstr(iclass, "MOVMSK")) return VEC_CONVERT;  // crosses to the integer domain
+    if (startsWith(iclass, "VMOV") || startsWith(iclass, "VLDDQU")) return VEC_MOVE;
+    if (startsWith(iclass, "VDIV") || startsWith(iclass, "VSQRT")) return VEC_DIV;
+    if (startsWith(iclass, "VCVT")) return VEC_CONVERT;
+    if (startsWith(iclass, "VPMUL") || startsWith(iclass, "VPMADD")) return VEC_INT_MUL;
+    if (startsWith(iclass, "VMUL") || startsWith(iclass, "VRCP") || startsWith(iclass, "VRSQRT") || startsWith(iclass, "VDP")) return VEC_FP_MUL;
+    for (const char** p = fpAddPrefixes; *p; p++) if (startsWith(iclass, *p)) return VEC_FP_ADD;
+    for (const char** p = shufflePrefixes; *p; p++) if (startsWith(iclass, *p)) return VEC_SHUFFLE;
+    return VEC_ALU;  // logic, integer add/sub/compare/shift, blends, ternlog
+}
+
+//Widest operand, in bytes
+static uint32_t vectorBytes(INS ins) {
+    uint32_t bits = 0;
+    for (uint32_t op = 0; op < INS_OperandCount(ins); op++) bits = std::max(bits, (uint32_t)INS_OperandWidth(ins, op));
+    return bits/8;
+}
+
+static inline bool isOpmaskReg(uint32_t reg) {
+    std::string name = REG_StringShort((REG)reg);
+    return name.size() == 2 && name[0] == 'k' && name[1] >= '0' && name[1] <= '7';
+}
+
+void Decoder::emitVectorOp(Instr& instr, DynUopVec& uops, uint32_t opcode) {
+    const VectorUarch& va = vectorUarchs[zinfo->vectorUarch];
+    VecOpClass cls = classifyVectorOp(xed_iclass_enum_t2str((xed_iclass_enum_t)opcode));
+
+    //AVX-512 opmasks are seldom on the critical path; move them after the data sources, so they are the ones dropped if there are too many
+    for (uint32_t i = 0; i < instr.numInRegs; i++) {
+        if (isOpmaskReg(instr.inRegs[i]) && i + 1 < instr.numInRegs && !isOpmaskReg(instr.inRegs[i+1])) {
+            std::swap(instr.inRegs[i], instr.inRegs[i+1]);
+        }
+    }
+
+    if (cls == VEC_MOVE) {
+        //Full-width loads and stores are a single access; masked and merging moves need an extra blend
+        if (instr.numLoads + instr.numInRegs <= 1 && instr.numStores + instr.numOutRegs == 1) {
+            emitBasicMove(instr, uops, va.lat[VEC_ALU], va.ports[VEC_ALU]);
+            return;
+        }
+        cls = VEC_MASK_MOVE;
+    }
+
+    if (cls == VEC_MASK_MOVE) {
+        emitBasicOp(instr, uops, va.lat[VEC_ALU], va.ports[VEC_ALU], 0, false);
+        return;
+    }
+
+    uint32_t parts = std::max(1u, (vectorBytes(instr.ins) + va.datapathBytes - 1)/va.datapathBytes);
+    uint8_t extraSlots = (cls == VEC_DIV)? va.divExtraSlots : 0;
+
+    emitLoads(instr, uops);
+
+    uint32_t srcs = instr.numLoads + instr.numInRegs;
+    uint32_t dsts = instr.numStores + instr.numOutRegs;
+
+    uint32_t srcRegs[srcs + 2];
+    uint32_t dstRegs[dsts + 2];
+    populateRegArrays(instr, srcRegs, dstRegs);
+
+    //NOTE: FMAs have 3 sources; with the load or accumulator first, we drop the least likely critical one
+    for (uint32_t i = 0; i < parts; i++) {
+        emitExecUop(srcRegs[0], srcRegs[1], dstRegs[0], dstRegs[1], uops, va.lat[cls], va.ports[cls], extraSlots);
+    }
+
+    emitStores(instr, uops);
+}
+
+bool Decoder::getGatherInfo(INS ins, GatherInfo& info) {
+    xed_category_enum_t category = (xed_category_enum_t) INS_Category(ins);
+    if (category != XC(AVX2GATHER) && category != XC(GATHER)) return false;
+
+    //e.g., VGATHERDPS, VGATHERQPD, VPGATHERDD, VPGATHERQQ; prefetch gathers (VGATHERPF*) have no destination
+    const char* iclass = xed_iclass_enum_t2str((xed_iclass_enum_t) INS_Opcode(ins));
+    const char* suffix = strstr(iclass, "GATHER");
+    if (!suffix || strstr(iclass, "GATHERPF")) return false;
+    suffix += strlen("GATHER");
+    info.indexBytes = (suffix[0] == 'Q')? 8 : 4;
+    info.dataBytes = (strcmp(suffix + 1, "PD") == 0 || strcmp(suffix + 1, "Q") == 0)? 8 : 4;
+
+    //Operands are destination, memory, and mask (AVX2) or destination, opmask and memory (AVX-512)
+    bool hasMemOp = false;
+    REG dstReg = REG_INVALID();
+    REG maskReg = REG_INVALID();
+    for (uint32_t op = 0; op < INS_OperandCount(ins); op++) {
+        if (INS_OperandIsMemory(ins, op)) {
+            info.memOp = op;
+            hasMemOp = true;
+        } else if (INS_OperandIsReg(ins, op) && INS_OperandReg(ins, op)) {
+            if (dstReg == REG_INVALID()) dstReg = INS_OperandReg(ins, op);
+            else if (maskReg == REG_INVALID()) maskReg = INS_OperandReg(ins, op);
+        }
+    }
+    if (!hasMemOp || dstReg == REG_INVALID()) return false;
+
+    REG indexReg = INS_OperandMemoryIndexReg(ins, info.memOp);
+    info.elems = std::min(REG_Size(dstReg)/info.dataBytes, REG_Size(indexReg)/info.indexBytes);
+    assert(info.elems && info.elems <= MAX_GATHER_ELEMS);
+    info.maskReg = (category == XC(AVX2GATHER))? maskReg : REG_INVALID();
+    return true;
+}
+
+void Decoder::emitGather(Instr& instr, DynUopVec& uops, const GatherInfo& info) {
+    const VectorUarch& va = vectorUarchs[zinfo->vectorUarch];
+    uint32_t baseReg = INS_OperandMemoryBaseReg(instr.ins, info.memOp);
+    uint32_t indexReg = INS_OperandMemoryIndexReg(instr.ins, info.memOp);
+    uint32_t maskReg = (info.maskReg == REG_INVALID())? 0 : REG_FullRegName(info.maskReg);
+    uint32_t dstReg = instr.numOutRegs? instr.outRegs[0] : 0;
+
+    //Index extraction and mask setup
+    uint32_t nextTemp = REG_EXEC_TEMP;
+    uint32_t idxTemp = nextTemp++;
+    emitExecUop(indexReg, maskReg, idxTemp, 0, uops, va.lat[VEC_SHUFFLE], va.ports[VEC_SHUFFLE]);
+
+    //One load per element, matching the per-element addresses recorded by the instrumentation
+    uint32_t elemRegs[MAX_GATHER_ELEMS];
+    for (uint32_t i = 0; i < info.elems; i++) {
+        elemRegs[i] = nextTemp++;
+        DynUop uop;
+        uop.clear();
+        uop.rs[0] = baseReg;
+        uop.rs[1] = idxTemp;
+        uop.rd[0] = elemRegs[i];
+        uop.type = UOP_LOAD;
+        uop.portMask = PORT_2;
+        uops.push_back(uop);
+    }
+
+    //Insert the elements with a tree of 2-input uops, so the destination waits for every load
+    uint32_t live = info.elems;
+    while (live > 1) {
+        uint32_t next = 0;
+        for (uint32_t i = 0; i + 1 < live; i += 2) {
+            uint32_t mergeReg = nextTemp++;
+            emitExecUop(elemRegs[i], elemRegs[i+1], mergeReg, 0, uops, 0, va.ports[VEC_ALU]);
+            elemRegs[next++] = mergeReg;
+        }
+        if (live & 1) elemRegs[next++] = elemRegs[live-1];
+        live = next;
+    }
+    assert(nextTemp < MAX_REGISTERS);
+    emitExecUop(elemRegs[0], dstReg, dstReg, maskReg, uops, va.lat[VEC_SHUFFLE], va.ports[VEC_SHUFFLE]);  //also clears the AVX2 mask
+}
+
 bool Decoder::decodeInstr(INS ins, DynUopVec& uops) {
     uint32_t initialUops = uops.size();
     bool inaccurate = false;
@@ -573,7 +763,11 @@ bool Decoder::decodeInstr(INS ins, DynUopVec& uops) {
                     emitXchg(instr, uops);
                     break;
                 default:
-                    //TODO: MASKMOVQ, MASKMOVDQ, MOVBE (Atom only), MOVNTxx variants (nontemporal), MOV_CR and MOV_DR (privileged?), VMOVxxxx variants (AVX)
+                    if (xed_iclass_enum_t2str(opcode)[0] == 'V') {  //VMOVxxxx variants (AVX), including masked moves
+                        emitVectorOp(instr, uops, opcode);
+                        break;
+                    }
+                    //TODO: MASKMOVQ, MASKMOVDQ, MOVBE (Atom only), MOVNTxx variants (nontemporal), MOV_CR and MOV_DR (privileged?)
                     inaccurate = true;
                     emitBasicMove(instr, uops, 1, PORTS_015);
             }
@@ -968,17 +1162,37 @@ bool Decoder::decodeInstr(INS ins, DynUopVec& uops) {
                     emitBasicOp(instr, uops, 1, PORT_0 | PORT_5);
                     break;
 
-                default: // AVX converts
-                    inaccurate = true;
+                default:
+                    if (xed_iclass_enum_t2str(opcode)[0] == 'V') {  //AVX converts
+                        emitVectorOp(instr, uops, opcode);
+                    } else {
+                        inaccurate = true;
+                    }
             }
             break;
 
         case XC(AVX):
-            //TODO: Whatever, Nehalem has no AVX
+        case XC(AVX2):
+        case XC(AVX512):
+        case XC(VFMA):
+        case XC(BROADCAST): //part of AVX
+            emitVectorOp(instr, uops, opcode);
             break;
 
-        case XC(BROADCAST): //part of AVX
-            //TODO: Same as AVX
+        case XC(AVX2GATHER):
+        case XC(GATHER): //AVX-512
+            {
+                GatherInfo info;
+                if (getGatherInfo(ins, info)) {
+                    emitGather(instr, uops, info);
+                } else {
+                    inaccurate = true;
+                }
+            }
+            break;
+
+        case XC(KMASK): //AVX-512 opmask ops
+            emitBasicOp(instr, uops, 1, PORT_0);
             break;
 
         case XC(AES):
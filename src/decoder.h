@@ -87,7 +87,9 @@ struct BblInfo;  // defined in core.h
 #define MAX_INSTR_REG_WRITES 4
 #define MAX_INSTR_STORES 4
 
-#define MAX_UOPS_PER_INSTR 12  // technically, even full decoders produce 1-4 uops; we increase this for common microsequenced instructions (e.g. xchg).
+#define MAX_UOPS_PER_INSTR 40  // technically, even full decoders produce 1-4 uops; we increase this for common microsequenced instructions (e.g. xchg) and gathers (1 load/element).
+
+#define MAX_GATHER_ELEMS 16
 
 /* Temporary register offsets */
 #define REG_LOAD_TEMP (REG_LAST + 1)  // REG_LAST defined by PIN
@@ -99,7 +101,19 @@ struct BblInfo;  // defined in core.h
 
 typedef std::vector<DynUop> DynUopVec;
 
-//Nehalem-style decoder. Fully static for now
+/* Layout of a gather. Gathers are simulated as one load per element, both
+ * in the decoded uops and in the instrumentation, which reads the index
+ * and mask registers to compute the element addresses.
+ */
+struct GatherInfo {
+    uint32_t memOp;  // vector-SIB memory operand
+    uint32_t elems;
+    uint32_t indexBytes;  // 4 or 8
+    uint32_t dataBytes;  // 4 or 8
+    REG maskReg;  // AVX2 vector mask; REG_INVALID() for AVX-512 opmasks, which are not read (all elements are loaded)
+};
+
+//Nehalem-style decoder. Fully static for now, except for the vector execution model
 class Decoder {
     private:
         struct Instr {
@@ -128,6 +142,12 @@ class Decoder {
         //If oooDecoding is true, produces a DynBbl with DynUops that can be used in OOO cores
         static BblInfo* decodeBbl(BBL bbl, bool oooDecoding);
 
+        //Returns the index of the vector execution model of an OOO core preset (stored in zinfo->vectorUarch); panics if there is none
+        static uint32_t findVectorUarch(const char* preset);
+
+        //Returns false if ins is not a gather
+        static bool getGatherInfo(INS ins, GatherInfo& info);
+
 #ifdef BBL_PROFILING
         static void profileBbl(uint64_t bblIdx);
         static void dumpBblProfile();
@@ -178,6 +198,10 @@ class Decoder {
 
         static void emitCompareAndExchange(Instr&, DynUopVec&);
 
+        /* Vector (AVX, AVX2, FMA, AVX-512) ops, using the vector execution model of the preset */
+        static void emitVectorOp(Instr& instr, DynUopVec& uops, uint32_t opcode);
+        static void emitGather(Instr& instr, DynUopVec& uops, const GatherInfo& info);
+
         /* Other helper functions */
         static void reportUnhandledCase(Instr& instr, const char* desc);
         static void populateRegArrays(Instr& instr, uint32_t* srcRegs, uint32_t* dstRegs);
@@ -27,8 +27,8 @@
 #define EVENT_QUEUE_H_
 
 #include <stdint.h>
-#include "g_std/g_multimap.h"
 #include "galloc.h"
+#include "timing_wheel.h"
 #include "zsim.h"
 
 class Event : public GlobAlloc {
@@ -36,7 +36,10 @@ class Event : public GlobAlloc {
         uint64_t period;
 
     public:
-        explicit Event(uint64_t _period) : period(_period) {} //period == 0 events are one-shot
+        Event* next; //used by TimingWheel --- PRIVATE
+        uint64_t queueCycle; //used by TimingWheel --- PRIVATE
+
+        explicit Event(uint64_t _period) : period(_period), next(nullptr) {} //period == 0 events are one-shot
         uint64_t getPeriod() const {return period;}
         virtual void callback()=0;
 };
@@ -83,7 +86,7 @@ AdaptiveEvent<G, F>* makeAdaptiveEvent(G get, F fire, uint64_t start, uint64_t t
 
 class EventQueue : public GlobAlloc {
     private:
-        g_multimap<uint64_t, Event*> evMap;
+        TimingWheel<Event, 64> evQueue; //indexed by phase
         lock_t qLock;
 
     public:
@@ -92,19 +95,17 @@ class EventQueue : public GlobAlloc {
         void tick() {
             futex_lock(&qLock);
             uint64_t curPhase = zinfo->numPhases;
-            g_multimap<uint64_t, Event*>::iterator it = evMap.begin();
-            while (it != evMap.end() && it->first <= curPhase) {
-                if (unlikely(it->first != curPhase)) panic("First event should have ticked on phase %ld, this is %ld", it->first, curPhase);
-                //if (it->first != curPhase) warn("First event should have ticked on phase %ld, this is %ld", it->first, curPhase);
-                Event* ev = it->second;
-                evMap.erase(it);
+            while (evQueue.size() && evQueue.firstCycle() <= curPhase) {
+                uint64_t evPhase;
+                Event* ev = evQueue.dequeue(evPhase);
+                if (unlikely(evPhase != curPhase)) panic("First event should have ticked on phase %ld, this is %ld", evPhase, curPhase);
+                //if (evPhase != curPhase) warn("First event should have ticked on phase %ld, this is %ld", evPhase, curPhase);
                 ev->callback(); //NOTE: Callback cannot call insert(), will deadlock (could use recursive locks if needed)
                 if (ev->getPeriod()) {
-                    evMap.insert(std::pair<uint64_t, Event*>(curPhase + ev->getPeriod(), ev));
+                    evQueue.enqueue(ev, curPhase + ev->getPeriod());
                 } else {
                     delete ev;
                 }
-                it = evMap.begin();
             }
             futex_unlock(&qLock);
         }
@@ -114,7 +115,7 @@ class EventQueue : public GlobAlloc {
             uint64_t curPhase = zinfo->numPhases;
             uint64_t eventPhase = (startDelay == -1)? (curPhase + ev->getPeriod()) : (curPhase + startDelay);
             assert(eventPhase >= curPhase);
-            evMap.insert(std::pair<uint64_t, Event*>(eventPhase, ev));
+            evQueue.enqueue(ev, eventPhase);
             futex_unlock(&qLock);
         }
 };
@@ -29,16 +29,27 @@
 #include "bithacks.h"
 #include "cache.h"
 #include "galloc.h"
+#include "tlb.h"
 #include "zsim.h"
 
-/* Extends Cache with an L0 direct-mapped cache, optimized to hell for hits
+/* Extends Cache with an L0 set-associative cache, optimized to hell for hits
  *
  * L1 lookups are dominated by several kinds of overhead (grab the cache locks,
  * several virtual functions for the replacement policy, etc.). This
  * specialization of Cache solves these issues by having a filter array that
- * holds the most recently used line in each set. Accesses check the filter array,
- * and then go through the normal access path. Because there is one line per set,
- * it is fine to do this without grabbing a lock.
+ * holds the most recently used lines of each set (1 by default, up to the L1's
+ * ways), plus an optional fully-associative buffer of lines displaced from the
+ * filter array. Accesses check the filter, and then go through the normal access
+ * path. Filter hits never write anything but a replacement hint, so it is fine to
+ * do this without grabbing a lock.
+ *
+ * Every filtered line must be in the L1, so that invalidations clear it. An L1
+ * miss can only evict lines from its own set, so after each fill we drop the
+ * filtered lines of that set that the L1 no longer holds.
+ *
+ * With an MMU, filter misses are translated first (filter hits imply a recent
+ * translation, so we treat them as L1 TLB hits), and page walks go through
+ * this cache.
  */
 
 class FilterCache : public Cache {
@@ -47,33 +58,47 @@ class FilterCache : public Cache {
             volatile Address rdAddr;
             volatile Address wrAddr;
             volatile uint64_t availCycle;
+            volatile uint64_t lastCycle; //replacement hint, races with hits are benign
 
-            void clear() {wrAddr = 0; rdAddr = 0; availCycle = 0;}
+            void clear() {wrAddr = 0; rdAddr = 0; availCycle = 0; lastCycle = 0;}
+            void invalidate() {wrAddr = -1L; rdAddr = -1L; lastCycle = 0;}
         };
 
-        //Replicates the most accessed line of each set in the cache
+        //Replicates the most accessed lines of each set in the cache
         FilterEntry* filterArray;
+        FilterEntry* victimArray;
         Address setMask;
         uint32_t numSets;
+        uint32_t numWays;
+        uint32_t numVictims;
+        uint32_t victimPos; //round-robin replacement for the victim buffer
         uint32_t srcId; //should match the core
         uint32_t reqFlags;
+        Mmu* mmu;
 
         lock_t filterLock;
-        uint64_t fGETSHit, fGETXHit;
+        uint64_t fGETSHit, fGETXHit, fVictimHit, fMiss;
 
     public:
         FilterCache(uint32_t _numSets, uint32_t _numLines, CC* _cc, CacheArray* _array,
-                ReplPolicy* _rp, uint32_t _accLat, uint32_t _invLat, g_string& _name)
+                ReplPolicy* _rp, uint32_t _accLat, uint32_t _invLat, uint32_t _numWays, uint32_t _numVictims, g_string& _name)
             : Cache(_numLines, _cc, _array, _rp, _accLat, _invLat, _name)
         {
             numSets = _numSets;
+            numWays = _numWays;
+            numVictims = _numVictims;
+            assert(numWays > 0);
             setMask = numSets - 1;
-            filterArray = gm_memalign<FilterEntry>(CACHE_LINE_BYTES, numSets);
-            for (uint32_t i = 0; i < numSets; i++) filterArray[i].clear();
+            filterArray = gm_memalign<FilterEntry>(CACHE_LINE_BYTES, numSets*numWays);
+            for (uint32_t i = 0; i < numSets*numWays; i++) filterArray[i].clear();
+            victimArray = numVictims? gm_memalign<FilterEntry>(CACHE_LINE_BYTES, numVictims) : nullptr;
+            for (uint32_t i = 0; i < numVictims; i++) victimArray[i].clear();
+            victimPos = 0;
             futex_init(&filterLock);
-            fGETSHit = fGETXHit = 0;
+            fGETSHit = fGETXHit = fVictimHit = fMiss = 0;
             srcId = -1;
             reqFlags = 0;
+            mmu = nullptr;
         }
 
         void setSourceId(uint32_t id) {
@@ -84,6 +109,10 @@ class FilterCache : public Cache {
             reqFlags = flags;
         }
 
+        void setMmu(Mmu* _mmu) {
+            mmu = _mmu;
+        }
+
         void initStats(AggregateStat* parentStat) {
             AggregateStat* cacheStat = new AggregateStat();
             cacheStat->init(name.c_str(), "Filter cache stats");
@@ -92,69 +121,136 @@ class FilterCache : public Cache {
             fgetsStat->init("fhGETS", "Filtered GETS hits", &fGETSHit);
             ProxyStat* fgetxStat = new ProxyStat();
             fgetxStat->init("fhGETX", "Filtered GETX hits", &fGETXHit);
+            ProxyStat* fvictimStat = new ProxyStat();
+            fvictimStat->init("fhVictim", "Filtered hits in the victim buffer (included in fhGETS/fhGETX)", &fVictimHit);
+            ProxyStat* fmissStat = new ProxyStat();
+            fmissStat->init("fMiss", "Filter misses (accesses that took the locked L1 path)", &fMiss);
+            auto hitRate = [this]() {
+                uint64_t hits = fGETSHit + fGETXHit;
+                return (hits + fMiss)? hits*10000/(hits + fMiss) : 0;
+            };
+            auto fhRateStat = makeLambdaStat(hitRate);
+            fhRateStat->init("fhRate", "Filter hit rate, in 1/10000ths");
             cacheStat->append(fgetsStat);
             cacheStat->append(fgetxStat);
+            cacheStat->append(fvictimStat);
+            cacheStat->append(fmissStat);
+            cacheStat->append(fhRateStat);
 
             initCacheStats(cacheStat);
+            if (mmu) mmu->initStats(cacheStat);
             parentStat->append(cacheStat);
         }
 
         inline uint64_t load(Address vAddr, uint64_t curCycle) {
-            Address vLineAddr = vAddr >> lineBits;
-            uint32_t idx = vLineAddr & setMask;
-            uint64_t availCycle = filterArray[idx].availCycle; //read before, careful with ordering to avoid timing races
-            if (vLineAddr == filterArray[idx].rdAddr) {
-                fGETSHit++;
-                return MAX(curCycle, availCycle);
-            } else {
-                return replace(vLineAddr, idx, true, curCycle);
-            }
+            return filterAccess(vAddr, true, curCycle, 0, nullptr, nullptr);
         }
 
         inline uint64_t store(Address vAddr, uint64_t curCycle) {
-            Address vLineAddr = vAddr >> lineBits;
-            uint32_t idx = vLineAddr & setMask;
-            uint64_t availCycle = filterArray[idx].availCycle; //read before, careful with ordering to avoid timing races
-            if (vLineAddr == filterArray[idx].wrAddr) {
-                fGETXHit++;
-                //NOTE: Stores don't modify availCycle; we'll catch matches in the core
-                //filterArray[idx].availCycle = curCycle; //do optimistic store-load forwarding
-                return MAX(curCycle, availCycle);
-            } else {
-                return replace(vLineAddr, idx, false, curCycle);
-            }
+            return filterAccess(vAddr, false, curCycle, 0, nullptr, nullptr);
         }
 
-        uint64_t replace(Address vLineAddr, uint32_t idx, bool isLoad, uint64_t curCycle) {
-            Address pLineAddr = procMask | vLineAddr;
+        /* For cores that limit their outstanding misses: L1 misses are not issued before fbCycle (i.e., until the
+         * core has a free fill buffer). missCycle is set to the cycle the miss was issued, or 0 if the access did
+         * not miss in the L1, and readyCycle to the cycle the miss could have issued with a free fill buffer (i.e.,
+         * after address translation), so the core can tell fill-buffer stalls apart from page walks.
+         */
+        inline uint64_t load(Address vAddr, uint64_t curCycle, uint64_t fbCycle, uint64_t& missCycle, uint64_t& readyCycle) {
+            missCycle = 0;
+            return filterAccess(vAddr, true, curCycle, fbCycle, &missCycle, &readyCycle);
+        }
+
+        inline uint64_t store(Address vAddr, uint64_t curCycle, uint64_t fbCycle, uint64_t& missCycle, uint64_t& readyCycle) {
+            missCycle = 0;
+            return filterAccess(vAddr, false, curCycle, fbCycle, &missCycle, &readyCycle);
+        }
+
+        /* For devices (e.g., an accelerator's DMA engine) that use this cache as their port to the hierarchy.
+         * Takes a physical line address and skips the filter, which only caches core accesses.
+         */
+        uint64_t deviceAccess(Address pLineAddr, bool isLoad, uint64_t curCycle) {
             MESIState dummyState = MESIState::I;
             futex_lock(&filterLock);
             MemReq req = {pLineAddr, isLoad? GETS : GETX, 0, &dummyState, curCycle, &filterLock, dummyState, srcId, reqFlags};
+            uint64_t respCycle = access(req);
+            futex_unlock(&filterLock);
+            return respCycle;
+        }
+
+        uint64_t replace(Address vLineAddr, uint32_t idx, bool isLoad, uint64_t curCycle, uint64_t fbCycle, uint64_t* missCycle, uint64_t* readyCycle) {
+            Address pLineAddr = procMask | vLineAddr;
+            MESIState dummyState = MESIState::I;
+            futex_lock(&filterLock);
+            fMiss++;
+            uint64_t reqCycle = mmu? mmu->translate(vLineAddr, curCycle, this, srcId) : curCycle;
+            if (readyCycle) *readyCycle = reqCycle;
+            //Only L1 misses need a fill buffer (L1 hits respond at reqCycle, the L1 has no access latency)
+            if (fbCycle > reqCycle && array->lookup(pLineAddr, nullptr, false) == -1) reqCycle = fbCycle;
+            MemReq req = {pLineAddr, isLoad? GETS : GETX, 0, &dummyState, reqCycle, &filterLock, dummyState, srcId, reqFlags};
             uint64_t respCycle  = access(req);
+            if (mmu) mmu->finishAccess(srcId);
+            if (missCycle && respCycle > reqCycle) *missCycle = reqCycle;
 
             //Due to the way we do the locking, at this point the old address might be invalidated, but we have the new address guaranteed until we release the lock
 
+            //Reuse the entry that already holds the line (e.g., on a store to a read-only line), or take the LRU way
+            FilterEntry* set = &filterArray[idx*numWays];
+            FilterEntry* entry = find(set, numWays, vLineAddr);
+            if (!entry && numVictims) entry = find(victimArray, numVictims, vLineAddr);
+            if (!entry) {
+                entry = &set[0];
+                for (uint32_t w = 1; w < numWays; w++) {
+                    if (set[w].lastCycle < entry->lastCycle) entry = &set[w];
+                }
+                if (numVictims && isValid(entry->rdAddr)) {
+                    FilterEntry& victim = victimArray[victimPos];
+                    victimPos = (victimPos + 1) % numVictims;
+                    victim.rdAddr = -1L; //no hits on a half-written entry
+                    victim.wrAddr = entry->wrAddr;
+                    victim.availCycle = entry->availCycle;
+                    victim.lastCycle = entry->lastCycle;
+                    victim.rdAddr = entry->rdAddr;
+                }
+            }
+
             //Careful with this order
-            Address oldAddr = filterArray[idx].rdAddr;
-            filterArray[idx].wrAddr = isLoad? -1L : vLineAddr;
-            filterArray[idx].rdAddr = vLineAddr;
+            Address oldAddr = entry->rdAddr;
+            entry->wrAddr = isLoad? -1L : vLineAddr;
+            entry->rdAddr = vLineAddr;
+            entry->lastCycle = curCycle;
 
             //For LSU simulation purposes, loads bypass stores even to the same line if there is no conflict,
             //(e.g., st to x, ld from x+8) and we implement store-load forwarding at the core.
             //So if this is a load, it always sets availCycle; if it is a store hit, it doesn't
-            if (oldAddr != vLineAddr) filterArray[idx].availCycle = respCycle;
+            if (oldAddr != vLineAddr) entry->availCycle = respCycle;
+
+            //The L1 fill may have evicted other filtered lines of this set
+            if (numWays > 1 || numVictims) dropEvicted(idx, entry);
 
             futex_unlock(&filterLock);
             return respCycle;
         }
 
+        //Page-table read for the MMU, called from replace() with the filter lock held
+        uint64_t walkAccess(Address pLineAddr, uint64_t curCycle) {
+            MESIState dummyState = MESIState::I;
+            MemReq req = {pLineAddr, GETS, 0, &dummyState, curCycle, &filterLock, dummyState, srcId, reqFlags};
+            uint64_t respCycle = access(req);
+            dropEvicted(pLineAddr & setMask, nullptr);
+            return respCycle;
+        }
+
         uint64_t invalidate(const InvReq& req) {
             Cache::startInvalidate();  // grabs cache's downLock
             futex_lock(&filterLock);
             uint32_t idx = req.lineAddr & setMask; //works because of how virtual<->physical is done...
-            if ((filterArray[idx].rdAddr | procMask) == req.lineAddr) { //FIXME: If another process calls invalidate(), procMask will not match even though we may be doing a capacity-induced invalidation!
-                filterArray[idx].wrAddr = -1L;
-                filterArray[idx].rdAddr = -1L;
+            //FIXME: If another process calls invalidate(), procMask will not match even though we may be doing a capacity-induced invalidation!
+            for (uint32_t w = 0; w < numWays; w++) {
+                FilterEntry& e = filterArray[idx*numWays + w];
+                if ((e.rdAddr | procMask) == req.lineAddr) e.invalidate();
+            }
+            for (uint32_t v = 0; v < numVictims; v++) {
+                if ((victimArray[v].rdAddr | procMask) == req.lineAddr) victimArray[v].invalidate();
             }
             uint64_t respCycle = Cache::finishInvalidate(req); // releases cache's downLock
             futex_unlock(&filterLock);
@@ -163,9 +259,66 @@ class FilterCache : public Cache {
 
         void contextSwitch() {
             futex_lock(&filterLock);
-            for (uint32_t i = 0; i < numSets; i++) filterArray[i].clear();
+            for (uint32_t i = 0; i < numSets*numWays; i++) filterArray[i].clear();
+            for (uint32_t i = 0; i < numVictims; i++) victimArray[i].clear();
             futex_unlock(&filterLock);
         }
+
+    private:
+        inline uint64_t filterAccess(Address vAddr, bool isLoad, uint64_t curCycle, uint64_t fbCycle, uint64_t* missCycle, uint64_t* readyCycle) {
+            Address vLineAddr = vAddr >> lineBits;
+            uint32_t idx = vLineAddr & setMask;
+            uint64_t respCycle;
+            //NOTE: Stores don't modify availCycle; we'll catch matches in the core
+            if (probe(&filterArray[idx*numWays], numWays, vLineAddr, isLoad, curCycle, respCycle)) {
+                if (isLoad) fGETSHit++;
+                else fGETXHit++;
+                return respCycle;
+            } else if (numVictims && probe(victimArray, numVictims, vLineAddr, isLoad, curCycle, respCycle)) {
+                if (isLoad) fGETSHit++;
+                else fGETXHit++;
+                fVictimHit++;
+                return respCycle;
+            } else {
+                return replace(vLineAddr, idx, isLoad, curCycle, fbCycle, missCycle, readyCycle);
+            }
+        }
+
+        inline bool probe(FilterEntry* entries, uint32_t n, Address vLineAddr, bool isLoad, uint64_t curCycle, uint64_t& respCycle) {
+            for (uint32_t i = 0; i < n; i++) {
+                uint64_t availCycle = entries[i].availCycle; //read before, careful with ordering to avoid timing races
+                if (vLineAddr == (isLoad? entries[i].rdAddr : entries[i].wrAddr)) {
+                    if (n > 1) entries[i].lastCycle = curCycle;
+                    respCycle = MAX(curCycle, availCycle);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        FilterEntry* find(FilterEntry* entries, uint32_t n, Address vLineAddr) {
+            for (uint32_t i = 0; i < n; i++) {
+                if (entries[i].rdAddr == vLineAddr) return &entries[i];
+            }
+            return nullptr;
+        }
+
+        static inline bool isValid(Address vLineAddr) {
+            return vLineAddr != 0 && vLineAddr != (Address)-1L;
+        }
+
+        void dropEvicted(uint32_t idx, FilterEntry* keep) {
+            for (uint32_t w = 0; w < numWays; w++) {
+                if (&filterArray[idx*numWays + w] != keep) dropIfEvicted(filterArray[idx*numWays + w]);
+            }
+            for (uint32_t v = 0; v < numVictims; v++) {
+                if (&victimArray[v] != keep && (victimArray[v].rdAddr & setMask) == idx) dropIfEvicted(victimArray[v]);
+            }
+        }
+
+        void dropIfEvicted(FilterEntry& e) {
+            if (isValid(e.rdAddr) && array->lookup(procMask | e.rdAddr, nullptr, false) == -1) e.invalidate();
+        }
 };
 
 #endif  // FILTER_CACHE_H_
@@ -24,6 +24,7 @@
  */
 
 #include "galloc.h"
+#include <sched.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -50,10 +51,39 @@
  */
 #define GM_BASE_ADDR ((const void*)0x00ABBA000000)
 
+/* Size-class caches. Every simulator thread and process allocates from the same mspace, so small allocations
+ * (timing events, stats, etc.) are served from per-CPU caches of free blocks that are refilled from and returned
+ * to the mspace in batches. We index caches by the CPU the caller runs on (threads are mostly pinned, and Pin
+ * tools can't rely on thread-local storage), so caches are only contended when threads migrate or share a CPU.
+ * A block freed by another thread just goes to that thread's cache; caches over their high watermark return
+ * blocks to the mspace lazily, a batch at a time.
+ *
+ * Classes are 16-byte multiples up to GM_MAX_CACHED bytes. Frees find the class of a block from its usable size,
+ * so blocks that did not come from a cache (e.g., calloc'd arrays or aligned blocks) can be cached as well.
+ */
+#define GM_SLOTS 32
+#define GM_CLASS_BYTES 16
+#define GM_CLASSES 64
+#define GM_MAX_CACHED (GM_CLASSES*GM_CLASS_BYTES)
+#define GM_BATCH_BYTES 1024
+
+struct gm_free_block {
+    gm_free_block* next;
+};
+
+struct gm_slot {
+    lock_t lock;
+    gm_free_block* heads[GM_CLASSES];
+    uint32_t counts[GM_CLASSES];
+    gm_counters counters;
+} ATTR_LINE_ALIGNED;
+
 struct gm_segment {
     volatile void* base_regp; //common data structure, accessible with glob_ptr; threads poll on gm_isready to determine when everything has been initialized
     volatile void* secondary_regp; //secondary data structure, used to exchange information between harness and initializing process
     mspace mspace_ptr;
+    gm_slot* slots;
+    gm_counters uncachedCounters;  // protected by lock
 
     PAD();
     lock_t lock;
@@ -106,6 +136,12 @@ int gm_init(size_t segmentSize) {
     futex_init(&GM->lock);
     assert(GM->mspace_ptr);
 
+    GM->slots = static_cast<gm_slot*>(mspace_memalign(GM->mspace_ptr, CACHE_LINE_BYTES, GM_SLOTS*sizeof(gm_slot)));
+    assert(GM->slots);
+    memset(GM->slots, 0, GM_SLOTS*sizeof(gm_slot));
+    for (uint32_t i = 0; i < GM_SLOTS; i++) futex_init(&GM->slots[i].lock);
+    memset(&GM->uncachedCounters, 0, sizeof(gm_counters));
+
     return gm_shmid;
 }
 
@@ -121,12 +157,63 @@ void gm_attach(int shmid) {
 }
 
 
+static inline gm_slot* gm_get_slot() {
+    int cpu = sched_getcpu();
+    return &GM->slots[(cpu < 0)? 0 : cpu % GM_SLOTS];
+}
+
+static inline uint32_t gm_class_batch(uint32_t cls) {
+    uint32_t batch = GM_BATCH_BYTES/((cls + 1)*GM_CLASS_BYTES);
+    return (batch < 4)? 4 : ((batch > 32)? 32 : batch);
+}
+
+// Allocates a block of at least size bytes (size <= GM_MAX_CACHED) from the calling CPU's cache
+static void* gm_cached_malloc(size_t size) {
+    uint32_t cls = (size == 0)? 0 : (size - 1)/GM_CLASS_BYTES;
+    gm_slot* slot = gm_get_slot();
+    futex_lock(&slot->lock);
+    slot->counters.allocs++;
+    gm_free_block* b = slot->heads[cls];
+    if (!b) {
+        // Refill with a batch of blocks from the mspace
+        uint32_t batch = gm_class_batch(cls);
+        size_t bytes = (cls + 1)*GM_CLASS_BYTES;
+        futex_lock(&GM->lock);
+        for (uint32_t i = 0; i < batch; i++) {
+            gm_free_block* nb = static_cast<gm_free_block*>(mspace_malloc(GM->mspace_ptr, bytes));
+            if (!nb) break;
+            nb->next = b;
+            b = nb;
+            slot->counts[cls]++;
+        }
+        futex_unlock(&GM->lock);
+        slot->counters.refills++;
+        if (!b) {
+            futex_unlock(&slot->lock);
+            return nullptr;
+        }
+    } else {
+        slot->counters.cacheHits++;
+    }
+    slot->heads[cls] = b->next;
+    slot->counts[cls]--;
+    futex_unlock(&slot->lock);
+    return b;
+}
+
 void* gm_malloc(size_t size) {
     assert(GM);
     assert(GM->mspace_ptr);
-    futex_lock(&GM->lock);
-    void* ptr = mspace_malloc(GM->mspace_ptr, size);
-    futex_unlock(&GM->lock);
+    void* ptr;
+    if (size <= GM_MAX_CACHED) {
+        ptr = gm_cached_malloc(size);
+    } else {
+        futex_lock(&GM->lock);
+        ptr = mspace_malloc(GM->mspace_ptr, size);
+        GM->uncachedCounters.allocs++;
+        GM->uncachedCounters.uncached++;
+        futex_unlock(&GM->lock);
+    }
     if (!ptr) panic("gm_malloc(): Out of global heap memory, use a larger GM segment");
     return ptr;
 }
@@ -134,9 +221,19 @@ void* gm_malloc(size_t size) {
 void* __gm_calloc(size_t num, size_t size) {
     assert(GM);
     assert(GM->mspace_ptr);
-    futex_lock(&GM->lock);
-    void* ptr = mspace_calloc(GM->mspace_ptr, num, size);
-    futex_unlock(&GM->lock);
+    size_t bytes = num*size;
+    if (num && bytes/num != size) panic("gm_calloc(): Overflow, %ld x %ld bytes", num, size);
+    void* ptr;
+    if (bytes <= GM_MAX_CACHED) {
+        ptr = gm_cached_malloc(bytes);
+        if (ptr) memset(ptr, 0, bytes);
+    } else {
+        futex_lock(&GM->lock);
+        ptr = mspace_calloc(GM->mspace_ptr, num, size);
+        GM->uncachedCounters.allocs++;
+        GM->uncachedCounters.uncached++;
+        futex_unlock(&GM->lock);
+    }
     if (!ptr) panic("gm_calloc(): Out of global heap memory, use a larger GM segment");
     return ptr;
 }
@@ -144,8 +241,11 @@ void* __gm_calloc(size_t num, size_t size) {
 void* __gm_memalign(size_t blocksize, size_t bytes) {
     assert(GM);
     assert(GM->mspace_ptr);
+    if (blocksize <= GM_CLASS_BYTES) return gm_malloc(bytes);  // mspace blocks are 16-byte aligned
     futex_lock(&GM->lock);
     void* ptr = mspace_memalign(GM->mspace_ptr, blocksize, bytes);
+    GM->uncachedCounters.allocs++;
+    GM->uncachedCounters.uncached++;
     futex_unlock(&GM->lock);
     if (!ptr) panic("gm_memalign(): Out of global heap memory, use a larger GM segment");
     return ptr;
@@ -155,9 +255,37 @@ void* __gm_memalign(size_t blocksize, size_t bytes) {
 void gm_free(void* ptr) {
     assert(GM);
     assert(GM->mspace_ptr);
-    futex_lock(&GM->lock);
-    mspace_free(GM->mspace_ptr, ptr);
-    futex_unlock(&GM->lock);
+    if (!ptr) return;
+    size_t usable = mspace_usable_size(ptr);  // only reads the block's header, which we own
+    if (usable < GM_CLASS_BYTES || usable >= GM_MAX_CACHED + GM_CLASS_BYTES) {
+        futex_lock(&GM->lock);
+        mspace_free(GM->mspace_ptr, ptr);
+        GM->uncachedCounters.frees++;
+        futex_unlock(&GM->lock);
+        return;
+    }
+
+    uint32_t cls = usable/GM_CLASS_BYTES - 1;  // every block of the class has at least (cls+1)*16 bytes
+    gm_free_block* b = static_cast<gm_free_block*>(ptr);
+    gm_slot* slot = gm_get_slot();
+    futex_lock(&slot->lock);
+    slot->counters.frees++;
+    b->next = slot->heads[cls];
+    slot->heads[cls] = b;
+    uint32_t batch = gm_class_batch(cls);
+    if (++slot->counts[cls] >= 4*batch) {
+        // Over the high watermark, return a couple of batches to the mspace
+        futex_lock(&GM->lock);
+        for (uint32_t i = 0; i < 2*batch; i++) {
+            gm_free_block* fb = slot->heads[cls];
+            slot->heads[cls] = fb->next;
+            mspace_free(GM->mspace_ptr, fb);
+        }
+        futex_unlock(&GM->lock);
+        slot->counts[cls] -= 2*batch;
+        slot->counters.flushes++;
+    }
+    futex_unlock(&slot->lock);
 }
 
 
@@ -196,6 +324,25 @@ void* gm_get_secondary_ptr() {
 void gm_stats() {
     assert(GM);
     mspace_malloc_stats(GM->mspace_ptr);
+    gm_counters c;
+    gm_get_counters(&c);
+    fprintf(stderr, "allocs = %10lu (%lu cached, %lu uncached)\nfrees  = %10lu\nrefills = %lu, flushes = %lu\n",
+            c.allocs, c.cacheHits, c.uncached, c.frees, c.refills, c.flushes);
+}
+
+void gm_get_counters(gm_counters* c) {
+    assert(GM);
+    memset(c, 0, sizeof(gm_counters));
+    for (uint32_t i = 0; i <= GM_SLOTS; i++) {
+        // Racy reads are fine, these are just stats
+        const gm_counters& sc = (i == GM_SLOTS)? GM->uncachedCounters : GM->slots[i].counters;
+        c->allocs += sc.allocs;
+        c->frees += sc.frees;
+        c->cacheHits += sc.cacheHits;
+        c->uncached += sc.uncached;
+        c->refills += sc.refills;
+        c->flushes += sc.flushes;
+    }
 }
 
 bool gm_isready() {
@@ -26,6 +26,7 @@
 #ifndef GALLOC_H_
 #define GALLOC_H_
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -61,6 +62,18 @@ void* gm_get_secondary_ptr();
 
 void gm_stats();
 
+// Allocator event counts, summed over all processes and threads
+struct gm_counters {
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t cacheHits;  // allocations served from a size-class cache
+    uint64_t uncached;  // large or aligned allocations, which always go to the shared heap
+    uint64_t refills;  // size-class caches refilled from the shared heap
+    uint64_t flushes;  // size-class caches over their high watermark, partly returned to the shared heap
+};
+
+void gm_get_counters(gm_counters* c);
+
 bool gm_isready();
 void gm_detach();
 
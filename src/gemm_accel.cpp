@@ -0,0 +1,357 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gemm_accel.h"
+#include "contention_sim.h"
+#include "filter_cache.h"
+#include "log.h"
+#include "timing_event.h"
+#include "zsim.h"
+
+// Starts a recorded DMA access in the accelerator's domain
+class AccelIssueEvent : public TimingEvent {
+    public:
+        AccelIssueEvent(uint32_t delay, int32_t domain) : TimingEvent(0, delay, domain) {}
+
+        void simulate(uint64_t startCycle) {
+            done(startCycle);
+        }
+};
+
+// Ends a recorded DMA read, and reports how late it arrived compared to the bound phase
+class AccelRespEvent : public TimingEvent {
+    private:
+        GemmAccel* accel;
+        uint64_t boundRespCycle;
+
+    public:
+        AccelRespEvent(GemmAccel* _accel, uint64_t _boundRespCycle, int32_t domain)
+            : TimingEvent(0, 0, domain), accel(_accel), boundRespCycle(_boundRespCycle) {}
+
+        void simulate(uint64_t startCycle) {
+            accel->dmaRespSimulated(boundRespCycle, startCycle);
+            done(startCycle);
+        }
+};
+
+GemmAccel::GemmAccel(uint32_t _rows, uint32_t _cols, uint32_t _spadBytes, uint32_t _dmaOutstanding, uint32_t _domain, uint32_t _lineSize)
+    : rows(_rows), cols(_cols), spadBytes(_spadBytes), dmaOutstanding(_dmaOutstanding), domain(_domain), lineSize(_lineSize)
+{
+    if (!rows || !cols) panic("GEMM accelerator needs at least one PE per dimension (%dx%d)", rows, cols);
+    if (!dmaOutstanding) panic("GEMM accelerator needs at least one outstanding DMA line");
+    uint32_t tileBytes = rows*cols*ELEM_BYTES;
+    kChunk = (spadBytes > tileBytes)? (spadBytes - tileBytes)/(2*(rows + cols)*ELEM_BYTES) : 0;
+    if (!kChunk) panic("GEMM accelerator: %d-byte scratchpad can't hold a %dx%d tile and two operand chunks", spadBytes, rows, cols);
+
+    port = nullptr;
+    evRec = nullptr;
+    futex_init(&accelLock);
+    curId = nextId = 0;
+    jobActive = chunkActive = chunkDrain = wbPending = false;
+    tileM = tileN = chunkK = 0;
+    tm = tn = tk = 0;
+    numBlocks = curBlock = 0;
+    jobStartCycle = computeFreeCycle = wbDoneCycle = 0;
+    bufFreeCycles[0] = bufFreeCycles[1] = 0;
+    curBuf = 0;
+    lastIssueCycle = 0;
+    dmaRespCycles = gm_calloc<uint64_t>(dmaOutstanding);
+    dmaPos = 0;
+    weaveLateness = 0;
+    info("GEMM accelerator: %dx%d array, %d KB scratchpad (K chunks of %d), %d outstanding DMA lines, domain %d",
+            rows, cols, spadBytes/1024, kChunk, dmaOutstanding, domain);
+}
+
+void GemmAccel::setPort(FilterCache* _port, uint32_t srcId, bool recordAccesses) {
+    port = _port;
+    port->setSourceId(srcId);
+    if (recordAccesses) {
+        evRec = new EventRecorder();
+        evRec->setSourceId(srcId);
+        evRec->setGapCycles(0);  // the accelerator never skews its timeline against the weave phase
+        evRec->setStartSlack(0);
+    }
+}
+
+void GemmAccel::initStats(AggregateStat* parentStat) {
+    AggregateStat* accelStat = new AggregateStat();
+    accelStat->init("accel", "GEMM accelerator stats");
+    profJobs.init("jobs", "Jobs completed"); accelStat->append(&profJobs);
+    profMACs.init("macs", "Multiply-accumulates"); accelStat->append(&profMACs);
+    profActiveCycles.init("activeCycles", "Cycles with a job running"); accelStat->append(&profActiveCycles);
+    profComputeCycles.init("computeCycles", "Cycles the array was computing, including fill and drain"); accelStat->append(&profComputeCycles);
+    profMemStallCycles.init("memStallCycles", "Cycles the array waited for DMA loads"); accelStat->append(&profMemStallCycles);
+    profDmaRdLines.init("dmaRdLines", "Lines read by the DMA engine"); accelStat->append(&profDmaRdLines);
+    profDmaWrLines.init("dmaWrLines", "Lines written by the DMA engine"); accelStat->append(&profDmaWrLines);
+    profDmaLat.init("dmaLat", "Cumulative DMA line latency (bound phase)"); accelStat->append(&profDmaLat);
+    profLateLines.init("lateLines", "DMA reads that arrived later than the bound phase predicted"); accelStat->append(&profLateLines);
+    profLateCycles.init("lateCycles", "Cumulative lateness of late DMA reads"); accelStat->append(&profLateCycles);
+    profShiftCycles.init("shiftCycles", "Cycles the timeline was delayed by late DMA reads (included in memStallCycles)"); accelStat->append(&profShiftCycles);
+
+    auto util = [this]() {
+        uint64_t active = profActiveCycles.get();
+        return active? profComputeCycles.get()*10000/active : 0;
+    };
+    auto utilStat = makeLambdaStat(util);
+    utilStat->init("util", "Array busy cycles over active cycles, in 1/10000ths");
+    accelStat->append(utilStat);
+
+    auto peUtil = [this]() {
+        uint64_t active = profActiveCycles.get();
+        return active? profMACs.get()*10000/(active*rows*cols) : 0;
+    };
+    auto peUtilStat = makeLambdaStat(peUtil);
+    peUtilStat->init("peUtil", "MACs over PE-cycles while active, in 1/10000ths");
+    accelStat->append(peUtilStat);
+    parentStat->append(accelStat);
+}
+
+uint64_t GemmAccel::launch(const Job& job) {
+    futex_lock(&accelLock);
+    if (nextId - curId >= MAX_JOBS) panic("GEMM accelerator: more than %d jobs in flight", MAX_JOBS);
+    uint64_t id = nextId++;
+    jobs[id % MAX_JOBS] = job;
+    advance(zinfo->globPhaseCycles + zinfo->phaseLength);
+    futex_unlock(&accelLock);
+    return id;
+}
+
+bool GemmAccel::poll(uint64_t id, uint64_t* doneCycle) {
+    futex_lock(&accelLock);
+    if (id >= nextId || nextId - id > MAX_JOBS) panic("GEMM accelerator: polled job %ld, valid ids are %ld-%ld", id, nextId - MIN(nextId, MAX_JOBS), nextId - 1);
+    bool done = id < curId;
+    if (done) *doneCycle = doneCycles[id % MAX_JOBS];
+    futex_unlock(&accelLock);
+    return done;
+}
+
+void GemmAccel::tick() {
+    futex_lock(&accelLock);
+    uint64_t late = weaveLateness;
+    weaveLateness = 0;
+    if (late && jobActive) shift(late);
+    advance(zinfo->globPhaseCycles + 2*zinfo->phaseLength);  // the next phase
+    futex_unlock(&accelLock);
+}
+
+void GemmAccel::dmaRespSimulated(uint64_t boundRespCycle, uint64_t respCycle) {
+    if (respCycle <= boundRespCycle) return;
+    uint64_t late = respCycle - boundRespCycle;
+    profLateLines.atomicInc();
+    profLateCycles.atomicInc(late);
+    uint64_t cur = weaveLateness;
+    while (late > cur && !__sync_bool_compare_and_swap(&weaveLateness, cur, late)) cur = weaveLateness;
+}
+
+// Delays everything not issued yet; the array stalls for these cycles
+void GemmAccel::shift(uint64_t cycles) {
+    computeFreeCycle += cycles;
+    bufFreeCycles[0] += cycles;
+    bufFreeCycles[1] += cycles;
+    if (chunkActive) {
+        for (uint32_t i = 0; i < numBlocks; i++) {
+            blocks[i].readyCycle += cycles;
+            blocks[i].doneCycle += cycles;
+        }
+    }
+    if (wbPending) {
+        wbBlock.readyCycle += cycles;
+        wbBlock.doneCycle += cycles;
+    }
+    wbDoneCycle += cycles;
+    profShiftCycles.inc(cycles);
+    profMemStallCycles.inc(cycles);
+}
+
+// Runs the timeline until all jobs are done or the next DMA line would issue at or after limit
+void GemmAccel::advance(uint64_t limit) {
+    while (chunkActive || startChunk()) {
+        while (curBlock < numBlocks) {
+            if (!issueBlock(blocks[curBlock], limit)) return;
+            curBlock++;
+        }
+        finishChunk();
+    }
+}
+
+bool GemmAccel::startChunk() {
+    if (!jobActive) {
+        if (curId == nextId) return false;
+        jobActive = true;
+        tileM = tileN = chunkK = 0;
+        jobStartCycle = MAX(jobs[curId % MAX_JOBS].launchCycle, computeFreeCycle);
+        computeFreeCycle = bufFreeCycles[0] = bufFreeCycles[1] = jobStartCycle;
+        wbDoneCycle = 0;
+    }
+
+    const Job& job = jobs[curId % MAX_JOBS];
+    uint64_t startCycle = bufFreeCycles[curBuf];
+    numBlocks = curBlock = 0;
+    chunkDrain = tileM*rows >= job.m;  // all tiles computed, only the last writeback is left
+    if (!chunkDrain) {
+        uint32_t m0 = tileM*rows, n0 = tileN*cols, k0 = chunkK*kChunk;
+        tm = MIN(rows, job.m - m0);
+        tn = MIN(cols, job.n - n0);
+        tk = MIN(kChunk, job.k - k0);
+        if (job.accumulate && k0 == 0) initBlock(blocks[numBlocks++], job.c, m0, n0, tm, tn, job.ldc, true, startCycle);
+        initBlock(blocks[numBlocks++], job.a, m0, k0, tm, tk, job.lda, true, startCycle);
+        initBlock(blocks[numBlocks++], job.b, k0, n0, tk, tn, job.ldb, true, startCycle);
+    }
+    if (wbPending) {
+        blocks[numBlocks++] = wbBlock;
+        wbPending = false;
+    }
+    chunkActive = true;
+    return true;
+}
+
+void GemmAccel::finishChunk() {
+    const Job& job = jobs[curId % MAX_JOBS];
+    chunkActive = false;
+    uint64_t loadDoneCycle = 0;
+    for (uint32_t i = 0; i < numBlocks; i++) {
+        if (blocks[i].isLoad) loadDoneCycle = MAX(loadDoneCycle, blocks[i].doneCycle);
+        else wbDoneCycle = MAX(wbDoneCycle, blocks[i].doneCycle);
+    }
+
+    if (chunkDrain) {
+        finishJob(MAX(computeFreeCycle, wbDoneCycle));
+        return;
+    }
+
+    uint64_t computeStartCycle = MAX(loadDoneCycle, computeFreeCycle);
+    profMemStallCycles.inc(computeStartCycle - computeFreeCycle);
+    bool lastChunk = chunkK*kChunk + tk >= job.k;
+    uint32_t cycles = tk + (lastChunk? tm + tn - 2 : 0);  // skewed operands fill and drain the array once per tile
+    computeFreeCycle = computeStartCycle + cycles;
+    bufFreeCycles[curBuf] = computeFreeCycle;
+    curBuf ^= 1;
+    profComputeCycles.inc(cycles);
+    profMACs.inc((uint64_t)tm*tn*tk);
+
+    if (lastChunk) {
+        initBlock(wbBlock, job.c, tileM*rows, tileN*cols, tm, tn, job.ldc, false, computeFreeCycle);
+        wbPending = true;
+        chunkK = 0;
+        if (++tileN*cols >= job.n) {
+            tileN = 0;
+            tileM++;
+        }
+    } else {
+        chunkK++;
+    }
+}
+
+void GemmAccel::finishJob(uint64_t doneCycle) {
+    doneCycles[curId % MAX_JOBS] = doneCycle;
+    curId++;
+    jobActive = false;
+    computeFreeCycle = doneCycle;
+    profJobs.inc();
+    profActiveCycles.inc(doneCycle - jobStartCycle);
+}
+
+void GemmAccel::initBlock(DMABlock& blk, Address base, uint32_t r0, uint32_t c0, uint32_t nr, uint32_t nc,
+        uint32_t ld, bool isLoad, uint64_t readyCycle) {
+    blk.base = base + ((Address)r0*ld + c0)*ELEM_BYTES;
+    blk.rows = nr;
+    blk.rowBytes = nc*ELEM_BYTES;
+    blk.strideBytes = ld*ELEM_BYTES;
+    blk.isLoad = isLoad;
+    blk.readyCycle = readyCycle;
+    blk.doneCycle = readyCycle;
+    blk.row = 0;
+    blk.nextLine = blk.base/lineSize;
+}
+
+// Returns false if it stopped because the next line would issue at or after limit
+bool GemmAccel::issueBlock(DMABlock& blk, uint64_t limit) {
+    Address procMask = jobs[curId % MAX_JOBS].procMask;
+    while (blk.row < blk.rows) {
+        Address lastLine = (blk.base + (Address)blk.row*blk.strideBytes + blk.rowBytes - 1)/lineSize;
+        while (blk.nextLine <= lastLine) {
+            // One line per cycle, a free DMA slot, and not before the current weave limit
+            uint64_t cycle = MAX(MAX(blk.readyCycle, lastIssueCycle + 1), MAX(dmaRespCycles[dmaPos], zinfo->contentionSim->getLastLimit()));
+            if (cycle >= limit) return false;
+            uint64_t respCycle = dmaLine(procMask | blk.nextLine, blk.isLoad, cycle);
+            blk.doneCycle = MAX(blk.doneCycle, respCycle);
+            blk.nextLine++;
+        }
+        blk.row++;
+        if (blk.row < blk.rows) blk.nextLine = (blk.base + (Address)blk.row*blk.strideBytes)/lineSize;
+    }
+    return true;
+}
+
+uint64_t GemmAccel::dmaLine(Address lineAddr, bool isLoad, uint64_t cycle) {
+    uint64_t respCycle = port->deviceAccess(lineAddr, isLoad, cycle);
+
+    if (evRec && evRec->hasRecord()) {
+        TimingRecord tr = evRec->popRecord();
+        assert(tr.reqCycle >= cycle);
+        AccelIssueEvent* ev = new (evRec) AccelIssueEvent(tr.reqCycle - cycle, domain);
+        ev->setMinStartCycle(cycle);
+        ev->addChild(tr.startEvent, evRec);
+        if (IsGet(tr.type)) {
+            AccelRespEvent* respEv = new (evRec) AccelRespEvent(this, tr.respCycle, domain);
+            respEv->setMinStartCycle(tr.respCycle);
+            tr.endEvent->addChild(respEv, evRec);
+        }
+        ev->produceCrossings(evRec);
+        evRec->getCrossingStack().clear();
+        ev->queue(cycle);
+    }
+
+    dmaRespCycles[dmaPos] = respCycle;
+    dmaPos = (dmaPos + 1) % dmaOutstanding;
+    lastIssueCycle = cycle;
+    if (isLoad) profDmaRdLines.inc();
+    else profDmaWrLines.inc();
+    profDmaLat.inc(respCycle - cycle);
+    return respCycle;
+}
+
+template <typename T>
+static void gemm(bool accumulate, const T* a, const T* b, T* c, uint32_t m, uint32_t n, uint32_t k) {
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t j = 0; j < n; j++) {
+            T acc = accumulate? c[i*n + j] : 0;
+            for (uint32_t kk = 0; kk < k; kk++) acc += a[i*k + kk]*b[kk*n + j];
+            c[i*n + j] = acc;
+        }
+    }
+}
+
+void GemmAccel::compute(uint32_t type, bool accumulate, const void* a, const void* b, void* c,
+        uint32_t m, uint32_t n, uint32_t k) {
+    switch (type) {
+        case F32:
+            gemm<float>(accumulate, (const float*)a, (const float*)b, (float*)c, m, n, k);
+            break;
+        case I32:  // unsigned arithmetic wraps like the 32-bit integer datapath
+            gemm<uint32_t>(accumulate, (const uint32_t*)a, (const uint32_t*)b, (uint32_t*)c, m, n, k);
+            break;
+        default: panic("Invalid GEMM element type %d", type);
+    }
+}
@@ -0,0 +1,183 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GEMM_ACCEL_H_
+#define GEMM_ACCEL_H_
+
+#include "event_queue.h"
+#include "event_recorder.h"
+#include "galloc.h"
+#include "locks.h"
+#include "memory_hierarchy.h"
+#include "pad.h"
+#include "stats.h"
+
+class FilterCache;
+
+/* Systolic-array GEMM accelerator with a scratchpad and a DMA engine,
+ * launched by the ACCEL_GEMM magic op and waited on with ACCEL_WAIT.
+ *
+ * The array is output-stationary, rows x cols PEs, and computes C (+)= A*B
+ * one rows x cols tile of C at a time. Each tile's K dimension is split into
+ * chunks sized so that two chunks of A and B operands plus the C tile fit in
+ * the scratchpad, so the DMA engine loads chunk i+1 while the array works on
+ * chunk i. A chunk of depth kc takes kc cycles, plus rows + cols - 2 cycles
+ * to fill and drain the array once per tile. Finished tiles are written back
+ * while the next tile is loaded.
+ *
+ * The DMA engine issues one line per cycle, with up to dmaOutstanding lines in
+ * flight, through a port: a private terminal cache whose parent is the LLC.
+ * Lines take the same coherent access path as core misses, so the accelerator
+ * and the cores compete for LLC and memory bandwidth. The port has srcId
+ * numCores. If the weave phase is active, each DMA access is recorded like a
+ * core access, and responses that come back later than the bound phase
+ * predicted delay the accelerator's timeline in the next phase.
+ *
+ * Jobs run in order. The timeline is computed in the bound phase up to the end
+ * of the current phase when a job is launched, and then one phase at a time
+ * from the event queue, so the DMA traffic is interleaved with the cores'.
+ */
+class GemmAccel : public GlobAlloc {
+    public:
+        enum ElemType {F32 = 0, I32 = 1};  // must match zsim_hooks.h
+
+        static const uint32_t MAX_JOBS = 64;  // launched but not waited on
+        static const uint32_t ELEM_BYTES = 4;  // both element types
+
+        struct Job {
+            Address procMask;  // of the launching process, the event queue may tick in any process
+            Address a, b, c;   // virtual addresses
+            uint32_t m, n, k;
+            uint32_t lda, ldb, ldc;  // in elements
+            bool accumulate;   // C += A*B (C is loaded) instead of C = A*B
+            uint64_t launchCycle;
+        };
+
+    private:
+        // A rectangular block of a row-major matrix moved by the DMA engine, with a line cursor
+        struct DMABlock {
+            Address base;  // virtual address of the first element
+            uint32_t rows, rowBytes, strideBytes;
+            bool isLoad;
+            uint64_t readyCycle;  // no line is issued before this
+            uint64_t doneCycle;   // latest response so far
+            uint32_t row;
+            Address nextLine;     // next line of the current row, 0 if the row has not started
+        };
+
+        const uint32_t rows, cols, spadBytes, dmaOutstanding;
+        const uint32_t domain;
+        const uint32_t lineSize;
+        FilterCache* port;
+        EventRecorder* evRec;  // nullptr if there is no weave phase
+        lock_t accelLock;
+
+        // Jobs, in a ring indexed by id % MAX_JOBS; ids [curId, nextId) are pending or running
+        Job jobs[MAX_JOBS];
+        uint64_t doneCycles[MAX_JOBS];
+        uint64_t curId, nextId;
+
+        // Running job
+        bool jobActive;
+        uint32_t kChunk;  // K elements per chunk
+        uint32_t tileM, tileN, chunkK;  // next chunk
+        uint64_t jobStartCycle;
+
+        // Current chunk: its DMA blocks, issued in order, then compute
+        bool chunkActive, chunkDrain;  // a drain chunk only writes back the last tile
+        uint32_t tm, tn, tk;
+        DMABlock blocks[4];
+        uint32_t numBlocks, curBlock;
+
+        // Writeback of the last computed tile, issued with the next chunk
+        bool wbPending;
+        DMABlock wbBlock;
+        uint64_t wbDoneCycle;  // of the running job's writebacks so far
+
+        uint64_t computeFreeCycle;
+        uint64_t bufFreeCycles[2];  // double-buffered operands
+        uint32_t curBuf;
+
+        uint64_t lastIssueCycle;
+        uint64_t* dmaRespCycles;  // ring, dmaOutstanding entries
+        uint32_t dmaPos;
+
+        // Max lateness of DMA responses in the weave phase since the last tick
+        volatile uint64_t weaveLateness;
+
+        class TickEvent : public Event {
+            private:
+                GemmAccel* accel;
+            public:
+                explicit TickEvent(GemmAccel* _accel) : Event(1), accel(_accel) {}
+                void callback() { accel->tick(); }
+        };
+
+        PAD();
+        Counter profJobs, profMACs;
+        Counter profActiveCycles, profComputeCycles, profMemStallCycles;
+        Counter profDmaRdLines, profDmaWrLines, profDmaLat;
+        Counter profLateLines, profLateCycles, profShiftCycles;
+        PAD();
+
+    public:
+        GemmAccel(uint32_t _rows, uint32_t _cols, uint32_t _spadBytes, uint32_t _dmaOutstanding, uint32_t _domain, uint32_t _lineSize);
+
+        // The port must be a terminal cache not used by any core. Only record accesses if there is a weave phase.
+        void setPort(FilterCache* _port, uint32_t srcId, bool recordAccesses);
+        EventRecorder* getEventRecorder() const { return evRec; }
+        void initStats(AggregateStat* parentStat);
+
+        // Returns the periodic event that advances the timeline, to be inserted in the event queue
+        Event* getTickEvent() { return new TickEvent(this); }
+
+        // Bound phase. Returns the job id.
+        uint64_t launch(const Job& job);
+        // Bound phase. Returns true and sets doneCycle if the job's timeline has been computed to its end.
+        // Jobs must be polled before MAX_JOBS newer jobs are launched.
+        bool poll(uint64_t id, uint64_t* doneCycle);
+
+        // Weave phase, called by DMA response events
+        void dmaRespSimulated(uint64_t boundRespCycle, uint64_t respCycle);
+
+        // Functional GEMM on packed row-major matrices (lda == k, ldb == ldc == n)
+        static void compute(uint32_t type, bool accumulate, const void* a, const void* b, void* c,
+                uint32_t m, uint32_t n, uint32_t k);
+        static bool validType(uint32_t type) { return type <= I32; }
+
+    private:
+        void tick();
+        void advance(uint64_t limit);
+        bool startChunk();
+        void finishChunk();
+        void finishJob(uint64_t doneCycle);
+        void shift(uint64_t cycles);
+
+        void initBlock(DMABlock& blk, Address base, uint32_t r0, uint32_t c0, uint32_t nr, uint32_t nc,
+                uint32_t ld, bool isLoad, uint64_t readyCycle);
+        bool issueBlock(DMABlock& blk, uint64_t limit);
+        uint64_t dmaLine(Address lineAddr, bool isLoad, uint64_t cycle);
+};
+
+#endif  // GEMM_ACCEL_H_
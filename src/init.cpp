@@ -41,19 +41,23 @@
 #include "detailed_mem_params.h"
 #include "ddr_mem.h"
 #include "debug_zsim.h"
+#include "decoder.h"
 #include "dramsim_mem_ctrl.h"
 #include "event_queue.h"
 #include "filter_cache.h"
 #include "galloc.h"
+#include "gemm_accel.h"
 #include "hash.h"
 #include "ideal_arrays.h"
 #include "locks.h"
 #include "log.h"
 #include "mem_ctrls.h"
+#include "mesh_network.h"
 #include "network.h"
 #include "null_core.h"
 #include "ooo_core.h"
 #include "part_repl_policies.h"
+#include "pim_unit.h"
 #include "pin_cmd.h"
 #include "prefetcher.h"
 #include "proc_stats.h"
@@ -63,12 +67,15 @@
 #include "repl_policies.h"
 #include "scheduler.h"
 #include "simple_core.h"
+#include "sparse_dir.h"
 #include "stats.h"
 #include "stats_filter.h"
 #include "str.h"
+#include "tiered_mem.h"
 #include "timing_cache.h"
 #include "timing_core.h"
 #include "timing_event.h"
+#include "tlb.h"
 #include "trace_driver.h"
 #include "tracing_cache.h"
 #include "virt/port_virtualizer.h"
@@ -164,6 +171,28 @@ BaseCache* BuildCacheBank(Config& config, const string& prefix, g_string& name,
         rp = new NRUReplPolicy(numLines, candidates);
     } else if (replType == "Rand") {
         rp = new RandReplPolicy(candidates);
+    } else if (replType == "SRRIP" || replType == "BRRIP" || replType == "DRRIP" || replType == "SHiP") {
+        uint32_t rrpvBits = config.get<uint32_t>(prefix + "repl.rrpvBits", 2);
+        if (replType == "SRRIP") {
+            rp = new SRRIPReplPolicy(numLines, ways, rrpvBits);
+        } else if (replType == "BRRIP") {
+            rp = new BRRIPReplPolicy(numLines, ways, rrpvBits);
+        } else if (replType == "DRRIP") {
+            uint32_t leaderSets = config.get<uint32_t>(prefix + "repl.leaderSets", 32);
+            uint32_t pselBits = config.get<uint32_t>(prefix + "repl.pselBits", 10);
+            rp = new DRRIPReplPolicy(numLines, ways, rrpvBits, leaderSets, pselBits);
+        } else {
+            uint32_t shctEntries = config.get<uint32_t>(prefix + "repl.shctEntries", 16384);
+            uint32_t regionBits = config.get<uint32_t>(prefix + "repl.regionBits", 4);
+            rp = new SHiPReplPolicy(numLines, ways, rrpvBits, shctEntries, regionBits);
+        }
+    } else if (replType == "Hawkeye") {
+        if (arrayType != "SetAssoc") panic("%s: Hawkeye replacement requires SetAssoc array", name.c_str());
+        uint32_t predEntries = config.get<uint32_t>(prefix + "repl.predictorEntries", 2048);
+        uint32_t regionBits = config.get<uint32_t>(prefix + "repl.regionBits", 4);
+        uint32_t sampledSets = config.get<uint32_t>(prefix + "repl.sampledSets", 64);
+        uint32_t historyMult = config.get<uint32_t>(prefix + "repl.historyMult", 8);
+        rp = new HawkeyeReplPolicy(numLines, ways, predEntries, regionBits, sampledSets, historyMult);
     } else if (replType == "WayPart" || replType == "Vantage" || replType == "IdealLRUPart") {
         if (replType == "WayPart" && arrayType != "SetAssoc") panic("WayPart replacement requires SetAssoc array");
 
@@ -171,12 +200,14 @@ BaseCache* BuildCacheBank(Config& config, const string& prefix, g_string& name,
         // TODO: One partition mapper per cache (not bank).
         string partMapper = config.get<const char*>(prefix + "repl.partMapper", "Core");
         PartMapper* pm = nullptr;
+        //The accelerator's DMA port uses srcId == numCores, so it gets a partition of its own
+        uint32_t numSrcs = zinfo->numCores + (config.exists("sys.accel")? 1 : 0);
         if (partMapper == "Core") {
-            pm = new CorePartMapper(zinfo->numCores); //NOTE: If the cache is not fully shared, trhis will be inefficient...
+            pm = new CorePartMapper(numSrcs); //NOTE: If the cache is not fully shared, trhis will be inefficient...
         } else if (partMapper == "InstrData") {
             pm = new InstrDataPartMapper();
         } else if (partMapper == "InstrDataCore") {
-            pm = new InstrDataCorePartMapper(zinfo->numCores);
+            pm = new InstrDataCorePartMapper(numSrcs);
         } else if (partMapper == "Process") {
             pm = new ProcessPartMapper(zinfo->numProcs);
         } else if (partMapper == "InstrDataProcess") {
@@ -262,10 +293,30 @@ BaseCache* BuildCacheBank(Config& config, const string& prefix, g_string& name,
     // Finally, build the cache
     Cache* cache;
     CC* cc;
+    // Directory (non-terminal caches): Inclusive keeps a full sharer bit-vector per line, Sparse uses a separate directory
+    string dirType = config.get<const char*>(prefix + "directory.type", "Inclusive");
     if (isTerminal) {
         cc = new MESITerminalCC(numLines, name);
-    } else {
+    } else if (dirType == "Inclusive") {
         cc = new MESICC(numLines, nonInclusiveHack, name);
+    } else if (dirType == "Sparse") {
+        if (nonInclusiveHack) panic("%s: nonInclusiveHack is not supported with sparse directories", name.c_str());
+        uint32_t dirEntries = config.get<uint32_t>(prefix + "directory.entries", numLines);
+        uint32_t dirWays = config.get<uint32_t>(prefix + "directory.ways", 8);
+        if (dirWays == 0 || dirEntries % dirWays != 0) panic("%s: directory entries (%d) must be a multiple of its ways (%d)", name.c_str(), dirEntries, dirWays);
+        string sharers = config.get<const char*>(prefix + "directory.sharers", "FullMap");
+        SharerFormat format;
+        if (sharers == "FullMap") format = SHARERS_FULLMAP;
+        else if (sharers == "LimitedPtr") format = SHARERS_LIMITEDPTR;
+        else if (sharers == "CoarseVector") format = SHARERS_COARSEVECTOR;
+        else panic("%s: Invalid directory sharer format %s", name.c_str(), sharers.c_str());
+        uint32_t pointers = config.get<uint32_t>(prefix + "directory.pointers", 4);
+        uint32_t groupSize = config.get<uint32_t>(prefix + "directory.groupSize", 4);
+        if (format != SHARERS_FULLMAP && pointers == 0) panic("%s: directory needs at least one pointer", name.c_str());
+        if (format == SHARERS_COARSEVECTOR && groupSize == 0) panic("%s: directory groupSize must be > 0", name.c_str());
+        cc = new MESISparseDirCC(numLines, dirEntries, dirWays, format, pointers, groupSize, name);
+    } else {
+        panic("%s: Invalid directory type %s", name.c_str(), dirType.c_str());
     }
     rp->setCC(cc);
     if (!isTerminal) {
@@ -287,7 +338,10 @@ BaseCache* BuildCacheBank(Config& config, const string& prefix, g_string& name,
         //Filter cache optimization
         if (type != "Simple") panic("Terminal cache %s can only have type == Simple", name.c_str());
         if (arrayType != "SetAssoc" || hashType != "None" || replType != "LRU") panic("Invalid FilterCache config %s", name.c_str());
-        cache = new FilterCache(numSets, numLines, cc, array, rp, accLat, invLat, name);
+        uint32_t filterWays = config.get<uint32_t>(prefix + "filter.ways", 1);
+        uint32_t filterVictims = config.get<uint32_t>(prefix + "filter.victims", 0);
+        if (filterWays == 0 || filterWays > ways) panic("%s: filter.ways must be between 1 and the cache's ways (%d), is %d", name.c_str(), ways, filterWays);
+        cache = new FilterCache(numSets, numLines, cc, array, rp, accLat, invLat, filterWays, filterVictims, name);
     }
 
 #if 0
@@ -318,17 +372,23 @@ DDRMemory* BuildDDRMemory(Config& config, uint32_t lineSize, uint32_t frequency,
     uint32_t queueDepth = config.get<uint32_t>(prefix + "queueDepth", 16);
     uint32_t controllerLatency = config.get<uint32_t>(prefix + "controllerLatency", 10);  // in system cycles
 
+    // Bank groups per rank (0 -> tech default, e.g., 4 for DDR4, 8 for DDR5)
+    uint32_t bankGroups = config.get<uint32_t>(prefix + "bankGroups", 0);
+    // AllBank, PerBank (HBM), or SameBank (DDR5)
+    const char* refreshMode = config.get<const char*>(prefix + "refreshMode", "AllBank");
+
     auto mem = new DDRMemory(zinfo->lineSize, pageSize, ranksPerChannel, banksPerRank, frequency, tech,
-            addrMapping, controllerLatency, queueDepth, maxRowHits, deferWrites, closedPage, domain, name);
+            addrMapping, controllerLatency, queueDepth, maxRowHits, deferWrites, closedPage, bankGroups,
+            refreshMode, domain, name);
     return mem;
 }
 
-MemObject* BuildMemoryController(Config& config, uint32_t lineSize, uint32_t frequency, uint32_t domain, g_string& name) {
+MemObject* BuildMemoryController(Config& config, uint32_t lineSize, uint32_t frequency, uint32_t domain, g_string& name, const string& prefix) {
     //Type
-    string type = config.get<const char*>("sys.mem.type", "Simple");
+    string type = config.get<const char*>(prefix + "type", "Simple");
 
     //Latency
-    uint32_t latency = (type == "DDR")? -1 : config.get<uint32_t>("sys.mem.latency", 100);
+    uint32_t latency = (type == "DDR")? -1 : config.get<uint32_t>(prefix + "latency", 100);
 
     MemObject* mem = nullptr;
     if (type == "Simple") {
@@ -339,29 +399,29 @@ MemObject* BuildMemoryController(Config& config, uint32_t lineSize, uint32_t fre
         // a single CCT across the system, and we are dealing with latencies in *core* clock cycles
 
         // Peak bandwidth (in MB/s)
-        uint32_t bandwidth = config.get<uint32_t>("sys.mem.bandwidth", 6400);
+        uint32_t bandwidth = config.get<uint32_t>(prefix + "bandwidth", 6400);
 
         mem = new MD1Memory(lineSize, frequency, bandwidth, latency, name);
     } else if (type == "WeaveMD1") {
-        uint32_t bandwidth = config.get<uint32_t>("sys.mem.bandwidth", 6400);
-        uint32_t boundLatency = config.get<uint32_t>("sys.mem.boundLatency", latency);
+        uint32_t bandwidth = config.get<uint32_t>(prefix + "bandwidth", 6400);
+        uint32_t boundLatency = config.get<uint32_t>(prefix + "boundLatency", latency);
         mem = new WeaveMD1Memory(lineSize, frequency, bandwidth, latency, boundLatency, domain, name);
     } else if (type == "WeaveSimple") {
-        uint32_t boundLatency = config.get<uint32_t>("sys.mem.boundLatency", 100);
+        uint32_t boundLatency = config.get<uint32_t>(prefix + "boundLatency", 100);
         mem = new WeaveSimpleMemory(latency, boundLatency, domain, name);
     } else if (type == "DDR") {
-        mem = BuildDDRMemory(config, lineSize, frequency, domain, name, "sys.mem.");
+        mem = BuildDDRMemory(config, lineSize, frequency, domain, name, prefix);
     } else if (type == "DRAMSim") {
         uint64_t cpuFreqHz = 1000000 * frequency;
-        uint32_t capacity = config.get<uint32_t>("sys.mem.capacityMB", 16384);
-        string dramTechIni = config.get<const char*>("sys.mem.techIni");
-        string dramSystemIni = config.get<const char*>("sys.mem.systemIni");
-        string outputDir = config.get<const char*>("sys.mem.outputDir");
-        string traceName = config.get<const char*>("sys.mem.traceName");
+        uint32_t capacity = config.get<uint32_t>(prefix + "capacityMB", 16384);
+        string dramTechIni = config.get<const char*>(prefix + "techIni");
+        string dramSystemIni = config.get<const char*>(prefix + "systemIni");
+        string outputDir = config.get<const char*>(prefix + "outputDir");
+        string traceName = config.get<const char*>(prefix + "traceName");
         mem = new DRAMSimMemory(dramTechIni, dramSystemIni, outputDir, traceName, capacity, cpuFreqHz, latency, domain, name);
     } else if (type == "Detailed") {
         // FIXME(dsm): Don't use a separate config file... see DDRMemory
-        g_string mcfg = config.get<const char*>("sys.mem.paramFile", "");
+        g_string mcfg = config.get<const char*>(prefix + "paramFile", "");
         mem = new MemControllerBase(mcfg, lineSize, frequency, domain, name);
     } else {
         panic("Invalid memory controller type %s", type.c_str());
@@ -369,8 +429,122 @@ MemObject* BuildMemoryController(Config& config, uint32_t lineSize, uint32_t fre
     return mem;
 }
 
+uint32_t NumMemoryControllers(Config& config, const string& prefix) {
+    uint32_t memControllers = config.get<uint32_t>(prefix + "controllers", 1);
+    assert(memControllers > 0);
+
+    // DDR5 sub-channels and HBM pseudo-channels are independent, so each gets its own controller
+    if (string(config.get<const char*>(prefix + "type", "Simple")) == "DDR") {
+        memControllers *= DDRMemory::techSubChannels(config.get<const char*>(prefix + "tech", "DDR3-1333-CL10"));
+    }
+    return memControllers;
+}
+
+// Builds the controllers of one memory (sys.mem, or a tier such as sys.mem.cxl), interleaved by a splitter if requested
+g_vector<MemObject*> BuildMemoryControllers(Config& config, const string& prefix, const char* namePrefix) {
+    uint32_t memControllers = NumMemoryControllers(config, prefix);
+
+    g_vector<MemObject*> mems;
+    mems.resize(memControllers);
+
+    for (uint32_t i = 0; i < memControllers; i++) {
+        stringstream ss;
+        ss << namePrefix << "-" << i;
+        g_string name(ss.str().c_str());
+        //uint32_t domain = nextDomain(); //i*zinfo->numDomains/memControllers;
+        uint32_t domain = i*zinfo->numDomains/memControllers;
+        mems[i] = BuildMemoryController(config, zinfo->lineSize, zinfo->freqMHz, domain, name, prefix);
+    }
+
+    if (memControllers > 1) {
+        bool splitAddrs = config.get<bool>(prefix + "splitAddrs", true);
+        if (splitAddrs) {
+            MemObject* splitter = new SplitAddrMemory(mems, (string(namePrefix) + "-splitter").c_str());
+            mems.resize(1);
+            mems[0] = splitter;
+        }
+    }
+    return mems;
+}
+
+MemObject* BuildTieredMemory(Config& config, MemObject* localMem, MemObject* cxlMem) {
+    string policyStr = config.get<const char*>("sys.mem.tiering.policy", "FirstTouch");
+    TieredMemory::Policy policy;
+    if (policyStr == "FirstTouch") policy = TieredMemory::FIRST_TOUCH;
+    else if (policyStr == "Interleave") policy = TieredMemory::INTERLEAVE;
+    else if (policyStr == "Hotness") policy = TieredMemory::HOTNESS;
+    else panic("Invalid tiering policy %s (FirstTouch, Interleave or Hotness)", policyStr.c_str());
+
+    TieredMemory::Params p;
+    p.policy = policy;
+    p.pageSize = config.get<uint32_t>("sys.mem.tiering.pageSize", 4096);
+    p.localCapacityMB = config.get<uint32_t>("sys.mem.tiering.localCapacityMB", 1024);
+    // Interleave: localWeight local pages for every cxlWeight CXL pages, in first-touch order
+    p.localWeight = config.get<uint32_t>("sys.mem.tiering.localWeight", 1);
+    p.cxlWeight = config.get<uint32_t>("sys.mem.tiering.cxlWeight", 1);
+    p.epochPhases = config.get<uint32_t>("sys.mem.tiering.epochPhases", 10);  // Hotness: migrate every these many phases
+    p.maxMigrations = config.get<uint32_t>("sys.mem.tiering.maxMigrations", 64);  // Hotness: max promotions per epoch
+    p.hotThreshold = config.get<uint32_t>("sys.mem.tiering.hotThreshold", 8);  // Hotness: min epoch accesses to promote
+    p.linkLatency = config.get<uint32_t>("sys.mem.cxl.linkLatency", 70);  // round trip, in system cycles
+    p.linkBandwidth = config.get<uint32_t>("sys.mem.cxl.linkBandwidth", 32000);  // in MB/s, per direction
+    return new TieredMemory(localMem, cxlMem, p, zinfo->lineSize, zinfo->freqMHz, "mem-tiered");
+}
+
+
 typedef vector<vector<BaseCache*>> CacheGroup;
 
+MeshNetwork* BuildMeshNetwork(Config& config) {
+    string type = config.get<const char*>("sys.network.type", "Mesh");
+    if (type != "Mesh" && type != "Torus") panic("Invalid network type %s (Mesh or Torus)", type.c_str());
+    string routingStr = config.get<const char*>("sys.network.routing", "XY");
+    MeshNetwork::Routing routing;
+    if (routingStr == "XY") routing = MeshNetwork::XY;
+    else if (routingStr == "Adaptive") routing = MeshNetwork::ADAPTIVE;
+    else panic("Invalid network routing %s (XY or Adaptive)", routingStr.c_str());
+
+    return new MeshNetwork(config.get<uint32_t>("sys.network.x", 4), config.get<uint32_t>("sys.network.y", 4),
+            type == "Torus", routing,
+            config.get<uint32_t>("sys.network.linkBytes", 16),  // flit size, one flit per link per cycle
+            config.get<uint32_t>("sys.network.routerDelay", 2),  // router pipeline stages
+            config.get<uint32_t>("sys.network.linkDelay", 1),
+            config.get<uint32_t>("sys.network.ctrlBytes", 8));  // requests, acks and invalidations
+}
+
+/* Spreads each cache group's banks and the memory controllers evenly over the
+ * mesh tiles, so that e.g. the k-th L2 and L1s of a tiled CMP share tile k.
+ * memTiles overrides the controllers' tiles. A single memory object in front
+ * of several controllers is placed on all of their tiles.
+ */
+static void PlaceOnMesh(Config& config, MeshNetwork* mesh, const vector<const char*>& cacheGroupNames,
+        unordered_map<string, CacheGroup*>& cMap, const g_vector<MemObject*>& mems) {
+    uint32_t tiles = mesh->getNumTiles();
+    auto spread = [tiles](uint32_t i, uint32_t n) -> uint32_t { return ((uint64_t)i)*tiles/n; };
+
+    for (const char* grp : cacheGroupNames) {
+        vector<BaseCache*> banks;
+        for (vector<BaseCache*>& cacheBanks : *cMap[grp]) banks.insert(banks.end(), cacheBanks.begin(), cacheBanks.end());
+        for (uint32_t i = 0; i < banks.size(); i++) {
+            g_vector<uint32_t> tile(1, spread(i, banks.size()));
+            mesh->addNode(banks[i]->getName(), tile);
+        }
+    }
+
+    uint32_t memControllers = NumMemoryControllers(config, "sys.mem.");
+    vector<uint32_t> memTiles = ParseList<uint32_t>(config.get<const char*>("sys.network.memTiles", ""));
+    if (memTiles.empty()) {
+        for (uint32_t i = 0; i < memControllers; i++) memTiles.push_back(spread(i, memControllers));
+    } else if (memTiles.size() != memControllers) {
+        panic("sys.network.memTiles has %ld tiles, but there are %d memory controllers", memTiles.size(), memControllers);
+    }
+
+    if (mems.size() == memControllers) {
+        for (uint32_t i = 0; i < memControllers; i++) mesh->addNode(mems[i]->getName(), g_vector<uint32_t>(1, memTiles[i]));
+    } else {
+        assert(mems.size() == 1);
+        mesh->addNode(mems[0]->getName(), g_vector<uint32_t>(memTiles));
+    }
+}
+
 CacheGroup* BuildCacheGroup(Config& config, const string& name, bool isTerminal) {
     CacheGroup* cgp = new CacheGroup;
     CacheGroup& cg = *cgp;
@@ -380,13 +554,26 @@ CacheGroup* BuildCacheGroup(Config& config, const string& name, bool isTerminal)
     bool isPrefetcher = config.get<bool>(prefix + "isPrefetcher", false);
     if (isPrefetcher) { //build a prefetcher group
         uint32_t prefetchers = config.get<uint32_t>(prefix + "prefetchers", 1);
+        string pfType = config.get<const char*>(prefix + "prefetcher.type", "Stream");
+        uint32_t pfEntries = config.get<uint32_t>(prefix + "prefetcher.trackedLines", 1024);
+        uint32_t pfDegree = config.get<uint32_t>(prefix + "prefetcher.degree", 32);
+        uint32_t pfDistance = config.get<uint32_t>(prefix + "prefetcher.distance", 2);
+        uint32_t pfFeatureLines = config.get<uint32_t>(prefix + "prefetcher.featureLines", 4);
         cg.resize(prefetchers);
         for (vector<BaseCache*>& bg : cg) bg.resize(1);
         for (uint32_t i = 0; i < prefetchers; i++) {
             stringstream ss;
             ss << name << "-" << i;
             g_string pfName(ss.str().c_str());
-            cg[i][0] = new StreamPrefetcher(pfName);
+            if (pfType == "Stream") {
+                cg[i][0] = new StreamPrefetcher(pfName);
+            } else if (pfType == "Indirect") {
+                cg[i][0] = new IndirectPrefetcher(pfEntries, pfDegree, pfDistance, pfName);
+            } else if (pfType == "CSR") {
+                cg[i][0] = new CSRPrefetcher(pfEntries, pfDegree, pfDistance, pfFeatureLines, pfName);
+            } else {
+                panic("%s: Invalid prefetcher type %s", name.c_str(), pfType.c_str());
+            }
         }
         return cgp;
     }
@@ -419,6 +606,67 @@ CacheGroup* BuildCacheGroup(Config& config, const string& name, bool isTerminal)
     return cgp;
 }
 
+// OOO cores are templated on their microarchitecture preset, so each core group picks its builder at config time
+typedef OOOCore* (*OOOCoreBuilder)(void* mem, FilterCache* ic, FilterCache* dc, BranchPredictor* bp, uint32_t profiledBranches, g_string& name);
+
+template <typename T>
+static OOOCore* BuildOOOCore(void* mem, FilterCache* ic, FilterCache* dc, BranchPredictor* bp, uint32_t profiledBranches, g_string& name) {
+    return new (mem) T(ic, dc, bp, profiledBranches, name);
+}
+
+// Returns nullptr for the preset's default predictor
+static BranchPredictor* BuildBranchPredictor(Config& config, const string& prefix) {
+    string type = config.get<const char*>(prefix + "type", "Default");
+    if (type == "Default") {
+        return nullptr;
+    } else if (type == "TAGE") {
+        uint32_t tables = config.get<uint32_t>(prefix + "tables", 7);
+        uint32_t tableBits = config.get<uint32_t>(prefix + "tableBits", 10);
+        uint32_t baseBits = config.get<uint32_t>(prefix + "baseBits", 13);
+        uint32_t tagBits = config.get<uint32_t>(prefix + "tagBits", 9);
+        uint32_t minHist = config.get<uint32_t>(prefix + "minHist", 5);
+        uint32_t maxHist = config.get<uint32_t>(prefix + "maxHist", 130);
+        return new TAGEBranchPredictor(tables, tableBits, baseBits, tagBits, minHist, maxHist);
+    } else {
+        panic("Invalid branch predictor type %s", type.c_str());
+    }
+}
+
+// Returns nullptr if the core group does not model address translation
+static Mmu* BuildMmu(Config& config, const string& prefix, g_string& name) {
+    if (!config.get<bool>(prefix + "enabled", false)) return nullptr;
+
+    static const char* sizeNames[] = {"4K", "2M", "1G"};
+    uint32_t l1DefEntries[] = {64, 32, 4};
+    uint32_t l1Entries[NUM_PAGE_SIZES];
+    uint32_t l1Ways[NUM_PAGE_SIZES];
+    for (uint32_t s = 0; s < NUM_PAGE_SIZES; s++) {
+        l1Entries[s] = config.get<uint32_t>(prefix + "l1.entries" + sizeNames[s], l1DefEntries[s]);
+        l1Ways[s] = config.get<uint32_t>(prefix + "l1.ways" + sizeNames[s], 4);
+    }
+    uint32_t l2Entries = config.get<uint32_t>(prefix + "l2.entries", 1536);
+    uint32_t l2Ways = config.get<uint32_t>(prefix + "l2.ways", 12);
+    uint32_t l2Latency = config.get<uint32_t>(prefix + "l2.latency", 7);
+    uint32_t pwcEntries = config.get<uint32_t>(prefix + "pwc.entries", 16);
+    uint32_t pwcLatency = config.get<uint32_t>(prefix + "pwc.latency", 1);
+
+    // The hugepage policy is an OS setting, so it is system-wide
+    string policyStr = config.get<const char*>("sys.hugePages.policy", "madvise");
+    string maxSizeStr = config.get<const char*>("sys.hugePages.maxSize", "2M");
+    HugePagePolicy policy;
+    if (policyStr == "never") policy = THP_NEVER;
+    else if (policyStr == "madvise") policy = THP_MADVISE;
+    else if (policyStr == "always") policy = THP_ALWAYS;
+    else panic("Invalid hugepage policy %s, must be never, madvise, or always", policyStr.c_str());
+    PageSize maxPageSize;
+    if (maxSizeStr == "4K") maxPageSize = PAGE_4K;
+    else if (maxSizeStr == "2M") maxPageSize = PAGE_2M;
+    else if (maxSizeStr == "1G") maxPageSize = PAGE_1G;
+    else panic("Invalid max page size %s, must be 4K, 2M, or 1G", maxSizeStr.c_str());
+
+    return new Mmu(l1Entries, l1Ways, l2Entries, l2Ways, l2Latency, pwcEntries, pwcLatency, policy, maxPageSize, name + "-mmu");
+}
+
 static void InitSystem(Config& config) {
     unordered_map<string, string> parentMap; //child -> parent
     unordered_map<string, vector<vector<string>>> childMap; //parent -> children (a parent may have multiple children)
@@ -433,9 +681,16 @@ static void InitSystem(Config& config) {
         return cVec;
     };
 
-    // If a network file is specified, build a Network
+    // If a network file is specified, build a Network; sys.network builds a mesh NoC instead
     string networkFile = config.get<const char*>("sys.networkFile", "");
-    Network* network = (networkFile != "")? new Network(networkFile.c_str()) : nullptr;
+    MeshNetwork* mesh = nullptr;
+    Network* network = nullptr;
+    if (config.exists("sys.network")) {
+        if (networkFile != "") panic("sys.networkFile and sys.network are mutually exclusive");
+        network = mesh = BuildMeshNetwork(config);
+    } else if (networkFile != "") {
+        network = new Network(networkFile.c_str());
+    }
 
     // Build the caches
     vector<const char*> cacheGroupNames;
@@ -494,30 +749,29 @@ static void InitSystem(Config& config) {
      */
 
     //Build the memory controllers
-    uint32_t memControllers = config.get<uint32_t>("sys.mem.controllers", 1);
-    assert(memControllers > 0);
+    g_vector<MemObject*> mems = BuildMemoryControllers(config, "sys.mem.", "mem");
 
-    g_vector<MemObject*> mems;
-    mems.resize(memControllers);
-
-    for (uint32_t i = 0; i < memControllers; i++) {
-        stringstream ss;
-        ss << "mem-" << i;
-        g_string name(ss.str().c_str());
-        //uint32_t domain = nextDomain(); //i*zinfo->numDomains/memControllers;
-        uint32_t domain = i*zinfo->numDomains/memControllers;
-        mems[i] = BuildMemoryController(config, zinfo->lineSize, zinfo->freqMHz, domain, name);
+    // Optional CXL-attached tier behind the local one
+    if (config.exists("sys.mem.cxl")) {
+        g_vector<MemObject*> cxlMems = BuildMemoryControllers(config, "sys.mem.cxl.", "cxlmem");
+        if (mems.size() != 1 || cxlMems.size() != 1) panic("Tiered memory needs splitAddrs on both tiers");
+        mems[0] = BuildTieredMemory(config, mems[0], cxlMems[0]);
     }
 
-    if (memControllers > 1) {
-        bool splitAddrs = config.get<bool>("sys.mem.splitAddrs", true);
-        if (splitAddrs) {
-            MemObject* splitter = new SplitAddrMemory(mems, "mem-splitter");
-            mems.resize(1);
-            mems[0] = splitter;
-        }
+    // Optional near-memory gather-reduce units, one per controller (all cycles are system cycles)
+    if (config.exists("sys.mem.pim")) {
+        zinfo->pimUnit = new PIMUnit(NumMemoryControllers(config, "sys.mem."),
+                config.get<uint32_t>("sys.mem.pim.banks", 16),
+                zinfo->lineSize,
+                config.get<uint32_t>("sys.mem.pim.bankLatency", 40),  // ACT + RD to data at the unit
+                config.get<uint32_t>("sys.mem.pim.bankInterval", 16),  // min cycles between line reads in a bank
+                config.get<uint32_t>("sys.mem.pim.reduceBytesPerCycle", 32),
+                config.get<uint32_t>("sys.mem.pim.transferCycles", 8),  // one line over the DRAM bus
+                config.get<uint32_t>("sys.mem.pim.latency", 20));  // controller <-> unit and core <-> controller
     }
 
+    if (mesh) PlaceOnMesh(config, mesh, cacheGroupNames, cMap, mems);
+
     //Connect everything
     bool printHierarchy = config.get<bool>("sim.printHierarchy", false);
 
@@ -630,15 +884,38 @@ static void InitSystem(Config& config) {
             union {
                 SimpleCore* simpleCores;
                 TimingCore* timingCores;
-                OOOCore* oooCores;
+                uint8_t* oooCores;
                 NullCore* nullCores;
             };
+            OOOCoreBuilder oooBuilder = nullptr;
+            size_t oooCoreSize = 0;
             if (type == "Simple") {
                 simpleCores = gm_memalign<SimpleCore>(CACHE_LINE_BYTES, cores);
             } else if (type == "Timing") {
                 timingCores = gm_memalign<TimingCore>(CACHE_LINE_BYTES, cores);
             } else if (type == "OOO") {
-                oooCores = gm_memalign<OOOCore>(CACHE_LINE_BYTES, cores);
+                string preset = config.get<const char*>(prefix + "preset", "nehalem");
+                if (preset == "nehalem") {
+                    oooBuilder = BuildOOOCore<NehalemOOOCore>;
+                    oooCoreSize = sizeof(NehalemOOOCore);
+                } else if (preset == "skylake") {
+                    oooBuilder = BuildOOOCore<SkylakeOOOCore>;
+                    oooCoreSize = sizeof(SkylakeOOOCore);
+                } else if (preset == "zen") {
+                    oooBuilder = BuildOOOCore<ZenOOOCore>;
+                    oooCoreSize = sizeof(ZenOOOCore);
+                } else if (preset == "wide") {
+                    oooBuilder = BuildOOOCore<WideOOOCore>;
+                    oooCoreSize = sizeof(WideOOOCore);
+                } else {
+                    panic("%s: Invalid OOO core preset %s", group, preset.c_str());
+                }
+                oooCores = gm_memalign<uint8_t>(CACHE_LINE_BYTES, cores*oooCoreSize);
+
+                // Uops are decoded once and shared by all cores, so vector ops follow the first OOO group's preset
+                uint32_t vectorUarch = Decoder::findVectorUarch(preset.c_str());
+                if (!zinfo->oooDecode) zinfo->vectorUarch = vectorUarch;
+                else if (zinfo->vectorUarch != vectorUarch) warn("%s: OOO preset %s differs from other core groups, vector ops are decoded for the first group's preset", group, preset.c_str());
                 zinfo->oooDecode = true; //enable uop decoding, this is false by default, must be true if even one OOO cpu is in the system
             } else if (type == "Null") {
                 nullCores = gm_memalign<NullCore>(CACHE_LINE_BYTES, cores);
@@ -678,6 +955,7 @@ static void InitSystem(Config& config) {
                     FilterCache* dc = dynamic_cast<FilterCache*>(dgroup[assignedCaches[dcache]][0]);
                     assert(dc);
                     dc->setSourceId(coreIdx);
+                    dc->setMmu(BuildMmu(config, prefix + "tlb.", name));
                     assignedCaches[dcache]++;
 
                     //Build the core
@@ -691,7 +969,9 @@ static void InitSystem(Config& config) {
                         core = tcore;
                     } else {
                         assert(type == "OOO");
-                        OOOCore* ocore = new (&oooCores[j]) OOOCore(ic, dc, name);
+                        BranchPredictor* bp = BuildBranchPredictor(config, prefix + "branchPredictor.");
+                        uint32_t profiledBranches = config.get<uint32_t>(prefix + "branchPredictor.profiledBranches", 0);
+                        OOOCore* ocore = oooBuilder(&oooCores[j*oooCoreSize], ic, dc, bp, profiledBranches, name);
                         zinfo->eventRecorders[coreIdx] = ocore->getEventRecorder();
                         zinfo->eventRecorders[coreIdx]->setSourceId(coreIdx);
                         core = ocore;
@@ -712,6 +992,33 @@ static void InitSystem(Config& config) {
             }
         }
 
+        // Optional GEMM accelerator, with a terminal cache of its own as its DMA port
+        if (config.exists("sys.accel")) {
+            string port = config.get<const char*>("sys.accel.port");
+            if (!assignedCaches.count(port)) panic("sys.accel: Invalid port %s, must be a terminal cache group", port.c_str());
+            if (assignedCaches[port] >= cMap[port]->size()) panic("sys.accel: port group %s is fully used by cores", port.c_str());
+            FilterCache* pc = dynamic_cast<FilterCache*>((*cMap[port])[assignedCaches[port]][0]);
+            assert(pc);
+            assignedCaches[port]++;
+            if (coreIdx >= MAX_THREADS) panic("sys.accel: its port needs a source id, but there are already %d cores", coreIdx);
+
+            uint32_t domain = config.get<uint32_t>("sys.accel.domain", 0);
+            if (domain >= zinfo->numDomains) panic("sys.accel: domain %d, but there are only %d domains", domain, zinfo->numDomains);
+            GemmAccel* accel = new GemmAccel(config.get<uint32_t>("sys.accel.rows", 16),
+                    config.get<uint32_t>("sys.accel.cols", 16),
+                    config.get<uint32_t>("sys.accel.scratchpadKB", 256)*1024,
+                    config.get<uint32_t>("sys.accel.dmaOutstanding", 32),
+                    domain, zinfo->lineSize);
+
+            // Record DMA accesses for the weave phase only if some core does
+            bool weave = false;
+            for (uint32_t c = 0; c < coreIdx; c++) weave |= zinfo->eventRecorders[c] != nullptr;
+            accel->setPort(pc, coreIdx /*srcId*/, weave);
+            zinfo->eventRecorders[coreIdx] = accel->getEventRecorder();
+            zinfo->eventQueue->insert(accel->getTickEvent());
+            zinfo->gemmAccel = accel;
+        }
+
         //Check that all the terminal caches are fully connected
         for (const char* grp : cacheGroupNames) {
             if (isTerminal(grp) && assignedCaches[grp] != cMap[grp]->size()) {
@@ -769,8 +1076,12 @@ static void InitSystem(Config& config) {
     AggregateStat* memStat = new AggregateStat(true);
     memStat->init("mem", "Memory controller stats");
     for (auto mem : mems) mem->initStats(memStat);
+    if (zinfo->pimUnit) zinfo->pimUnit->initStats(memStat);
     zinfo->rootStat->append(memStat);
 
+    if (mesh) mesh->initStats(zinfo->rootStat);
+    if (zinfo->gemmAccel) zinfo->gemmAccel->initStats(zinfo->rootStat);
+
     //Odds and ends: BuildCacheGroup new'd the cache groups, we need to delete them
     for (pair<string, CacheGroup*> kv : cMap) delete kv.second;
     cMap.clear();
@@ -855,6 +1166,28 @@ static void InitGlobalStats() {
     ProxyStat* phaseStat = new ProxyStat();
     phaseStat->init("phase", "Simulated phases", &zinfo->numPhases);
     zinfo->rootStat->append(phaseStat);
+
+    AggregateStat* gmStat = new AggregateStat();
+    gmStat->init("galloc", "Global heap allocator stats");
+    ProxyFuncStat* gmAllocs = new ProxyFuncStat();
+    gmAllocs->init("allocs", "Allocations", []() {gm_counters c; gm_get_counters(&c); return c.allocs;});
+    ProxyFuncStat* gmFrees = new ProxyFuncStat();
+    gmFrees->init("frees", "Frees", []() {gm_counters c; gm_get_counters(&c); return c.frees;});
+    ProxyFuncStat* gmHits = new ProxyFuncStat();
+    gmHits->init("cacheHits", "Allocations served from size-class caches", []() {gm_counters c; gm_get_counters(&c); return c.cacheHits;});
+    ProxyFuncStat* gmUncached = new ProxyFuncStat();
+    gmUncached->init("uncached", "Large or aligned allocations from the shared heap", []() {gm_counters c; gm_get_counters(&c); return c.uncached;});
+    ProxyFuncStat* gmRefills = new ProxyFuncStat();
+    gmRefills->init("refills", "Size-class cache refills", []() {gm_counters c; gm_get_counters(&c); return c.refills;});
+    ProxyFuncStat* gmFlushes = new ProxyFuncStat();
+    gmFlushes->init("flushes", "Size-class cache flushes", []() {gm_counters c; gm_get_counters(&c); return c.flushes;});
+    gmStat->append(gmAllocs);
+    gmStat->append(gmFrees);
+    gmStat->append(gmHits);
+    gmStat->append(gmUncached);
+    gmStat->append(gmRefills);
+    gmStat->append(gmFlushes);
+    zinfo->rootStat->append(gmStat);
 }
 
 
@@ -900,9 +1233,10 @@ void SimInit(const char* configFile, const char* outputDir, uint32_t shmid) {
 
     zinfo->numDomains = config.get<uint32_t>("sim.domains", 1);
     uint32_t numSimThreads = config.get<uint32_t>("sim.contentionThreads", MAX((uint32_t)1, zinfo->numDomains/2)); //gives a bit of parallelism, TODO tune
-    zinfo->contentionSim = new ContentionSim(zinfo->numDomains, numSimThreads);
+    bool contentionStealing = config.get<bool>("sim.contentionStealing", false); //balance domains across threads dynamically
+    zinfo->contentionSim = new ContentionSim(zinfo->numDomains, numSimThreads, contentionStealing);
     zinfo->contentionSim->initStats(zinfo->rootStat);
-    zinfo->eventRecorders = gm_calloc<EventRecorder*>(zinfo->numCores);
+    zinfo->eventRecorders = gm_calloc<EventRecorder*>(zinfo->numCores + (config.exists("sys.accel")? 1 : 0)); //the accelerator's DMA port comes after the cores
 
     zinfo->traceWriters = new g_vector<AccessTraceWriter*>();
 
@@ -932,6 +1266,9 @@ void SimInit(const char* configFile, const char* outputDir, uint32_t shmid) {
     zinfo->ffReinstrument = config.get<bool>("sim.ffReinstrument", false);
     if (zinfo->ffReinstrument) warn("sim.ffReinstrument = true, switching fast-forwarding on a multi-threaded process may be unstable");
 
+    string bblCacheDir = config.get<const char*>("sim.bblCacheDir", "");
+    zinfo->bblCacheDir = bblCacheDir.empty()? nullptr : gm_strdup(bblCacheDir.c_str());
+
     zinfo->registerThreads = config.get<bool>("sim.registerThreads", false);
     zinfo->globalPauseFlag = config.get<bool>("sim.startInGlobalPause", false);
 
@@ -112,6 +112,9 @@ struct InvReq {
     bool* writeback;
     uint64_t cycle;
     uint32_t srcId;
+    // Sent to a superset of the sharers (e.g., by a sparse directory whose sharer set overflowed), so the line may
+    // not be present. Such invalidates are just acked.
+    bool imprecise;
 };
 
 /** INTERFACES **/
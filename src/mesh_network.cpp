@@ -0,0 +1,250 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mesh_network.h"
+#include <sstream>
+#include "event_recorder.h"
+#include "timing_event.h"
+#include "zsim.h"
+
+class NoCTraversalEvent : public TimingEvent {
+    private:
+        MeshNetwork* noc;
+        uint32_t srcTile, dstTile, bytes;
+
+    public:
+        NoCTraversalEvent(MeshNetwork* _noc, uint32_t _srcTile, uint32_t _dstTile, uint32_t _bytes)
+            : TimingEvent(0, 0, -1), noc(_noc), srcTile(_srcTile), dstTile(_dstTile), bytes(_bytes) {}
+
+        void simulate(uint64_t startCycle) {
+            done(noc->traverse(srcTile, dstTile, bytes, startCycle));
+        }
+};
+
+MeshNetwork::MeshNetwork(uint32_t _xDim, uint32_t _yDim, bool _torus, Routing _routing,
+        uint32_t _linkBytes, uint32_t _routerDelay, uint32_t _linkDelay, uint32_t _ctrlBytes)
+    : xDim(_xDim), yDim(_yDim), numTiles(_xDim*_yDim), torus(_torus), routing(_routing),
+      linkBytes(_linkBytes), routerDelay(_routerDelay), linkDelay(_linkDelay), ctrlBytes(_ctrlBytes)
+{
+    if (!xDim || !yDim) panic("Mesh network needs at least one tile per dimension (%dx%d)", xDim, yDim);
+    if (!linkBytes) panic("Mesh network links must be at least 1 byte wide");
+    slots = gm_calloc<uint64_t>(numTiles*NUM_DIRS*SLOTS);
+    futex_init(&linkLock);
+    info("Mesh network: %dx%d %s, %s routing, %d-byte links, %d-cycle routers, %d-cycle links", xDim, yDim,
+            torus? "torus" : "mesh", (routing == XY)? "XY" : "adaptive", linkBytes, routerDelay, linkDelay);
+}
+
+void MeshNetwork::initStats(AggregateStat* parentStat) {
+    AggregateStat* nocStat = new AggregateStat();
+    nocStat->init("noc", "Mesh network stats");
+    profMsgs.init("msgs", "Messages");
+    profFlits.init("flits", "Flits injected");
+    profHops.init("hops", "Link traversals");
+    profLat.init("lat", "Cumulative message latency");
+    profZeroLoadLat.init("zlLat", "Cumulative zero-load message latency (lat - zlLat is queueing delay)");
+
+    static const char* dirNames[] = {"E", "W", "N", "S"};
+    uint32_t numLinks = numTiles*NUM_DIRS;
+    const char** linkNames = gm_calloc<const char*>(numLinks);
+    for (uint32_t i = 0; i < numLinks; i++) {
+        std::stringstream ss;
+        ss << (i / NUM_DIRS) << dirNames[i % NUM_DIRS];
+        linkNames[i] = gm_strdup(ss.str().c_str());
+    }
+    profLinkFlits.init("linkFlits", "Flits carried by each tile's output links; utilization is flits/cycles", numLinks, linkNames);
+    gm_free(linkNames);
+
+    nocStat->append(&profMsgs);
+    nocStat->append(&profFlits);
+    nocStat->append(&profHops);
+    nocStat->append(&profLat);
+    nocStat->append(&profZeroLoadLat);
+    nocStat->append(&profLinkFlits);
+    parentStat->append(nocStat);
+}
+
+void MeshNetwork::addNode(const char* name, const g_vector<uint32_t>& tiles) {
+    if (getNode(name) != -1) panic("%s placed twice on the mesh network", name);
+    if (tiles.empty()) panic("%s placed on no tiles", name);
+    for (uint32_t tile : tiles) {
+        if (tile >= numTiles) panic("%s placed on tile %d, but the mesh network has %d tiles", name, tile, numTiles);
+    }
+    Node node;
+    node.name = name;
+    node.tiles = tiles;
+    nodes.push_back(node);
+}
+
+int32_t MeshNetwork::getNode(const char* name) const {
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].name == name) return i;
+    }
+    return -1;
+}
+
+uint32_t MeshNetwork::getRTT(const char* src, const char* dst) {
+    int32_t srcNode = getNode(src);
+    int32_t dstNode = getNode(dst);
+    if (srcNode == -1 || dstNode == -1) {
+        warn("%s and %s are not both on the mesh network, returning 0 latency", src, dst);
+        return 0;
+    }
+
+    // Average over all tile pairs if either is interleaved
+    const g_vector<uint32_t>& srcTiles = nodes[srcNode].tiles;
+    const g_vector<uint32_t>& dstTiles = nodes[dstNode].tiles;
+    uint64_t totalLat = 0;
+    for (uint32_t s : srcTiles) {
+        for (uint32_t d : dstTiles) {
+            totalLat += getLatency(s, d, ctrlBytes) + getLatency(d, s, ctrlBytes);
+        }
+    }
+    return totalLat / (srcTiles.size()*dstTiles.size());
+}
+
+uint32_t MeshNetwork::getLatency(uint32_t srcTile, uint32_t dstTile, uint32_t bytes) const {
+    if (srcTile == dstTile) return 0;
+    // Source router, then a link and a router per hop, then the remaining flits
+    return routerDelay + numHops(srcTile, dstTile)*(linkDelay + routerDelay) + numFlits(bytes) - 1;
+}
+
+void MeshNetwork::recordTraversals(EventRecorder* evRec, uint32_t srcTile, uint32_t dstTile, uint32_t reqBytes,
+        uint32_t respBytes, uint64_t reqCycle, uint64_t respCycle) {
+    if (!evRec || !evRec->hasRecord() || srcTile == dstTile) return;
+    TimingRecord r = evRec->popRecord();
+
+    NoCTraversalEvent* reqEv = new (evRec) NoCTraversalEvent(this, srcTile, dstTile, reqBytes);
+    reqEv->setMinStartCycle(reqCycle);
+    reqEv->addChild(r.startEvent, evRec);
+
+    NoCTraversalEvent* respEv = new (evRec) NoCTraversalEvent(this, dstTile, srcTile, respBytes);
+    respEv->setMinStartCycle(r.respCycle);
+    r.endEvent->addChild(respEv, evRec);
+
+    TimingRecord tr = {r.addr, reqCycle, respCycle, r.type, reqEv, respEv};
+    evRec->pushRecord(tr);
+}
+
+uint64_t MeshNetwork::traverse(uint32_t srcTile, uint32_t dstTile, uint32_t bytes, uint64_t cycle) {
+    if (srcTile == dstTile) return cycle;
+    uint32_t flits = numFlits(bytes);
+
+    futex_lock(&linkLock);
+    uint64_t headCycle = cycle + routerDelay;  // ready to leave the source router
+    uint64_t tailCycle = headCycle + flits - 1;
+    uint32_t hops = 0;
+    uint32_t cur = srcTile;
+    while (cur != dstTile) {
+        int32_t xDir = dimDir(cur, dstTile, 0, EAST, WEST);
+        int32_t yDir = dimDir(cur, dstTile, 1, NORTH, SOUTH);
+        uint32_t dir;
+        if (xDir == -1) {
+            dir = yDir;
+        } else if (yDir == -1 || routing == XY) {
+            dir = xDir;
+        } else {
+            bool yFirst = firstFree(cur*NUM_DIRS + yDir, headCycle) < firstFree(cur*NUM_DIRS + xDir, headCycle);
+            dir = yFirst? yDir : xDir;
+        }
+
+        uint32_t link = cur*NUM_DIRS + dir;
+        uint64_t lastSlot;
+        uint64_t firstSlot = reserve(link, headCycle, flits, lastSlot);
+        profLinkFlits.inc(link, flits);
+
+        headCycle = firstSlot + linkDelay + routerDelay;
+        tailCycle = MAX(lastSlot, tailCycle) + linkDelay + routerDelay;
+        cur = neighbor(cur, dir);
+        hops++;
+    }
+
+    profMsgs.inc();
+    profFlits.inc(flits);
+    profHops.inc(hops);
+    profLat.inc(tailCycle - cycle);
+    profZeroLoadLat.inc(getLatency(srcTile, dstTile, bytes));
+    futex_unlock(&linkLock);
+    return tailCycle;
+}
+
+uint32_t MeshNetwork::numHops(uint32_t srcTile, uint32_t dstTile) const {
+    uint32_t hops = 0;
+    uint32_t dims[] = {xDim, yDim};
+    uint32_t src[] = {srcTile % xDim, srcTile / xDim};
+    uint32_t dst[] = {dstTile % xDim, dstTile / xDim};
+    for (uint32_t d = 0; d < 2; d++) {
+        uint32_t fwd = (dst[d] + dims[d] - src[d]) % dims[d];
+        if (torus) hops += MIN(fwd, dims[d] - fwd);
+        else hops += (dst[d] > src[d])? dst[d] - src[d] : src[d] - dst[d];
+    }
+    return hops;
+}
+
+int32_t MeshNetwork::dimDir(uint32_t cur, uint32_t dst, uint32_t dim, Dir pos, Dir neg) const {
+    uint32_t n = dim? yDim : xDim;
+    uint32_t c = dim? cur / xDim : cur % xDim;
+    uint32_t d = dim? dst / xDim : dst % xDim;
+    if (c == d) return -1;
+    if (!torus) return (d > c)? pos : neg;
+    uint32_t fwd = (d + n - c) % n;
+    return (fwd <= n - fwd)? pos : neg;
+}
+
+uint32_t MeshNetwork::neighbor(uint32_t tile, uint32_t dir) const {
+    uint32_t x = tile % xDim;
+    uint32_t y = tile / xDim;
+    switch (dir) {
+        case EAST: x = (x + 1) % xDim; break;
+        case WEST: x = (x + xDim - 1) % xDim; break;
+        case NORTH: y = (y + 1) % yDim; break;
+        case SOUTH: y = (y + yDim - 1) % yDim; break;
+        default: panic("Invalid direction %d", dir);
+    }
+    return y*xDim + x;
+}
+
+uint64_t MeshNetwork::firstFree(uint32_t link, uint64_t cycle) const {
+    const uint64_t* cal = &slots[link*SLOTS];
+    uint64_t c = cycle;
+    while (cal[c & (SLOTS-1)] == c + 1) c++;
+    return c;
+}
+
+uint64_t MeshNetwork::reserve(uint32_t link, uint64_t cycle, uint32_t flits, uint64_t& last) {
+    assert(flits);
+    uint64_t* cal = &slots[link*SLOTS];
+    uint64_t c = cycle;
+    uint64_t first = cycle;
+    last = cycle;
+    for (uint32_t f = 0; f < flits; c++) {
+        uint64_t& slot = cal[c & (SLOTS-1)];
+        if (slot == c + 1) continue;  // busy
+        slot = c + 1;
+        if (f == 0) first = c;
+        last = c;
+        f++;
+    }
+    return first;
+}
@@ -0,0 +1,135 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MESH_NETWORK_H_
+#define MESH_NETWORK_H_
+
+#include "g_std/g_string.h"
+#include "g_std/g_vector.h"
+#include "galloc.h"
+#include "locks.h"
+#include "memory_hierarchy.h"
+#include "network.h"
+#include "pad.h"
+#include "stats.h"
+
+class EventRecorder;
+
+/* 2D mesh or torus NoC. Caches and memory controllers are placed on tiles
+ * (an entity that fronts several controllers, like SplitAddrMemory, is placed
+ * on all of their tiles and reached by line address, as the splitter does).
+ *
+ * Messages are split into linkBytes flits. Each hop goes through a router
+ * pipeline of routerDelay cycles and a link of linkDelay cycles, and each
+ * link carries one flit per cycle. Routing is dimension-ordered (XY), or
+ * minimal adaptive: when both dimensions are productive, take the output
+ * link that frees up first. Torus links wrap around, and each dimension
+ * goes the short way.
+ *
+ * The bound phase only sees zero-load latencies. In the weave phase, each
+ * request to a parent and its response traverse the network as events that
+ * reserve flit slots on every link of their route, so concurrent coherence
+ * and LLC bank traffic queue behind each other. Each link keeps a calendar of
+ * its next SLOTS cycles instead of a single free cycle, so that domains that
+ * run behind in the weave phase can still use the link's past idle cycles.
+ * Invalidations keep their zero-load bound-phase latency.
+ */
+class MeshNetwork : public Network, public GlobAlloc {
+    public:
+        enum Routing {XY, ADAPTIVE};
+        enum Dir {EAST = 0, WEST = 1, NORTH = 2, SOUTH = 3, NUM_DIRS = 4};
+
+    private:
+        static const uint32_t SLOTS = 1024;  // per-link calendar, power of 2
+
+        struct Node {
+            g_string name;
+            g_vector<uint32_t> tiles;  // interleaved by line address if more than one
+        };
+
+        const uint32_t xDim, yDim, numTiles;
+        const bool torus;
+        const Routing routing;
+        const uint32_t linkBytes, routerDelay, linkDelay, ctrlBytes;
+        g_vector<Node> nodes;
+
+        // links[tile*NUM_DIRS + dir] is the output link of tile towards dir.
+        // slot c % SLOTS of a link holds c+1 if the link is busy on cycle c
+        uint64_t* slots;
+        lock_t linkLock;
+
+        PAD();
+        Counter profMsgs, profFlits, profHops, profLat, profZeroLoadLat;
+        VectorCounter profLinkFlits;
+        PAD();
+
+    public:
+        MeshNetwork(uint32_t _xDim, uint32_t _yDim, bool _torus, Routing _routing,
+                uint32_t _linkBytes, uint32_t _routerDelay, uint32_t _linkDelay, uint32_t _ctrlBytes);
+
+        void initStats(AggregateStat* parentStat);
+
+        // Placement, at initialization
+        void addNode(const char* name, const g_vector<uint32_t>& tiles);
+        int32_t getNode(const char* name) const;  // -1 if not on the network
+
+        uint32_t getNumTiles() const { return numTiles; }
+        uint32_t getCtrlBytes() const { return ctrlBytes; }
+        uint32_t getTile(uint32_t node, Address lineAddr) const {
+            const g_vector<uint32_t>& tiles = nodes[node].tiles;
+            return tiles[lineAddr % tiles.size()];
+        }
+
+        // Zero-load round trip of a control message and its response
+        uint32_t getRTT(const char* src, const char* dst);
+
+        // Zero-load latency of a bytes-long message
+        uint32_t getLatency(uint32_t srcTile, uint32_t dstTile, uint32_t bytes) const;
+
+        /* Bound phase: if the access just sent to dstTile left a timing record
+         * in evRec, wraps it with the request and response traversals.
+         * reqCycle and respCycle are the cycles the request leaves and the
+         * response arrives back at srcTile.
+         */
+        void recordTraversals(EventRecorder* evRec, uint32_t srcTile, uint32_t dstTile, uint32_t reqBytes,
+                uint32_t respBytes, uint64_t reqCycle, uint64_t respCycle);
+
+        // Weave phase: returns the cycle the last flit arrives at dstTile
+        uint64_t traverse(uint32_t srcTile, uint32_t dstTile, uint32_t bytes, uint64_t cycle);
+
+    private:
+        uint32_t numFlits(uint32_t bytes) const { return bytes? (bytes + linkBytes - 1) / linkBytes : 1; }
+        uint32_t numHops(uint32_t srcTile, uint32_t dstTile) const;
+
+        // Productive direction in one dimension (-1 if already there)
+        int32_t dimDir(uint32_t cur, uint32_t dst, uint32_t dim, Dir pos, Dir neg) const;
+        uint32_t neighbor(uint32_t tile, uint32_t dir) const;
+
+        // First cycle >= cycle on which link is free
+        uint64_t firstFree(uint32_t link, uint64_t cycle) const;
+        // Reserves flits (>= 1) slots from cycle on, returns the first one and sets last to the last one
+        uint64_t reserve(uint32_t link, uint64_t cycle, uint32_t flits, uint64_t& last);
+};
+
+#endif  // MESH_NETWORK_H_
@@ -39,9 +39,13 @@ class Network {
     private:
         std::unordered_map<std::string, uint32_t> delayMap;
 
+    protected:
+        Network() {}  // for networks that compute their delays (see mesh_network.h)
+
     public:
         explicit Network(const char* filename);
-        uint32_t getRTT(const char* src, const char* dst);
+        virtual ~Network() {}
+        virtual uint32_t getRTT(const char* src, const char* dst);
 };
 
 #endif  // NETWORK_H_
@@ -44,6 +44,8 @@ class NullCore : public Core {
         uint64_t getInstrs() const {return instrs;}
         uint64_t getPhaseCycles() const;
         uint64_t getCycles() const {return instrs; /*IPC=1*/ }
+        uint64_t getCurCycle() const {return curCycle;}
+        void stallUntil(uint64_t cycle) {}  // IPC=1, no stalls
 
         void contextSwitch(int32_t gid);
         virtual void join();
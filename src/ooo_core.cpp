@@ -41,22 +41,14 @@
 #define DEBUG_MSG(args...)
 //#define DEBUG_MSG(args...) info(args)
 
-// Core parameters
-// TODO(dsm): Make OOOCore templated, subsuming these
-
-// Stages --- more or less matched to Westmere, but have not seen detailed pipe diagrams anywhare
-#define FETCH_STAGE 1
-#define DECODE_STAGE 4  // NOTE: Decoder adds predecode delays to decode
-#define ISSUE_STAGE 7
-#define DISPATCH_STAGE 13  // RAT + ROB + RS, each is easily 2 cycles
-
-#define L1D_LAT 4  // fixed, and FilterCache does not include L1 delay
-#define FETCH_BYTES_PER_CYCLE 16
-#define ISSUES_PER_CYCLE 4
-#define RF_READS_PER_CYCLE 3
-
-OOOCore::OOOCore(FilterCache* _l1i, FilterCache* _l1d, g_string& _name) : Core(_name), l1i(_l1i), l1d(_l1d), cRec(0, _name) {
-    decodeCycle = DECODE_STAGE;  // allow subtracting from it
+template <typename Config>
+OOOCoreImpl<Config>::OOOCoreImpl(FilterCache* _l1i, FilterCache* _l1d, BranchPredictor* _branchPred, uint32_t profiledBranches, g_string& _name)
+    : OOOCore(_name), l1i(_l1i), l1d(_l1d), branchPred(_branchPred), cRec(0, Config::FILL_BUFFERS, _name)
+{
+    if (!branchPred) branchPred = new typename Config::DefaultBranchPredictor();
+    branchProfiler.init(profiledBranches);
+
+    decodeCycle = Config::DECODE_STAGE;  // allow subtracting from it
     curCycle = 0;
     phaseEndCycle = zinfo->phaseLength;
 
@@ -76,7 +68,8 @@ OOOCore::OOOCore(FilterCache* _l1i, FilterCache* _l1d, g_string& _name) : Core(_
     for (uint32_t i = 0; i < FWD_ENTRIES; i++) fwdArray[i].set((Address)(-1L), 0);
 }
 
-void OOOCore::initStats(AggregateStat* parentStat) {
+template <typename Config>
+void OOOCoreImpl<Config>::initStats(AggregateStat* parentStat) {
     AggregateStat* coreStat = new AggregateStat();
     coreStat->init(name.c_str(), "Core stats");
 
@@ -107,6 +100,16 @@ void OOOCore::initStats(AggregateStat* parentStat) {
     coreStat->append(approxInstrsStat);
     coreStat->append(mispredBranchesStat);
 
+    fbOccupancy.init("fbOcc", "Fill buffers in use when each L1D miss issued", Config::FILL_BUFFERS + 1);
+    fbStalls.init("fbStalls", "L1D misses that waited for a free fill buffer");
+    fbStallCycles.init("fbStallCycles", "Cycles L1D misses waited for a free fill buffer");
+    coreStat->append(&fbOccupancy);
+    coreStat->append(&fbStalls);
+    coreStat->append(&fbStallCycles);
+
+    branchPred->initStats(coreStat);
+    branchProfiler.initStats(coreStat);
+
 #ifdef OOO_STALL_STATS
     profFetchStalls.init("fetchStalls",  "Fetch stalls");  coreStat->append(&profFetchStalls);
     profDecodeStalls.init("decodeStalls", "Decode stalls"); coreStat->append(&profDecodeStalls);
@@ -116,10 +119,13 @@ void OOOCore::initStats(AggregateStat* parentStat) {
     parentStat->append(coreStat);
 }
 
-uint64_t OOOCore::getInstrs() const {return instrs;}
-uint64_t OOOCore::getPhaseCycles() const {return curCycle % zinfo->phaseLength;}
+template <typename Config>
+uint64_t OOOCoreImpl<Config>::getInstrs() const {return instrs;}
+template <typename Config>
+uint64_t OOOCoreImpl<Config>::getPhaseCycles() const {return curCycle % zinfo->phaseLength;}
 
-void OOOCore::contextSwitch(int32_t gid) {
+template <typename Config>
+void OOOCoreImpl<Config>::contextSwitch(int32_t gid) {
     if (gid == -1) {
         // Do not execute previous BBL, as we were context-switched
         prevBbl = nullptr;
@@ -131,31 +137,47 @@ void OOOCore::contextSwitch(int32_t gid) {
 }
 
 
-InstrFuncPtrs OOOCore::GetFuncPtrs() {return {LoadFunc, StoreFunc, BblFunc, BranchFunc, PredLoadFunc, PredStoreFunc, FPTR_ANALYSIS, {0}};}
+template <typename Config>
+InstrFuncPtrs OOOCoreImpl<Config>::GetFuncPtrs() {return {LoadFunc, StoreFunc, BblFunc, BranchFunc, PredLoadFunc, PredStoreFunc, FPTR_ANALYSIS, {0}};}
 
-inline void OOOCore::load(Address addr) {
+template <typename Config>
+inline void OOOCoreImpl<Config>::load(Address addr) {
     loadAddrs[loads++] = addr;
 }
 
-void OOOCore::store(Address addr) {
+template <typename Config>
+void OOOCoreImpl<Config>::store(Address addr) {
     storeAddrs[stores++] = addr;
 }
 
 // Predicated loads and stores call this function, gets recorded as a 0-cycle op.
 // Predication is rare enough that we don't need to model it perfectly to be accurate (i.e. the uops still execute, retire, etc), but this is needed for correctness.
-void OOOCore::predFalseMemOp() {
+template <typename Config>
+void OOOCoreImpl<Config>::predFalseMemOp() {
     // I'm going to go out on a limb and assume just loads are predicated (this will not fail silently if it's a store)
     loadAddrs[loads++] = -1L;
 }
 
-void OOOCore::branch(Address pc, bool taken, Address takenNpc, Address notTakenNpc) {
+template <typename Config>
+void OOOCoreImpl<Config>::branch(Address pc, bool taken, Address takenNpc, Address notTakenNpc) {
     branchPc = pc;
     branchTaken = taken;
     branchTakenNpc = takenNpc;
     branchNotTakenNpc = notTakenNpc;
 }
 
-inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
+template <typename Config>
+inline uint32_t OOOCoreImpl<Config>::allocFillBuffer(uint64_t readyCycle, uint64_t missCycle, uint64_t respCycle) {
+    if (missCycle > readyCycle) {
+        fbStalls.inc();
+        fbStallCycles.inc(missCycle - readyCycle);
+    }
+    fbOccupancy.inc(MIN(fillBuffers.occupancy(missCycle), Config::FILL_BUFFERS));
+    return fillBuffers.alloc(respCycle);
+}
+
+template <typename Config>
+inline void OOOCoreImpl<Config>::bbl(Address bblAddr, BblInfo* bblInfo) {
     if (!prevBbl) {
         // This is the 1st BBL since scheduled, nothing to simulate
         prevBbl = bblInfo;
@@ -196,8 +218,8 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
         prevDecCycle = uop->decCycle;
         uopQueue.markLeave(curCycle);
 
-        // Implement issue width limit --- we can only issue 4 uops/cycle
-        if (curCycleIssuedUops >= ISSUES_PER_CYCLE) {
+        // Implement issue width limit --- we can only issue ISSUES_PER_CYCLE uops/cycle
+        if (curCycleIssuedUops >= Config::ISSUES_PER_CYCLE) {
 #ifdef OOO_STALL_STATS
             profIssueStalls.inc();
 #endif
@@ -218,8 +240,8 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
         // RF read stalls
         // if srcs are not available at issue time, we have to go thru the RF
         curCycleRFReads += ((c0 < curCycle)? 1 : 0) + ((c1 < curCycle)? 1 : 0);
-        if (curCycleRFReads > RF_READS_PER_CYCLE) {
-            curCycleRFReads -= RF_READS_PER_CYCLE;
+        if (curCycleRFReads > Config::RF_READS_PER_CYCLE) {
+            curCycleRFReads -= Config::RF_READS_PER_CYCLE;
             curCycleIssuedUops = 0;  // or 1? that's probably a 2nd-order detail
             insWindow.advancePos(curCycle);
         }
@@ -230,7 +252,7 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
         uint64_t cOps = MAX(c0, c1);
 
         // Model RAT + ROB + RS delay between issue and dispatch
-        uint64_t dispatchCycle = MAX(cOps, MAX(c2, c3) + (DISPATCH_STAGE - ISSUE_STAGE));
+        uint64_t dispatchCycle = MAX(cOps, MAX(c2, c3) + (Config::DISPATCH_STAGE - Config::ISSUE_STAGE));
 
         // info("IW 0x%lx %d %ld %ld %x", bblAddr, i, c2, dispatchCycle, uop->portMask);
         // NOTE: Schedule can adjust both cur and dispatch cycles
@@ -268,8 +290,11 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
                     Address addr = loadAddrs[loadIdx++];
                     uint64_t reqSatisfiedCycle = dispatchCycle;
                     if (addr != ((Address)-1L)) {
-                        reqSatisfiedCycle = l1d->load(addr, dispatchCycle) + L1D_LAT;
-                        cRec.record(curCycle, dispatchCycle, reqSatisfiedCycle);
+                        uint64_t missCycle, readyCycle;
+                        uint64_t respCycle = l1d->load(addr, dispatchCycle, fillBuffers.minAllocCycle(), missCycle, readyCycle);
+                        uint32_t fb = missCycle? allocFillBuffer(readyCycle, missCycle, respCycle) : OOOCoreRecorder::NO_FILL_BUFFER;
+                        reqSatisfiedCycle = respCycle + Config::L1D_LAT;
+                        cRec.record(curCycle, dispatchCycle, reqSatisfiedCycle, fb);
                     }
 
                     // Enforce st-ld forwarding
@@ -305,8 +330,11 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
                     dispatchCycle = MAX(lastStoreAddrCommitCycle+1, dispatchCycle);
 
                     Address addr = storeAddrs[storeIdx++];
-                    uint64_t reqSatisfiedCycle = l1d->store(addr, dispatchCycle) + L1D_LAT;
-                    cRec.record(curCycle, dispatchCycle, reqSatisfiedCycle);
+                    uint64_t missCycle, readyCycle;
+                    uint64_t respCycle = l1d->store(addr, dispatchCycle, fillBuffers.minAllocCycle(), missCycle, readyCycle);
+                    uint32_t fb = missCycle? allocFillBuffer(readyCycle, missCycle, respCycle) : OOOCoreRecorder::NO_FILL_BUFFER;
+                    uint64_t reqSatisfiedCycle = respCycle + Config::L1D_LAT;
+                    cRec.record(curCycle, dispatchCycle, reqSatisfiedCycle, fb);
 
                     // Fill the forwarding table
                     fwdArray[(addr>>2) & (FWD_ENTRIES-1)].set(addr, reqSatisfiedCycle);
@@ -370,11 +398,13 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
      */
 
     // Model fetch-decode delay (fixed, weak predec/IQ assumption)
-    uint64_t fetchCycle = decodeCycle - (DECODE_STAGE - FETCH_STAGE);
+    uint64_t fetchCycle = decodeCycle - (Config::DECODE_STAGE - Config::FETCH_STAGE);
     uint32_t lineSize = 1 << lineBits;
 
     // Simulate branch prediction
-    if (branchPc && !branchPred.predict(branchPc, branchTaken)) {
+    bool mispred = branchPc && !branchPred->predict(branchPc, branchTaken);
+    if (branchPc) branchProfiler.record(branchPc, mispred);
+    if (mispred) {
         mispredBranches++;
 
         /* Simulate wrong-path fetches
@@ -411,7 +441,7 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
                 break;
             }
             // Model fetch throughput limit
-            reqCycle = respCycle + lineSize/FETCH_BYTES_PER_CYCLE;
+            reqCycle = respCycle + lineSize/Config::FETCH_BYTES_PER_CYCLE;
         }
 
         fetchCycle = lastCommitCycle;
@@ -433,7 +463,7 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
     // If fetch rules, take into account delay between fetch and decode;
     // If decode rules, different BBLs make the decoders skip a cycle
     decodeCycle++;
-    uint64_t minFetchDecCycle = fetchCycle + (DECODE_STAGE - FETCH_STAGE);
+    uint64_t minFetchDecCycle = fetchCycle + (Config::DECODE_STAGE - Config::FETCH_STAGE);
     if (minFetchDecCycle > decodeCycle) {
 #ifdef OOO_STALL_STATS
         profFetchStalls.inc(decodeCycle - minFetchDecCycle);
@@ -443,7 +473,8 @@ inline void OOOCore::bbl(Address bblAddr, BblInfo* bblInfo) {
 }
 
 // Timing simulation code
-void OOOCore::join() {
+template <typename Config>
+void OOOCoreImpl<Config>::join() {
     DEBUG_MSG("[%s] Joining, curCycle %ld phaseEnd %ld", name.c_str(), curCycle, phaseEndCycle);
     uint64_t targetCycle = cRec.notifyJoin(curCycle);
     if (targetCycle > curCycle) advance(targetCycle);
@@ -452,24 +483,34 @@ void OOOCore::join() {
     DEBUG_MSG("[%s] Joined, curCycle %ld phaseEnd %ld", name.c_str(), curCycle, phaseEndCycle);
 }
 
-void OOOCore::leave() {
+template <typename Config>
+void OOOCoreImpl<Config>::leave() {
     DEBUG_MSG("[%s] Leaving, curCycle %ld phaseEnd %ld", name.c_str(), curCycle, phaseEndCycle);
     cRec.notifyLeave(curCycle);
 }
 
-void OOOCore::cSimStart() {
+template <typename Config>
+void OOOCoreImpl<Config>::cSimStart() {
     uint64_t targetCycle = cRec.cSimStart(curCycle);
     assert(targetCycle >= curCycle);
     if (targetCycle > curCycle) advance(targetCycle);
 }
 
-void OOOCore::cSimEnd() {
+template <typename Config>
+void OOOCoreImpl<Config>::cSimEnd() {
     uint64_t targetCycle = cRec.cSimEnd(curCycle);
     assert(targetCycle >= curCycle);
     if (targetCycle > curCycle) advance(targetCycle);
 }
 
-void OOOCore::advance(uint64_t targetCycle) {
+// Blocking offloads stall fetch until they finish; like cSimEnd, this jumps the whole core forward
+template <typename Config>
+void OOOCoreImpl<Config>::stallUntil(uint64_t cycle) {
+    if (cycle > curCycle) advance(cycle);
+}
+
+template <typename Config>
+void OOOCoreImpl<Config>::advance(uint64_t targetCycle) {
     assert(targetCycle > curCycle);
     decodeCycle += targetCycle - curCycle;
     insWindow.longAdvance(curCycle, targetCycle);
@@ -484,23 +525,28 @@ void OOOCore::advance(uint64_t targetCycle) {
 
 // Pin interface code
 
-void OOOCore::LoadFunc(THREADID tid, ADDRINT addr) {static_cast<OOOCore*>(cores[tid])->load(addr);}
-void OOOCore::StoreFunc(THREADID tid, ADDRINT addr) {static_cast<OOOCore*>(cores[tid])->store(addr);}
+template <typename Config>
+void OOOCoreImpl<Config>::LoadFunc(THREADID tid, ADDRINT addr) {static_cast<OOOCoreImpl<Config>*>(cores[tid])->load(addr);}
+template <typename Config>
+void OOOCoreImpl<Config>::StoreFunc(THREADID tid, ADDRINT addr) {static_cast<OOOCoreImpl<Config>*>(cores[tid])->store(addr);}
 
-void OOOCore::PredLoadFunc(THREADID tid, ADDRINT addr, BOOL pred) {
-    OOOCore* core = static_cast<OOOCore*>(cores[tid]);
+template <typename Config>
+void OOOCoreImpl<Config>::PredLoadFunc(THREADID tid, ADDRINT addr, BOOL pred) {
+    OOOCoreImpl<Config>* core = static_cast<OOOCoreImpl<Config>*>(cores[tid]);
     if (pred) core->load(addr);
     else core->predFalseMemOp();
 }
 
-void OOOCore::PredStoreFunc(THREADID tid, ADDRINT addr, BOOL pred) {
-    OOOCore* core = static_cast<OOOCore*>(cores[tid]);
+template <typename Config>
+void OOOCoreImpl<Config>::PredStoreFunc(THREADID tid, ADDRINT addr, BOOL pred) {
+    OOOCoreImpl<Config>* core = static_cast<OOOCoreImpl<Config>*>(cores[tid]);
     if (pred) core->store(addr);
     else core->predFalseMemOp();
 }
 
-void OOOCore::BblFunc(THREADID tid, ADDRINT bblAddr, BblInfo* bblInfo) {
-    OOOCore* core = static_cast<OOOCore*>(cores[tid]);
+template <typename Config>
+void OOOCoreImpl<Config>::BblFunc(THREADID tid, ADDRINT bblAddr, BblInfo* bblInfo) {
+    OOOCoreImpl<Config>* core = static_cast<OOOCoreImpl<Config>*>(cores[tid]);
     core->bbl(bblAddr, bblInfo);
 
     while (core->curCycle > core->phaseEndCycle) {
@@ -519,7 +565,13 @@ void OOOCore::BblFunc(THREADID tid, ADDRINT bblAddr, BblInfo* bblInfo) {
     }
 }
 
-void OOOCore::BranchFunc(THREADID tid, ADDRINT pc, BOOL taken, ADDRINT takenNpc, ADDRINT notTakenNpc) {
-    static_cast<OOOCore*>(cores[tid])->branch(pc, taken, takenNpc, notTakenNpc);
+template <typename Config>
+void OOOCoreImpl<Config>::BranchFunc(THREADID tid, ADDRINT pc, BOOL taken, ADDRINT takenNpc, ADDRINT notTakenNpc) {
+    static_cast<OOOCoreImpl<Config>*>(cores[tid])->branch(pc, taken, takenNpc, notTakenNpc);
 }
 
+// Presets; see the OOOConfig* structs in ooo_core.h
+template class OOOCoreImpl<OOOConfigNehalem>;
+template class OOOCoreImpl<OOOConfigSkylake>;
+template class OOOCoreImpl<OOOConfigZen>;
+template class OOOCoreImpl<OOOConfigWide>;
@@ -29,6 +29,8 @@
 #include <algorithm>
 #include <queue>
 #include <string>
+#include "bithacks.h"
+#include "branch_predictor.h"
 #include "core.h"
 #include "g_std/g_multimap.h"
 #include "memory_hierarchy.h"
@@ -40,66 +42,6 @@
 
 class FilterCache;
 
-/* 2-level branch predictor:
- *  - L1: Branch history shift registers (bshr): 2^NB entries, HB bits of history/entry, indexed by XOR'd PC
- *  - L2: Pattern history table (pht): 2^LB entries, 2-bit sat counters, indexed by XOR'd bshr contents
- *  NOTE: Assumes LB is in [NB, HB] range for XORing (e.g., HB = 18 and NB = 10, LB = 13 is OK)
- */
-template<uint32_t NB, uint32_t HB, uint32_t LB>
-class BranchPredictorPAg {
-    private:
-        uint32_t bhsr[1 << NB];
-        uint8_t pht[1 << LB];
-
-    public:
-        BranchPredictorPAg() {
-            uint32_t numBhsrs = 1 << NB;
-            uint32_t phtSize = 1 << LB;
-
-            for (uint32_t i = 0; i < numBhsrs; i++) {
-                bhsr[i] = 0;
-            }
-            for (uint32_t i = 0; i < phtSize; i++) {
-                pht[i] = 1;  // weak non-taken
-            }
-
-            static_assert(LB <= HB, "Too many PHT entries");
-            static_assert(LB >= NB, "Too few PHT entries (you'll need more XOR'ing)");
-        }
-
-        // Predicts and updates; returns false if mispredicted
-        inline bool predict(Address branchPc, bool taken) {
-            uint32_t bhsrMask = (1 << NB) - 1;
-            uint32_t histMask = (1 << HB) - 1;
-            uint32_t phtMask  = (1 << LB) - 1;
-
-            // Predict
-            // uint32_t bhsrIdx = ((uint32_t)( branchPc ^ (branchPc >> NB) ^ (branchPc >> 2*NB) )) & bhsrMask;
-            uint32_t bhsrIdx = ((uint32_t)( branchPc >> 1)) & bhsrMask;
-            uint32_t phtIdx = bhsr[bhsrIdx];
-
-            // Shift-XOR-mask to fit in PHT
-            phtIdx ^= (phtIdx & ~phtMask) >> (HB - LB); // take the [HB-1, LB] bits of bshr, XOR with [LB-1, ...] bits
-            phtIdx &= phtMask;
-
-            // If uncommented, behaves like a global history predictor
-            // bhsrIdx = 0;
-            // phtIdx = (bhsr[bhsrIdx] ^ ((uint32_t)branchPc)) & phtMask;
-
-            bool pred = pht[phtIdx] > 1;
-
-            // info("BP Pred: 0x%lx bshr[%d]=%x taken=%d pht=%d pred=%d", branchPc, bhsrIdx, phtIdx, taken, pht[phtIdx], pred);
-
-            // Update
-            pht[phtIdx] = taken? (pred? 3 : (pht[phtIdx]+1)) : (pred? (pht[phtIdx]-1) : 0); //2-bit saturating counter
-            bhsr[bhsrIdx] = ((bhsr[bhsrIdx] << 1) & histMask ) | (taken? 1: 0); //we apply phtMask here, dependence is further away
-
-            // info("BP Update: newPht=%d newBshr=%x", pht[phtIdx], bhsr[bhsrIdx]);
-            return (taken == pred);
-        }
-};
-
-
 template<uint32_t H, uint32_t WSZ>
 class WindowStructure {
     private:
@@ -332,6 +274,43 @@ class ReorderBuffer {
         }
 };
 
+/* L1D fill buffers (MSHRs) cap the misses in flight. Like the LSQs, entries are grabbed in dataflow order: a miss
+ * takes the entry that frees up first, and issues once it is free. Secondary misses to in-flight lines hit in the
+ * FilterCache (with a later availCycle), so they do not take an entry.
+ */
+template<uint32_t SZ>
+class FillBuffers {
+    private:
+        uint64_t freeCycle[SZ];
+        uint32_t minIdx;  // entry that frees up first; only changes on misses, so hits just read it
+
+    public:
+        FillBuffers() {
+            for (uint32_t i = 0; i < SZ; i++) freeCycle[i] = 0;
+            minIdx = 0;
+        }
+
+        inline uint64_t minAllocCycle() const {
+            return freeCycle[minIdx];
+        }
+
+        inline uint32_t occupancy(uint64_t cycle) const {
+            uint32_t occ = 0;
+            for (uint32_t i = 0; i < SZ; i++) occ += (freeCycle[i] > cycle)? 1 : 0;
+            return occ;
+        }
+
+        // Takes the entry that frees up first until respCycle, returns its index
+        inline uint32_t alloc(uint64_t respCycle) {
+            uint32_t entry = minIdx;
+            freeCycle[entry] = MAX(freeCycle[entry], respCycle);
+            for (uint32_t i = 0; i < SZ; i++) {
+                if (freeCycle[i] < freeCycle[minIdx]) minIdx = i;
+            }
+            return entry;
+        }
+};
+
 // Similar to ReorderBuffer, but must have in-order allocations and retires (--> faster)
 template<uint32_t SZ>
 class CycleQueue {
@@ -356,9 +335,130 @@ class CycleQueue {
         }
 };
 
+/* Core microarchitecture configurations. OOOCoreImpl is templated on one of these, so all structure sizes,
+ * widths and stage depths are compile-time constants in the bbl() hot path. Presets are selected per core
+ * group with sys.cores.<group>.preset (see init.cpp).
+ *
+ * DefaultBranchPredictor is used unless the core group configures a different one.
+ *
+ * NOTE: Port masks, and thus the execution width of the IW, come from the decoder, which models Nehalem's 6
+ * ports. The WindowStructure supports up to 8 ports.
+ */
+
+// Nehalem/Westmere, the original zsim OOO model
+struct OOOConfigNehalem {
+    // Stages --- more or less matched to Westmere, but have not seen detailed pipe diagrams anywhare
+    static const uint32_t FETCH_STAGE = 1;
+    static const uint32_t DECODE_STAGE = 4;  // NOTE: Decoder adds predecode delays to decode
+    static const uint32_t ISSUE_STAGE = 7;
+    static const uint32_t DISPATCH_STAGE = 13;  // RAT + ROB + RS, each is easily 2 cycles
+
+    static const uint32_t L1D_LAT = 4;  // fixed, and FilterCache does not include L1 delay
+    static const uint32_t FETCH_BYTES_PER_CYCLE = 16;
+    static const uint32_t ISSUES_PER_CYCLE = 4;
+    static const uint32_t RF_READS_PER_CYCLE = 3;
+
+    static const uint32_t ROB_SIZE = 128;
+    static const uint32_t RETIRE_WIDTH = 4;
+    static const uint32_t IW_SIZE = 36;
+    static const uint32_t LOAD_QUEUE_SIZE = 32;
+    static const uint32_t STORE_QUEUE_SIZE = 32;
+    static const uint32_t UOP_QUEUE_SIZE = 28;
+    static const uint32_t FILL_BUFFERS = 10;
+
+    // Agner's guide says it's a 2-level pred and BHSR is 18 bits, so this is the config that makes sense;
+    // in practice, this is probably closer to the Pentium M's branch predictor, (see Uzelac and Milenkovic,
+    // ISPASS 2009), which get the 18 bits of history through a hybrid predictor (2-level + bimodal + loop)
+    // where a few of the 2-level history bits are in the tag.
+    // Since this is close enough, we'll leave it as is for now. Feel free to reverse-engineer the real thing...
+    // UPDATE: Now pht index is XOR-folded BSHR. This has 6656 bytes total -- not negligible, but not ridiculous.
+    typedef BranchPredictorPAg<11, 18, 14> DefaultBranchPredictor;
+};
+
+// Skylake client core. The PRF removes RF read port stalls, so RF reads never limit issue.
+struct OOOConfigSkylake {
+    static const uint32_t FETCH_STAGE = 1;
+    static const uint32_t DECODE_STAGE = 4;
+    static const uint32_t ISSUE_STAGE = 7;
+    static const uint32_t DISPATCH_STAGE = 13;
+
+    static const uint32_t L1D_LAT = 5;
+    static const uint32_t FETCH_BYTES_PER_CYCLE = 16;
+    static const uint32_t ISSUES_PER_CYCLE = 4;
+    static const uint32_t RF_READS_PER_CYCLE = 2*ISSUES_PER_CYCLE;
+
+    static const uint32_t ROB_SIZE = 224;
+    static const uint32_t RETIRE_WIDTH = 4;
+    static const uint32_t IW_SIZE = 97;
+    static const uint32_t LOAD_QUEUE_SIZE = 72;
+    static const uint32_t STORE_QUEUE_SIZE = 56;
+    static const uint32_t UOP_QUEUE_SIZE = 64;
+    static const uint32_t FILL_BUFFERS = 12;
+
+    typedef BranchPredictorPAg<12, 20, 16> DefaultBranchPredictor;
+};
+
+// Zen 2: 6-wide dispatch, 8-wide retire, 32B/cycle fetch
+struct OOOConfigZen {
+    static const uint32_t FETCH_STAGE = 1;
+    static const uint32_t DECODE_STAGE = 4;
+    static const uint32_t ISSUE_STAGE = 7;
+    static const uint32_t DISPATCH_STAGE = 12;
+
+    static const uint32_t L1D_LAT = 4;
+    static const uint32_t FETCH_BYTES_PER_CYCLE = 32;
+    static const uint32_t ISSUES_PER_CYCLE = 6;
+    static const uint32_t RF_READS_PER_CYCLE = 2*ISSUES_PER_CYCLE;
+
+    static const uint32_t ROB_SIZE = 224;
+    static const uint32_t RETIRE_WIDTH = 8;
+    static const uint32_t IW_SIZE = 92;
+    static const uint32_t LOAD_QUEUE_SIZE = 44;
+    static const uint32_t STORE_QUEUE_SIZE = 48;
+    static const uint32_t UOP_QUEUE_SIZE = 72;
+    static const uint32_t FILL_BUFFERS = 22;
+
+    typedef BranchPredictorPAg<12, 20, 16> DefaultBranchPredictor;
+};
+
+// Wide server core, roughly sized like Golden Cove / Sapphire Rapids
+struct OOOConfigWide {
+    static const uint32_t FETCH_STAGE = 1;
+    static const uint32_t DECODE_STAGE = 5;
+    static const uint32_t ISSUE_STAGE = 8;
+    static const uint32_t DISPATCH_STAGE = 14;
+
+    static const uint32_t L1D_LAT = 5;
+    static const uint32_t FETCH_BYTES_PER_CYCLE = 32;
+    static const uint32_t ISSUES_PER_CYCLE = 6;
+    static const uint32_t RF_READS_PER_CYCLE = 2*ISSUES_PER_CYCLE;
+
+    static const uint32_t ROB_SIZE = 512;
+    static const uint32_t RETIRE_WIDTH = 8;
+    static const uint32_t IW_SIZE = 160;
+    static const uint32_t LOAD_QUEUE_SIZE = 192;
+    static const uint32_t STORE_QUEUE_SIZE = 114;
+    static const uint32_t UOP_QUEUE_SIZE = 144;
+    static const uint32_t FILL_BUFFERS = 16;
+
+    typedef BranchPredictorPAg<13, 22, 18> DefaultBranchPredictor;
+};
+
 struct BblInfo;
 
+/* Common interface of all OOO core presets, used by the contention simulation */
 class OOOCore : public Core {
+    public:
+        explicit OOOCore(g_string& _name) : Core(_name) {}
+
+        // Contention simulation interface
+        virtual EventRecorder* getEventRecorder() = 0;
+        virtual void cSimStart() = 0;
+        virtual void cSimEnd() = 0;
+};
+
+template <typename Config>
+class OOOCoreImpl : public OOOCore {
     private:
         FilterCache* l1i;
         FilterCache* l1d;
@@ -371,7 +471,7 @@ class OOOCore : public Core {
         BblInfo* prevBbl;
 
         //Record load and store addresses
-        Address loadAddrs[256];
+        Address loadAddrs[1024];  // gathers issue one load per element
         Address storeAddrs[256];
         uint32_t loads;
         uint32_t stores;
@@ -382,10 +482,13 @@ class OOOCore : public Core {
         //LSU queues are modeled like the ROB. Surprising? Entries are grabbed in dataflow order,
         //and for ordering purposes should leave in program order. In reality they are associative
         //buffers, but we split the associative component from the limited-size modeling.
-        //NOTE: We do not model the 10-entry fill buffer here; the weave model should take care
-        //to not overlap more than 10 misses.
-        ReorderBuffer<32, 4> loadQueue;
-        ReorderBuffer<32, 4> storeQueue;
+        ReorderBuffer<Config::LOAD_QUEUE_SIZE, Config::RETIRE_WIDTH> loadQueue;
+        ReorderBuffer<Config::STORE_QUEUE_SIZE, Config::RETIRE_WIDTH> storeQueue;
+
+        //L1D misses in flight are capped by the fill buffers, in both the bound and weave phases
+        FillBuffers<Config::FILL_BUFFERS> fillBuffers;
+        VectorCounter fbOccupancy;  // entries in use when each miss issues
+        Counter fbStalls, fbStallCycles;
 
         uint32_t curCycleRFReads; //for RF read stalls
         uint32_t curCycleIssuedUops; //for uop issue limits
@@ -393,17 +496,11 @@ class OOOCore : public Core {
         //This would be something like the Atom... (but careful, the iw probably does not allow 2-wide when configured with 1 slot)
         //WindowStructure<1024, 1 /*size*/, 2 /*width*/> insWindow; //this would be something like an Atom, except all the instruction pairing business...
 
-        //Nehalem
-        WindowStructure<1024, 36 /*size*/> insWindow; //NOTE: IW width is implicitly determined by the decoder, which sets the port masks according to uop type
-        ReorderBuffer<128, 4> rob;
+        WindowStructure<1024, Config::IW_SIZE> insWindow; //NOTE: IW width is implicitly determined by the decoder, which sets the port masks according to uop type
+        ReorderBuffer<Config::ROB_SIZE, Config::RETIRE_WIDTH> rob;
 
-        // Agner's guide says it's a 2-level pred and BHSR is 18 bits, so this is the config that makes sense;
-        // in practice, this is probably closer to the Pentium M's branch predictor, (see Uzelac and Milenkovic,
-        // ISPASS 2009), which get the 18 bits of history through a hybrid predictor (2-level + bimodal + loop)
-        // where a few of the 2-level history bits are in the tag.
-        // Since this is close enough, we'll leave it as is for now. Feel free to reverse-engineer the real thing...
-        // UPDATE: Now pht index is XOR-folded BSHR. This has 6656 bytes total -- not negligible, but not ridiculous.
-        BranchPredictorPAg<11, 18, 14> branchPred;
+        BranchPredictor* branchPred;
+        BranchProfiler branchProfiler;
 
         Address branchPc;  //0 if last bbl was not a conditional branch
         bool branchTaken;
@@ -411,7 +508,7 @@ class OOOCore : public Core {
         Address branchNotTakenNpc;
 
         uint64_t decodeCycle;
-        CycleQueue<28> uopQueue;  // models issue queue
+        CycleQueue<Config::UOP_QUEUE_SIZE> uopQueue;  // models issue queue
 
         uint64_t instrs, uops, bbls, approxInstrs, mispredBranches;
 
@@ -434,13 +531,16 @@ class OOOCore : public Core {
         OOOCoreRecorder cRec;
 
     public:
-        OOOCore(FilterCache* _l1i, FilterCache* _l1d, g_string& _name);
+        // A null _branchPred selects the preset's DefaultBranchPredictor
+        OOOCoreImpl(FilterCache* _l1i, FilterCache* _l1d, BranchPredictor* _branchPred, uint32_t profiledBranches, g_string& _name);
 
         void initStats(AggregateStat* parentStat);
 
         uint64_t getInstrs() const;
         uint64_t getPhaseCycles() const;
         uint64_t getCycles() const {return cRec.getUnhaltedCycles(curCycle);}
+        uint64_t getCurCycle() const {return curCycle;}
+        void stallUntil(uint64_t cycle);
 
         void contextSwitch(int32_t gid);
 
@@ -450,7 +550,7 @@ class OOOCore : public Core {
         InstrFuncPtrs GetFuncPtrs();
 
         // Contention simulation interface
-        inline EventRecorder* getEventRecorder() {return cRec.getEventRecorder();}
+        EventRecorder* getEventRecorder() {return cRec.getEventRecorder();}
         void cSimStart();
         void cSimEnd();
 
@@ -463,8 +563,8 @@ class OOOCore : public Core {
          * jumps.
          *
          * UPDATE: With decodeCycle, this difference is more serious. ONLY
-         * cSimStart and cSimEnd should call advance(). advance() is now meant
-         * to advance the cycle counters in the whole core in lockstep.
+         * cSimStart, cSimEnd and stallUntil should call advance(). advance() is
+         * now meant to advance the cycle counters in the whole core in lockstep.
          */
         inline void advance(uint64_t targetCycle);
 
@@ -476,6 +576,9 @@ class OOOCore : public Core {
 
         inline void bbl(Address bblAddr, BblInfo* bblInfo);
 
+        // Takes a fill buffer for an L1D miss issued at missCycle (ready to issue at readyCycle), returns its index for the weave phase
+        inline uint32_t allocFillBuffer(uint64_t readyCycle, uint64_t missCycle, uint64_t respCycle);
+
         static void LoadFunc(THREADID tid, ADDRINT addr);
         static void StoreFunc(THREADID tid, ADDRINT addr);
         static void PredLoadFunc(THREADID tid, ADDRINT addr, BOOL pred);
@@ -484,4 +587,10 @@ class OOOCore : public Core {
         static void BranchFunc(THREADID tid, ADDRINT pc, BOOL taken, ADDRINT takenNpc, ADDRINT notTakenNpc);
 } ATTR_LINE_ALIGNED;  // Take up an int number of cache lines
 
+// Instantiated in ooo_core.cpp
+typedef OOOCoreImpl<OOOConfigNehalem> NehalemOOOCore;
+typedef OOOCoreImpl<OOOConfigSkylake> SkylakeOOOCore;
+typedef OOOCoreImpl<OOOConfigZen> ZenOOOCore;
+typedef OOOCoreImpl<OOOConfigWide> WideOOOCore;
+
 #endif  // OOO_CORE_H_
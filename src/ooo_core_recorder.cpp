@@ -100,9 +100,12 @@ bool OOOCoreRecorder::CompareRespEvents::operator()(const FutureResponse& e1, co
 }
 
 
-OOOCoreRecorder::OOOCoreRecorder(uint32_t _domain, g_string& _name)
+OOOCoreRecorder::OOOCoreRecorder(uint32_t _domain, uint32_t _fillBuffers, g_string& _name)
     : domain(_domain), name(_name + "-rec")
 {
+    fillBufferResps.resize(_fillBuffers);
+    for (FutureResponse& fr : fillBufferResps) fr = {0, nullptr};
+
     state = HALTED;
     gapCycles = 0;
     eventRecorder.setGapCycles(gapCycles);
@@ -213,7 +216,7 @@ S& GetPrioQueueContainer(std::priority_queue<T, S, C>& q) {
     return PQE::Container(q);
 }
 
-void OOOCoreRecorder::recordAccess(uint64_t curCycle, uint64_t dispatchCycle, uint64_t respCycle) {
+void OOOCoreRecorder::recordAccess(uint64_t curCycle, uint64_t dispatchCycle, uint64_t respCycle, uint32_t fillBuffer) {
     assert(eventRecorder.hasRecord());
     TimingRecord tr = eventRecorder.popRecord();
 
@@ -240,10 +243,13 @@ void OOOCoreRecorder::recordAccess(uint64_t curCycle, uint64_t dispatchCycle, ui
                 fr.ev->addChild(dl, eventRecorder)->addChild(dispEv, eventRecorder);
             }
         }
-        //Link request
+        //Link request. The request leaves the core through reqEv, a core-domain join point where the fill buffer
+        //dependence (below) also lands, so the crossing produced from lastEvProduced covers both
         DelayEvent* dUp = new (eventRecorder) DelayEvent(tr.reqCycle - dispatchCycle); //TODO: remove, postdelay in dispatch...
         dUp->setMinStartCycle(dispatchCycle);
-        lastEvProduced->addChild(dDisp, eventRecorder)->addChild(dispEv, eventRecorder)->addChild(dUp, eventRecorder)->addChild(tr.startEvent, eventRecorder);
+        DelayEvent* reqEv = new (eventRecorder) DelayEvent(0);
+        reqEv->setMinStartCycle(tr.reqCycle);
+        lastEvProduced->addChild(dDisp, eventRecorder)->addChild(dispEv, eventRecorder)->addChild(dUp, eventRecorder)->addChild(reqEv, eventRecorder)->addChild(tr.startEvent, eventRecorder);
 
         //Link response
         assert(respCycle >= tr.respCycle);
@@ -255,6 +261,18 @@ void OOOCoreRecorder::recordAccess(uint64_t curCycle, uint64_t dispatchCycle, ui
         tr.endEvent->addChild(respEvent, eventRecorder);
         TRACE_MSG("Adding resp zllCycle %ld delay %ld", respCycle - gapCycles, respCycle-curCycle);
         futureResponses.push({zllStartCycle, respEvent});
+
+        //Link with the previous miss on the same fill buffer, if it was still outstanding at dispatch
+        if (fillBuffer != NO_FILL_BUFFER) {
+            FutureResponse& prev = fillBufferResps[fillBuffer];
+            if (prev.ev && prev.zllStartCycle > zllDispatchCycle) {
+                uint64_t zllReqCycle = tr.reqCycle - gapCycles;
+                DelayEvent* dFb = new (eventRecorder) DelayEvent((zllReqCycle > prev.zllStartCycle)? (zllReqCycle - prev.zllStartCycle) : 0);
+                prev.ev->addChild(dFb, eventRecorder)->addChild(reqEv, eventRecorder);
+                TRACE_MSG("linked Req zll %ld with fill buffer %d Resp zll %ld", zllReqCycle, fillBuffer, prev.zllStartCycle);
+            }
+            prev = {zllStartCycle, respEvent};
+        }
     } else {
         //info("Handling PUT: curCycle %ld", curCycle);
         assert(IsPut(tr.type));
@@ -296,6 +314,7 @@ uint64_t OOOCoreRecorder::cSimStart(uint64_t curCycle) {
         //Drain futureResponses... we could be a bit more exact by doing partial drains,
         //but if the thread has not joined back by the end of phase, chances are this is a long leave
         while (!futureResponses.empty()) futureResponses.pop();
+        for (FutureResponse& fr : fillBufferResps) fr.ev = nullptr;
         if (curCycle < nextPhaseCycle) curCycle = nextPhaseCycle; // bring cycle up
     }
     return curCycle;
@@ -342,6 +361,9 @@ uint64_t OOOCoreRecorder::cSimEnd(uint64_t curCycle) {
             fr.ev = nullptr;
         }
     }
+    for (FutureResponse& fr : fillBufferResps) {
+        if (fr.ev && fr.ev->cRec != this) fr.ev = nullptr;
+    }
 
     if (!lastEvProduced) {
         //if we were RUNNING, the phase would have been tapered off
@@ -77,6 +77,10 @@ class OOOCoreRecorder {
 
         std::priority_queue<FutureResponse, g_vector<FutureResponse>, CompareRespEvents> futureResponses;
 
+        // Last response that used each fill buffer; misses that waited for a fill buffer in the bound phase also
+        // wait for the previous response on that fill buffer in the weave phase
+        g_vector<FutureResponse> fillBufferResps;
+
         uint64_t lastEvSimulatedZllStartCycle;
         uint64_t lastEvSimulatedStartCycle;
 
@@ -89,15 +93,17 @@ class OOOCoreRecorder {
         g_string name;
 
     public:
-        OOOCoreRecorder(uint32_t _domain, g_string& _name);
+        static const uint32_t NO_FILL_BUFFER = (uint32_t)-1;
+
+        OOOCoreRecorder(uint32_t _domain, uint32_t _fillBuffers, g_string& _name);
 
         //Methods called in the bound phase
         uint64_t notifyJoin(uint64_t curCycle); //returns th updated curCycle, if it needs updating
         void notifyLeave(uint64_t curCycle);
 
         //This better be inlined 100% of the time, it's called on EVERY access
-        inline void record(uint64_t curCycle, uint64_t dispatchCycle, uint64_t respCycle) {
-            if (unlikely(eventRecorder.hasRecord())) recordAccess(curCycle, dispatchCycle, respCycle);
+        inline void record(uint64_t curCycle, uint64_t dispatchCycle, uint64_t respCycle, uint32_t fillBuffer = NO_FILL_BUFFER) {
+            if (unlikely(eventRecorder.hasRecord())) recordAccess(curCycle, dispatchCycle, respCycle, fillBuffer);
         }
 
         //Methods called between the bound and weave phases
@@ -117,7 +123,7 @@ class OOOCoreRecorder {
         const g_string& getName() const {return name;}
 
     private:
-        void recordAccess(uint64_t curCycle, uint64_t dispatchCycle, uint64_t respCycle);
+        void recordAccess(uint64_t curCycle, uint64_t dispatchCycle, uint64_t respCycle, uint32_t fillBuffer);
         void addIssueEvent(uint64_t evCycle);
 };
 
@@ -29,6 +29,7 @@
 #include "zsim.h"
 
 uint32_t CorePartMapper::getPartition(const MemReq& req) {
+    assert(req.srcId < numCores);
     return req.srcId;
 }
 
@@ -37,6 +38,7 @@ uint32_t InstrDataPartMapper::getPartition(const MemReq& req) {
 }
 
 uint32_t InstrDataCorePartMapper::getPartition(const MemReq& req) {
+    assert(req.srcId < numCores);
     bool instr = req.flags & MemReq::IFETCH;
     return req.srcId + (instr ? numCores : 0); //all instruction partitions come after data partitions
 }
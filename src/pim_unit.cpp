@@ -0,0 +1,120 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "pim_unit.h"
+#include <algorithm>
+#include <string.h>
+#include <vector>
+#include "log.h"
+
+PIMUnit::PIMUnit(uint32_t _numChannels, uint32_t _banksPerChannel, uint32_t _lineSize, uint32_t _bankLatency,
+        uint32_t _bankInterval, uint32_t reduceBytesPerCycle, uint32_t _transferCycles, uint32_t _ctrlLatency)
+    : numChannels(_numChannels), banksPerChannel(_banksPerChannel), lineSize(_lineSize), bankLatency(_bankLatency),
+      bankInterval(_bankInterval), reduceCycles((_lineSize + reduceBytesPerCycle - 1)/reduceBytesPerCycle),
+      transferCycles(_transferCycles), ctrlLatency(_ctrlLatency)
+{
+    assert(numChannels && banksPerChannel && reduceBytesPerCycle);
+    channels = gm_calloc<Channel>(numChannels);
+    for (uint32_t c = 0; c < numChannels; c++) {
+        futex_init(&channels[c].lock);
+        channels[c].unitFreeCycle = 0;
+        channels[c].bankFreeCycles = gm_calloc<uint64_t>(banksPerChannel);
+    }
+    info("PIM: %d channels x %d banks, bank lat/interval %d/%d, %d cycles/line reduce, %d cycles/line transfer",
+            numChannels, banksPerChannel, bankLatency, bankInterval, reduceCycles, transferCycles);
+}
+
+void PIMUnit::initStats(AggregateStat* parentStat) {
+    AggregateStat* pimStats = new AggregateStat();
+    pimStats->init("pim", "Near-memory gather-reduce stats");
+    profOps.init("ops", "Gather-reduce ops"); pimStats->append(&profOps);
+    profLines.init("lines", "Lines gathered"); pimStats->append(&profLines);
+    profTotalLat.init("lat", "Total latency of gather-reduce ops"); pimStats->append(&profTotalLat);
+    profBusBytes.init("busBytes", "DRAM bus bytes moved by gather-reduce ops (partial results)"); pimStats->append(&profBusBytes);
+    profHostBusBytes.init("hostBusBytes", "DRAM bus bytes the same gathers would move if done by the host"); pimStats->append(&profHostBusBytes);
+    parentStat->append(pimStats);
+}
+
+uint64_t PIMUnit::gather(const Address* lineAddrs, uint32_t numLines, uint64_t startCycle) {
+    assert(numLines && numLines <= MAX_LINES);
+    uint64_t unitStartCycle = startCycle + 2*ctrlLatency;  // core -> controller -> unit
+
+    // Bucket lines by channel so that each channel lock is taken once
+    uint32_t numUsed = 0;
+    uint64_t doneCycle = 0;
+    std::vector< std::vector<Address> > chanLines(numChannels);
+    for (uint32_t i = 0; i < numLines; i++) chanLines[lineAddrs[i] % numChannels].push_back(lineAddrs[i] / numChannels);
+
+    for (uint32_t c = 0; c < numChannels; c++) {
+        if (chanLines[c].empty()) continue;
+        numUsed++;
+        Channel& ch = channels[c];
+        futex_lock(&ch.lock);
+        uint64_t unitCycle = std::max(ch.unitFreeCycle, unitStartCycle);
+        for (Address ctrlAddr : chanLines[c]) {
+            uint64_t& bankFree = ch.bankFreeCycles[ctrlAddr % banksPerChannel];
+            uint64_t readCycle = std::max(bankFree, unitStartCycle);
+            bankFree = readCycle + bankInterval;
+            unitCycle = std::max(unitCycle, readCycle + bankLatency) + reduceCycles;
+        }
+        ch.unitFreeCycle = unitCycle;
+        futex_unlock(&ch.lock);
+        doneCycle = std::max(doneCycle, unitCycle + transferCycles);
+    }
+
+    // Controller combines the partials, then responds
+    doneCycle += (numUsed - 1)*reduceCycles + ctrlLatency;
+
+    profOps.atomicInc();
+    profLines.atomicInc(numLines);
+    profTotalLat.atomicInc(doneCycle - startCycle);
+    profBusBytes.atomicInc(numUsed*lineSize);
+    profHostBusBytes.atomicInc(numLines*lineSize);
+    return doneCycle;
+}
+
+void PIMUnit::reduce(uint32_t op, uint8_t* acc, const uint8_t* line, uint32_t bytes) {
+    switch (op) {
+        case SUM_F32:
+        case MAX_F32:
+            for (uint32_t i = 0; i < bytes/sizeof(float); i++) {
+                float a, b;
+                memcpy(&a, acc + i*sizeof(float), sizeof(float));
+                memcpy(&b, line + i*sizeof(float), sizeof(float));
+                a = (op == SUM_F32)? a + b : std::max(a, b);
+                memcpy(acc + i*sizeof(float), &a, sizeof(float));
+            }
+            break;
+        case SUM_I32:
+            for (uint32_t i = 0; i < bytes/sizeof(int32_t); i++) {
+                int32_t a, b;
+                memcpy(&a, acc + i*sizeof(int32_t), sizeof(int32_t));
+                memcpy(&b, line + i*sizeof(int32_t), sizeof(int32_t));
+                a += b;
+                memcpy(acc + i*sizeof(int32_t), &a, sizeof(int32_t));
+            }
+            break;
+        default: panic("Invalid PIM reduce op %d", op);
+    }
+}
@@ -0,0 +1,91 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PIM_UNIT_H_
+#define PIM_UNIT_H_
+
+#include "g_std/g_vector.h"
+#include "galloc.h"
+#include "locks.h"
+#include "memory_hierarchy.h"
+#include "pad.h"
+#include "stats.h"
+
+/* Near-memory gather-reduce units, one per memory channel (e.g., on the DIMM
+ * buffer chip or the HBM logic die), driven by the PIM_GATHER magic op.
+ *
+ * A gather of N lines reads each line from its channel's banks and reduces it
+ * in that channel's unit. Each channel involved then sends one partial line
+ * over its DRAM bus, and the controller combines the partials into the result.
+ * Host-side gathers would instead move all N lines over the bus; we report
+ * both byte counts.
+ *
+ * Timing is computed in the bound phase. Each bank starts a line read every
+ * bankInterval cycles and delivers it bankLatency cycles later, so lines to
+ * different banks overlap. Each unit reduces reduceBytesPerCycle. Bank and
+ * unit occupancy persists across ops, so concurrent gathers contend with each
+ * other. They don't contend with regular controller traffic. Lines map to
+ * channels as in SplitAddrMemory, and to banks by their low channel address
+ * bits (like DDRMemory's default rank:col:bank mapping).
+ */
+class PIMUnit : public GlobAlloc {
+    public:
+        enum ReduceOp {SUM_F32 = 0, MAX_F32 = 1, SUM_I32 = 2};  // must match zsim_hooks.h
+
+        static const uint32_t MAX_LINES = 4096;  // per op
+
+    private:
+        struct Channel {
+            lock_t lock;
+            uint64_t unitFreeCycle;
+            uint64_t* bankFreeCycles;
+        };
+
+        const uint32_t numChannels, banksPerChannel, lineSize;
+        const uint32_t bankLatency, bankInterval;
+        const uint32_t reduceCycles;    // per line
+        const uint32_t transferCycles;  // per line over the DRAM bus
+        const uint32_t ctrlLatency;     // controller <-> unit and core <-> controller, each way
+        Channel* channels;
+
+        PAD();
+        Counter profOps, profLines, profTotalLat;
+        Counter profBusBytes, profHostBusBytes;
+        PAD();
+
+    public:
+        PIMUnit(uint32_t _numChannels, uint32_t _banksPerChannel, uint32_t _lineSize, uint32_t _bankLatency,
+                uint32_t _bankInterval, uint32_t reduceBytesPerCycle, uint32_t _transferCycles, uint32_t _ctrlLatency);
+
+        void initStats(AggregateStat* parentStat);
+
+        // Returns the cycle at which the result line reaches the core
+        uint64_t gather(const Address* lineAddrs, uint32_t numLines, uint64_t startCycle);
+
+        // Functional reduction of one line into acc (lineSize bytes)
+        static void reduce(uint32_t op, uint8_t* acc, const uint8_t* line, uint32_t bytes);
+        static bool validOp(uint32_t op) { return op <= SUM_I32; }
+};
+
+#endif  // PIM_UNIT_H_
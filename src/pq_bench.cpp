@@ -0,0 +1,103 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmark for the weave-phase event queues: runs a hold model (dequeue the
+ * first event, enqueue it again some cycles later) on PrioQueue and TimingWheel,
+ * with a mix of near and far events, and reports operations per second. Both
+ * queues must dequeue the same cycles.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "galloc.h"
+#include "log.h"
+#include "mtrand.h"
+#include "prio_queue.h"
+#include "timing_wheel.h"
+
+struct BenchEvent {
+    BenchEvent* next;
+    uint64_t queueCycle;
+};
+
+#define BLOCKS 1024
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// Delays: nearly all within PrioQueue's near window, except farPct% between 100K and 10M cycles
+static std::vector<uint64_t> makeDelays(uint32_t farPct) {
+    std::vector<uint64_t> delays(1 << 16);
+    MTRand rnd(0x5EED);
+    for (uint64_t& d : delays) {
+        if (rnd.randInt(99) < farPct) d = 100000 + rnd.randInt(10*1000*1000);
+        else d = 1 + rnd.randInt(999);
+    }
+    return delays;
+}
+
+template <typename Q>
+static uint64_t hold(const char* type, uint32_t numEvents, uint32_t farPct, uint64_t ops) {
+    Q* q = new Q();  // too big for the stack
+    std::vector<BenchEvent> evs(numEvents);
+    std::vector<uint64_t> delays = makeDelays(farPct);
+    for (uint32_t i = 0; i < numEvents; i++) {
+        evs[i].next = nullptr;
+        q->enqueue(&evs[i], delays[i & (delays.size() - 1)]);
+    }
+
+    uint64_t sum = 0;
+    double start = now();
+    for (uint64_t i = 0; i < ops; i++) {
+        uint64_t cycle;
+        BenchEvent* ev = q->dequeue(cycle);
+        sum += cycle;
+        q->enqueue(ev, cycle + delays[(i + numEvents) & (delays.size() - 1)]);
+    }
+    double secs = now() - start;
+    info("%-12s %6d events %3d%% far: %8.2f Mops/s", type, numEvents, farPct, ops/secs/1e6);
+    delete q;
+    return sum;
+}
+
+int main(int argc, char* argv[]) {
+    InitLog("[B] ");
+    uint64_t ops = (argc > 1)? strtoull(argv[1], nullptr, 0) : 10*1000*1000;
+    gm_init(256 << 20);
+    info("Event queue microbenchmark, %ld hold operations per config", ops);
+
+    for (uint32_t numEvents : {16, 1024, 65536}) {
+        for (uint32_t farPct : {0, 5, 25}) {
+            uint64_t pqSum = hold<PrioQueue<BenchEvent, BLOCKS>>("PrioQueue", numEvents, farPct, ops);
+            uint64_t twSum = hold<TimingWheel<BenchEvent, BLOCKS>>("TimingWheel", numEvents, farPct, ops);
+            if (pqSum != twSum) panic("Queues dequeued different cycles (%ld vs %ld)", pqSum, twSum);
+        }
+    }
+    return 0;
+}
@@ -25,6 +25,9 @@
 
 #include "prefetcher.h"
 #include "bithacks.h"
+#include "pin.H"
+#include "timing_event.h"
+#include "zsim.h"
 
 //#define DBG(args...) info(args)
 #define DBG(args...)
@@ -188,3 +191,403 @@ uint64_t StreamPrefetcher::invalidate(const InvReq& req) {
 }
 
 
+
+/* DataPrefetcher */
+
+#define MAX_LINE_WORDS 32  // 256-byte lines
+
+static inline uint64_t readElem(const uint64_t* buf, uint32_t bytes, uint32_t idx) {
+    return (bytes == 4)? reinterpret_cast<const uint32_t*>(buf)[idx] : buf[idx];
+}
+
+DataPrefetcher::DataPrefetcher(uint32_t _pfEntries, uint32_t _degree, uint32_t _distance, const g_string& _name)
+    : pfEntries(_pfEntries), degree(_degree), distance(_distance), name(_name)
+{
+    if (!isPow2(pfEntries)) panic("%s: trackedLines must be a power of 2, is %d", name.c_str(), pfEntries);
+    if (zinfo->lineSize > MAX_LINE_WORDS*sizeof(uint64_t)) panic("%s: lines over %ld bytes not supported", name.c_str(), MAX_LINE_WORDS*sizeof(uint64_t));
+    pfArray = gm_calloc<PfEntry>(pfEntries);
+    curReq = nullptr;
+    curReqCycle = 0;
+    curPrefetches = 0;
+}
+
+void DataPrefetcher::setParents(uint32_t _childId, const g_vector<MemObject*>& parents, Network* network) {
+    childId = _childId;
+    if (parents.size() != 1) panic("Must have one parent");
+    if (network) panic("Network not handled");
+    parent = parents[0];
+}
+
+void DataPrefetcher::setChildren(const g_vector<BaseCache*>& children, Network* network) {
+    if (children.size() != 1) panic("Must have one children");
+    if (network) panic("Network not handled");
+    child = children[0];
+}
+
+void DataPrefetcher::initStats(AggregateStat* parentStat) {
+    AggregateStat* s = new AggregateStat();
+    s->init(name.c_str(), "Prefetcher stats");
+    profAccesses.init("acc", "Demand accesses"); s->append(&profAccesses);
+    profPrefetches.init("pf", "Issued prefetches"); s->append(&profPrefetches);
+    profHits.init("hit", "Useful prefetches (demand accesses to prefetched lines)"); s->append(&profHits);
+    profLateHits.init("lateHit", "Useful prefetches that had not arrived by the demand access"); s->append(&profLateHits);
+    profLateCycles.init("lateCycles", "Cycles demand accesses waited for late prefetches"); s->append(&profLateCycles);
+    profUnused.init("unused", "Prefetches evicted from the tracking table before use"); s->append(&profUnused);
+
+    auto accuracy = [this]() { return profPrefetches.get()? profHits.get()*10000/profPrefetches.get() : 0; };
+    auto accuracyStat = makeLambdaStat(accuracy);
+    accuracyStat->init("accuracy", "Useful/issued prefetches, in 1/10000ths");
+    s->append(accuracyStat);
+    auto coverage = [this]() { return profAccesses.get()? profHits.get()*10000/profAccesses.get() : 0; };
+    auto coverageStat = makeLambdaStat(coverage);
+    coverageStat->init("coverage", "Demand accesses to prefetched lines, in 1/10000ths");
+    s->append(coverageStat);
+    auto lateness = [this]() { return profHits.get()? profLateHits.get()*10000/profHits.get() : 0; };
+    auto latenessStat = makeLambdaStat(lateness);
+    latenessStat->init("lateness", "Late/useful prefetches, in 1/10000ths");
+    s->append(latenessStat);
+
+    initPrefetcherStats(s);
+    parentStat->append(s);
+}
+
+uint64_t DataPrefetcher::access(MemReq& req) {
+    uint32_t origChildId = req.childId;
+    req.childId = childId;
+
+    if (req.type != GETS) {  //other reqs ignored, including stores
+        uint64_t respCycle = parent->access(req);
+        req.childId = origChildId;
+        return respCycle;
+    }
+
+    profAccesses.inc();
+
+    uint64_t reqCycle = req.cycle;
+    uint64_t respCycle = parent->access(req);
+
+    PfEntry& e = pfArray[req.lineAddr & (pfEntries - 1)];
+    if (e.lineAddr == req.lineAddr) {
+        profHits.inc();
+        if (e.respCycle > respCycle) {
+            profLateHits.inc();
+            profLateCycles.inc(e.respCycle - respCycle);
+            respCycle = e.respCycle;
+        }
+        e.lineAddr = 0;
+    }
+
+    EventRecorder* evRec = zinfo->eventRecorders[req.srcId];
+    curRecord.clear();
+    if (evRec && evRec->hasRecord()) curRecord = evRec->popRecord();
+    curReq = &req;
+    curReqCycle = reqCycle;
+    curPrefetches = 0;
+
+    train(req.lineAddr, reqCycle, respCycle);
+
+    curReq = nullptr;
+    if (curRecord.isValid()) evRec->pushRecord(curRecord);
+    req.childId = origChildId;
+    return respCycle;
+}
+
+uint64_t DataPrefetcher::invalidate(const InvReq& req) {
+    return child->invalidate(req);
+}
+
+uint64_t DataPrefetcher::prefetch(Address lineAddr, uint64_t cycle) {
+    assert(curReq);
+    PfEntry& e = pfArray[lineAddr & (pfEntries - 1)];
+    if (e.lineAddr == lineAddr) return e.respCycle;  // already in flight
+    if (curPrefetches >= degree) return 0;
+    curPrefetches++;
+
+    MESIState state = I;
+    MemReq pfReq = {lineAddr, GETS, childId, &state, cycle, curReq->childLock, state, curReq->srcId, MemReq::PREFETCH};
+    uint64_t pfRespCycle = parent->access(pfReq);
+    assert(state == I);  // prefetch access should not give us any permissions
+    profPrefetches.inc();
+
+    if (e.lineAddr) profUnused.inc();
+    e.lineAddr = lineAddr;
+    e.respCycle = pfRespCycle;
+
+    EventRecorder* evRec = zinfo->eventRecorders[curReq->srcId];
+    if (evRec && evRec->hasRecord()) {
+        TimingRecord pf = evRec->popRecord();
+        foldRecord(pf, curReqCycle);
+    }
+    return pfRespCycle;
+}
+
+// Keeps a single record per access, as Cache::access does with writebacks
+void DataPrefetcher::foldRecord(TimingRecord& pf, uint64_t reqCycle) {
+    if (!curRecord.isValid()) {
+        // No demand record: the core treats the prefetch as fire-and-forget, like a writeback
+        pf.type = PUTS;
+        pf.endEvent = nullptr;
+        curRecord = pf;
+        return;
+    }
+
+    EventRecorder* evRec = zinfo->eventRecorders[curReq->srcId];
+    assert(curRecord.reqCycle >= reqCycle && pf.reqCycle >= reqCycle);
+    DelayEvent* startEv = new (evRec) DelayEvent(0);
+    DelayEvent* dCurEv = new (evRec) DelayEvent(curRecord.reqCycle - reqCycle);
+    DelayEvent* dPfEv = new (evRec) DelayEvent(pf.reqCycle - reqCycle);
+    startEv->setMinStartCycle(reqCycle);
+    dCurEv->setMinStartCycle(reqCycle);
+    dPfEv->setMinStartCycle(reqCycle);
+    startEv->addChild(dCurEv, evRec)->addChild(curRecord.startEvent, evRec);
+    startEv->addChild(dPfEv, evRec)->addChild(pf.startEvent, evRec);
+    curRecord.reqCycle = reqCycle;
+    curRecord.startEvent = startEv;
+}
+
+Address DataPrefetcher::toVAddr(Address lineAddr) {
+    Address vLineMask = (1UL << (64 - lineBits)) - 1;
+    return (lineAddr & vLineMask) << lineBits;
+}
+
+Address DataPrefetcher::toLineAddr(Address vAddr, Address refLineAddr) {
+    Address vLineMask = (1UL << (64 - lineBits)) - 1;
+    return ((vAddr >> lineBits) & vLineMask) | (refLineAddr & ~vLineMask);
+}
+
+bool DataPrefetcher::readLine(Address lineAddr, void* buf) const {
+    Address vLineMask = (1UL << (64 - lineBits)) - 1;
+    if ((lineAddr & ~vLineMask) != procMask) return false;  // not our process
+    return PIN_SafeCopy(buf, (const VOID*)toVAddr(lineAddr), zinfo->lineSize) == zinfo->lineSize;
+}
+
+/* IndirectPrefetcher */
+
+void IndirectPrefetcher::Stream::alloc(Address lineAddr, uint64_t _ts) {
+    lastLine = lineAddr;
+    ts = _ts;
+    seqHits = 0;
+    cursor = 0;
+    for (uint32_t w = 0; w < WIDTHS; w++) {
+        for (uint32_t s = 0; s < SHIFTS; s++) {
+            candBase[w][s] = 0;
+            candConf[w][s].reset();
+        }
+    }
+    hasPattern = false;
+    patternConf.reset();
+}
+
+IndirectPrefetcher::IndirectPrefetcher(uint32_t _pfEntries, uint32_t _degree, uint32_t _distance, const g_string& _name)
+    : DataPrefetcher(_pfEntries, _degree, _distance, _name), timestamp(0), lastStream(-1)
+{
+    for (Stream& st : streams) st.alloc(0, 0);
+}
+
+void IndirectPrefetcher::initPrefetcherStats(AggregateStat* s) {
+    profPatterns.init("patterns", "Indirect patterns learned"); s->append(&profPatterns);
+    profTriggers.init("triggers", "Index lines that triggered indirect prefetches"); s->append(&profTriggers);
+}
+
+void IndirectPrefetcher::train(Address lineAddr, uint64_t reqCycle, uint64_t respCycle) {
+    // 1. Advance index streams
+    for (uint32_t i = 0; i < STREAMS; i++) {
+        Stream& st = streams[i];
+        if (lineAddr == st.lastLine) {
+            st.ts = timestamp++;
+            return;
+        } else if (lineAddr == st.lastLine + 1) {
+            st.lastLine = lineAddr;
+            st.seqHits++;
+            st.cursor = 0;
+            st.ts = timestamp++;
+            lastStream = i;
+            if (st.hasPattern) prefetchIndirect(st, reqCycle);
+            return;
+        }
+    }
+
+    // 2. Irregular access, may be A[B[i]] for the current index line
+    if (lastStream >= 0 && streams[lastStream].seqHits >= 2) learn(streams[lastStream], lineAddr);
+
+    // 3. Start a new stream, replacing entries that have not proven sequential first
+    uint32_t victim = 0;
+    for (uint32_t i = 1; i < STREAMS; i++) {
+        bool iSeq = streams[i].seqHits >= 2;
+        bool vSeq = streams[victim].seqHits >= 2;
+        if ((iSeq == vSeq && streams[i].ts < streams[victim].ts) || (!iSeq && vSeq)) victim = i;
+    }
+    streams[victim].alloc(lineAddr, timestamp++);
+    if ((int32_t)victim == lastStream) lastStream = -1;
+}
+
+void IndirectPrefetcher::learn(Stream& st, Address lineAddr) {
+    uint64_t buf[MAX_LINE_WORDS];
+    if (!readLine(st.lastLine, buf)) return;
+
+    Address missAddr = toVAddr(lineAddr);
+    uint32_t lineBytes = zinfo->lineSize;
+    uint32_t cursor = st.cursor++;
+
+    // Does the miss match base + (B[j] << shift) for an index near the cursor? Misses are line-aligned, so
+    // bases match within a line, and we keep the highest one (the closest to the real base)
+    auto match = [&](uint32_t w, uint32_t s, Address& base) -> bool {
+        uint32_t bytes = 4 << w;
+        uint32_t elems = lineBytes/bytes;
+        uint32_t lo = (cursor > 2)? cursor - 2 : 0;
+        uint32_t hi = MIN(cursor + 3, elems);
+        for (uint32_t j = lo; j < hi; j++) {
+            Address b = missAddr - (readElem(buf, bytes, j) << s);
+            if (b - base < lineBytes || base - b < lineBytes) {
+                base = MAX(base, b);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if (st.hasPattern) {
+        if (match(st.width, st.shift, st.base)) st.patternConf.inc();
+        else st.patternConf.dec();
+        if (!st.patternConf.pred()) st.hasPattern = false;
+        return;
+    }
+
+    for (uint32_t w = 0; w < WIDTHS; w++) {
+        uint32_t elems = lineBytes/(4 << w);
+        if (cursor >= elems + 2) continue;  // past this line's indices
+        for (uint32_t s = 0; s < SHIFTS; s++) {
+            if (match(w, s, st.candBase[w][s])) {
+                st.candConf[w][s].inc();
+                if (st.candConf[w][s].pred() && !st.hasPattern) {
+                    st.hasPattern = true;
+                    st.width = w;
+                    st.shift = s;
+                    st.base = st.candBase[w][s];
+                    st.patternConf.reset();
+                    profPatterns.inc();
+                }
+            } else if (st.candConf[w][s].counter() == 0) {
+                st.candBase[w][s] = missAddr - (readElem(buf, 4 << w, MIN(cursor, elems - 1)) << s);
+            } else {
+                st.candConf[w][s].dec();
+            }
+        }
+    }
+}
+
+void IndirectPrefetcher::prefetchIndirect(Stream& st, uint64_t reqCycle) {
+    profTriggers.inc();
+    Address idxLine = st.lastLine + distance;
+    uint64_t idxRespCycle = prefetch(idxLine, reqCycle);
+    uint64_t buf[MAX_LINE_WORDS];
+    if (!idxRespCycle || !readLine(idxLine, buf)) return;
+
+    // Targets depend on the index values, so they issue when the index line arrives
+    uint32_t bytes = 4 << st.width;
+    uint32_t elems = zinfo->lineSize/bytes;
+    for (uint32_t j = 0; j < elems; j++) {
+        Address target = st.base + (readElem(buf, bytes, j) << st.shift);
+        if (!prefetch(toLineAddr(target, idxLine), idxRespCycle)) break;
+    }
+}
+
+/* CSRPrefetcher */
+
+#define MAX_CSR_GRAPHS 8
+
+// Per-process, like the addresses they describe
+static CSRGraphDesc csrGraphs[MAX_CSR_GRAPHS];
+static uint32_t numCsrGraphs = 0;
+
+void CSRPrefetcher::registerGraph(const CSRGraphDesc& graph) {
+    if ((graph.offsetBytes != 4 && graph.offsetBytes != 8) || (graph.neighborBytes != 4 && graph.neighborBytes != 8)) {
+        warn("Ignoring CSR graph with %d-byte offsets and %d-byte neighbors, only 4 and 8 are supported", graph.offsetBytes, graph.neighborBytes);
+    } else if (numCsrGraphs == MAX_CSR_GRAPHS) {
+        warn("Ignoring CSR graph, already have %d", MAX_CSR_GRAPHS);
+    } else {
+        csrGraphs[numCsrGraphs++] = graph;
+        info("Registered CSR graph: %ld vertices, %ld edges, offsets 0x%lx neighbors 0x%lx features 0x%lx (%d bytes/row)",
+                graph.numVertices, graph.numEdges, graph.offsets, graph.neighbors, graph.features, graph.featureBytes);
+    }
+}
+
+CSRPrefetcher::CSRPrefetcher(uint32_t _pfEntries, uint32_t _degree, uint32_t _distance, uint32_t _featureLines, const g_string& _name)
+    : DataPrefetcher(_pfEntries, _degree, _distance, _name), featureLines(_featureLines) {}
+
+void CSRPrefetcher::initPrefetcherStats(AggregateStat* s) {
+    profOffsetTriggers.init("offsetTriggers", "Offsets array accesses"); s->append(&profOffsetTriggers);
+    profNeighborTriggers.init("neighborTriggers", "Neighbors array accesses"); s->append(&profNeighborTriggers);
+}
+
+void CSRPrefetcher::train(Address lineAddr, uint64_t reqCycle, uint64_t respCycle) {
+    Address vAddr = toVAddr(lineAddr);
+    uint32_t lineBytes = zinfo->lineSize;
+    Address aheadLine = lineAddr + distance;
+    Address aheadAddr = vAddr + distance*lineBytes;
+    uint64_t buf[MAX_LINE_WORDS];
+
+    for (uint32_t i = 0; i < numCsrGraphs; i++) {
+        const CSRGraphDesc& g = csrGraphs[i];
+        Address offsetsEnd = g.offsets + (g.numVertices + 1)*g.offsetBytes;
+        Address neighborsEnd = g.neighbors + g.numEdges*g.neighborBytes;
+
+        if (vAddr + lineBytes > g.offsets && vAddr < offsetsEnd) {
+            // Offsets line -> neighbor lines of its vertices -> their feature rows
+            profOffsetTriggers.inc();
+            if (aheadAddr >= offsetsEnd) return;
+            uint64_t offRespCycle = prefetch(aheadLine, reqCycle);
+            if (!offRespCycle || !readLine(aheadLine, buf)) return;
+            Address first = MAX(aheadAddr, g.offsets);
+            Address last = MIN(aheadAddr + lineBytes, offsetsEnd) - g.offsetBytes;
+            if (first > last) return;
+            uint64_t firstEdge = readElem(buf, g.offsetBytes, (first - aheadAddr)/g.offsetBytes);
+            uint64_t lastEdge = readElem(buf, g.offsetBytes, (last - aheadAddr)/g.offsetBytes);
+            prefetchNeighbors(g, firstEdge, MIN(lastEdge, g.numEdges), offRespCycle);
+            return;
+        } else if (vAddr + lineBytes > g.neighbors && vAddr < neighborsEnd) {
+            // Neighbor line -> feature rows of those neighbors
+            profNeighborTriggers.inc();
+            if (aheadAddr >= neighborsEnd) return;
+            uint64_t nbrRespCycle = prefetch(aheadLine, reqCycle);
+            if (nbrRespCycle) prefetchFeatures(g, aheadLine, 0, g.numEdges, nbrRespCycle);
+            return;
+        }
+    }
+}
+
+void CSRPrefetcher::prefetchNeighbors(const CSRGraphDesc& g, uint64_t firstEdge, uint64_t lastEdge, uint64_t cycle) {
+    if (firstEdge >= lastEdge) return;
+    Address firstLine = toLineAddr(g.neighbors + firstEdge*g.neighborBytes, curReq->lineAddr);
+    Address lastLine = toLineAddr(g.neighbors + lastEdge*g.neighborBytes - 1, curReq->lineAddr);
+    // Depth-first, so the first vertices get their whole chain
+    for (Address line = firstLine; line <= lastLine; line++) {
+        uint64_t nbrRespCycle = prefetch(line, cycle);
+        if (!nbrRespCycle) return;
+        prefetchFeatures(g, line, firstEdge, lastEdge, nbrRespCycle);
+    }
+}
+
+void CSRPrefetcher::prefetchFeatures(const CSRGraphDesc& g, Address nbrLineAddr, uint64_t firstEdge, uint64_t lastEdge, uint64_t cycle) {
+    uint64_t buf[MAX_LINE_WORDS];
+    if (!g.features || !g.featureBytes || !readLine(nbrLineAddr, buf)) return;
+
+    // Edges held by this line, clamped to [firstEdge, lastEdge)
+    Address lineStart = toVAddr(nbrLineAddr);
+    Address lineEnd = lineStart + zinfo->lineSize;
+    uint64_t e0 = (lineStart > g.neighbors)? (lineStart - g.neighbors + g.neighborBytes - 1)/g.neighborBytes : 0;
+    uint64_t e1 = (lineEnd - g.neighbors)/g.neighborBytes;
+    e0 = MAX(e0, firstEdge);
+    e1 = MIN(e1, MIN(lastEdge, g.numEdges));
+
+    for (uint64_t e = e0; e < e1; e++) {
+        uint64_t nbr = readElem(buf, g.neighborBytes, (g.neighbors + e*g.neighborBytes - lineStart)/g.neighborBytes);
+        if (nbr >= g.numVertices) continue;
+        Address row = g.features + nbr*g.featureBytes;
+        Address rowFirst = toLineAddr(row, nbrLineAddr);
+        Address rowLast = toLineAddr(row + g.featureBytes - 1, nbrLineAddr);
+        for (Address line = rowFirst; line <= rowLast && line < rowFirst + featureLines; line++) {
+            if (!prefetch(line, cycle)) return;
+        }
+    }
+}
@@ -28,6 +28,7 @@
 
 #include <bitset>
 #include "bithacks.h"
+#include "event_recorder.h"
 #include "g_std/g_string.h"
 #include "memory_hierarchy.h"
 #include "stats.h"
@@ -113,4 +114,157 @@ class StreamPrefetcher : public BaseCache {
         uint64_t invalidate(const InvReq& req);
 };
 
+/* Base class for prefetchers that follow data read from memory (indirect and pointer-chasing patterns).
+ *
+ * The memory hierarchy does not carry data, but zsim runs in the simulated process, so requests from the current
+ * process can read the values of the lines they touch (lines of other processes are never read). Prefetches that
+ * depend on a value are issued at the response cycle of the line that holds it, so chains of dependent
+ * prefetches take as long as the demand accesses would. Issued prefetches are tracked in a small direct-mapped
+ * table: a demand access to a prefetched line is a useful prefetch, and a late one if the prefetch had not arrived.
+ *
+ * NOTE: Like StreamPrefetcher, prefetches are bound-phase only. Their timing records are folded into the demand
+ * access's record so the core still sees a single record per access.
+ */
+class DataPrefetcher : public BaseCache {
+    protected:
+        struct PfEntry {
+            Address lineAddr;
+            uint64_t respCycle;
+        };
+
+        PfEntry* pfArray;
+        uint32_t pfEntries;  // power of 2
+        uint32_t degree;  // max prefetches per trigger
+        uint32_t distance;  // in lines
+
+        Counter profAccesses, profPrefetches, profHits, profLateHits, profLateCycles, profUnused;
+
+        MemObject* parent;
+        BaseCache* child;
+        uint32_t childId;
+        g_string name;
+
+        // Per-access state, valid during train()
+        MemReq* curReq;
+        uint64_t curReqCycle;
+        TimingRecord curRecord;
+        uint32_t curPrefetches;
+
+    public:
+        DataPrefetcher(uint32_t _pfEntries, uint32_t _degree, uint32_t _distance, const g_string& _name);
+        void initStats(AggregateStat* parentStat);
+        const char* getName() { return name.c_str();}
+        void setParents(uint32_t _childId, const g_vector<MemObject*>& parents, Network* network);
+        void setChildren(const g_vector<BaseCache*>& children, Network* network);
+
+        uint64_t access(MemReq& req);
+        uint64_t invalidate(const InvReq& req);
+
+    protected:
+        // Called on every demand GETS with its request and response cycles, issues prefetches through prefetch()
+        virtual void train(Address lineAddr, uint64_t reqCycle, uint64_t respCycle) = 0;
+        virtual void initPrefetcherStats(AggregateStat* s) {}
+
+        // Issues a prefetch at cycle, returns when the line will be available (or 0 if over the degree)
+        uint64_t prefetch(Address lineAddr, uint64_t cycle);
+
+        // Reads the contents of a line of the current process, returns false if the line can't be read
+        bool readLine(Address lineAddr, void* buf) const;
+
+        // Translation between line addresses (which include the process mask) and virtual addresses
+        static Address toVAddr(Address lineAddr);
+        static Address toLineAddr(Address vAddr, Address refLineAddr);  // same process as refLineAddr
+
+    private:
+        void foldRecord(TimingRecord& pf, uint64_t reqCycle);
+};
+
+/* Indirect memory prefetcher, after IMP (Yu et al., MICRO 2015), adapted to the line-granularity requests seen
+ * below the L1.
+ *
+ * Sequential streams of lines are candidate index arrays B. Misses that follow an index line are matched against
+ * the values in that line to learn A[B[i]] patterns, i.e., an index width (4 or 8 bytes), a shift (A's element
+ * size) and a base (&A[0]). Once a stream has a confirmed pattern, each new index line triggers a prefetch of the
+ * index line `distance` lines ahead and, when that line arrives, of A[B[j]] for its elements.
+ */
+class IndirectPrefetcher : public DataPrefetcher {
+    private:
+        static const uint32_t STREAMS = 8;
+        static const uint32_t WIDTHS = 2;  // 4 and 8-byte indices
+        static const uint32_t SHIFTS = 7;  // 1 to 64-byte elements
+
+        struct Stream {
+            Address lastLine;
+            uint64_t ts;
+            uint32_t seqHits;
+            uint32_t cursor;  // misses seen since the stream entered lastLine, ~index of the current element
+
+            Address candBase[WIDTHS][SHIFTS];
+            SatCounter<3, 2, 0> candConf[WIDTHS][SHIFTS];
+
+            bool hasPattern;
+            uint32_t width, shift;
+            Address base;
+            SatCounter<7, 1, 4> patternConf;
+
+            void alloc(Address lineAddr, uint64_t _ts);
+        };
+
+        Stream streams[STREAMS];
+        uint64_t timestamp;
+        int32_t lastStream;  // most recently advanced stream, -1 if none
+
+        Counter profPatterns, profTriggers;
+
+    public:
+        IndirectPrefetcher(uint32_t _pfEntries, uint32_t _degree, uint32_t _distance, const g_string& _name);
+
+    protected:
+        void train(Address lineAddr, uint64_t reqCycle, uint64_t respCycle);
+        void initPrefetcherStats(AggregateStat* s);
+
+    private:
+        void learn(Stream& st, Address lineAddr);
+        void prefetchIndirect(Stream& st, uint64_t reqCycle);
+};
+
+// CSR graph registered by a program, see CSRPrefetcher
+struct CSRGraphDesc {  // must match zsim_hooks.h
+    uint64_t offsets;  // address of the offsets array (numVertices + 1 elements)
+    uint64_t neighbors;  // address of the neighbors array (numEdges elements)
+    uint64_t features;  // address of the feature table (numVertices rows), 0 if none
+    uint64_t numVertices;
+    uint64_t numEdges;
+    uint32_t offsetBytes;  // 4 or 8
+    uint32_t neighborBytes;  // 4 or 8
+    uint32_t featureBytes;  // bytes per feature row
+    uint32_t pad;
+};
+
+/* Graph-aware prefetcher for CSR traversals. Programs register their CSR arrays (offsets, neighbors and,
+ * optionally, a feature table) with the REGISTER_CSR magic op. Then:
+ *  - Accesses to the offsets array prefetch the offsets line `distance` lines ahead, then the neighbor lines of
+ *    its vertices, then the feature rows of those neighbors, each level at the response of the previous one.
+ *  - Accesses to the neighbors array prefetch the neighbor line `distance` lines ahead, then its feature rows.
+ */
+class CSRPrefetcher : public DataPrefetcher {
+    private:
+        uint32_t featureLines;  // max lines prefetched per feature row
+        Counter profOffsetTriggers, profNeighborTriggers;
+
+    public:
+        CSRPrefetcher(uint32_t _pfEntries, uint32_t _degree, uint32_t _distance, uint32_t _featureLines, const g_string& _name);
+
+        // Called from the REGISTER_CSR magic op; graphs are per process
+        static void registerGraph(const CSRGraphDesc& graph);
+
+    protected:
+        void train(Address lineAddr, uint64_t reqCycle, uint64_t respCycle);
+        void initPrefetcherStats(AggregateStat* s);
+
+    private:
+        void prefetchNeighbors(const CSRGraphDesc& g, uint64_t firstEdge, uint64_t lastEdge, uint64_t cycle);
+        void prefetchFeatures(const CSRGraphDesc& g, Address nbrLineAddr, uint64_t firstEdge, uint64_t lastEdge, uint64_t cycle);
+};
+
 #endif  // PREFETCHER_H_
@@ -372,6 +372,401 @@ class LFUReplPolicy : public LegacyReplPolicy {
         }
 };
 
+/* Re-reference interval prediction (Jaleel et al., ISCA 2010). Each line has an
+ * RRPV; victims are lines at the max RRPV (distant re-reference), and if there
+ * are none, all candidates age until one gets there. Hits promote to 0. The
+ * insertion RRPV is what distinguishes the policies below.
+ *
+ * Lines are grouped into sets of `ways` consecutive ids, which matches
+ * SetAssocArray; on other arrays these are just fixed groups of lines, which
+ * set dueling can still sample.
+ */
+class RRIPReplPolicy : public ReplPolicy {
+    protected:
+        uint8_t* rrpv;
+        uint32_t numLines;
+        uint32_t ways;
+        uint32_t numSets;
+        uint8_t maxRrpv;
+        uint32_t lastReplaced; //the array calls replaced(), then update() on insertions
+
+    public:
+        RRIPReplPolicy(uint32_t _numLines, uint32_t _ways, uint32_t rrpvBits) : numLines(_numLines), ways(_ways), lastReplaced(-1) {
+            if (rrpvBits < 1 || rrpvBits > 7) panic("RRIP needs 1-7 RRPV bits, %d given", rrpvBits);
+            maxRrpv = (1 << rrpvBits) - 1;
+            numSets = numLines/ways;
+            rrpv = gm_calloc<uint8_t>(numLines);
+            for (uint32_t i = 0; i < numLines; i++) rrpv[i] = maxRrpv;
+        }
+
+        ~RRIPReplPolicy() {
+            gm_free(rrpv);
+        }
+
+        void update(uint32_t id, const MemReq* req) {
+            if (id == lastReplaced) {
+                lastReplaced = -1;
+                rrpv[id] = insertionRrpv(id, req);
+            } else {
+                rrpv[id] = hitRrpv(id, req);
+            }
+        }
+
+        void replaced(uint32_t id) {
+            lastReplaced = id;
+        }
+
+        template <typename C> inline uint32_t rank(const MemReq* req, C cands) {
+            uint32_t bestCand = -1;
+            uint8_t bestRrpv = 0;
+            for (auto ci = cands.begin(); ci != cands.end(); ci.inc()) {
+                if (!cc->isValid(*ci)) return *ci;
+                if (bestCand == (uint32_t)-1 || rrpv[*ci] > bestRrpv) {
+                    bestCand = *ci;
+                    bestRrpv = rrpv[*ci];
+                }
+            }
+            //Age everyone as if we had incremented until the victim reached maxRrpv
+            uint8_t age = maxRrpv - bestRrpv;
+            if (age) {
+                for (auto ci = cands.begin(); ci != cands.end(); ci.inc()) rrpv[*ci] += age;
+            }
+            evicting(bestCand);
+            return bestCand;
+        }
+
+        DECL_RANK_BINDINGS;
+
+    protected:
+        virtual uint8_t insertionRrpv(uint32_t id, const MemReq* req) = 0;
+        virtual uint8_t hitRrpv(uint32_t id, const MemReq* req) { return 0; }
+        virtual void evicting(uint32_t id) {}
+};
+
+//Static RRIP: insert with a long re-reference interval
+class SRRIPReplPolicy : public RRIPReplPolicy {
+    public:
+        SRRIPReplPolicy(uint32_t _numLines, uint32_t _ways, uint32_t rrpvBits) : RRIPReplPolicy(_numLines, _ways, rrpvBits) {}
+
+    protected:
+        uint8_t insertionRrpv(uint32_t id, const MemReq* req) { return maxRrpv - 1; }
+};
+
+//Bimodal RRIP: insert with a distant re-reference interval, except for 1 in 32 insertions (scan and thrash resistant)
+class BRRIPReplPolicy : public RRIPReplPolicy {
+    protected:
+        uint32_t bimodalCount;
+
+    public:
+        BRRIPReplPolicy(uint32_t _numLines, uint32_t _ways, uint32_t rrpvBits) : RRIPReplPolicy(_numLines, _ways, rrpvBits), bimodalCount(0) {}
+
+    protected:
+        uint8_t insertionRrpv(uint32_t id, const MemReq* req) { return bimodalRrpv(); }
+
+        inline uint8_t bimodalRrpv() {
+            return ((bimodalCount++ & 31) == 0)? maxRrpv - 1 : maxRrpv;
+        }
+};
+
+//Dynamic RRIP: set dueling between SRRIP and BRRIP leader sets, followers use the one with fewer misses
+class DRRIPReplPolicy : public BRRIPReplPolicy {
+    private:
+        uint32_t constituency; //each constituency has one SRRIP and one BRRIP leader set
+        uint32_t psel; //incremented on SRRIP leader misses, decremented on BRRIP leader misses
+        uint32_t pselMax;
+        Counter profSrripInsertions, profBrripInsertions;
+
+    public:
+        DRRIPReplPolicy(uint32_t _numLines, uint32_t _ways, uint32_t rrpvBits, uint32_t leaderSets, uint32_t pselBits)
+            : BRRIPReplPolicy(_numLines, _ways, rrpvBits)
+        {
+            if (numSets < 2) panic("DRRIP needs at least 2 sets to duel");
+            if (leaderSets == 0) panic("DRRIP needs at least 1 leader set per policy");
+            leaderSets = MIN(leaderSets, numSets/2);
+            constituency = numSets/leaderSets;
+            pselMax = (1 << pselBits) - 1;
+            psel = pselMax/2;
+        }
+
+        void initStats(AggregateStat* parentStat) {
+            profSrripInsertions.init("srripIns", "Insertions with SRRIP (leader or follower)");
+            profBrripInsertions.init("brripIns", "Insertions with BRRIP (leader or follower)");
+            parentStat->append(&profSrripInsertions);
+            parentStat->append(&profBrripInsertions);
+        }
+
+    protected:
+        uint8_t insertionRrpv(uint32_t id, const MemReq* req) {
+            uint32_t pos = (id/ways) % constituency;
+            bool useBrrip;
+            if (pos == 0) { //SRRIP leader
+                psel = MIN(psel + 1, pselMax);
+                useBrrip = false;
+            } else if (pos == constituency/2) { //BRRIP leader (constituency >= 2)
+                psel = (psel > 0)? psel - 1 : 0;
+                useBrrip = true;
+            } else {
+                useBrrip = psel > pselMax/2;
+            }
+            if (useBrrip) {
+                profBrripInsertions.inc();
+                return bimodalRrpv();
+            } else {
+                profSrripInsertions.inc();
+                return maxRrpv - 1;
+            }
+        }
+};
+
+/* Signature-based hit prediction (Wu et al., MICRO 2011) on top of SRRIP. Lines
+ * whose signature has not seen hits recently are inserted at distant RRPV. The
+ * hierarchy does not carry PCs, so we use the SHiP-Mem signature: the memory
+ * region (16 lines by default) the line belongs to.
+ */
+class SHiPReplPolicy : public RRIPReplPolicy {
+    private:
+        uint16_t* lineSig;
+        bool* lineHit; //outcome bit: was the line re-referenced since insertion?
+        uint8_t* shct; //signature history counter table, 3-bit counters
+        uint32_t shctMask;
+        uint32_t regionBits;
+        Counter profDistantInsertions;
+
+    public:
+        SHiPReplPolicy(uint32_t _numLines, uint32_t _ways, uint32_t rrpvBits, uint32_t shctEntries, uint32_t _regionBits)
+            : RRIPReplPolicy(_numLines, _ways, rrpvBits), regionBits(_regionBits)
+        {
+            if (!isPow2(shctEntries) || shctEntries > (1 << 16)) panic("SHiP needs a power-of-2 SHCT of up to 64K entries, %d given", shctEntries);
+            shctMask = shctEntries - 1;
+            lineSig = gm_calloc<uint16_t>(numLines);
+            lineHit = gm_calloc<bool>(numLines);
+            shct = gm_calloc<uint8_t>(shctEntries);
+            for (uint32_t i = 0; i < shctEntries; i++) shct[i] = 1; //weakly reused
+        }
+
+        ~SHiPReplPolicy() {
+            gm_free(lineSig);
+            gm_free(lineHit);
+            gm_free(shct);
+        }
+
+        void initStats(AggregateStat* parentStat) {
+            profDistantInsertions.init("distantIns", "Insertions predicted dead (distant RRPV)");
+            parentStat->append(&profDistantInsertions);
+        }
+
+    protected:
+        uint8_t insertionRrpv(uint32_t id, const MemReq* req) {
+            uint32_t sig = signature(req->lineAddr);
+            lineSig[id] = sig;
+            lineHit[id] = false;
+            if (shct[sig] == 0) {
+                profDistantInsertions.inc();
+                return maxRrpv;
+            }
+            return maxRrpv - 1;
+        }
+
+        uint8_t hitRrpv(uint32_t id, const MemReq* req) {
+            if (!lineHit[id]) {
+                lineHit[id] = true;
+                shct[lineSig[id]] = MIN(shct[lineSig[id]] + 1, 7);
+            }
+            return 0;
+        }
+
+        void evicting(uint32_t id) {
+            if (cc->isValid(id) && !lineHit[id] && shct[lineSig[id]]) shct[lineSig[id]]--;
+        }
+
+    private:
+        inline uint32_t signature(Address lineAddr) const {
+            Address region = lineAddr >> regionBits;
+            return (region ^ (region >> 14) ^ (region >> 28)) & shctMask;
+        }
+};
+
+/* Hawkeye (Jain and Lin, ISCA 2016). OPTgen reconstructs Belady's decisions
+ * on a few sampled sets: a reuse would have hit under OPT if the cache was not
+ * full (occupancy < ways) at any point since the previous access. These
+ * outcomes train a predictor, indexed by the signature of the access that
+ * brought or last touched the line, that classifies accesses as cache-friendly
+ * (inserted at RRPV 0, aging other friendly lines) or cache-averse (RRPV max,
+ * evicted first). As in SHiP, signatures are memory regions instead of PCs.
+ *
+ * Requires set-associative arrays, since OPTgen needs real sets.
+ */
+class HawkeyeReplPolicy : public ReplPolicy {
+    private:
+        static const uint8_t MAX_RRPV = 7;
+        static const uint8_t PRED_MAX = 7;
+        static const uint8_t PRED_FRIENDLY = 4; //counter >= this is cache-friendly
+
+        struct SamplerEntry {
+            Address lineAddr;
+            uint64_t lastTime;
+            uint16_t sig;
+        };
+
+        struct SampledSet {
+            uint64_t time; //accesses to the set so far
+            uint8_t* occupancy; //liveness intervals per time quantum, circular (history entries)
+            SamplerEntry* history; //previous accesses (history entries, LRU)
+        };
+
+        uint8_t* rrpv;
+        uint16_t* lineSig;
+        uint8_t* predictor;
+        uint32_t predMask;
+        uint32_t numLines;
+        uint32_t ways;
+        uint32_t numSets;
+        uint32_t regionBits;
+        uint32_t sampleStride;
+        uint32_t numSampledSets;
+        uint32_t historyLen;
+        SampledSet* sampledSets;
+        uint32_t lastReplaced;
+
+        Counter profOptHits, profOptMisses, profFriendlyIns, profAverseIns, profDetrains;
+
+    public:
+        HawkeyeReplPolicy(uint32_t _numLines, uint32_t _ways, uint32_t predEntries, uint32_t _regionBits, uint32_t sampledSetsNum, uint32_t historyMult)
+            : numLines(_numLines), ways(_ways), regionBits(_regionBits), lastReplaced(-1)
+        {
+            if (!isPow2(predEntries) || predEntries > (1 << 16)) panic("Hawkeye needs a power-of-2 predictor of up to 64K entries, %d given", predEntries);
+            numSets = numLines/ways;
+            predMask = predEntries - 1;
+            rrpv = gm_calloc<uint8_t>(numLines);
+            for (uint32_t i = 0; i < numLines; i++) rrpv[i] = MAX_RRPV;
+            lineSig = gm_calloc<uint16_t>(numLines);
+            predictor = gm_calloc<uint8_t>(predEntries);
+            for (uint32_t i = 0; i < predEntries; i++) predictor[i] = PRED_FRIENDLY;
+
+            numSampledSets = MAX(1u, MIN(sampledSetsNum, numSets));
+            sampleStride = numSets/numSampledSets;
+            historyLen = historyMult*ways;
+            sampledSets = gm_calloc<SampledSet>(numSampledSets);
+            for (uint32_t i = 0; i < numSampledSets; i++) {
+                sampledSets[i].time = 0;
+                sampledSets[i].occupancy = gm_calloc<uint8_t>(historyLen);
+                sampledSets[i].history = gm_calloc<SamplerEntry>(historyLen);
+            }
+        }
+
+        void initStats(AggregateStat* parentStat) {
+            profOptHits.init("optHits", "OPTgen reuses that hit under OPT");
+            profOptMisses.init("optMisses", "OPTgen reuses that missed under OPT");
+            profFriendlyIns.init("friendlyIns", "Insertions predicted cache-friendly");
+            profAverseIns.init("averseIns", "Insertions predicted cache-averse");
+            profDetrains.init("detrains", "Evictions of cache-friendly lines");
+            parentStat->append(&profOptHits);
+            parentStat->append(&profOptMisses);
+            parentStat->append(&profFriendlyIns);
+            parentStat->append(&profAverseIns);
+            parentStat->append(&profDetrains);
+        }
+
+        void update(uint32_t id, const MemReq* req) {
+            uint32_t set = id/ways;
+            uint32_t sig = signature(req->lineAddr);
+            //when numSampledSets does not divide numSets, the sets past the last sampled one are not sampled
+            if (set % sampleStride == 0 && set/sampleStride < numSampledSets) optgen(sampledSets[set/sampleStride], req->lineAddr, sig);
+
+            bool friendly = predictor[sig] >= PRED_FRIENDLY;
+            bool insertion = (id == lastReplaced);
+            if (insertion) {
+                lastReplaced = -1;
+                if (friendly) {
+                    profFriendlyIns.inc();
+                    for (uint32_t i = set*ways; i < (set + 1)*ways; i++) {
+                        if (rrpv[i] < MAX_RRPV - 1) rrpv[i]++;
+                    }
+                } else {
+                    profAverseIns.inc();
+                }
+            }
+            rrpv[id] = friendly? 0 : MAX_RRPV;
+            lineSig[id] = sig;
+        }
+
+        void replaced(uint32_t id) {
+            lastReplaced = id;
+        }
+
+        template <typename C> inline uint32_t rank(const MemReq* req, C cands) {
+            uint32_t bestCand = -1;
+            uint8_t bestRrpv = 0;
+            for (auto ci = cands.begin(); ci != cands.end(); ci.inc()) {
+                if (!cc->isValid(*ci)) return *ci;
+                if (rrpv[*ci] == MAX_RRPV) return *ci; //cache-averse
+                if (bestCand == (uint32_t)-1 || rrpv[*ci] > bestRrpv) {
+                    bestCand = *ci;
+                    bestRrpv = rrpv[*ci];
+                }
+            }
+            //Evicting a line we thought was friendly: the prediction was wrong
+            profDetrains.inc();
+            uint8_t& ctr = predictor[lineSig[bestCand]];
+            if (ctr) ctr--;
+            return bestCand;
+        }
+
+        DECL_RANK_BINDINGS;
+
+    private:
+        inline uint32_t signature(Address lineAddr) const {
+            Address region = lineAddr >> regionBits;
+            return (region ^ (region >> 14) ^ (region >> 28)) & predMask;
+        }
+
+        void optgen(SampledSet& s, Address lineAddr, uint32_t sig) {
+            uint64_t now = s.time++;
+            s.occupancy[now % historyLen] = 0;
+
+            SamplerEntry* e = nullptr;
+            SamplerEntry* lru = &s.history[0];
+            for (uint32_t i = 0; i < historyLen; i++) {
+                SamplerEntry& h = s.history[i];
+                if (h.lineAddr == lineAddr) {
+                    e = &h;
+                    break;
+                }
+                if (h.lastTime < lru->lastTime) lru = &h;
+            }
+
+            if (e) {
+                //Would OPT have kept the line since its last access?
+                bool optHit = false;
+                if (now - e->lastTime < historyLen) {
+                    optHit = true;
+                    for (uint64_t t = e->lastTime; t < now; t++) {
+                        if (s.occupancy[t % historyLen] >= ways) {
+                            optHit = false;
+                            break;
+                        }
+                    }
+                    if (optHit) {
+                        for (uint64_t t = e->lastTime; t < now; t++) s.occupancy[t % historyLen]++;
+                    }
+                }
+                uint8_t& ctr = predictor[e->sig];
+                if (optHit) {
+                    profOptHits.inc();
+                    if (ctr < PRED_MAX) ctr++;
+                } else {
+                    profOptMisses.inc();
+                    if (ctr) ctr--;
+                }
+            } else {
+                e = lru;
+                e->lineAddr = lineAddr;
+            }
+            e->lastTime = now;
+            e->sig = sig;
+        }
+};
+
 //Extends a given replacement policy to profile access ordering violations
 template <class T>
 class ProfViolReplPolicy : public T {
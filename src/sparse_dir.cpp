@@ -0,0 +1,316 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sparse_dir.h"
+#include "cache.h"
+#include "network.h"
+
+SparseDirTopCC::SparseDirTopCC(uint32_t _numLines, uint32_t _numEntries, uint32_t _numWays, SharerFormat _format, uint32_t _maxPtrs, uint32_t _groupSize)
+    : numEntries(_numEntries), numWays(_numWays), curUse(0), numLines(_numLines), format(_format), maxPtrs(_maxPtrs), groupSize(_groupSize),
+      wordsPerEntry(0), ptrs(nullptr), bits(nullptr)
+{
+    assert(numWays > 0 && numEntries % numWays == 0);
+    numSets = numEntries/numWays;
+    if (format == SHARERS_FULLMAP) maxPtrs = 0;
+    array = gm_calloc<Entry>(numEntries);
+    for (uint32_t i = 0; i < numEntries; i++) {
+        array[i].lineId = -1;
+    }
+    lineToEntry = gm_calloc<int32_t>(numLines);
+    for (uint32_t i = 0; i < numLines; i++) {
+        lineToEntry[i] = -1;
+    }
+    futex_init(&ccLock);
+}
+
+void SparseDirTopCC::init(const g_vector<BaseCache*>& _children, Network* network, const char* name) {
+    if (_children.size() > (1 << 16)) {
+        panic("[%s] Children size (%d) > %d, not supported by sparse directories", name, (uint32_t)_children.size(), 1 << 16);
+    }
+    children.resize(_children.size());
+    childrenRTTs.resize(_children.size());
+    for (uint32_t c = 0; c < children.size(); c++) {
+        children[c] = _children[c];
+        childrenRTTs[c] = (network)? network->getRTT(name, children[c]->getName()) : 0;
+    }
+
+    uint32_t numBits = 0;
+    if (format == SHARERS_FULLMAP) numBits = children.size();
+    else if (format == SHARERS_COARSEVECTOR) numBits = (children.size() + groupSize - 1)/groupSize;
+    wordsPerEntry = (numBits + 63)/64;
+    if (maxPtrs) ptrs = gm_calloc<uint16_t>(numEntries*maxPtrs);
+    if (wordsPerEntry) bits = gm_calloc<uint64_t>(numEntries*wordsPerEntry);
+}
+
+void SparseDirTopCC::initStats(AggregateStat* parentStat) {
+    profEvictions.init("dirEvs", "Directory evictions");
+    profEvInvs.init("dirEvINV", "Invalidates sent on directory evictions");
+    profOverflows.init("dirOverflows", "Sharer set overflows");
+    profSpuriousInvs.init("dirSpurINV", "Invalidates sent to non-sharers (imprecise sharer sets)");
+    parentStat->append(&profEvictions);
+    parentStat->append(&profEvInvs);
+    parentStat->append(&profOverflows);
+    parentStat->append(&profSpuriousInvs);
+}
+
+void SparseDirTopCC::addSharer(uint32_t entry, uint32_t childId) {
+    Entry& e = array[entry];
+    if (format == SHARERS_FULLMAP) {
+        setBit(entry, childId);
+    } else if (!e.overflow) {
+        uint16_t* p = &ptrs[entry*maxPtrs];
+        if (e.numPtrs < maxPtrs) {
+            p[e.numPtrs++] = childId;
+            return;
+        }
+        e.overflow = true;
+        profOverflows.inc();
+        if (format == SHARERS_COARSEVECTOR) {
+            for (uint32_t i = 0; i < e.numPtrs; i++) setBit(entry, p[i]/groupSize);
+            setBit(entry, childId/groupSize);
+        }
+        e.numPtrs = 0;
+    } else if (format == SHARERS_COARSEVECTOR) {
+        setBit(entry, childId/groupSize);
+    }
+}
+
+void SparseDirTopCC::removeSharer(uint32_t entry, uint32_t childId) {
+    Entry& e = array[entry];
+    if (format == SHARERS_FULLMAP) {
+        uint64_t* b = &bits[entry*wordsPerEntry];
+        assert(b[childId/64] & (1ul << (childId % 64)));
+        b[childId/64] &= ~(1ul << (childId % 64));
+    } else if (!e.overflow) {
+        uint16_t* p = &ptrs[entry*maxPtrs];
+        uint32_t i = 0;
+        while (i < e.numPtrs && p[i] != childId) i++;
+        assert_msg(i < e.numPtrs, "Child %d not in sharer set", childId);
+        p[i] = p[--e.numPtrs];
+    }
+    //overflowed sets can't drop sharers; they stay imprecise until the entry is cleared
+}
+
+void SparseDirTopCC::clearSharers(uint32_t entry) {
+    Entry& e = array[entry];
+    e.numSharers = 0;
+    e.numPtrs = 0;
+    e.exclusive = false;
+    e.overflow = false;
+    for (uint32_t w = 0; w < wordsPerEntry; w++) bits[entry*wordsPerEntry + w] = 0;
+}
+
+void SparseDirTopCC::freeEntry(uint32_t entry) {
+    Entry& e = array[entry];
+    assert(e.lineId != -1 && lineToEntry[e.lineId] == (int32_t)entry);
+    clearSharers(entry);
+    lineToEntry[e.lineId] = -1;
+    e.lineId = -1;
+}
+
+uint64_t SparseDirTopCC::sendInvalidate(uint32_t childId, const InvReq& req) {
+    return children[childId]->invalidate(req) + childrenRTTs[childId];
+}
+
+uint64_t SparseDirTopCC::sendInvalidates(uint32_t entry, InvType type, bool* reqWriteback, uint64_t cycle, uint32_t srcId, uint32_t skipChild) {
+    Entry& e = array[entry];
+
+    //Don't propagate downgrades if sharers are not exclusive.
+    if (type == INVX && !e.isExclusive()) {
+        return cycle;
+    }
+    if (e.numSharers == 0) return cycle;
+
+    bool precise = isPrecise(e);
+    InvReq req = {e.lineAddr, type, reqWriteback, cycle, srcId, !precise};
+    uint64_t maxCycle = cycle; //keep maximum cycle only, we assume all invals are sent in parallel
+    uint32_t sentInvs = 0;
+    uint32_t numChildren = children.size();
+    if (format == SHARERS_FULLMAP || (format == SHARERS_COARSEVECTOR && e.overflow)) {
+        uint32_t span = (format == SHARERS_FULLMAP)? 1 : groupSize;
+        const uint64_t* b = &bits[entry*wordsPerEntry];
+        for (uint32_t w = 0; w < wordsPerEntry; w++) {
+            uint64_t word = b[w];
+            while (word) {
+                uint32_t bit = w*64 + __builtin_ctzl(word);
+                word &= word - 1;
+                for (uint32_t c = bit*span; c < MIN((bit + 1)*span, numChildren); c++) {
+                    if (c == skipChild) continue;
+                    maxCycle = MAX(maxCycle, sendInvalidate(c, req));
+                    sentInvs++;
+                }
+            }
+        }
+    } else if (!e.overflow) {
+        const uint16_t* p = &ptrs[entry*maxPtrs];
+        for (uint32_t i = 0; i < e.numPtrs; i++) {
+            if (p[i] == skipChild) continue;
+            maxCycle = MAX(maxCycle, sendInvalidate(p[i], req));
+            sentInvs++;
+        }
+    } else {  // overflowed limited pointers, broadcast
+        for (uint32_t c = 0; c < numChildren; c++) {
+            if (c == skipChild) continue;
+            maxCycle = MAX(maxCycle, sendInvalidate(c, req));
+            sentInvs++;
+        }
+    }
+
+    if (precise) {
+        assert(sentInvs == e.numSharers);
+    } else {
+        assert(sentInvs >= e.numSharers);
+        profSpuriousInvs.inc(sentInvs - e.numSharers);
+    }
+
+    if (type == INV) {
+        clearSharers(entry);
+    } else {
+        assert(e.isExclusive());
+        e.exclusive = false;
+    }
+    return maxCycle;
+}
+
+uint64_t SparseDirTopCC::allocEntry(Address lineAddr, uint32_t lineId, Address* evLineAddr, int32_t* evLineId, bool* evWriteback, uint64_t cycle, uint32_t srcId) {
+    if (lineToEntry[lineId] != -1) {
+        array[lineToEntry[lineId]].lastUse = ++curUse;
+        return cycle;
+    }
+
+    uint32_t set = (uint32_t)(((lineAddr * 0x9E3779B97F4A7C15ul) >> 32) % numSets);
+    uint32_t first = set*numWays;
+    uint32_t victim = first;
+    for (uint32_t w = first; w < first + numWays; w++) {
+        if (array[w].lineId == -1) {
+            victim = w;
+            break;
+        }
+        if (array[w].lastUse < array[victim].lastUse) victim = w;
+    }
+
+    uint64_t respCycle = cycle;
+    Entry& e = array[victim];
+    if (e.lineId != -1) {
+        //Conflict in the directory: the sharers of the LRU entry lose their copies
+        profEvictions.inc();
+        profEvInvs.inc(e.numSharers);
+        bool wb = false;
+        *evLineAddr = e.lineAddr;
+        *evLineId = e.lineId;
+        respCycle = sendInvalidates(victim, INV, &wb, cycle, srcId);
+        *evWriteback = wb;
+        freeEntry(victim);
+    }
+
+    e.lineAddr = lineAddr;
+    e.lineId = lineId;
+    e.lastUse = ++curUse;
+    clearSharers(victim);
+    lineToEntry[lineId] = victim;
+    return respCycle;
+}
+
+uint64_t SparseDirTopCC::processEviction(Address wbLineAddr, uint32_t lineId, bool* reqWriteback, uint64_t cycle, uint32_t srcId) {
+    int32_t entry = lineToEntry[lineId];
+    if (entry == -1) return cycle;  //no child has it
+    uint64_t respCycle = sendInvalidates(entry, INV, reqWriteback, cycle, srcId);
+    freeEntry(entry);
+    return respCycle;
+}
+
+uint64_t SparseDirTopCC::processAccess(Address lineAddr, uint32_t lineId, AccessType type, uint32_t childId, bool haveExclusive,
+                                       MESIState* childState, bool* inducedWriteback, uint64_t cycle, uint32_t srcId, uint32_t flags) {
+    int32_t entry = lineToEntry[lineId];
+    assert(entry != -1);  //GETs allocate, PUTs come from sharers
+    Entry& e = array[entry];
+    uint64_t respCycle = cycle;
+    switch (type) {
+        case PUTX:
+            assert(e.isExclusive());
+            if (flags & MemReq::PUTX_KEEPEXCL) {
+                assert(*childState == M);
+                *childState = E; //they don't hold dirty data anymore
+                break; //don't remove from sharer set. It'll keep exclusive perms.
+            }
+            //note NO break in general
+        case PUTS:
+            removeSharer(entry, childId);
+            e.numSharers--;
+            *childState = I;
+            if (e.numSharers == 0) freeEntry(entry);
+            break;
+        case GETS:
+            if (e.numSharers == 0 && haveExclusive && !(flags & MemReq::NOEXCL)) {
+                //Give in E state
+                addSharer(entry, childId);
+                e.exclusive = true;
+                e.numSharers = 1;
+                *childState = E;
+            } else {
+                //Give in S state
+                if (e.isExclusive()) {
+                    //Downgrade the exclusive sharer
+                    respCycle = sendInvalidates(entry, INVX, inducedWriteback, cycle, srcId);
+                }
+                addSharer(entry, childId);
+                e.numSharers++;
+                e.exclusive = false;
+                *childState = S;
+            }
+            break;
+        case GETX:
+            assert(haveExclusive); //the current cache better have exclusive access to this line
+
+            // If the child is a sharer (upgrade miss), take it out. Its state tells, since sharer sets may be imprecise
+            if (*childState != I) {
+                assert_msg(!e.isExclusive(), "Spurious GETX, childId=%d numSharers=%d", childId, e.numSharers);
+                removeSharer(entry, childId);
+                e.numSharers--;
+            }
+
+            // Invalidate all other copies
+            respCycle = sendInvalidates(entry, INV, inducedWriteback, cycle, srcId, childId);
+
+            // Set current sharer, mark exclusive
+            addSharer(entry, childId);
+            e.numSharers = 1;
+            e.exclusive = true;
+            *childState = M; //give in M directly
+            break;
+
+        default: panic("!?");
+    }
+    return respCycle;
+}
+
+uint64_t SparseDirTopCC::processInval(Address lineAddr, uint32_t lineId, InvType type, bool* reqWriteback, uint64_t cycle, uint32_t srcId) {
+    if (type == FWD) return cycle;  //we are inclusive, so we have the line, just invLat works
+    int32_t entry = lineToEntry[lineId];
+    if (entry == -1) return cycle;
+    uint64_t respCycle = sendInvalidates(entry, type, reqWriteback, cycle, srcId);
+    if (type == INV) freeEntry(entry);
+    return respCycle;
+}
@@ -0,0 +1,267 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPARSE_DIR_H_
+#define SPARSE_DIR_H_
+
+#include "coherence_ctrls.h"
+
+/* Sparse directory coherence.
+ *
+ * MESITopCC keeps a full sharer bit-vector for every line of the cache, which caps the number of children at
+ * MAX_CACHE_CHILDREN and costs numLines * MAX_CACHE_CHILDREN bits. SparseDirTopCC instead tracks the lines cached
+ * by its children in a separate set-associative directory with its own capacity. Allocating an entry in a full set
+ * evicts the LRU entry and invalidates its sharers (the line itself stays in the cache), so undersized directories
+ * show the conflict invalidations of real sparse directories.
+ *
+ * Each entry stores its sharers in one of these formats:
+ *  - FullMap: one bit per child (precise).
+ *  - LimitedPtr: up to a number of child pointers; on overflow, invalidates are broadcast to all children (Dir_iB).
+ *  - CoarseVector: up to a number of child pointers; on overflow, one bit per group of children (Dir_iCV).
+ * The number of sharers is always kept exactly, so PUTs on overflowed entries and freeing entries work as usual.
+ * Invalidates to imprecise sharer sets are marked as such, and children that do not have the line just ack them.
+ */
+
+enum SharerFormat {
+    SHARERS_FULLMAP,
+    SHARERS_LIMITEDPTR,
+    SHARERS_COARSEVECTOR
+};
+
+class SparseDirTopCC : public GlobAlloc {
+    private:
+        struct Entry {
+            Address lineAddr;
+            int32_t lineId;  // -1 if free
+            uint32_t numSharers;  // exact, even if the sharer set is not
+            uint32_t numPtrs;
+            bool exclusive;
+            bool overflow;
+            uint64_t lastUse;
+
+            bool isExclusive() {
+                return (numSharers == 1) && (exclusive);
+            }
+        };
+
+        Entry* array;
+        uint32_t numEntries;
+        uint32_t numWays;
+        uint32_t numSets;
+        uint64_t curUse;
+
+        int32_t* lineToEntry;  // per cache line, -1 if no child has it
+        uint32_t numLines;
+
+        SharerFormat format;
+        uint32_t maxPtrs;
+        uint32_t groupSize;
+        uint32_t wordsPerEntry;
+        uint16_t* ptrs;  // maxPtrs per entry
+        uint64_t* bits;  // wordsPerEntry per entry; full map or coarse vector
+
+        g_vector<BaseCache*> children;
+        g_vector<uint32_t> childrenRTTs;
+
+        Counter profEvictions, profEvInvs, profOverflows, profSpuriousInvs;
+
+        PAD();
+        lock_t ccLock;
+        PAD();
+
+    public:
+        SparseDirTopCC(uint32_t _numLines, uint32_t _numEntries, uint32_t _numWays, SharerFormat _format, uint32_t _maxPtrs, uint32_t _groupSize);
+
+        void init(const g_vector<BaseCache*>& _children, Network* network, const char* name);
+        void initStats(AggregateStat* parentStat);
+
+        // Makes sure lineAddr has a directory entry. If this evicts another entry and its sharers write back, returns
+        // the evicted line in evLineAddr/evLineId and sets evWriteback
+        uint64_t allocEntry(Address lineAddr, uint32_t lineId, Address* evLineAddr, int32_t* evLineId, bool* evWriteback, uint64_t cycle, uint32_t srcId);
+
+        uint64_t processEviction(Address wbLineAddr, uint32_t lineId, bool* reqWriteback, uint64_t cycle, uint32_t srcId);
+
+        uint64_t processAccess(Address lineAddr, uint32_t lineId, AccessType type, uint32_t childId, bool haveExclusive,
+                MESIState* childState, bool* inducedWriteback, uint64_t cycle, uint32_t srcId, uint32_t flags);
+
+        uint64_t processInval(Address lineAddr, uint32_t lineId, InvType type, bool* reqWriteback, uint64_t cycle, uint32_t srcId);
+
+        inline void lock() {
+            futex_lock(&ccLock);
+        }
+
+        inline void unlock() {
+            futex_unlock(&ccLock);
+        }
+
+        /* Replacement policy query interface */
+        inline uint32_t numSharers(uint32_t lineId) {
+            int32_t entry = lineToEntry[lineId];
+            return (entry == -1)? 0 : array[entry].numSharers;
+        }
+
+    private:
+        inline bool isPrecise(const Entry& e) const {
+            return format == SHARERS_FULLMAP || !e.overflow;
+        }
+
+        inline void setBit(uint32_t entry, uint32_t bit) {
+            bits[entry*wordsPerEntry + bit/64] |= 1ul << (bit % 64);
+        }
+
+        void addSharer(uint32_t entry, uint32_t childId);
+        void removeSharer(uint32_t entry, uint32_t childId);
+        void clearSharers(uint32_t entry);
+        void freeEntry(uint32_t entry);
+
+        // Sends an invalidate or downgrade to every child in the sharer set except skipChild
+        uint64_t sendInvalidates(uint32_t entry, InvType type, bool* reqWriteback, uint64_t cycle, uint32_t srcId, uint32_t skipChild = (uint32_t)-1);
+        uint64_t sendInvalidate(uint32_t childId, const InvReq& req);
+};
+
+// Non-terminal CC backed by a sparse directory; same protocol as MESICC. Does not support nonInclusiveHack.
+class MESISparseDirCC : public CC {
+    private:
+        SparseDirTopCC* tcc;
+        MESIBottomCC* bcc;
+        uint32_t numLines;
+        uint32_t dirEntries;
+        uint32_t dirWays;
+        SharerFormat format;
+        uint32_t maxPtrs;
+        uint32_t groupSize;
+        g_string name;
+
+    public:
+        //Initialization
+        MESISparseDirCC(uint32_t _numLines, uint32_t _dirEntries, uint32_t _dirWays, SharerFormat _format, uint32_t _maxPtrs, uint32_t _groupSize, g_string& _name)
+            : tcc(nullptr), bcc(nullptr), numLines(_numLines), dirEntries(_dirEntries), dirWays(_dirWays), format(_format),
+              maxPtrs(_maxPtrs), groupSize(_groupSize), name(_name) {}
+
+        void setParents(uint32_t childId, const g_vector<MemObject*>& parents, Network* network) {
+            bcc = new MESIBottomCC(numLines, childId, false /*inclusive*/);
+            bcc->init(parents, network, name.c_str());
+        }
+
+        void setChildren(const g_vector<BaseCache*>& children, Network* network) {
+            tcc = new SparseDirTopCC(numLines, dirEntries, dirWays, format, maxPtrs, groupSize);
+            tcc->init(children, network, name.c_str());
+        }
+
+        void initStats(AggregateStat* cacheStat) {
+            bcc->initStats(cacheStat);
+            tcc->initStats(cacheStat);
+        }
+
+        //Access methods
+        bool startAccess(MemReq& req) {
+            assert((req.type == GETS) || (req.type == GETX) || (req.type == PUTS) || (req.type == PUTX));
+            if (req.childLock) {
+                futex_unlock(req.childLock);
+            }
+
+            tcc->lock(); //must lock tcc FIRST
+            bcc->lock();
+
+            bool skipAccess = CheckForMESIRace(req.type /*may change*/, req.state, req.initialState);
+            return skipAccess;
+        }
+
+        bool shouldAllocate(const MemReq& req) {
+            if ((req.type == GETS) || (req.type == GETX)) {
+                return true;
+            } else {
+                panic("[%s] We lost inclusion on this line! 0x%lx, type %s, childId %d, childState %s", name.c_str(),
+                        req.lineAddr, AccessTypeName(req.type), req.childId, MESIStateName(*req.state));
+            }
+        }
+
+        uint64_t processEviction(const MemReq& triggerReq, Address wbLineAddr, int32_t lineId, uint64_t startCycle) {
+            bool lowerLevelWriteback = false;
+            uint64_t evCycle = tcc->processEviction(wbLineAddr, lineId, &lowerLevelWriteback, startCycle, triggerReq.srcId);
+            evCycle = bcc->processEviction(wbLineAddr, lineId, lowerLevelWriteback, evCycle, triggerReq.srcId);
+            return evCycle;
+        }
+
+        uint64_t processAccess(const MemReq& req, int32_t lineId, uint64_t startCycle, uint64_t* getDoneCycle = nullptr) {
+            assert(lineId != -1);
+            bool isPrefetch = req.flags & MemReq::PREFETCH;
+            assert(!isPrefetch || req.type == GETS);
+            uint32_t flags = req.flags & ~MemReq::PREFETCH;
+
+            uint64_t respCycle = bcc->processAccess(req.lineAddr, lineId, req.type, startCycle, req.srcId, flags);
+            if (getDoneCycle) *getDoneCycle = respCycle;
+            if (!isPrefetch) {
+                if ((req.type == GETS) || (req.type == GETX)) {
+                    //Directory evictions invalidate the sharers of another line, which we keep; if they had it dirty, it is now dirty here
+                    Address evLineAddr = 0;
+                    int32_t evLineId = -1;
+                    bool evWriteback = false;
+                    respCycle = tcc->allocEntry(req.lineAddr, lineId, &evLineAddr, &evLineId, &evWriteback, respCycle, req.srcId);
+                    if (evWriteback) bcc->processWritebackOnAccess(evLineAddr, evLineId, PUTX);
+                }
+                bool lowerLevelWriteback = false;
+                respCycle = tcc->processAccess(req.lineAddr, lineId, req.type, req.childId, bcc->isExclusive(lineId), req.state,
+                        &lowerLevelWriteback, respCycle, req.srcId, flags);
+                if (lowerLevelWriteback) {
+                    bcc->processWritebackOnAccess(req.lineAddr, lineId, req.type);
+                }
+            }
+            return respCycle;
+        }
+
+        void endAccess(const MemReq& req) {
+            //Relock child before we unlock ourselves (hand-over-hand)
+            if (req.childLock) {
+                futex_lock(req.childLock);
+            }
+
+            bcc->unlock();
+            tcc->unlock();
+        }
+
+        //Inv methods
+        void startInv() {
+            bcc->lock(); //as in MESICC, down accesses don't grab tcc; the directory is only modified with bcc held
+        }
+
+        uint64_t processInv(const InvReq& req, int32_t lineId, uint64_t startCycle) {
+            if (req.imprecise && (lineId == -1 || !bcc->isValid(lineId))) { //imprecise invalidate of a line we don't have (maybe a stale I tag), just ack it
+                bcc->unlock();
+                return startCycle;
+            }
+            uint64_t respCycle = tcc->processInval(req.lineAddr, lineId, req.type, req.writeback, startCycle, req.srcId);
+            bcc->processInval(req.lineAddr, lineId, req.type, req.writeback);
+
+            bcc->unlock();
+            return respCycle;
+        }
+
+        //Repl policy interface
+        uint32_t numSharers(uint32_t lineId) {return tcc->numSharers(lineId);}
+        bool isValid(uint32_t lineId) {return bcc->isValid(lineId);}
+};
+
+#endif  // SPARSE_DIR_H_
@@ -0,0 +1,219 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tiered_mem.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "bithacks.h"
+#include "zsim.h"
+
+TieredMemory::TieredMemory(MemObject* localMem, MemObject* cxlMem, const Params& _params, uint32_t _lineSize,
+        uint32_t megacyclesPerSecond, const char* _name)
+    : params(_params), lineSize(_lineSize), name(_name)
+{
+    tiers[LOCAL] = localMem;
+    tiers[CXL] = cxlMem;
+
+    if (!isPow2(params.pageSize) || params.pageSize < lineSize) panic("%s: invalid pageSize %d", name.c_str(), params.pageSize);
+    pageShift = ilog2(params.pageSize/lineSize);
+    localCapacityPages = ((uint64_t)params.localCapacityMB << 20)/params.pageSize;
+    tierPages[LOCAL] = tierPages[CXL] = 0;
+    touchedPages = 0;
+    if (params.policy == INTERLEAVE && !(params.localWeight + params.cxlWeight)) panic("%s: interleave weights can't both be 0", name.c_str());
+    if (params.policy == HOTNESS && !params.epochPhases) panic("%s: epochPhases must be > 0", name.c_str());
+
+    futex_init(&pageLock);
+    lastEpochPhase = 0;
+
+    double bytesPerCycle = ((double)params.linkBandwidth)/((double)megacyclesPerSecond);
+    maxLinkBytesPerCycle = bytesPerCycle;
+    assert(maxLinkBytesPerCycle > 0.0);
+    lastLinkPhase = 0;
+    curLinkBytes = 0;
+    smoothedLinkBytes = 0.0;
+    curLinkLatency = params.linkLatency;
+    futex_init(&updateLock);
+
+    info("%s: local %s (%ld pages) + CXL %s, %d-byte pages, link %d cycles %d MB/s", name.c_str(),
+            localMem->getName(), localCapacityPages, cxlMem->getName(), params.pageSize, params.linkLatency, params.linkBandwidth);
+}
+
+void TieredMemory::initStats(AggregateStat* parentStat) {
+    AggregateStat* memStats = new AggregateStat();
+    memStats->init(name.c_str(), "Tiered memory stats");
+    const char* tierNames[] = {"local", "cxl"};
+    const char* tierDescs[] = {"Local tier stats", "CXL tier stats"};
+    for (uint32_t t = 0; t < NUM_TIERS; t++) {
+        TierStats& ts = tierStats[t];
+        AggregateStat* tierStat = new AggregateStat();
+        tierStat->init(tierNames[t], tierDescs[t]);
+        ts.profReads.init("rd", "Read requests"); tierStat->append(&ts.profReads);
+        ts.profWrites.init("wr", "Write requests"); tierStat->append(&ts.profWrites);
+        ts.profTotalRdLat.init("rdlat", "Total latency experienced by read requests"); tierStat->append(&ts.profTotalRdLat);
+        ts.profTotalWrLat.init("wrlat", "Total latency experienced by write requests"); tierStat->append(&ts.profTotalWrLat);
+        ts.profBytes.init("bytes", "Bytes transferred, including page migrations"); tierStat->append(&ts.profBytes);
+        ts.profPages.init("pages", "Pages currently placed in this tier", &tierPages[t]); tierStat->append(&ts.profPages);
+        memStats->append(tierStat);
+    }
+    profPromotions.init("promotions", "Pages migrated from CXL to local"); memStats->append(&profPromotions);
+    profDemotions.init("demotions", "Pages migrated from local to CXL"); memStats->append(&profDemotions);
+    profLinkLoad.init("linkLoad", "Sum of CXL link load factors (0-100) per update"); memStats->append(&profLinkLoad);
+    profLinkUpdates.init("linkUps", "Number of CXL link latency updates"); memStats->append(&profLinkUpdates);
+    profClampedLoads.init("clampedLoads", "Number of updates where the link load was clamped to 95%"); memStats->append(&profClampedLoads);
+    parentStat->append(memStats);
+
+    tiers[LOCAL]->initStats(parentStat);
+    tiers[CXL]->initStats(parentStat);
+}
+
+// Called with pageLock held
+uint32_t TieredMemory::placePage() {
+    uint32_t tier = (tierPages[LOCAL] < localCapacityPages)? LOCAL : CXL;
+    if (params.policy == INTERLEAVE && touchedPages % (params.localWeight + params.cxlWeight) >= params.localWeight) {
+        tier = CXL;
+    }
+    touchedPages++;
+    tierPages[tier]++;
+    return tier;
+}
+
+void TieredMemory::updateLink() {
+    uint64_t phaseCycles = (zinfo->numPhases - lastLinkPhase)*(zinfo->phaseLength);
+    if (phaseCycles < 10000) return; //Skip with short phases
+
+    smoothedLinkBytes = (curLinkBytes*0.5) + (smoothedLinkBytes*0.5);
+    double load = smoothedLinkBytes/((double)phaseCycles)/maxLinkBytesPerCycle;
+
+    //Clamp load
+    if (load > 0.95) {
+        load = 0.95;
+        profClampedLoads.inc();
+    }
+
+    // Each line occupies the link for serviceCycles; M/D/1 queueing delay is load/(2*(1-load)) times that
+    double serviceCycles = lineSize/maxLinkBytesPerCycle;
+    curLinkLatency = params.linkLatency + (uint32_t)(serviceCycles*(1.0 + 0.5*load/(1.0 - load)));
+
+    profLinkLoad.inc((uint32_t)(load*100.0));
+    profLinkUpdates.inc();
+
+    curLinkBytes = 0;
+    __sync_synchronize();
+    lastLinkPhase = zinfo->numPhases;
+}
+
+// Called with pageLock held
+void TieredMemory::migrate() {
+    std::vector< std::pair<uint32_t, Address> > hot, cold;
+    for (auto& it : pages) {
+        const PageInfo& pi = it.second;
+        if (pi.tier == CXL && pi.accesses >= params.hotThreshold) hot.push_back(std::make_pair(pi.accesses, it.first));
+        else if (pi.tier == LOCAL) cold.push_back(std::make_pair(pi.accesses, it.first));
+    }
+
+    // Hottest CXL pages first, coldest local pages first
+    uint32_t numHot = std::min((size_t)params.maxMigrations, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + numHot, hot.end(), std::greater< std::pair<uint32_t, Address> >());
+    uint32_t numCold = std::min((size_t)numHot, cold.size());
+    std::partial_sort(cold.begin(), cold.begin() + numCold, cold.end());
+
+    uint32_t promotions = 0, demotions = 0;
+    for (uint32_t i = 0; i < numHot; i++) {
+        if (tierPages[LOCAL] >= localCapacityPages) {
+            // Swap with the coldest local page, if it's colder
+            if (demotions == numCold || cold[demotions].first >= hot[i].first) break;
+            pages[cold[demotions].second].tier = CXL;
+            tierPages[LOCAL]--;
+            tierPages[CXL]++;
+            demotions++;
+        }
+        pages[hot[i].second].tier = LOCAL;
+        tierPages[CXL]--;
+        tierPages[LOCAL]++;
+        promotions++;
+    }
+
+    // Each migration reads a page from one tier and writes it to the other, and crosses the link
+    uint64_t migBytes = (uint64_t)(promotions + demotions)*params.pageSize;
+    __sync_fetch_and_add(&curLinkBytes, migBytes);
+    tierStats[LOCAL].profBytes.atomicInc(migBytes);
+    tierStats[CXL].profBytes.atomicInc(migBytes);
+    profPromotions.inc(promotions);
+    profDemotions.inc(demotions);
+
+    for (auto& it : pages) it.second.accesses /= 2;
+}
+
+uint64_t TieredMemory::access(MemReq& req) {
+    if (zinfo->numPhases > lastLinkPhase) {
+        futex_lock(&updateLock);
+        //Recheck, someone may have updated already
+        if (zinfo->numPhases > lastLinkPhase) {
+            updateLink();
+        }
+        futex_unlock(&updateLock);
+    }
+
+    Address page = req.lineAddr >> pageShift;
+    futex_lock(&pageLock);
+    if (params.policy == HOTNESS && zinfo->numPhases >= lastEpochPhase + params.epochPhases) {
+        migrate();
+        lastEpochPhase = zinfo->numPhases;
+    }
+    auto it = pages.find(page);
+    if (it == pages.end()) {
+        PageInfo pi = {placePage(), 0};
+        it = pages.insert(std::make_pair(page, pi)).first;
+    }
+    if (req.type != PUTS) it->second.accesses++;
+    uint32_t tier = it->second.tier;
+    futex_unlock(&pageLock);
+
+    if (req.type == PUTS) return tiers[tier]->access(req);  // not a real access
+
+    uint64_t reqCycle = req.cycle;
+    uint64_t respCycle;
+    if (tier == CXL) {
+        // Half the link latency each way; the cache hierarchy adds the gaps as delays in the weave phase
+        uint32_t linkLat = curLinkLatency;
+        __sync_fetch_and_add(&curLinkBytes, lineSize);
+        req.cycle = reqCycle + linkLat/2;
+        respCycle = tiers[CXL]->access(req) + (linkLat - linkLat/2);
+        req.cycle = reqCycle;
+    } else {
+        respCycle = tiers[LOCAL]->access(req);
+    }
+
+    TierStats& ts = tierStats[tier];
+    if (req.type == PUTX) {
+        ts.profWrites.atomicInc();
+        ts.profTotalWrLat.atomicInc(respCycle - reqCycle);
+    } else {
+        ts.profReads.atomicInc();
+        ts.profTotalRdLat.atomicInc(respCycle - reqCycle);
+    }
+    ts.profBytes.atomicInc(lineSize);
+    return respCycle;
+}
@@ -0,0 +1,118 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TIERED_MEM_H_
+#define TIERED_MEM_H_
+
+#include "g_std/g_string.h"
+#include "g_std/g_unordered_map.h"
+#include "locks.h"
+#include "memory_hierarchy.h"
+#include "pad.h"
+#include "stats.h"
+
+/* Two-tier memory: a local tier (e.g., DDR channels) and a CXL-attached
+ * expander, reached over a link that adds latency and has limited bandwidth.
+ *
+ * Pages are placed on first touch: in the local tier while it has room
+ * (FirstTouch, Hotness), or interleaved by weight (Interleave). Under Hotness,
+ * every epochPhases phases we promote the most accessed CXL pages, demoting
+ * the coldest local pages if the local tier is full. Migrations do not send
+ * requests to the tier controllers; instead, their copy traffic is charged to
+ * the CXL link, which is what limits migration bandwidth in practice.
+ *
+ * The link uses an M/D/1 model like MD1Memory: queueing delay grows with the
+ * link load seen in recent phases, including migration traffic.
+ */
+class TieredMemory : public MemObject {
+    public:
+        enum Policy {FIRST_TOUCH, INTERLEAVE, HOTNESS};
+
+        struct Params {
+            Policy policy;
+            uint32_t pageSize;         // in bytes
+            uint32_t localCapacityMB;
+            uint32_t localWeight, cxlWeight;  // Interleave
+            uint32_t epochPhases, maxMigrations, hotThreshold;  // Hotness
+            uint32_t linkLatency;      // round trip, in system cycles
+            uint32_t linkBandwidth;    // in MB/s
+        };
+
+    private:
+        enum {LOCAL = 0, CXL = 1, NUM_TIERS = 2};
+
+        struct PageInfo {
+            uint32_t tier;
+            uint32_t accesses;  // decays by half every epoch
+        };
+
+        MemObject* tiers[NUM_TIERS];
+        const Params params;
+        const uint32_t lineSize;
+        uint32_t pageShift;  // lineAddr >> pageShift is the page
+        uint64_t localCapacityPages;
+        uint64_t tierPages[NUM_TIERS];
+        uint64_t touchedPages;
+
+        g_unordered_map<Address, PageInfo> pages;
+        lock_t pageLock;
+        uint64_t lastEpochPhase;
+
+        // CXL link model
+        double maxLinkBytesPerCycle;
+        uint64_t lastLinkPhase;
+        uint64_t curLinkBytes;  // since lastLinkPhase, including migrations
+        double smoothedLinkBytes;
+        volatile uint32_t curLinkLatency;
+        lock_t updateLock;
+
+        g_string name;
+
+        PAD();
+        struct TierStats {
+            Counter profReads, profWrites;
+            Counter profTotalRdLat, profTotalWrLat;
+            Counter profBytes;  // demand and migration bytes
+            ProxyStat profPages;
+        } tierStats[NUM_TIERS];
+        Counter profPromotions, profDemotions;
+        Counter profLinkLoad, profLinkUpdates, profClampedLoads;
+        PAD();
+
+    public:
+        TieredMemory(MemObject* localMem, MemObject* cxlMem, const Params& _params, uint32_t _lineSize,
+                uint32_t megacyclesPerSecond, const char* _name);
+
+        void initStats(AggregateStat* parentStat);
+        const char* getName() {return name.c_str();}
+
+        uint64_t access(MemReq& req);
+
+    private:
+        uint32_t placePage();
+        void updateLink();
+        void migrate();
+};
+
+#endif  // TIERED_MEM_H_
@@ -53,6 +53,8 @@ class TimingCore : public Core {
         uint64_t getInstrs() const {return instrs;}
         uint64_t getPhaseCycles() const;
         uint64_t getCycles() const {return cRec.getUnhaltedCycles(curCycle);}
+        uint64_t getCurCycle() const {return curCycle;}
+        void stallUntil(uint64_t cycle) {if (cycle > curCycle) curCycle = cycle;}
 
         void contextSwitch(int32_t gid);
         virtual void join();
@@ -65,11 +65,9 @@ enum EventState {EV_INVALID, EV_NONE, EV_QUEUED, EV_RUNNING, EV_HELD, EV_DONE};
 class CrossingEvent;
 
 class TimingEvent {
-    private:
-        uint64_t privCycle; //only touched by ContentionSim
-
     public:
-        TimingEvent* next; //used by PrioQueue --- PRIVATE
+        TimingEvent* next; //used by TimingWheel --- PRIVATE
+        uint64_t queueCycle; //used by TimingWheel --- PRIVATE
 
     private:
         EventState state;
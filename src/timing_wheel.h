@@ -0,0 +1,237 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMING_WHEEL_H_
+#define TIMING_WHEEL_H_
+
+#include <stdint.h>
+#include "log.h"
+
+/* Hierarchical timing wheel; a drop-in replacement for PrioQueue without its far-element multimap.
+ *
+ * Level 0 is PrioQueue's array of B 64-slot bitmap blocks, but aligned: it holds the elements whose cycle only
+ * differs from the current cycle in the low log2(64*B) bits. Each of the L upper levels has 64 unordered slots,
+ * and holds the elements whose cycle first differs from the current cycle in that level's 6-bit digit (and only
+ * the overflow list holds elements beyond all levels). So every element in a level comes after every element in
+ * lower levels, and elements are only moved down (cascaded) when the current cycle enters their slot, at most L
+ * times each. Insertions are O(1); dequeues are O(1) amortized, plus a scan of the level-0 occupancy summary.
+ *
+ * Lists are intrusive, so nothing is allocated: T must have T* next and uint64_t queueCycle members, both private
+ * to the wheel. Like PrioQueue, elements may be enqueued on or after the block of the last dequeued element.
+ */
+template <typename T, uint32_t B, uint32_t L = 3>
+class TimingWheel {
+    static_assert(B >= 64 && (B & (B - 1)) == 0, "B must be a power of 2 >= 64");
+    static_assert(L >= 1 && 6 + __builtin_ctz(B) + 6*L < 64, "Too many levels");
+
+    static const uint32_t L0_BITS = 6 + __builtin_ctz(B);  // log2 of the cycles spanned by level 0
+
+    struct Block {
+        T* array[64];
+        uint64_t occ; // bit i is 1 if array[i] is populated
+    };
+
+    Block blocks[B];
+    uint64_t blocksOcc[B/64]; // bit i is 1 if blocks[i] is populated
+
+    T* slots[L][64];
+    uint64_t slotsOcc[L];
+    T* overflow;
+
+    uint64_t curBlock; // absolute, i.e., cycle/64
+    uint64_t elems;
+    uint64_t upperElems; // in upper levels or overflow
+
+    // Min cycle in upper levels, computed lazily; they are only scanned once per cascade
+    mutable uint64_t upperMin;
+    mutable bool upperMinValid;
+
+    public:
+        TimingWheel() {
+            for (uint32_t i = 0; i < B; i++) {
+                for (uint32_t j = 0; j < 64; j++) blocks[i].array[j] = nullptr;
+                blocks[i].occ = 0;
+            }
+            for (uint32_t i = 0; i < B/64; i++) blocksOcc[i] = 0;
+            for (uint32_t l = 0; l < L; l++) {
+                for (uint32_t j = 0; j < 64; j++) slots[l][j] = nullptr;
+                slotsOcc[l] = 0;
+            }
+            overflow = nullptr;
+            curBlock = 0;
+            elems = 0;
+            upperElems = 0;
+            upperMin = 0;
+            upperMinValid = false;
+        }
+
+        void enqueue(T* obj, uint64_t cycle) {
+            assert(cycle/64 >= curBlock);
+            assert(!obj->next);
+            obj->queueCycle = cycle;
+            place(obj);
+            elems++;
+        }
+
+        T* dequeue(uint64_t& deqCycle) {
+            assert(elems);
+            int64_t b;
+            while ((b = nextBlock()) == -1) cascade();
+
+            curBlock = (curBlock & ~(uint64_t)(B - 1)) + b;
+            Block& blk = blocks[b];
+            uint32_t pos = __builtin_ctzl(blk.occ);
+            T* res = blk.array[pos];
+            T* next = res->next;
+            blk.array[pos] = next;
+            if (!next) {
+                blk.occ ^= 1ul << pos;
+                if (!blk.occ) blocksOcc[b/64] ^= 1ul << (b % 64);
+            }
+            res->next = nullptr;
+            elems--;
+
+            deqCycle = curBlock*64 + pos;
+            assert(deqCycle == res->queueCycle);
+            return res;
+        }
+
+        inline uint64_t size() const {
+            return elems;
+        }
+
+        inline uint64_t firstCycle() const {
+            assert(elems);
+            int64_t b = nextBlock();
+            if (b != -1) return ((curBlock & ~(uint64_t)(B - 1)) + b)*64 + __builtin_ctzl(blocks[b].occ);
+            if (!upperMinValid) {
+                upperMin = findUpperMin();
+                upperMinValid = true;
+            }
+            return upperMin;
+        }
+
+    private:
+        static inline uint32_t shift(uint32_t level) { // of upper level 1..L
+            return L0_BITS + 6*(level - 1);
+        }
+
+        inline void place(T* obj) {
+            uint64_t cycle = obj->queueCycle;
+            uint64_t diff = cycle ^ (curBlock*64);
+            if (diff < (1ul << L0_BITS)) {
+                uint32_t b = (cycle/64) % B;
+                uint32_t pos = cycle % 64;
+                Block& blk = blocks[b];
+                blk.occ |= 1ul << pos;
+                blocksOcc[b/64] |= 1ul << (b % 64);
+                obj->next = blk.array[pos];
+                blk.array[pos] = obj;
+            } else {
+                uint32_t level = (63 - __builtin_clzl(diff) - L0_BITS)/6 + 1;
+                if (level <= L) {
+                    uint32_t s = (cycle >> shift(level)) % 64;
+                    obj->next = slots[level - 1][s];
+                    slots[level - 1][s] = obj;
+                    slotsOcc[level - 1] |= 1ul << s;
+                } else {
+                    obj->next = overflow;
+                    overflow = obj;
+                }
+                if (upperElems == 0) {
+                    upperMin = cycle;
+                    upperMinValid = true;
+                } else if (upperMinValid && cycle < upperMin) {
+                    upperMin = cycle;
+                }
+                upperElems++;
+            }
+        }
+
+        // Index of the first populated level-0 block at or after curBlock, or -1
+        inline int64_t nextBlock() const {
+            uint32_t b = curBlock % B;
+            if (blocks[b].occ) return b;
+            uint32_t w = b/64;
+            uint64_t occ = blocksOcc[w] & (~0ul << (b % 64));
+            while (!occ) {
+                if (++w == B/64) return -1;
+                occ = blocksOcc[w];
+            }
+            return w*64 + __builtin_ctzl(occ);
+        }
+
+        // Level 0 is empty: move the current cycle to the start of the first populated upper slot, and move its
+        // elements down
+        void cascade() {
+            assert(upperElems);
+            T* list;
+            uint64_t cur = curBlock*64;
+            uint32_t level = 1;
+            while (level <= L && !slotsOcc[level - 1]) level++;
+            if (level <= L) {
+                uint32_t s = __builtin_ctzl(slotsOcc[level - 1]);
+                uint32_t sh = shift(level);
+                cur = ((cur >> (sh + 6)) << (sh + 6)) | ((uint64_t)s << sh);
+                list = slots[level - 1][s];
+                slots[level - 1][s] = nullptr;
+                slotsOcc[level - 1] ^= 1ul << s;
+            } else {
+                // Past all levels; restart from the earliest overflow element
+                uint64_t minCycle = (uint64_t)-1;
+                for (T* e = overflow; e; e = e->next) minCycle = (e->queueCycle < minCycle)? e->queueCycle : minCycle;
+                cur = minCycle & ~63ul;
+                list = overflow;
+                overflow = nullptr;
+            }
+            assert(cur/64 >= curBlock);
+            curBlock = cur/64;
+            upperMinValid = false;
+
+            while (list) {
+                T* obj = list;
+                list = obj->next;
+                obj->next = nullptr;
+                upperElems--;
+                place(obj);
+            }
+        }
+
+        uint64_t findUpperMin() const {
+            assert(upperElems);
+            T* list = overflow;
+            for (uint32_t l = 0; l < L; l++) {
+                if (slotsOcc[l]) {
+                    list = slots[l][__builtin_ctzl(slotsOcc[l])];
+                    break;
+                }
+            }
+            uint64_t minCycle = (uint64_t)-1;
+            for (T* e = list; e; e = e->next) minCycle = (e->queueCycle < minCycle)? e->queueCycle : minCycle;
+            return minCycle;
+        }
+};
+
+#endif  // TIMING_WHEEL_H_
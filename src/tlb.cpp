@@ -0,0 +1,251 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tlb.h"
+#include <iterator>
+#include <map>
+#include "bithacks.h"
+#include "filter_cache.h"
+#include "locks.h"
+#include "timing_event.h"
+#include "zsim.h"
+
+static const uint32_t pageBits[NUM_PAGE_SIZES] = {12, 21, 30};
+static const uint32_t levelBits = 9;  // 512 entries per page-table level
+static const Address ptBase = 1UL << 48;  // page tables sit above the user address space
+
+/* Hugepage advice, per process */
+
+struct AdviceRange {
+    Address end;
+    bool huge;
+};
+
+static lock_t adviceLock;
+static std::map<Address, AdviceRange> adviceRanges;  // start -> range, non-overlapping
+static volatile uint32_t numAdviceRanges = 0;  // lets lookups skip the lock in the common case
+
+void RecordHugePageAdvice(Address start, uint64_t len, bool huge) {
+    if (!len) return;
+    Address end = start + len;
+    futex_lock(&adviceLock);
+    // Trim or split the ranges we overlap
+    auto it = adviceRanges.lower_bound(start);
+    if (it != adviceRanges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second.end > start) {
+            AdviceRange r = prev->second;
+            prev->second.end = start;
+            if (r.end > end) adviceRanges[end] = r;
+        }
+    }
+    while (it != adviceRanges.end() && it->first < end) {
+        if (it->second.end > end) adviceRanges[end] = it->second;
+        it = adviceRanges.erase(it);
+    }
+    adviceRanges[start] = {end, huge};
+    numAdviceRanges = adviceRanges.size();
+    futex_unlock(&adviceLock);
+}
+
+/* TlbArray */
+
+TlbArray::TlbArray(uint32_t entries, uint32_t ways) : numWays(ways), curTs(0) {
+    if (!ways || entries % ways) panic("TLB entries (%d) must be a multiple of ways (%d)", entries, ways);
+    numSets = entries/ways;
+    if (!isPow2(numSets)) panic("TLB sets (%d) must be a power of 2", numSets);
+    tags = gm_calloc<Address>(entries);
+    ts = gm_calloc<uint64_t>(entries);
+    for (uint32_t i = 0; i < entries; i++) tags[i] = -1L;
+}
+
+bool TlbArray::lookup(Address tag) {
+    uint32_t first = (tag & (numSets - 1))*numWays;
+    for (uint32_t w = first; w < first + numWays; w++) {
+        if (tags[w] == tag) {
+            ts[w] = ++curTs;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TlbArray::insert(Address tag) {
+    uint32_t first = (tag & (numSets - 1))*numWays;
+    uint32_t victim = first;
+    for (uint32_t w = first + 1; w < first + numWays; w++) {
+        if (ts[w] < ts[victim]) victim = w;
+    }
+    tags[victim] = tag;
+    ts[victim] = ++curTs;
+}
+
+/* Mmu */
+
+Mmu::Mmu(const uint32_t l1Entries[NUM_PAGE_SIZES], const uint32_t l1Ways[NUM_PAGE_SIZES], uint32_t l2Entries, uint32_t l2Ways,
+        uint32_t _l2Latency, uint32_t pwcEntries, uint32_t _pwcLatency, HugePagePolicy _policy, PageSize _maxPageSize, const g_string& _name)
+    : l2Latency(_l2Latency), pwcLatency(_pwcLatency), policy(_policy), maxPageSize(_maxPageSize), name(_name)
+{
+    for (uint32_t s = 0; s < NUM_PAGE_SIZES; s++) l1Tlbs[s] = new TlbArray(l1Entries[s], l1Ways[s]);
+    l2Tlb = new TlbArray(l2Entries, l2Ways);
+    pwcs[0] = nullptr;
+    for (uint32_t l = 1; l < LEVELS; l++) pwcs[l] = new TlbArray(pwcEntries, pwcEntries);  // fully associative
+    walkRecord.clear();
+}
+
+void Mmu::initStats(AggregateStat* parentStat) {
+    AggregateStat* mmuStat = new AggregateStat();
+    mmuStat->init(name.c_str(), "MMU stats");
+    static const char* sizeNames[] = {"4K", "2M", "1G"};
+    static const char* levelNames[] = {"PT", "PD", "PDPT", "PML4"};
+    profL1Hits.init("l1Hit", "L1 TLB hits", NUM_PAGE_SIZES, sizeNames); mmuStat->append(&profL1Hits);
+    profL2Hits.init("l2Hit", "L2 TLB hits", NUM_PAGE_SIZES, sizeNames); mmuStat->append(&profL2Hits);
+    profWalks.init("walks", "Page walks", NUM_PAGE_SIZES, sizeNames); mmuStat->append(&profWalks);
+    profPwcHits.init("pwcHit", "Page-walk cache hits (deepest level that hit)", LEVELS, levelNames); mmuStat->append(&profPwcHits);
+    profWalkAccesses.init("walkAcc", "Page-table accesses"); mmuStat->append(&profWalkAccesses);
+    profWalkCycles.init("walkCycles", "Cycles spent in page walks"); mmuStat->append(&profWalkCycles);
+    parentStat->append(mmuStat);
+}
+
+inline Address Mmu::tlbTag(Address vAddr, PageSize size) {
+    // procMask keeps processes apart, the size bits keep the unified L2 and PWC keys apart
+    return procMask | ((Address)size << 40) | (vAddr >> pageBits[size]);
+}
+
+PageSize Mmu::pageSizeOf(Address vAddr) const {
+    if (policy == THP_NEVER) return PAGE_4K;
+
+    bool huge = (policy == THP_ALWAYS);
+    Address lo = 0;
+    Address hi = -1L;
+    if (numAdviceRanges) {
+        futex_lock(&adviceLock);
+        auto it = adviceRanges.upper_bound(vAddr);
+        if (it != adviceRanges.begin()) {
+            it--;
+            if (it->second.end > vAddr) {
+                lo = it->first;
+                hi = it->second.end;
+                huge = it->second.huge;
+            }
+        }
+        futex_unlock(&adviceLock);
+    }
+    if (!huge) return PAGE_4K;
+
+    for (uint32_t s = maxPageSize; s > PAGE_4K; s--) {
+        Address frame = vAddr & ~((1UL << pageBits[s]) - 1);
+        if (frame >= lo && frame + (1UL << pageBits[s]) - 1 <= hi - 1) return (PageSize)s;
+    }
+    return PAGE_4K;
+}
+
+uint64_t Mmu::translate(Address vLineAddr, uint64_t curCycle, FilterCache* l1, uint32_t srcId) {
+    Address vAddr = vLineAddr << lineBits;
+
+    // L1 TLBs are probed in parallel with the (VIPT) L1, so hits are free
+    for (uint32_t s = 0; s < NUM_PAGE_SIZES; s++) {
+        if (l1Tlbs[s]->lookup(tlbTag(vAddr, (PageSize)s))) {
+            profL1Hits.inc(s);
+            return curCycle;
+        }
+    }
+
+    PageSize size = pageSizeOf(vAddr);
+    Address tag = tlbTag(vAddr, size);
+    uint64_t cycle = curCycle + l2Latency;
+    if (l2Tlb->lookup(tag)) {
+        profL2Hits.inc(size);
+        l1Tlbs[size]->insert(tag);
+        return cycle;
+    }
+
+    // Walk from the deepest level the page-walk caches have, down to the leaf
+    profWalks.inc(size);
+    uint32_t leaf = size;
+    uint32_t level = LEVELS - 1;
+    cycle += pwcLatency;
+    for (uint32_t l = leaf + 1; l < LEVELS; l++) {
+        if (pwcs[l]->lookup(tlbTag(vAddr >> (levelBits*l), PAGE_4K))) {
+            profPwcHits.inc(l);
+            level = l - 1;
+            break;
+        }
+    }
+
+    EventRecorder* evRec = zinfo->eventRecorders[srcId];
+    uint64_t walkStart = cycle;
+    for (int32_t l = level; l >= (int32_t)leaf; l--) {
+        Address pteAddr = ptBase | ((Address)l << 44) | ((vAddr >> (pageBits[PAGE_4K] + levelBits*l)) << 3);
+        cycle = l1->walkAccess(procMask | (pteAddr >> lineBits), cycle);
+        if (evRec && evRec->hasRecord()) chainRecord(evRec, evRec->popRecord());
+        if ((uint32_t)l > leaf) pwcs[l]->insert(tlbTag(vAddr >> (levelBits*l), PAGE_4K));
+        profWalkAccesses.inc();
+    }
+    profWalkCycles.inc(cycle - walkStart);
+
+    l2Tlb->insert(tag);
+    l1Tlbs[size]->insert(tag);
+    return cycle;
+}
+
+/* Walk accesses are dependent, so their records are chained rather than forked as in Cache::access. Records
+ * without an end event (e.g., writebacks or prefetches folded into a PUT) are fire-and-forget, so nothing chains
+ * after them: later records fork off a common start, as in Cache::access.
+ */
+void Mmu::chainRecord(EventRecorder* evRec, const TimingRecord& rec) {
+    if (!walkRecord.isValid()) {
+        walkRecord = rec;
+        return;
+    }
+    assert(rec.reqCycle >= walkRecord.reqCycle);
+    if (walkRecord.endEvent) {
+        assert(rec.reqCycle >= walkRecord.respCycle);
+        DelayEvent* dEv = new (evRec) DelayEvent(rec.reqCycle - walkRecord.respCycle);
+        dEv->setMinStartCycle(walkRecord.respCycle);
+        walkRecord.endEvent->addChild(dEv, evRec)->addChild(rec.startEvent, evRec);
+        if (!rec.endEvent) return;
+    } else {
+        DelayEvent* startEv = new (evRec) DelayEvent(0);
+        DelayEvent* dEv = new (evRec) DelayEvent(rec.reqCycle - walkRecord.reqCycle);
+        startEv->setMinStartCycle(walkRecord.reqCycle);
+        dEv->setMinStartCycle(walkRecord.reqCycle);
+        startEv->addChild(walkRecord.startEvent, evRec);
+        startEv->addChild(dEv, evRec)->addChild(rec.startEvent, evRec);
+        walkRecord.startEvent = startEv;
+    }
+    walkRecord.addr = rec.addr;
+    walkRecord.type = rec.type;
+    walkRecord.respCycle = rec.respCycle;
+    walkRecord.endEvent = rec.endEvent;
+}
+
+void Mmu::finishAccess(uint32_t srcId) {
+    if (!walkRecord.isValid()) return;
+    EventRecorder* evRec = zinfo->eventRecorders[srcId];
+    if (evRec->hasRecord()) chainRecord(evRec, evRec->popRecord());
+    evRec->pushRecord(walkRecord);
+    walkRecord.clear();
+}
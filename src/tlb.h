@@ -0,0 +1,114 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TLB_H_
+#define TLB_H_
+
+#include "event_recorder.h"
+#include "g_std/g_string.h"
+#include "galloc.h"
+#include "memory_hierarchy.h"
+#include "stats.h"
+
+/* Address translation model: per-core L1/L2 data TLBs, page-walk caches, and
+ * x86-64 radix page-table walks that go through the cache hierarchy.
+ *
+ * zsim does not model physical memory allocation (line addresses stay
+ * procMask | vLineAddr), so pages only matter for TLB reach and walk depth.
+ * Page sizes are chosen per address by a THP-like policy: never (4KB only),
+ * madvise (huge pages only in MADV_HUGEPAGE ranges, intercepted in virt), or
+ * always (huge pages everywhere, except MADV_NOHUGEPAGE ranges). Huge pages
+ * are the largest size up to maxPageSize whose aligned frame fits the range.
+ *
+ * Page-table entries live in a reserved region above the 48-bit user address
+ * space, laid out as one contiguous array per level, so neighboring pages
+ * share PTE lines as they do with real page tables.
+ */
+
+enum PageSize {PAGE_4K, PAGE_2M, PAGE_1G, NUM_PAGE_SIZES};
+
+enum HugePagePolicy {THP_NEVER, THP_MADVISE, THP_ALWAYS};
+
+// Records madvise(MADV_HUGEPAGE/MADV_NOHUGEPAGE) ranges of the current process (called from virt)
+void RecordHugePageAdvice(Address start, uint64_t len, bool huge);
+
+class FilterCache;
+
+// Set-associative, LRU array of translations
+class TlbArray : public GlobAlloc {
+    private:
+        Address* tags;
+        uint64_t* ts;
+        uint32_t numSets;
+        uint32_t numWays;
+        uint64_t curTs;
+
+    public:
+        TlbArray(uint32_t entries, uint32_t ways);
+
+        bool lookup(Address tag);
+        void insert(Address tag);
+};
+
+class Mmu : public GlobAlloc {
+    private:
+        static const uint32_t LEVELS = 4;
+
+        TlbArray* l1Tlbs[NUM_PAGE_SIZES];
+        TlbArray* l2Tlb;
+        TlbArray* pwcs[LEVELS];  // only the non-leaf levels (1-3) are used
+        uint32_t l2Latency;
+        uint32_t pwcLatency;
+        HugePagePolicy policy;
+        PageSize maxPageSize;
+        g_string name;
+
+        TimingRecord walkRecord;  // pending records of the current walk, chained
+
+        VectorCounter profL1Hits, profL2Hits, profWalks, profPwcHits;
+        Counter profWalkAccesses, profWalkCycles;
+
+    public:
+        Mmu(const uint32_t l1Entries[NUM_PAGE_SIZES], const uint32_t l1Ways[NUM_PAGE_SIZES], uint32_t l2Entries, uint32_t l2Ways,
+                uint32_t _l2Latency, uint32_t pwcEntries, uint32_t _pwcLatency, HugePagePolicy _policy, PageSize _maxPageSize, const g_string& _name);
+
+        void initStats(AggregateStat* parentStat);
+
+        /* Translates vLineAddr at curCycle, walking the page table through the given L1 on a TLB miss. Returns the
+         * cycle the translation is available. Called with the L1's filter lock held.
+         */
+        uint64_t translate(Address vLineAddr, uint64_t curCycle, FilterCache* l1, uint32_t srcId);
+
+        // Makes the access's timing record (if any) depend on the walk's; call after the translated access
+        void finishAccess(uint32_t srcId);
+
+    private:
+        PageSize pageSizeOf(Address vAddr) const;
+        void chainRecord(EventRecorder* evRec, const TimingRecord& rec);
+
+        static inline Address tlbTag(Address vAddr, PageSize size);
+};
+
+#endif  // TLB_H_
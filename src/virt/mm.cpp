@@ -0,0 +1,45 @@
+/** $lic$
+ * Copyright (C) 2012-2015 by Massachusetts Institute of Technology
+ * Copyright (C) 2010-2013 by The Board of Trustees of Stanford University
+ *
+ * This file is part of zsim.
+ *
+ * zsim is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2.
+ *
+ * If you use this software in your research, we request that you reference
+ * the zsim paper ("ZSim: Fast and Accurate Microarchitectural Simulation of
+ * Thousand-Core Systems", Sanchez and Kozyrakis, ISCA-40, June 2013) as the
+ * source of the simulator in any publications that use this software, and that
+ * you send us a citation of your work.
+ *
+ * zsim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sys/mman.h>
+#include "log.h"
+#include "tlb.h"
+#include "virt/common.h"
+
+// SYS_madvise
+
+/* The MMU model picks page sizes per address, so we record the MADV_HUGEPAGE
+ * and MADV_NOHUGEPAGE ranges that the kernel accepts.
+ */
+PostPatchFn PatchMadvise(PrePatchArgs args) {
+    ADDRINT start = PIN_GetSyscallArgument(args.ctxt, args.std, 0);
+    ADDRINT len = PIN_GetSyscallArgument(args.ctxt, args.std, 1);
+    int advice = PIN_GetSyscallArgument(args.ctxt, args.std, 2);
+    if (advice != MADV_HUGEPAGE && advice != MADV_NOHUGEPAGE) return NullPostPatch;
+    return [start, len, advice](PostPatchArgs args) {
+        if (PIN_GetSyscallReturn(args.ctxt, args.std) == 0) RecordHugePageAdvice(start, len, advice == MADV_HUGEPAGE);
+        return PPA_NOTHING;
+    };
+}
@@ -42,6 +42,9 @@ PF(SYS_getcpu, PatchGetcpu);
 PF(SYS_sched_getaffinity, PatchSchedGetaffinity);
 PF(SYS_sched_setaffinity, PatchSchedSetaffinity);
 
+// Hugepage advice -- mm.cpp
+PF(SYS_madvise, PatchMadvise);
+
 
 // Conditional patches, only when not fast-forwarded
 
@@ -41,19 +41,25 @@
 #include <sys/resource.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <vector>
 #include "access_tracing.h"
+#include "bbl_cache.h"
 #include "constants.h"
 #include "contention_sim.h"
 #include "core.h"
 #include "cpuenum.h"
 #include "cpuid.h"
 #include "debug_zsim.h"
+#include "decoder.h"
 #include "event_queue.h"
 #include "galloc.h"
+#include "gemm_accel.h"
 #include "init.h"
 #include "log.h"
 #include "pin.H"
 #include "pin_cmd.h"
+#include "pim_unit.h"
+#include "prefetcher.h"
 #include "process_tree.h"
 #include "profile_stats.h"
 #include "scheduler.h"
@@ -103,6 +109,15 @@ KNOB<bool> KnobLogToFile(KNOB_MODE_WRITEONCE, "pintool",
 KNOB<string> KnobOutputDir(KNOB_MODE_WRITEONCE, "pintool",
         "outputDir", "./", "absolute path to write output files into");
 
+//SSD checkpoints let many ROI runs start from one preconditioned, warmed-up drive
+//Each process models its own SSD, so both paths get a .<procIdx> suffix
+KNOB<string> KnobSSDCheckpointLoad(KNOB_MODE_WRITEONCE, "pintool",
+        "ssdCheckpointLoad", "", "SSD checkpoint to restore at startup, .<procIdx> is appended (empty: none)");
+
+KNOB<string> KnobSSDCheckpointSave(KNOB_MODE_WRITEONCE, "pintool",
+        "ssdCheckpointSave", "", "file to checkpoint the SSD state into when fast-forwarding ends, .<procIdx> is appended (empty: none)");
+
+
 
 
 /* ===================================================================== */
@@ -125,6 +140,7 @@ uint32_t lineBits; //process-local for performance, but logically global
 Address procMask;
 
 static ProcessTreeNode* procTreeNode;
+static BblCache* bblCache = nullptr;  // only used when sim.bblCacheDir is set
 
 //tid to cid translation
 #define INVALID_CID ((uint32_t)-1)
@@ -165,7 +181,7 @@ VOID SimThreadStart(THREADID tid);
 VOID SimThreadFini(THREADID tid);
 VOID SimEnd();
 
-VOID HandleMagicOp(THREADID tid, ADDRINT op);
+VOID HandleMagicOp(THREADID tid, ADDRINT op, ADDRINT arg);
 
 VOID HandleFlashGNNCall(THREADID tid, ADDRINT op);
 
@@ -227,6 +243,17 @@ VOID PIN_FAST_ANALYSIS_CALL IndirectPredStoreSingle(THREADID tid, ADDRINT addr,
     fPtrs[tid].predStorePtr(tid, addr, pred);
 }
 
+// Gathers issue one (predicated) load per element, see Decoder::emitGather. mask is null for AVX-512 opmasks.
+VOID PIN_FAST_ANALYSIS_CALL IndirectGather(THREADID tid, ADDRINT base, ADDRINT disp, UINT32 scale, const PIN_REGISTER* index,
+        const PIN_REGISTER* mask, UINT32 elems, UINT32 indexBytes, UINT32 dataBytes) {
+    for (uint32_t i = 0; i < elems; i++) {
+        int64_t idx = (indexBytes == 4)? (int64_t)(int32_t)index->dword[i] : (int64_t)index->qword[i];
+        ADDRINT addr = base + disp + idx*scale;
+        bool active = !mask || ((dataBytes == 4)? (mask->dword[i] >> 31) : (mask->qword[i] >> 63));
+        fPtrs[tid].predLoadPtr(tid, addr, active);
+    }
+}
+
 
 //Non-simulation variants of analysis functions
 
@@ -413,6 +440,10 @@ static const InstrFuncPtrs& GetFFPtrs() {
     return ffiEnabled? (ffiNFF? ffiEntryPtrs : ffiPtrs) : ffPtrs;
 }
 
+static std::string SSDCheckpointFile(const std::string& path) {
+    return path + "." + std::to_string(procIdx);
+}
+
 //Fast-forwarding
 void EnterFastForward() {
     assert(!procTreeNode->isInFastForward());
@@ -426,6 +457,9 @@ void EnterFastForward() {
     //Transition to FF; we have the ff lock, this should be safe with end of phase code. This avoids profiling the end of a simulation as bound time
     //NOTE: Does not work well with multiprocess runs
     zinfo->profSimTime->transition(PROF_FF);
+
+    //Keep the SSD mapping/cache state warm without simulating its timing
+    ssd->enter_functional_mode();
 }
 
 
@@ -437,6 +471,14 @@ void ExitFastForward() {
     procTreeNode->exitFastForward();
     __sync_synchronize(); //make change globally visible
 
+    //Hand the warmed-up SSD state over to the timing model
+    ssd->exit_functional_mode();
+    if (!KnobSSDCheckpointSave.Value().empty()) {
+        std::string file = SSDCheckpointFile(KnobSSDCheckpointSave.Value());
+        ssd->save_checkpoint(file);
+        info("Saved SSD checkpoint to %s", file.c_str());
+    }
+
     //Re-instrument; VM/client lock are not needed
     if (zinfo->ffReinstrument) {
         PIN_RemoveInstrumentation();
@@ -577,7 +619,23 @@ VOID Instruction(INS ins) {
         AFUNPTR PredLoadFuncPtr = (AFUNPTR) IndirectPredLoadSingle;
         AFUNPTR PredStoreFuncPtr = (AFUNPTR) IndirectPredStoreSingle;
 
-        if (INS_IsMemoryRead(ins)) {
+        GatherInfo gather;
+        if (Decoder::getGatherInfo(ins, gather)) {
+            // Vector-SIB addresses are computed from the index register, one access per element
+            REG baseReg = INS_OperandMemoryBaseReg(ins, gather.memOp);
+            REG indexReg = INS_OperandMemoryIndexReg(ins, gather.memOp);
+            ADDRINT disp = INS_OperandMemoryDisplacement(ins, gather.memOp);
+            UINT32 scale = INS_OperandMemoryScale(ins, gather.memOp);
+            IARGLIST args = IARGLIST_Alloc();
+            if (baseReg != REG_INVALID()) IARGLIST_AddArguments(args, IARG_REG_VALUE, baseReg, IARG_END);
+            else IARGLIST_AddArguments(args, IARG_ADDRINT, (ADDRINT)0, IARG_END);
+            IARGLIST_AddArguments(args, IARG_ADDRINT, disp, IARG_UINT32, scale, IARG_REG_CONST_REFERENCE, indexReg, IARG_END);
+            if (gather.maskReg != REG_INVALID()) IARGLIST_AddArguments(args, IARG_REG_CONST_REFERENCE, gather.maskReg, IARG_END);
+            else IARGLIST_AddArguments(args, IARG_PTR, nullptr, IARG_END);
+            INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR) IndirectGather, IARG_FAST_ANALYSIS_CALL, IARG_THREAD_ID, IARG_IARGLIST, args,
+                    IARG_UINT32, gather.elems, IARG_UINT32, gather.indexBytes, IARG_UINT32, gather.dataBytes, IARG_END);
+            IARGLIST_Free(args);
+        } else if (INS_IsMemoryRead(ins)) {
             if (!INS_IsPredicated(ins)) {
                 INS_InsertCall(ins, IPOINT_BEFORE, LoadFuncPtr, IARG_FAST_ANALYSIS_CALL, IARG_THREAD_ID, IARG_MEMORYREAD_EA, IARG_END);
             } else {
@@ -615,7 +673,7 @@ VOID Instruction(INS ins) {
      */
     if (INS_IsXchg(ins) && INS_OperandReg(ins, 0) == LEVEL_BASE::REG_RCX && INS_OperandReg(ins, 1) == LEVEL_BASE::REG_RCX) {
         //info("Instrumenting magic op");
-        INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR) HandleMagicOp, IARG_THREAD_ID, IARG_REG_VALUE, REG_ECX, IARG_END);
+        INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR) HandleMagicOp, IARG_THREAD_ID, IARG_REG_VALUE, REG_ECX, IARG_REG_VALUE, LEVEL_BASE::REG_RDX, IARG_END);
     }
 
     if (INS_Opcode(ins) == XED_ICLASS_CPUID) {
@@ -644,7 +702,7 @@ VOID Trace(TRACE trace, VOID *v) {
     if (!procTreeNode->isInFastForward() || !zinfo->ffReinstrument) {
         // Visit every basic block in the trace
         for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
-            BblInfo* bblInfo = Decoder::decodeBbl(bbl, zinfo->oooDecode);
+            BblInfo* bblInfo = bblCache? bblCache->decodeBbl(bbl) : Decoder::decodeBbl(bbl, zinfo->oooDecode);
             BBL_InsertCall(bbl, IPOINT_BEFORE /*could do IPOINT_ANYWHERE if we redid load and store simulation in OOO*/, (AFUNPTR)IndirectBasicBlock, IARG_FAST_ANALYSIS_CALL,
                  IARG_THREAD_ID, IARG_ADDRINT, BBL_Address(bbl), IARG_PTR, bblInfo, IARG_END);
         }
@@ -1141,6 +1199,7 @@ VOID SimEnd() {
 #ifdef BBL_PROFILING
     Decoder::dumpBblProfile();
 #endif
+    if (bblCache) bblCache->flush();
 
     //global
     bool lastToFinish = procTreeNode->notifyEnd();
@@ -1177,8 +1236,141 @@ VOID SimEnd() {
 #define ZSIM_MAGIC_OP_ROI_END           (1026)
 #define ZSIM_MAGIC_OP_REGISTER_THREAD   (1027)
 #define ZSIM_MAGIC_OP_HEARTBEAT         (1028)
+#define ZSIM_MAGIC_OP_REGISTER_CSR      (1034) //arg (rdx) points to a CSRGraphDesc
+#define ZSIM_MAGIC_OP_PIM_GATHER        (1035) //arg (rdx) points to a PIMGatherDesc
+
+//Must match ZsimPimGather in misc/hooks/zsim_hooks.h
+struct PIMGatherDesc {
+    uint64_t srcs;      //address of an array of numLines source addresses, each a line-aligned line
+    uint64_t dst;       //address of the line-sized result
+    uint32_t numLines;
+    uint32_t op;        //PIMUnit::ReduceOp
+};
+
+/* Reduces the source lines into dst functionally, and if the thread is being
+ * simulated, stalls its core until the PIM units would have finished.
+ */
+static void HandlePIMGather(THREADID tid, ADDRINT arg) {
+    if (!zinfo->pimUnit) panic("Thread %d: PIM_GATHER magic op, but sys.mem.pim is not configured", tid);
+    PIMGatherDesc desc;
+    if (PIN_SafeCopy(&desc, (const VOID*)arg, sizeof(desc)) != sizeof(desc)) {
+        panic("Thread %d: PIM_GATHER magic op with invalid descriptor 0x%lx", tid, arg);
+    }
+    if (!desc.numLines || desc.numLines > PIMUnit::MAX_LINES || !PIMUnit::validOp(desc.op)) {
+        panic("Thread %d: PIM_GATHER magic op with %d lines (max %d), op %d", tid, desc.numLines, PIMUnit::MAX_LINES, desc.op);
+    }
+
+    uint32_t lineSize = zinfo->lineSize;
+    std::vector<uint64_t> srcs(desc.numLines);
+    std::vector<uint8_t> acc(lineSize), line(lineSize);
+    size_t srcBytes = desc.numLines*sizeof(uint64_t);
+    if (PIN_SafeCopy(&srcs[0], (const VOID*)desc.srcs, srcBytes) != srcBytes) {
+        panic("Thread %d: PIM_GATHER magic op with invalid source list 0x%lx", tid, desc.srcs);
+    }
+    for (uint32_t i = 0; i < desc.numLines; i++) {
+        uint8_t* dst = i? &line[0] : &acc[0];
+        if (PIN_SafeCopy(dst, (const VOID*)srcs[i], lineSize) != lineSize) {
+            panic("Thread %d: PIM_GATHER magic op with invalid source 0x%lx", tid, srcs[i]);
+        }
+        if (i) PIMUnit::reduce(desc.op, &acc[0], &line[0], lineSize);
+    }
+    if (PIN_SafeCopy((VOID*)desc.dst, &acc[0], lineSize) != lineSize) {
+        panic("Thread %d: PIM_GATHER magic op with invalid destination 0x%lx", tid, desc.dst);
+    }
 
-VOID HandleMagicOp(THREADID tid, ADDRINT op) {
+    if (procTreeNode->isInFastForward() || getCid(tid) == INVALID_CID) return;
+    std::vector<Address> lineAddrs(desc.numLines);
+    for (uint32_t i = 0; i < desc.numLines; i++) lineAddrs[i] = procMask | (srcs[i] >> lineBits);
+    Core* core = cores[tid];
+    core->stallUntil(zinfo->pimUnit->gather(&lineAddrs[0], desc.numLines, core->getCurCycle()));
+}
+
+#define ZSIM_MAGIC_OP_ACCEL_GEMM        (1036) //arg (rdx) points to an AccelGemmDesc
+#define ZSIM_MAGIC_OP_ACCEL_WAIT        (1037) //arg (rdx) points to the AccelGemmDesc of a launched GEMM
+
+//Must match ZsimAccelGemm in misc/hooks/zsim_hooks.h
+struct AccelGemmDesc {
+    uint64_t a, b, c;       //row-major A (m x k), B (k x n) and C (m x n)
+    uint32_t m, n, k;
+    uint32_t lda, ldb, ldc; //row strides, in elements
+    uint32_t type;          //GemmAccel::ElemType
+    uint32_t flags;
+    uint64_t id;            //set by ACCEL_GEMM
+    uint32_t done;          //set by ACCEL_WAIT
+    uint32_t pad;
+};
+
+#define ACCEL_GEMM_ACCUMULATE (1 << 0)
+static const uint64_t ACCEL_UNTIMED_JOB = -1L; //launched while not simulated, waits return immediately
+
+static void ReadAccelGemmDesc(THREADID tid, ADDRINT arg, AccelGemmDesc& desc) {
+    if (!zinfo->gemmAccel) panic("Thread %d: accelerator magic op, but sys.accel is not configured", tid);
+    if (PIN_SafeCopy(&desc, (const VOID*)arg, sizeof(desc)) != sizeof(desc)) {
+        panic("Thread %d: accelerator magic op with invalid descriptor 0x%lx", tid, arg);
+    }
+}
+
+static void CopyAccelMatrix(THREADID tid, bool in, uint32_t* buf, uint64_t base, uint32_t rows, uint32_t cols, uint32_t ld) {
+    size_t rowBytes = cols*GemmAccel::ELEM_BYTES;
+    for (uint32_t r = 0; r < rows; r++) {
+        VOID* addr = (VOID*)(base + (uint64_t)r*ld*GemmAccel::ELEM_BYTES);
+        size_t bytes = in? PIN_SafeCopy(&buf[r*cols], addr, rowBytes) : PIN_SafeCopy(addr, &buf[r*cols], rowBytes);
+        if (bytes != rowBytes) panic("Thread %d: ACCEL_GEMM magic op with invalid matrix 0x%lx (row %d)", tid, base, r);
+    }
+}
+
+/* Computes C functionally, and if the thread is being simulated, queues the
+ * GEMM on the accelerator. The core does not stall until ACCEL_WAIT.
+ */
+static void HandleAccelGemm(THREADID tid, ADDRINT arg) {
+    AccelGemmDesc desc;
+    ReadAccelGemmDesc(tid, arg, desc);
+    if (!desc.m || !desc.n || !desc.k || desc.lda < desc.k || desc.ldb < desc.n || desc.ldc < desc.n || !GemmAccel::validType(desc.type)) {
+        panic("Thread %d: ACCEL_GEMM magic op with %dx%dx%d GEMM, strides %d/%d/%d, type %d",
+                tid, desc.m, desc.n, desc.k, desc.lda, desc.ldb, desc.ldc, desc.type);
+    }
+    bool accumulate = desc.flags & ACCEL_GEMM_ACCUMULATE;
+
+    std::vector<uint32_t> a((size_t)desc.m*desc.k), b((size_t)desc.k*desc.n), c((size_t)desc.m*desc.n);
+    CopyAccelMatrix(tid, true, &a[0], desc.a, desc.m, desc.k, desc.lda);
+    CopyAccelMatrix(tid, true, &b[0], desc.b, desc.k, desc.n, desc.ldb);
+    if (accumulate) CopyAccelMatrix(tid, true, &c[0], desc.c, desc.m, desc.n, desc.ldc);
+    GemmAccel::compute(desc.type, accumulate, &a[0], &b[0], &c[0], desc.m, desc.n, desc.k);
+    CopyAccelMatrix(tid, false, &c[0], desc.c, desc.m, desc.n, desc.ldc);
+
+    if (procTreeNode->isInFastForward() || getCid(tid) == INVALID_CID) {
+        desc.id = ACCEL_UNTIMED_JOB;
+    } else {
+        GemmAccel::Job job = {procMask, desc.a, desc.b, desc.c, desc.m, desc.n, desc.k,
+            desc.lda, desc.ldb, desc.ldc, accumulate, cores[tid]->getCurCycle()};
+        desc.id = zinfo->gemmAccel->launch(job);
+    }
+    PIN_SafeCopy((VOID*)(arg + offsetof(AccelGemmDesc, id)), &desc.id, sizeof(desc.id));
+}
+
+/* Stalls the core until the GEMM finishes. The accelerator's timeline is only
+ * computed up to the end of the current phase, so if the GEMM finishes later,
+ * this stalls to the end of the phase and reports not done, and the program
+ * retries.
+ */
+static void HandleAccelWait(THREADID tid, ADDRINT arg) {
+    AccelGemmDesc desc;
+    ReadAccelGemmDesc(tid, arg, desc);
+    uint32_t done = 1;
+    if (desc.id != ACCEL_UNTIMED_JOB && !procTreeNode->isInFastForward() && getCid(tid) != INVALID_CID) {
+        Core* core = cores[tid];
+        uint64_t doneCycle;
+        if (zinfo->gemmAccel->poll(desc.id, &doneCycle)) {
+            core->stallUntil(doneCycle);
+        } else {
+            core->stallUntil(zinfo->globPhaseCycles + zinfo->phaseLength);
+            done = 0;
+        }
+    }
+    PIN_SafeCopy((VOID*)(arg + offsetof(AccelGemmDesc, done)), &done, sizeof(done));
+}
+
+VOID HandleMagicOp(THREADID tid, ADDRINT op, ADDRINT arg) {
     switch (op) {
         case ZSIM_MAGIC_OP_ROI_BEGIN:
             if (!zinfo->ignoreHooks) {
@@ -1236,6 +1428,25 @@ VOID HandleMagicOp(THREADID tid, ADDRINT op) {
         case ZSIM_MAGIC_OP_HEARTBEAT:
             procTreeNode->heartbeat(); //heartbeats are per process for now
             return;
+        case ZSIM_MAGIC_OP_REGISTER_CSR:
+            {
+                CSRGraphDesc graph;
+                if (PIN_SafeCopy(&graph, (const VOID*)arg, sizeof(graph)) != sizeof(graph)) {
+                    warn("Thread %d: REGISTER_CSR magic op with invalid descriptor 0x%lx", tid, arg);
+                } else {
+                    CSRPrefetcher::registerGraph(graph);
+                }
+            }
+            return;
+        case ZSIM_MAGIC_OP_PIM_GATHER:
+            HandlePIMGather(tid, arg);
+            return;
+        case ZSIM_MAGIC_OP_ACCEL_GEMM:
+            HandleAccelGemm(tid, arg);
+            return;
+        case ZSIM_MAGIC_OP_ACCEL_WAIT:
+            HandleAccelWait(tid, arg);
+            return;
 
         // HACK: Ubik magic ops
         case 1029:
@@ -1595,6 +1806,12 @@ int main(int argc, char *argv[]) {
     procTreeNode = zinfo->procArray[procIdx];
     if (!masterProcess) procTreeNode->notifyStart(); //masterProcess notifyStart is called in init() to avoid races
     assert(procTreeNode->getProcIdx() == (uint32_t)procIdx); //must be consistent
+    if (!KnobSSDCheckpointLoad.Value().empty()) {
+        std::string file = SSDCheckpointFile(KnobSSDCheckpointLoad.Value());
+        ssd->load_checkpoint(file);
+        info("Restored SSD checkpoint from %s", file.c_str());
+    }
+    if (procTreeNode->isInFastForward()) ssd->enter_functional_mode(); //startFastForwarded processes never call EnterFastForward()
 
     trace(Process, "SHM'd global segment, starting");
 
@@ -1627,6 +1844,14 @@ int main(int argc, char *argv[]) {
 
     if (zinfo->sched) zinfo->sched->processCleanup(procIdx);
 
+    if (zinfo->bblCacheDir && zinfo->oooDecode) {
+#ifdef BBL_PROFILING
+        warn("BBL profiling assigns per-run BBL indices, not using the BBL cache");
+#else
+        bblCache = new BblCache(zinfo->bblCacheDir);
+#endif
+    }
+
     VirtCaptureClocks(false);
     FFIInit();
 
@@ -52,6 +52,8 @@ class PortVirtualizer;
 class VectorCounter;
 class AccessTraceWriter;
 class TraceDriver;
+class PIMUnit;
+class GemmAccel;
 template <typename T> class g_vector;
 
 struct ClockDomainInfo {
@@ -112,6 +114,7 @@ struct GlobSimInfo {
     bool blockingSyscalls;
     bool perProcessCpuEnum; //if true, cpus are enumerated according to per-process masks (e.g., a 16-core mask in a 64-core sim sees 16 cores)
     bool oooDecode; //if true, Decoder does OOO (instr->uop) decoding
+    uint32_t vectorUarch; //vector execution model used by OOO decoding, see Decoder::findVectorUarch
 
     PAD();
 
@@ -136,6 +139,7 @@ struct GlobSimInfo {
     volatile bool terminationConditionMet;
 
     const char* outputDir; //all the output files mst be dumped here. Stored because complex workloads often change dir, then spawn...
+    const char* bblCacheDir; //if non-null, OOO-decoded BBLs are persisted here across runs (see BblCache)
 
     AggregateStat* rootStat;
     g_vector<StatsBackend*>* statsBackends; // used for termination dumps
@@ -185,6 +189,9 @@ struct GlobSimInfo {
     // Trace-driven simulation (no cores)
     bool traceDriven;
     TraceDriver* traceDriver;
+
+    PIMUnit* pimUnit; //near-memory gather-reduce units, nullptr if not modeled
+    GemmAccel* gemmAccel; //DMA-driven GEMM accelerator, nullptr if not modeled
 };
 
 // nfp 2023-6-8